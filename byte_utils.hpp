@@ -0,0 +1,73 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#ifndef BYTE_UTILS_HPP
+#define BYTE_UTILS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Helpers for the binary files, written little-endian whatever the 
+ *        host is, and a hash that is stable across platforms and runs, 
+ *        unlike std::hash.
+ */
+namespace shadergen_utils {
+inline static void append_u32(std::string& data, const uint32_t& value) noexcept {
+  for (int i{0}; i < 4; i++) data.push_back((char)((value >> (8 * i)) & 0xFF));
+}
+
+inline static void append_u64(std::string& data, const uint64_t& value) noexcept {
+  for (int i{0}; i < 8; i++) data.push_back((char)((value >> (8 * i)) & 0xFF));
+}
+
+inline static uint32_t read_u32(const char* data) noexcept {
+  uint32_t value{0};
+  for (int i{0}; i < 4; i++) value |= (uint32_t)(uint8_t)data[i] << (8 * i);
+  return value;
+}
+
+inline static uint64_t read_u64(const char* data) noexcept {
+  uint64_t value{0};
+  for (int i{0}; i < 8; i++) value |= (uint64_t)(uint8_t)data[i] << (8 * i);
+  return value;
+}
+
+// FNV-1a
+inline static uint64_t hash_bytes(const char* data, const size_t& size) noexcept {
+  uint64_t hash{0xCBF29CE484222325ULL};
+  for (size_t i{0}; i < size; i++) {
+    hash ^= (uint8_t)data[i];
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+inline static uint64_t hash_bytes(const std::string& data) noexcept { return hash_bytes(data.data(), data.size()); }
+}  // namespace shadergen_utils
+
+#endif  // BYTE_UTILS_HPP
@@ -0,0 +1,74 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_EVALUATOR_IMAGE_HPP
+#define ENIGMA_VISUAL_SHADER_EVALUATOR_IMAGE_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace shadergen_visual_shader_evaluator {
+/**
+ * @brief A float RGBA image. Pixels are stored row by row starting from the
+ *        top row, 4 floats per pixel.
+ *
+ * @note The shader's @c FragCoord has its origin at the bottom-left corner,
+ *       so row 0 of the image corresponds to @c FragCoord.y close to 1.0.
+ */
+struct Image {
+  int width{0};
+  int height{0};
+  std::vector<float> pixels;
+
+  Image() = default;
+  Image(const int& width, const int& height) : width(width), height(height), pixels(width * height * 4, 0.0f) {}
+
+  void resize(const int& width, const int& height) {
+    this->width = width;
+    this->height = height;
+    pixels.assign(width * height * 4, 0.0f);
+  }
+
+  float* at(const int& x, const int& y) { return pixels.data() + (y * width + x) * 4; }
+  const float* at(const int& x, const int& y) const { return pixels.data() + (y * width + x) * 4; }
+
+  /**
+   * @brief Converts to 8 bits per channel the way an RGBA8 framebuffer stores
+   *        the fragment color: clamped to [0, 1] and rounded.
+   */
+  void to_rgba8(std::vector<uint8_t>& data) const {
+    data.resize(pixels.size());
+    for (size_t i{0}; i < pixels.size(); i++) {
+      const float c{std::fmin(std::fmax(pixels[i], 0.0f), 1.0f)};
+      data[i] = (uint8_t)std::lround(c * 255.0f);
+    }
+  }
+};
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_EVALUATOR_IMAGE_HPP
@@ -0,0 +1,200 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/image_loss.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "error_macros.hpp"
+#include "evaluator/simd/batch_kernels.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+
+// SSIM stabilizers for a dynamic range of 1: (0.01 * L)^2 and (0.03 * L)^2.
+#define SSIM_C1 0.0001f
+#define SSIM_C2 0.0009f
+
+static bool is_same_size(const Image& image, const Image& target) noexcept {
+  return image.width == target.width && image.height == target.height && image.width > 0 && image.height > 0;
+}
+
+// Reduces row by row so the float accumulators of the kernels stay short.
+static void sum_rows(void (*kernel)(const float*, const float*, float*, const int&) noexcept, const Image& image,
+                     const Image& target, double* sums) noexcept {
+  const int row_size{image.width * 4};
+
+  for (int y{0}; y < image.height; y++) {
+    float row_sums[4]{0.0f, 0.0f, 0.0f, 0.0f};
+    kernel(image.at(0, y), target.at(0, y), row_sums, row_size);
+    for (int c{0}; c < 4; c++) sums[c] += (double)row_sums[c];
+  }
+}
+
+float compute_mse(const Image& image, const Image& target) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(!is_same_size(image, target), std::numeric_limits<float>::infinity(),
+                                "Image sizes do not match.");
+
+  double sums[4]{0.0, 0.0, 0.0, 0.0};
+  sum_rows(get_batch_kernels().squared_error, image, target, sums);
+
+  return (float)((sums[0] + sums[1] + sums[2]) / (double)(image.width * image.height * 3));
+}
+
+bool compute_l1(const Image& image, const Image& target, float* loss) noexcept {
+  CHECK_PARAM_NULLPTR_NON_VOID(loss, false, "Loss is null.");
+  CHECK_CONDITION_TRUE_NON_VOID(!is_same_size(image, target), false, "Image sizes do not match.");
+
+  double sums[4]{0.0, 0.0, 0.0, 0.0};
+  sum_rows(get_batch_kernels().absolute_error, image, target, sums);
+
+  const double count{(double)(image.width * image.height)};
+  for (int c{0}; c < 4; c++) loss[c] = (float)(sums[c] / count);
+
+  return true;
+}
+
+float compute_ssim(const Image& image, const Image& target) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(!is_same_size(image, target), 0.0f, "Image sizes do not match.");
+
+  // Windows are made of 2x2 blocks of half their size, so the moments of each
+  // pixel are only summed once. Pixels past the last full block are ignored,
+  // a side smaller than a window is a single block.
+  const int block_size{SHADER_GEN_EVALUATOR_SSIM_WINDOW_SIZE / 2};
+  const int block_width{image.width < SHADER_GEN_EVALUATOR_SSIM_WINDOW_SIZE ? image.width : block_size};
+  const int block_height{image.height < SHADER_GEN_EVALUATOR_SSIM_WINDOW_SIZE ? image.height : block_size};
+  const int blocks_x{image.width / block_width}, blocks_y{image.height / block_height};
+
+  const BatchKernels& kernels{get_batch_kernels()};
+
+  std::vector<float> block_sums(blocks_x * blocks_y * 20, 0.0f);
+  for (int by{0}; by < blocks_y; by++) {
+    for (int bx{0}; bx < blocks_x; bx++) {
+      kernels.moments(image.at(bx * block_width, by * block_height), target.at(bx * block_width, by * block_height),
+                      image.width * 4, block_height, block_sums.data() + (by * blocks_x + bx) * 20, block_width * 4);
+    }
+  }
+
+  const int span_x{blocks_x > 1 ? 2 : 1}, span_y{blocks_y > 1 ? 2 : 1};
+  const int windows_x{blocks_x - span_x + 1}, windows_y{blocks_y - span_y + 1};
+  const float count{(float)(span_x * block_width * span_y * block_height)};
+
+  double total{0.0};
+  for (int wy{0}; wy < windows_y; wy++) {
+    for (int wx{0}; wx < windows_x; wx++) {
+      float sums[20]{};
+      for (int by{wy}; by < wy + span_y; by++) {
+        for (int bx{wx}; bx < wx + span_x; bx++) {
+          const float* block{block_sums.data() + (by * blocks_x + bx) * 20};
+          for (int i{0}; i < 20; i++) sums[i] += block[i];
+        }
+      }
+
+      for (int c{0}; c < 3; c++) {
+        const float mean_a{sums[c] / count}, mean_b{sums[4 + c] / count};
+        const float var_a{sums[8 + c] / count - mean_a * mean_a};
+        const float var_b{sums[12 + c] / count - mean_b * mean_b};
+        const float cov{sums[16 + c] / count - mean_a * mean_b};
+
+        total += (double)(((2.0f * mean_a * mean_b + SSIM_C1) * (2.0f * cov + SSIM_C2)) /
+                          ((mean_a * mean_a + mean_b * mean_b + SSIM_C1) * (var_a + var_b + SSIM_C2)));
+      }
+    }
+  }
+
+  return (float)(total / (double)(windows_x * windows_y * 3));
+}
+
+float compute_image_loss(const Image& image, const Image& target, const ImageLossType& type) noexcept {
+  const float inf{std::numeric_limits<float>::infinity()};
+  CHECK_CONDITION_TRUE_NON_VOID(!is_same_size(image, target), inf, "Image sizes do not match.");
+
+  float loss{inf};
+  switch (type) {
+    case ImageLossType::MSE:
+      loss = compute_mse(image, target);
+      break;
+    case ImageLossType::L1: {
+      float l1[4];
+      if (compute_l1(image, target, l1)) loss = (l1[0] + l1[1] + l1[2]) / 3.0f;
+      break;
+    }
+    case ImageLossType::SSIM:
+      loss = 1.0f - compute_ssim(image, target);
+      break;
+    default:
+      FAIL_AND_RETURN_NON_VOID(inf, "Unknown image loss type.");
+  }
+
+  return std::isnan(loss) ? inf : loss;
+}
+
+void resize_image(const Image& image, const int& width, const int& height, Image& resized) noexcept {
+  resized.resize(width, height);
+  SILENT_CHECK_CONDITION_TRUE(image.width <= 0 || image.height <= 0);
+
+  for (int y{0}; y < height; y++) {
+    const int y0{y * image.height / height};
+    const int y1{std::max(y0 + 1, (y + 1) * image.height / height)};
+
+    for (int x{0}; x < width; x++) {
+      const int x0{x * image.width / width};
+      const int x1{std::max(x0 + 1, (x + 1) * image.width / width)};
+
+      float* pixel{resized.at(x, y)};
+      for (int sy{y0}; sy < y1; sy++) {
+        for (int sx{x0}; sx < x1; sx++) {
+          const float* source{image.at(sx, sy)};
+          for (int c{0}; c < 4; c++) pixel[c] += source[c];
+        }
+      }
+
+      const float count{(float)((y1 - y0) * (x1 - x0))};
+      for (int c{0}; c < 4; c++) pixel[c] /= count;
+    }
+  }
+}
+
+void build_image_pyramid(const Image& image, const int& width, const int& height, const int& min_size,
+                         ImagePyramid& pyramid) noexcept {
+  pyramid.levels.clear();
+  CHECK_CONDITION_TRUE(width <= 0 || height <= 0 || min_size <= 0, "Invalid pyramid size.");
+
+  pyramid.levels.emplace_back();
+  resize_image(image, width, height, pyramid.levels.back());
+
+  while (pyramid.levels.back().width / 2 >= min_size && pyramid.levels.back().height / 2 >= min_size) {
+    const Image& finer{pyramid.levels.back()};
+    Image coarser;
+    resize_image(finer, finer.width / 2, finer.height / 2, coarser);
+    pyramid.levels.emplace_back(std::move(coarser));
+  }
+
+  std::reverse(pyramid.levels.begin(), pyramid.levels.end());
+}
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,94 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_IMAGE_LOSS_HPP
+#define ENIGMA_IMAGE_LOSS_HPP
+
+#include <vector>
+
+#include "evaluator/image.hpp"
+
+// Side of the square windows SSIM is computed over, they overlap by half. Must be even.
+#define SHADER_GEN_EVALUATOR_SSIM_WINDOW_SIZE 8
+
+/**
+ * @brief Losses between a rendered image and a target image, computed with
+ *        the image loss kernels of @c get_batch_kernels. Only the RGB channels
+ *        are compared unless stated otherwise.
+ */
+namespace shadergen_visual_shader_evaluator {
+enum class ImageLossType { MSE, L1, SSIM };
+
+/**
+ * @brief Mean squared error of the RGB channels.
+ */
+float compute_mse(const Image& image, const Image& target) noexcept;
+
+/**
+ * @brief Mean absolute error of each RGBA channel.
+ *
+ * @param loss Receives 4 values, one per channel.
+ */
+bool compute_l1(const Image& image, const Image& target, float* loss) noexcept;
+
+/**
+ * @brief Mean structural similarity of the RGB channels, 1 for identical
+ *        images. Images smaller than a window are compared as a single window.
+ */
+float compute_ssim(const Image& image, const Image& target) noexcept;
+
+/**
+ * @brief Returns a loss where lower is better: the MSE, the L1 error averaged
+ *        over RGB, or 1 - SSIM.
+ *
+ * @return Infinity if the images have different sizes or the loss is NaN.
+ */
+float compute_image_loss(const Image& image, const Image& target, const ImageLossType& type) noexcept;
+
+/**
+ * @brief Box-filters @p image down (or nearest-samples it up) to the given size.
+ */
+void resize_image(const Image& image, const int& width, const int& height, Image& resized) noexcept;
+
+/**
+ * @brief An image at decreasing resolutions, each level half the size of the
+ *        previous one. @c levels.front() is the coarsest level and
+ *        @c levels.back() the full resolution.
+ */
+struct ImagePyramid {
+  std::vector<Image> levels;
+};
+
+/**
+ * @brief Resizes @p image to @p width x @p height and halves it while both
+ *        sides stay at or above @p min_size.
+ */
+void build_image_pyramid(const Image& image, const int& width, const int& height, const int& min_size,
+                         ImagePyramid& pyramid) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_IMAGE_LOSS_HPP
@@ -0,0 +1,118 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/simd/batch_kernels.hpp"
+
+#include <atomic>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace shadergen_visual_shader_evaluator {
+
+static bool is_cpu_sse4_supported() noexcept {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.1");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 19)) != 0;
+#else
+  return false;
+#endif
+}
+
+static bool is_cpu_avx2_supported() noexcept {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+
+  // The OS must save the YMM registers (OSXSAVE and XCR0 bits 1 and 2).
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+  if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return false;
+#endif
+}
+
+static const BatchKernels* get_batch_kernels_by_level(const SimdLevel& level) noexcept {
+  switch (level) {
+    case SimdLevel::AVX2:
+      return get_avx2_batch_kernels();
+    case SimdLevel::SSE4:
+      return get_sse4_batch_kernels();
+    default:
+      break;
+  }
+  return get_scalar_batch_kernels();
+}
+
+static bool is_simd_level_supported(const SimdLevel& level) noexcept {
+  switch (level) {
+    case SimdLevel::AVX2:
+      return get_avx2_batch_kernels() != nullptr && is_cpu_avx2_supported();
+    case SimdLevel::SSE4:
+      return get_sse4_batch_kernels() != nullptr && is_cpu_sse4_supported();
+    default:
+      break;
+  }
+  return true;
+}
+
+SimdLevel get_supported_simd_level() noexcept {
+  static const SimdLevel level{is_simd_level_supported(SimdLevel::AVX2)   ? SimdLevel::AVX2
+                               : is_simd_level_supported(SimdLevel::SSE4) ? SimdLevel::SSE4
+                                                                          : SimdLevel::SCALAR};
+  return level;
+}
+
+static std::atomic<SimdLevel>& get_simd_level_storage() noexcept {
+  static std::atomic<SimdLevel> level{get_supported_simd_level()};
+  return level;
+}
+
+SimdLevel get_simd_level() noexcept { return get_simd_level_storage().load(std::memory_order_relaxed); }
+
+bool set_simd_level(const SimdLevel& level) noexcept {
+  if (!is_simd_level_supported(level)) return false;
+  get_simd_level_storage().store(level, std::memory_order_relaxed);
+  return true;
+}
+
+const BatchKernels& get_batch_kernels() noexcept { return *get_batch_kernels_by_level(get_simd_level()); }
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,109 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_EVALUATOR_BATCH_KERNELS_HPP
+#define ENIGMA_VISUAL_SHADER_EVALUATOR_BATCH_KERNELS_HPP
+
+#include "gui/model/schema/visual_shader_nodes.pb.h"
+
+using namespace gui::model::schema;
+
+/**
+ * @brief Kernels that run one node operation over a structure-of-arrays batch
+ *        of pixels. Every kernel reads @p n lanes from each operand array and
+ *        writes @p n lanes to the result array, which may alias an operand.
+ *
+ * @note All implementations produce the same results as the scalar functions
+ *       of @c visual_shader_node_evaluators.hpp and
+ *       @c vs_node_noise_evaluators.hpp (only NaN propagation through
+ *       min/max may differ). sin and cos use the polynomials of
+ *       @c evaluator_utils::sin_cos everywhere for that reason, the other
+ *       transcendental functions are evaluated per lane with the C++ standard
+ *       library.
+ */
+namespace shadergen_visual_shader_evaluator {
+enum class SimdLevel { SCALAR, SSE4, AVX2 };
+
+struct BatchKernels {
+  void (*float_op)(const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType& op, const float* a, const float* b,
+                   float* r, const int& n) noexcept;
+  void (*float_func)(const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType& func, const float* x, float* r,
+                     const int& n) noexcept;
+
+  void (*clamp)(const float* x, const float* min_val, const float* max_val, float* r, const int& n) noexcept;
+  void (*mix)(const float* x, const float* y, const float* a, float* r, const int& n) noexcept;
+  void (*smoothstep)(const float* edge0, const float* edge1, const float* x, float* r, const int& n) noexcept;
+
+  void (*value_noise)(const float* u, const float* v, const float& scale, float* r, const int& n) noexcept;
+  void (*perlin_noise)(const float* u, const float* v, const float& scale, float* r, const int& n) noexcept;
+  void (*voronoi_noise)(const float* u, const float* v, const float& angle_offset, const float& cell_density,
+                        float* r, const int& n) noexcept;
+
+  /**
+   * @brief Image loss reductions over @p n interleaved RGBA floats (@p n is a
+   *        multiple of 4). They add to @p sums, indexed by channel, instead of
+   *        overwriting it.
+   *
+   * @c moments reduces a block of @p rows rows, @p stride floats apart, and
+   * fills 5 groups of 4 channels: the sums of a, b, a*a, b*b and a*b.
+   */
+  void (*squared_error)(const float* a, const float* b, float* sums, const int& n) noexcept;
+  void (*absolute_error)(const float* a, const float* b, float* sums, const int& n) noexcept;
+  void (*moments)(const float* a, const float* b, const int& stride, const int& rows, float* sums,
+                  const int& n) noexcept;
+};
+
+/**
+ * @brief The kernels of each instruction set. The SIMD ones are @c nullptr if
+ *        they were not compiled in (for example on non-x86 targets).
+ */
+const BatchKernels* get_scalar_batch_kernels() noexcept;
+const BatchKernels* get_sse4_batch_kernels() noexcept;
+const BatchKernels* get_avx2_batch_kernels() noexcept;
+
+/**
+ * @brief Returns the best instruction set supported by both the build and the
+ *        CPU running it.
+ */
+SimdLevel get_supported_simd_level() noexcept;
+
+SimdLevel get_simd_level() noexcept;
+
+/**
+ * @brief Forces the kernels returned by @c get_batch_kernels. Fails if @p level
+ *        is not supported.
+ */
+bool set_simd_level(const SimdLevel& level) noexcept;
+
+/**
+ * @brief Returns the kernels of the current SIMD level. The level defaults to
+ *        @c get_supported_simd_level.
+ */
+const BatchKernels& get_batch_kernels() noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_EVALUATOR_BATCH_KERNELS_HPP
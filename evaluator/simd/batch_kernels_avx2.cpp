@@ -0,0 +1,85 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/simd/batch_kernels.hpp"
+
+#if defined(__AVX2__)
+#define SHADER_GEN_EVALUATOR_HAS_AVX2
+#endif
+
+#ifdef SHADER_GEN_EVALUATOR_HAS_AVX2
+
+#include <immintrin.h>
+
+#include "evaluator/simd/batch_kernels_simd.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+namespace {
+struct Avx2Vector {
+  using type = __m256;
+  using mask = __m256;
+
+  static constexpr int width{8};
+
+  static type load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+  static void store(float* p, const type& v) noexcept { _mm256_storeu_ps(p, v); }
+  static type set1(const float& x) noexcept { return _mm256_set1_ps(x); }
+
+  static type add(const type& a, const type& b) noexcept { return _mm256_add_ps(a, b); }
+  static type sub(const type& a, const type& b) noexcept { return _mm256_sub_ps(a, b); }
+  static type mul(const type& a, const type& b) noexcept { return _mm256_mul_ps(a, b); }
+  static type div(const type& a, const type& b) noexcept { return _mm256_div_ps(a, b); }
+  static type min(const type& a, const type& b) noexcept { return _mm256_min_ps(a, b); }
+  static type max(const type& a, const type& b) noexcept { return _mm256_max_ps(a, b); }
+
+  static type sqrt(const type& x) noexcept { return _mm256_sqrt_ps(x); }
+  static type abs(const type& x) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x); }
+  static type neg(const type& x) noexcept { return _mm256_xor_ps(x, _mm256_set1_ps(-0.0f)); }
+  static type floor(const type& x) noexcept { return _mm256_floor_ps(x); }
+  static type ceil(const type& x) noexcept { return _mm256_ceil_ps(x); }
+  static type trunc(const type& x) noexcept { return _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+  static type round_even(const type& x) noexcept {
+    return _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+
+  static mask lt(const type& a, const type& b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+
+  // m ? a : b
+  static type select(const mask& m, const type& a, const type& b) noexcept { return _mm256_blendv_ps(b, a, m); }
+};
+}  // namespace
+
+const BatchKernels* get_avx2_batch_kernels() noexcept { return SimdKernels<Avx2Vector>::get(); }
+}  // namespace shadergen_visual_shader_evaluator
+
+#else
+
+namespace shadergen_visual_shader_evaluator {
+const BatchKernels* get_avx2_batch_kernels() noexcept { return nullptr; }
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // SHADER_GEN_EVALUATOR_HAS_AVX2
@@ -0,0 +1,109 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/simd/batch_kernels.hpp"
+
+#include <cmath>
+
+#include "evaluator/utils/utils.hpp"
+#include "evaluator/visual_shader_node_evaluators.hpp"
+#include "evaluator/vs_node_noise_evaluators.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+
+// Plain loops over the reference functions. This is the fallback for CPUs
+// without SSE4.1 and handles the tails and the per-lane operations of the
+// SIMD kernels.
+
+static void float_op(const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType& op, const float* a, const float* b,
+                     float* r, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) r[i] = apply_float_op(op, a[i], b[i]);
+}
+
+static void float_func(const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType& func, const float* x, float* r,
+                       const int& n) noexcept {
+  for (int i{0}; i < n; ++i) r[i] = apply_float_func(func, x[i]);
+}
+
+static void clamp(const float* x, const float* min_val, const float* max_val, float* r, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) r[i] = evaluator_utils::clamp(x[i], min_val[i], max_val[i]);
+}
+
+static void mix(const float* x, const float* y, const float* a, float* r, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) r[i] = evaluator_utils::mix(x[i], y[i], a[i]);
+}
+
+static void smoothstep(const float* edge0, const float* edge1, const float* x, float* r, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) r[i] = evaluator_utils::smoothstep(edge0[i], edge1[i], x[i]);
+}
+
+static void value_noise(const float* u, const float* v, const float& scale, float* r, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) r[i] = generate_value_noise_float(u[i], v[i], scale);
+}
+
+static void perlin_noise(const float* u, const float* v, const float& scale, float* r, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) r[i] = generate_perlin_noise_float(u[i], v[i], scale);
+}
+
+static void voronoi_noise(const float* u, const float* v, const float& angle_offset, const float& cell_density,
+                          float* r, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) r[i] = generate_voronoi_noise_float(u[i], v[i], angle_offset, cell_density);
+}
+
+static void squared_error(const float* a, const float* b, float* sums, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) {
+    const float d{a[i] - b[i]};
+    sums[i % 4] += d * d;
+  }
+}
+
+static void absolute_error(const float* a, const float* b, float* sums, const int& n) noexcept {
+  for (int i{0}; i < n; ++i) sums[i % 4] += std::fabs(a[i] - b[i]);
+}
+
+static void moments(const float* a, const float* b, const int& stride, const int& rows, float* sums,
+                    const int& n) noexcept {
+  for (int y{0}; y < rows; ++y) {
+    const float* ra{a + y * stride};
+    const float* rb{b + y * stride};
+    for (int i{0}; i < n; ++i) {
+      const int c{i % 4};
+      sums[c] += ra[i];
+      sums[4 + c] += rb[i];
+      sums[8 + c] += ra[i] * ra[i];
+      sums[12 + c] += rb[i] * rb[i];
+      sums[16 + c] += ra[i] * rb[i];
+    }
+  }
+}
+
+const BatchKernels* get_scalar_batch_kernels() noexcept {
+  static const BatchKernels kernels{float_op, float_func, clamp, mix, smoothstep, value_noise, perlin_noise,
+                                    voronoi_noise, squared_error, absolute_error, moments};
+  return &kernels;
+}
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,463 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_EVALUATOR_BATCH_KERNELS_SIMD_HPP
+#define ENIGMA_VISUAL_SHADER_EVALUATOR_BATCH_KERNELS_SIMD_HPP
+
+#include "evaluator/simd/batch_kernels.hpp"
+
+/**
+ * @brief Kernels written once against a vector type @c V and instantiated by
+ *        each instruction set translation unit. @c V provides @c type,
+ *        @c width and the load/store/arithmetic/compare/select primitives.
+ *
+ * @note Everything here has internal linkage on purpose: this header is
+ *       compiled with different instruction set flags per translation unit,
+ *       sharing an instantiation between them could leak AVX2 code into the
+ *       SSE4 path. Tails and the remaining functions go through the scalar
+ *       kernels, which are compiled without any instruction set flag.
+ */
+namespace shadergen_visual_shader_evaluator {
+namespace {
+
+template <typename V>
+struct SimdKernels {
+  using T = typename V::type;
+
+  static T fract(const T& x) noexcept { return V::sub(x, V::floor(x)); }
+
+  static T mod(const T& x, const T& y) noexcept { return V::sub(x, V::mul(y, V::floor(V::div(x, y)))); }
+
+  static T step(const T& edge, const T& x) noexcept {
+    return V::select(V::lt(x, edge), V::set1(0.0f), V::set1(1.0f));
+  }
+
+  static T clamp(const T& x, const T& min_val, const T& max_val) noexcept {
+    return V::min(V::max(x, min_val), max_val);
+  }
+
+  static T mix(const T& x, const T& y, const T& a) noexcept {
+    return V::add(V::mul(x, V::sub(V::set1(1.0f), a)), V::mul(y, a));
+  }
+
+  static T smoothstep(const T& edge0, const T& edge1, const T& x) noexcept {
+    const T t{clamp(V::div(V::sub(x, edge0), V::sub(edge1, edge0)), V::set1(0.0f), V::set1(1.0f))};
+    return V::mul(V::mul(t, t), V::sub(V::set1(3.0f), V::mul(V::set1(2.0f), t)));
+  }
+
+  // Same operations in the same order as evaluator_utils::sin_cos.
+  static T sin_cos(const T& x, const float& quadrant_offset) noexcept {
+    const T k{V::floor(V::add(V::mul(x, V::set1(0.63661977236758134308f)), V::set1(0.5f)))};
+    const T r{V::sub(V::sub(V::sub(x, V::mul(k, V::set1(1.5703125f))), V::mul(k, V::set1(4.837512969970703125e-4f))),
+                     V::mul(k, V::set1(7.54978995489188216e-8f)))};
+    const T z{V::mul(r, r)};
+
+    T s{V::add(V::mul(V::set1(-1.9515295891e-4f), z), V::set1(8.3321608736e-3f))};
+    s = V::sub(V::mul(s, z), V::set1(1.6666654611e-1f));
+    s = V::add(V::mul(V::mul(s, z), r), r);
+
+    T c{V::sub(V::mul(V::set1(2.443315711809948e-5f), z), V::set1(1.388731625493765e-3f))};
+    c = V::add(V::mul(c, z), V::set1(4.166664568298827e-2f));
+    c = V::add(V::sub(V::mul(V::mul(c, z), z), V::mul(V::set1(0.5f), z)), V::set1(1.0f));
+
+    const T q{mod(V::add(k, V::set1(quadrant_offset)), V::set1(4.0f))};
+    const T y{V::select(V::lt(V::set1(0.5f), mod(q, V::set1(2.0f))), c, s)};
+    return V::select(V::lt(V::set1(1.5f), q), V::neg(y), y);
+  }
+
+  static T sin(const T& x) noexcept { return sin_cos(x, 0.0f); }
+
+  static T cos(const T& x) noexcept { return sin_cos(x, 1.0f); }
+
+  /*************************************/
+  /* Operators and functions           */
+  /*************************************/
+
+  template <typename F>
+  static int binary(const float* a, const float* b, float* r, const int& n, F f) noexcept {
+    int i{0};
+    for (; i + V::width <= n; i += V::width) V::store(r + i, f(V::load(a + i), V::load(b + i)));
+    return i;
+  }
+
+  template <typename F>
+  static int unary(const float* x, float* r, const int& n, F f) noexcept {
+    int i{0};
+    for (; i + V::width <= n; i += V::width) V::store(r + i, f(V::load(x + i)));
+    return i;
+  }
+
+  template <typename F>
+  static int ternary(const float* a, const float* b, const float* c, float* r, const int& n, F f) noexcept {
+    int i{0};
+    for (; i + V::width <= n; i += V::width) V::store(r + i, f(V::load(a + i), V::load(b + i), V::load(c + i)));
+    return i;
+  }
+
+  static void float_op(const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType& op, const float* a, const float* b,
+                       float* r, const int& n) noexcept {
+    int i{0};
+
+    switch (op) {
+      case VisualShaderNodeFloatOp::OP_ADD:
+        i = binary(a, b, r, n, [](const T& x, const T& y) { return V::add(x, y); });
+        break;
+      case VisualShaderNodeFloatOp::OP_SUB:
+        i = binary(a, b, r, n, [](const T& x, const T& y) { return V::sub(x, y); });
+        break;
+      case VisualShaderNodeFloatOp::OP_MUL:
+        i = binary(a, b, r, n, [](const T& x, const T& y) { return V::mul(x, y); });
+        break;
+      case VisualShaderNodeFloatOp::OP_DIV:
+        i = binary(a, b, r, n, [](const T& x, const T& y) { return V::div(x, y); });
+        break;
+      case VisualShaderNodeFloatOp::OP_MOD:
+        i = binary(a, b, r, n, [](const T& x, const T& y) { return mod(x, y); });
+        break;
+      case VisualShaderNodeFloatOp::OP_MAX:
+        i = binary(a, b, r, n, [](const T& x, const T& y) { return V::max(x, y); });
+        break;
+      case VisualShaderNodeFloatOp::OP_MIN:
+        i = binary(a, b, r, n, [](const T& x, const T& y) { return V::min(x, y); });
+        break;
+      case VisualShaderNodeFloatOp::OP_STEP:
+        i = binary(a, b, r, n, [](const T& x, const T& y) { return step(x, y); });
+        break;
+      default:
+        break;
+    }
+
+    if (i < n) get_scalar_batch_kernels()->float_op(op, a + i, b + i, r + i, n - i);
+  }
+
+  static void float_func(const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType& func, const float* x,
+                         float* r, const int& n) noexcept {
+    int i{0};
+
+    switch (func) {
+      case VisualShaderNodeFloatFunc::FUNC_SIN:
+        i = unary(x, r, n, [](const T& v) { return sin(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_COS:
+        i = unary(x, r, n, [](const T& v) { return cos(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_SQRT:
+        i = unary(x, r, n, [](const T& v) { return V::sqrt(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_ABS:
+        i = unary(x, r, n, [](const T& v) { return V::abs(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_SIGN:
+        i = unary(x, r, n, [](const T& v) {
+          const T zero{V::set1(0.0f)};
+          return V::select(V::lt(zero, v), V::set1(1.0f), V::select(V::lt(v, zero), V::set1(-1.0f), zero));
+        });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_FLOOR:
+        i = unary(x, r, n, [](const T& v) { return V::floor(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_CEIL:
+        i = unary(x, r, n, [](const T& v) { return V::ceil(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_FRACT:
+        i = unary(x, r, n, [](const T& v) { return fract(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_SATURATE:
+        i = unary(x, r, n, [](const T& v) { return clamp(v, V::set1(0.0f), V::set1(1.0f)); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_NEGATE:
+        i = unary(x, r, n, [](const T& v) { return V::neg(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_DEGREES:
+        i = unary(x, r, n, [](const T& v) { return V::mul(v, V::set1(57.295779513082320876798f)); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_INVERSE_SQRT:
+        i = unary(x, r, n, [](const T& v) { return V::div(V::set1(1.0f), V::sqrt(v)); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_RADIANS:
+        i = unary(x, r, n, [](const T& v) { return V::mul(v, V::set1(0.017453292519943295769f)); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_RECIPROCAL:
+        i = unary(x, r, n, [](const T& v) { return V::div(V::set1(1.0f), v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_ROUNDEVEN:
+        i = unary(x, r, n, [](const T& v) { return V::round_even(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_TRUNC:
+        i = unary(x, r, n, [](const T& v) { return V::trunc(v); });
+        break;
+      case VisualShaderNodeFloatFunc::FUNC_ONEMINUS:
+        i = unary(x, r, n, [](const T& v) { return V::sub(V::set1(1.0f), v); });
+        break;
+      default:
+        break;
+    }
+
+    if (i < n) get_scalar_batch_kernels()->float_func(func, x + i, r + i, n - i);
+  }
+
+  static void clamp(const float* x, const float* min_val, const float* max_val, float* r, const int& n) noexcept {
+    const int i{ternary(x, min_val, max_val, r, n, [](const T& a, const T& b, const T& c) { return clamp(a, b, c); })};
+    if (i < n) get_scalar_batch_kernels()->clamp(x + i, min_val + i, max_val + i, r + i, n - i);
+  }
+
+  static void mix(const float* x, const float* y, const float* a, float* r, const int& n) noexcept {
+    const int i{ternary(x, y, a, r, n, [](const T& p, const T& q, const T& t) { return mix(p, q, t); })};
+    if (i < n) get_scalar_batch_kernels()->mix(x + i, y + i, a + i, r + i, n - i);
+  }
+
+  static void smoothstep(const float* edge0, const float* edge1, const float* x, float* r, const int& n) noexcept {
+    const int i{ternary(edge0, edge1, x, r, n,
+                        [](const T& e0, const T& e1, const T& v) { return smoothstep(e0, e1, v); })};
+    if (i < n) get_scalar_batch_kernels()->smoothstep(edge0 + i, edge1 + i, x + i, r + i, n - i);
+  }
+
+  /*************************************/
+  /* Value (Simple) Noise              */
+  /*************************************/
+
+  static T noise_random_value(const T& x, const T& y) noexcept {
+    const T s{sin(V::add(V::mul(x, V::set1(12.9898f)), V::mul(y, V::set1(78.233f))))};
+    return fract(V::mul(s, V::set1(43758.5453f)));
+  }
+
+  static T value_noise(const T& x, const T& y) noexcept {
+    const T one{V::set1(1.0f)};
+
+    const T ix{V::floor(x)}, iy{V::floor(y)};
+    T fx{fract(x)}, fy{fract(y)};
+    fx = V::mul(V::mul(fx, fx), V::sub(V::set1(3.0f), V::mul(V::set1(2.0f), fx)));
+    fy = V::mul(V::mul(fy, fy), V::sub(V::set1(3.0f), V::mul(V::set1(2.0f), fy)));
+
+    const T r0{noise_random_value(ix, iy)};
+    const T r1{noise_random_value(V::add(ix, one), iy)};
+    const T r2{noise_random_value(ix, V::add(iy, one))};
+    const T r3{noise_random_value(V::add(ix, one), V::add(iy, one))};
+
+    const T bottom_of_grid{V::add(V::mul(V::sub(one, fx), r0), V::mul(fx, r1))};
+    const T top_of_grid{V::add(V::mul(V::sub(one, fx), r2), V::mul(fx, r3))};
+    return V::add(V::mul(V::sub(one, fy), bottom_of_grid), V::mul(fy, top_of_grid));
+  }
+
+  static void value_noise(const float* u, const float* v, const float& scale, float* r, const int& n) noexcept {
+    const T s{V::set1(scale)};
+
+    int i{0};
+    for (; i + V::width <= n; i += V::width) {
+      const T su{V::mul(V::load(u + i), s)}, sv{V::mul(V::load(v + i), s)};
+
+      T t{V::set1(0.0f)};
+      t = V::add(t, V::mul(value_noise(su, sv), V::set1(0.125f)));
+      t = V::add(t, V::mul(value_noise(V::div(su, V::set1(2.0f)), V::div(sv, V::set1(2.0f))), V::set1(0.25f)));
+      t = V::add(t, V::mul(value_noise(V::div(su, V::set1(4.0f)), V::div(sv, V::set1(4.0f))), V::set1(0.5f)));
+
+      V::store(r + i, t);
+    }
+
+    if (i < n) get_scalar_batch_kernels()->value_noise(u + i, v + i, scale, r + i, n - i);
+  }
+
+  /*************************************/
+  /* Perlin (Gradient) Noise           */
+  /*************************************/
+
+  static void perlin_noise_dir(const T& x, const T& y, T& dir_x, T& dir_y) noexcept {
+    const T m{V::set1(289.0f)};
+    const T px{mod(x, m)}, py{mod(y, m)};
+
+    T t{V::add(mod(V::mul(V::add(V::mul(V::set1(34.0f), px), V::set1(1.0f)), px), m), py)};
+    t = mod(V::mul(V::add(V::mul(V::set1(34.0f), t), V::set1(1.0f)), t), m);
+    t = V::sub(V::mul(fract(V::div(t, V::set1(41.0f))), V::set1(2.0f)), V::set1(1.0f));
+
+    dir_x = V::sub(t, V::floor(V::add(t, V::set1(0.5f))));
+    dir_y = V::sub(V::abs(t), V::set1(0.5f));
+
+    const T len{V::sqrt(V::add(V::mul(dir_x, dir_x), V::mul(dir_y, dir_y)))};
+    dir_x = V::div(dir_x, len);
+    dir_y = V::div(dir_y, len);
+  }
+
+  static T perlin_noise(const T& x, const T& y) noexcept {
+    const T one{V::set1(1.0f)};
+
+    const T ipx{V::floor(x)}, ipy{V::floor(y)};
+    T fpx{fract(x)}, fpy{fract(y)};
+
+    T dx, dy;
+
+    perlin_noise_dir(ipx, ipy, dx, dy);
+    const T d00{V::add(V::mul(dx, fpx), V::mul(dy, fpy))};
+
+    perlin_noise_dir(ipx, V::add(ipy, one), dx, dy);
+    const T d01{V::add(V::mul(dx, fpx), V::mul(dy, V::sub(fpy, one)))};
+
+    perlin_noise_dir(V::add(ipx, one), ipy, dx, dy);
+    const T d10{V::add(V::mul(dx, V::sub(fpx, one)), V::mul(dy, fpy))};
+
+    perlin_noise_dir(V::add(ipx, one), V::add(ipy, one), dx, dy);
+    const T d11{V::add(V::mul(dx, V::sub(fpx, one)), V::mul(dy, V::sub(fpy, one)))};
+
+    const T c6{V::set1(6.0f)}, c15{V::set1(15.0f)}, c10{V::set1(10.0f)};
+    fpx = V::mul(V::mul(V::mul(fpx, fpx), fpx), V::add(V::mul(fpx, V::sub(V::mul(fpx, c6), c15)), c10));
+    fpy = V::mul(V::mul(V::mul(fpy, fpy), fpy), V::add(V::mul(fpy, V::sub(V::mul(fpy, c6), c15)), c10));
+
+    return mix(mix(d00, d01, fpy), mix(d10, d11, fpy), fpx);
+  }
+
+  static void perlin_noise(const float* u, const float* v, const float& scale, float* r, const int& n) noexcept {
+    const T s{V::set1(scale)};
+
+    int i{0};
+    for (; i + V::width <= n; i += V::width) {
+      const T t{perlin_noise(V::mul(V::load(u + i), s), V::mul(V::load(v + i), s))};
+      V::store(r + i, V::add(t, V::set1(0.5f)));
+    }
+
+    if (i < n) get_scalar_batch_kernels()->perlin_noise(u + i, v + i, scale, r + i, n - i);
+  }
+
+  /*************************************/
+  /* Voronoi (Worley) Noise            */
+  /*************************************/
+
+  static void voronoi_noise(const float* u, const float* v, const float& angle_offset, const float& cell_density,
+                            float* r, const int& n) noexcept {
+    const T density{V::set1(cell_density)}, offset{V::set1(angle_offset)};
+    const T half{V::set1(0.5f)};
+
+    int i{0};
+    for (; i + V::width <= n; i += V::width) {
+      const T su{V::mul(V::load(u + i), density)}, sv{V::mul(V::load(v + i), density)};
+      const T gx{V::floor(su)}, gy{V::floor(sv)};
+      const T fx{fract(su)}, fy{fract(sv)};
+
+      T out_buffer{V::set1(0.0f)};
+      T res{V::set1(8.0f)};
+
+      for (int y{-1}; y <= 1; y++) {
+        for (int x{-1}; x <= 1; x++) {
+          const T lx{V::set1(float(x))}, ly{V::set1(float(y))};
+          const T cx{V::add(lx, gx)}, cy{V::add(ly, gy)};
+
+          // mat2(15.27, 47.63, 99.41, 89.98) is column-major.
+          const T mx{V::add(V::mul(V::set1(15.27f), cx), V::mul(V::set1(99.41f), cy))};
+          const T my{V::add(V::mul(V::set1(47.63f), cx), V::mul(V::set1(89.98f), cy))};
+
+          const T ux{fract(V::mul(sin(mx), V::set1(46839.32f)))};
+          const T uy{fract(V::mul(sin(my), V::set1(46839.32f)))};
+
+          const T ox{V::add(V::mul(sin(V::mul(uy, offset)), half), half)};
+          const T oy{V::add(V::mul(cos(V::mul(ux, offset)), half), half)};
+
+          const T dx{V::sub(V::add(lx, ox), fx)}, dy{V::sub(V::add(ly, oy), fy)};
+          const T d{V::sqrt(V::add(V::mul(dx, dx), V::mul(dy, dy)))};
+
+          const typename V::mask closer{V::lt(d, res)};
+          res = V::select(closer, d, res);
+          out_buffer = V::select(closer, d, out_buffer);
+        }
+      }
+
+      V::store(r + i, out_buffer);
+    }
+
+    if (i < n) get_scalar_batch_kernels()->voronoi_noise(u + i, v + i, angle_offset, cell_density, r + i, n - i);
+  }
+
+  /*************************************/
+  /* Image Losses                      */
+  /*************************************/
+
+  // The widths are multiples of 4, so lane l always holds channel l % 4.
+  static void fold_channels(const T& acc, float* sums) noexcept {
+    alignas(32) float lanes[V::width];
+    V::store(lanes, acc);
+    for (int l{0}; l < V::width; l++) sums[l % 4] += lanes[l];
+  }
+
+  static void squared_error(const float* a, const float* b, float* sums, const int& n) noexcept {
+    T acc{V::set1(0.0f)};
+
+    int i{0};
+    for (; i + V::width <= n; i += V::width) {
+      const T d{V::sub(V::load(a + i), V::load(b + i))};
+      acc = V::add(acc, V::mul(d, d));
+    }
+
+    fold_channels(acc, sums);
+    if (i < n) get_scalar_batch_kernels()->squared_error(a + i, b + i, sums, n - i);
+  }
+
+  static void absolute_error(const float* a, const float* b, float* sums, const int& n) noexcept {
+    T acc{V::set1(0.0f)};
+
+    int i{0};
+    for (; i + V::width <= n; i += V::width) acc = V::add(acc, V::abs(V::sub(V::load(a + i), V::load(b + i))));
+
+    fold_channels(acc, sums);
+    if (i < n) get_scalar_batch_kernels()->absolute_error(a + i, b + i, sums, n - i);
+  }
+
+  static void moments(const float* a, const float* b, const int& stride, const int& rows, float* sums,
+                      const int& n) noexcept {
+    T sa{V::set1(0.0f)}, sb{V::set1(0.0f)}, saa{V::set1(0.0f)}, sbb{V::set1(0.0f)}, sab{V::set1(0.0f)};
+
+    const int vector_n{n - n % V::width};
+    for (int y{0}; y < rows; y++) {
+      const float* ra{a + y * stride};
+      const float* rb{b + y * stride};
+      for (int i{0}; i < vector_n; i += V::width) {
+        const T va{V::load(ra + i)}, vb{V::load(rb + i)};
+        sa = V::add(sa, va);
+        sb = V::add(sb, vb);
+        saa = V::add(saa, V::mul(va, va));
+        sbb = V::add(sbb, V::mul(vb, vb));
+        sab = V::add(sab, V::mul(va, vb));
+      }
+    }
+
+    fold_channels(sa, sums);
+    fold_channels(sb, sums + 4);
+    fold_channels(saa, sums + 8);
+    fold_channels(sbb, sums + 12);
+    fold_channels(sab, sums + 16);
+    if (vector_n < n) {
+      get_scalar_batch_kernels()->moments(a + vector_n, b + vector_n, stride, rows, sums, n - vector_n);
+    }
+  }
+
+  static const BatchKernels* get() noexcept {
+    static const BatchKernels kernels{float_op, float_func, clamp, mix, smoothstep, value_noise, perlin_noise,
+                                      voronoi_noise, squared_error, absolute_error, moments};
+    return &kernels;
+  }
+};
+
+}  // namespace
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_EVALUATOR_BATCH_KERNELS_SIMD_HPP
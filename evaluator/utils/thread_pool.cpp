@@ -0,0 +1,158 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/utils/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace evaluator_utils {
+
+// The pool whose task the current thread is running, if any.
+static thread_local const ThreadPool* current_pool{nullptr};
+
+ThreadPool::ThreadPool(const int& thread_count)
+    : thread_count(std::max(thread_count, 1)), ranges(new TaskRange[this->thread_count]) {
+  // The thread calling run is thread 0.
+  for (int i{1}; i < this->thread_count; i++) {
+    workers.emplace_back(&ThreadPool::worker_loop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  start_condition.notify_all();
+
+  for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::run(const int& task_count, const std::function<void(const int&, const int&)>& task) noexcept {
+  if (task_count <= 0) return;
+
+  if (current_pool == this) {
+    for (int i{0}; i < task_count; i++) task(i, 0);
+    return;
+  }
+
+  std::lock_guard<std::mutex> run_lock{run_mutex};
+
+  for (int i{0}; i < thread_count; i++) {
+    std::lock_guard<std::mutex> lock{ranges[i].mutex};
+    ranges[i].begin = (int)((int64_t)task_count * i / thread_count);
+    ranges[i].end = (int)((int64_t)task_count * (i + 1) / thread_count);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    this->task = &task;
+    busy_worker_count = (int)workers.size();
+    generation++;
+  }
+  start_condition.notify_all();
+
+  work(0);
+
+  std::unique_lock<std::mutex> lock{mutex};
+  done_condition.wait(lock, [this] { return busy_worker_count == 0; });
+  this->task = nullptr;
+}
+
+void ThreadPool::worker_loop(const int& thread_index) noexcept {
+  uint64_t last_generation{0};
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      start_condition.wait(lock, [&] { return stopping || generation != last_generation; });
+      if (stopping) return;
+      last_generation = generation;
+    }
+
+    work(thread_index);
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      busy_worker_count--;
+    }
+    done_condition.notify_one();
+  }
+}
+
+void ThreadPool::work(const int& thread_index) noexcept {
+  const ThreadPool* previous_pool{current_pool};
+  current_pool = this;
+
+  int task_index;
+  while (pop_task(thread_index, task_index) || (steal_tasks(thread_index) && pop_task(thread_index, task_index))) {
+    (*task)(task_index, thread_index);
+  }
+
+  current_pool = previous_pool;
+}
+
+bool ThreadPool::pop_task(const int& thread_index, int& task_index) noexcept {
+  TaskRange& range{ranges[thread_index]};
+  std::lock_guard<std::mutex> lock{range.mutex};
+  if (range.begin >= range.end) return false;
+
+  task_index = range.begin++;
+  return true;
+}
+
+bool ThreadPool::steal_tasks(const int& thread_index) noexcept {
+  for (int i{1}; i < thread_count; i++) {
+    TaskRange& victim{ranges[(thread_index + i) % thread_count]};
+
+    int begin, end;
+    {
+      std::lock_guard<std::mutex> lock{victim.mutex};
+      const int remaining{victim.end - victim.begin};
+      if (remaining <= 0) continue;
+
+      // Take the back half, the victim keeps running its front.
+      begin = victim.end - (remaining + 1) / 2;
+      end = victim.end;
+      victim.end = begin;
+    }
+
+    TaskRange& range{ranges[thread_index]};
+    std::lock_guard<std::mutex> lock{range.mutex};
+    range.begin = begin;
+    range.end = end;
+    return true;
+  }
+
+  return false;
+}
+
+ThreadPool& get_thread_pool() noexcept {
+  static ThreadPool pool{(int)std::thread::hardware_concurrency()};
+  return pool;
+}
+}  // namespace evaluator_utils
@@ -0,0 +1,115 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef EVALUATOR_THREAD_POOL_HPP
+#define EVALUATOR_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace evaluator_utils {
+/**
+ * @brief A fixed-size pool running indexed tasks with work stealing.
+ *
+ * Each thread starts with a contiguous range of task indices and runs them
+ * from the front. When its range is empty, it steals the back half of
+ * another thread's range, so uneven tasks (tiles with more expensive nodes,
+ * the image border) are balanced without a shared queue.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @param thread_count Number of threads running tasks, including the
+   *                     thread calling @c run.
+   */
+  explicit ThreadPool(const int& thread_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int get_thread_count() const noexcept { return thread_count; }
+
+  /**
+   * @brief Runs @p task for every index in [0, @p task_count) and returns
+   *        once all of them are done. The calling thread runs tasks too.
+   *
+   * @p task receives the task index and the index of the thread running it,
+   * in [0, @c get_thread_count()), which can be used to select per-thread
+   * scratch data.
+   *
+   * @note Calls are serialized. A call made from inside a task of the same
+   *       pool runs all its tasks on the calling thread with thread index 0,
+   *       so code that is already parallel (one thumbnail per task) can call
+   *       code that parallelizes internally (the tiled renderer).
+   */
+  void run(const int& task_count, const std::function<void(const int&, const int&)>& task) noexcept;
+
+ private:
+  // Padded to a cache line so threads do not share the lines they poll.
+  struct alignas(64) TaskRange {
+    std::mutex mutex;
+    int begin{0};
+    int end{0};
+  };
+
+  const int thread_count;
+
+  std::vector<std::thread> workers;
+  std::unique_ptr<TaskRange[]> ranges;
+
+  std::mutex run_mutex;
+
+  std::mutex mutex;
+  std::condition_variable start_condition;
+  std::condition_variable done_condition;
+  const std::function<void(const int&, const int&)>* task{nullptr};
+  uint64_t generation{0};
+  int busy_worker_count{0};
+  bool stopping{false};
+
+  void worker_loop(const int& thread_index) noexcept;
+
+  void work(const int& thread_index) noexcept;
+
+  bool pop_task(const int& thread_index, int& task_index) noexcept;
+
+  bool steal_tasks(const int& thread_index) noexcept;
+};
+
+/**
+ * @brief The pool shared by the renderers, sized to the number of cores.
+ */
+ThreadPool& get_thread_pool() noexcept;
+}  // namespace evaluator_utils
+
+#endif  // EVALUATOR_THREAD_POOL_HPP
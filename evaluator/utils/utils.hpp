@@ -0,0 +1,94 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef EVALUATOR_UTILS_HPP
+#define EVALUATOR_UTILS_HPP
+
+#include <cmath>
+
+/**
+ * @brief Scalar versions of the GLSL built-in functions used by the generated
+ *        shaders. The definitions follow the GLSL 4.30 specification so that
+ *        the CPU evaluator produces the same results as the GPU.
+ */
+namespace evaluator_utils {
+inline static float fract(const float& x) noexcept { return x - std::floor(x); }
+
+inline static float mod(const float& x, const float& y) noexcept { return x - y * std::floor(x / y); }
+
+inline static float step(const float& edge, const float& x) noexcept { return x < edge ? 0.0f : 1.0f; }
+
+inline static float clamp(const float& x, const float& min_val, const float& max_val) noexcept {
+  return std::fmin(std::fmax(x, min_val), max_val);
+}
+
+inline static float mix(const float& x, const float& y, const float& a) noexcept { return x * (1.0f - a) + y * a; }
+
+inline static float smoothstep(const float& edge0, const float& edge1, const float& x) noexcept {
+  float t{clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f)};
+  return t * t * (3.0f - 2.0f * t);
+}
+
+inline static float sign(const float& x) noexcept { return x > 0.0f ? 1.0f : (x < 0.0f ? -1.0f : 0.0f); }
+
+inline static float round_even(const float& x) noexcept { return std::nearbyint(x); }
+
+inline static float inversesqrt(const float& x) noexcept { return 1.0f / std::sqrt(x); }
+
+inline static float degrees(const float& x) noexcept { return x * 57.295779513082320876798f; }
+
+inline static float radians(const float& x) noexcept { return x * 0.017453292519943295769f; }
+
+/**
+ * @brief sin(x) for @p quadrant_offset 0 and cos(x) for 1, with the range
+ *       reduction and polynomials of Cephes' sinf/cosf. Accurate to about
+ *       1e-7 for |x| < 8192.
+ *
+ * @note The SIMD kernels run the same operations in the same order (see
+ *       @c SimdKernels::sin_cos), so every evaluator gets the same bits.
+ */
+inline static float sin_cos(const float& x, const float& quadrant_offset) noexcept {
+  // x = k * pi/2 + r with pi/2 split in three parts, k * 1.5703125f is exact.
+  const float k{std::floor(x * 0.63661977236758134308f + 0.5f)};
+  const float r{((x - k * 1.5703125f) - k * 4.837512969970703125e-4f) - k * 7.54978995489188216e-8f};
+  const float z{r * r};
+
+  const float s{((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r};
+  const float c{((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z -
+                0.5f * z + 1.0f};
+
+  const float q{mod(k + quadrant_offset, 4.0f)};
+  const float y{mod(q, 2.0f) > 0.5f ? c : s};
+  return q > 1.5f ? -y : y;
+}
+
+inline static float sin(const float& x) noexcept { return sin_cos(x, 0.0f); }
+
+inline static float cos(const float& x) noexcept { return sin_cos(x, 1.0f); }
+}  // namespace evaluator_utils
+
+#endif  // EVALUATOR_UTILS_HPP
@@ -0,0 +1,865 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/visual_shader_autodiff.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include "error_macros.hpp"
+#include "evaluator/image_loss.hpp"
+#include "evaluator/utils/thread_pool.hpp"
+#include "evaluator/utils/utils.hpp"
+#include "evaluator/vs_node_noise_evaluators.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+
+// Relative step of the central differences of noise nodes, the step of the
+// UV is divided by the noise frequency so it stays a fraction of a cell.
+#define NOISE_DIFFERENCE_STEP 1e-3f
+
+/*************************************/
+/* Parameters                        */
+/*************************************/
+
+int get_tunable_component_count(const VisualShader::VisualShaderNode& node) noexcept {
+  switch (node.node_type_case()) {
+    case VisualShader::VisualShaderNode::kFloatConstant:
+    case VisualShader::VisualShaderNode::kValueNoise:
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+      return 1;
+    case VisualShader::VisualShaderNode::kVec2Constant:
+    case VisualShader::VisualShaderNode::kVoronoiNoise:
+      return 2;
+    case VisualShader::VisualShaderNode::kVec3Constant:
+      return 3;
+    case VisualShader::VisualShaderNode::kVec4Constant:
+    case VisualShader::VisualShaderNode::kColorConstant:
+      return 4;
+    default:
+      break;
+  }
+  return 0;
+}
+
+void get_tunable_parameters(const VisualShader& visual_shader, std::vector<TunableParameter>& parameters) noexcept {
+  parameters.clear();
+  for (int i{0}; i < visual_shader.nodes_size(); i++) {
+    const VisualShader::VisualShaderNode& node{visual_shader.nodes(i)};
+    const int component_count{get_tunable_component_count(node)};
+    for (int c{0}; c < component_count; c++) parameters.push_back({node.id(), c});
+  }
+}
+
+static const VisualShader::VisualShaderNode* find_node(const VisualShader& visual_shader,
+                                                      const int& node_id) noexcept {
+  for (int i{0}; i < visual_shader.nodes_size(); i++) {
+    if (visual_shader.nodes(i).id() == node_id) return &visual_shader.nodes(i);
+  }
+  return nullptr;
+}
+
+static float get_component(const VisualShader::VisualShaderNode& node, const int& component) noexcept {
+  switch (node.node_type_case()) {
+    case VisualShader::VisualShaderNode::kFloatConstant:
+      return node.float_constant().value();
+    case VisualShader::VisualShaderNode::kVec2Constant: {
+      const VisualShaderNodeVec2Constant& c{node.vec2_constant()};
+      return component == 0 ? c.x() : c.y();
+    }
+    case VisualShader::VisualShaderNode::kVec3Constant: {
+      const VisualShaderNodeVec3Constant& c{node.vec3_constant()};
+      return component == 0 ? c.x() : (component == 1 ? c.y() : c.z());
+    }
+    case VisualShader::VisualShaderNode::kVec4Constant: {
+      const VisualShaderNodeVec4Constant& c{node.vec4_constant()};
+      const float values[4]{c.x(), c.y(), c.z(), c.w()};
+      return values[component];
+    }
+    case VisualShader::VisualShaderNode::kColorConstant: {
+      const VisualShaderNodeColorConstant& c{node.color_constant()};
+      const float values[4]{c.r(), c.g(), c.b(), c.a()};
+      return values[component];
+    }
+    case VisualShader::VisualShaderNode::kValueNoise:
+      return node.value_noise().scale();
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+      return node.perlin_noise().scale();
+    case VisualShader::VisualShaderNode::kVoronoiNoise:
+      return component == 0 ? node.voronoi_noise().angle_offset() : node.voronoi_noise().cell_density();
+    default:
+      break;
+  }
+  return 0.0f;
+}
+
+bool get_parameter_value(const VisualShader& visual_shader, const TunableParameter& parameter, float& value) noexcept {
+  const VisualShader::VisualShaderNode* node{find_node(visual_shader, parameter.node_id)};
+  CHECK_PARAM_NULLPTR_NON_VOID(node, false, "Node id " + std::to_string(parameter.node_id) + " not found.");
+  VALIDATE_INDEX_NON_VOID(parameter.component, get_tunable_component_count(*node), false,
+                          "Invalid component of node " + std::to_string(parameter.node_id) + ".");
+
+  value = get_component(*node, parameter.component);
+
+  return true;
+}
+
+bool set_parameter_value(VisualShader& visual_shader, const TunableParameter& parameter, const float& value) noexcept {
+  VisualShader::VisualShaderNode* node{nullptr};
+  for (int i{0}; i < visual_shader.nodes_size() && !node; i++) {
+    if (visual_shader.nodes(i).id() == parameter.node_id) node = visual_shader.mutable_nodes(i);
+  }
+  CHECK_PARAM_NULLPTR_NON_VOID(node, false, "Node id " + std::to_string(parameter.node_id) + " not found.");
+  VALIDATE_INDEX_NON_VOID(parameter.component, get_tunable_component_count(*node), false,
+                          "Invalid component of node " + std::to_string(parameter.node_id) + ".");
+
+  const int& c{parameter.component};
+  switch (node->node_type_case()) {
+    case VisualShader::VisualShaderNode::kFloatConstant:
+      node->mutable_float_constant()->set_value(value);
+      break;
+    case VisualShader::VisualShaderNode::kVec2Constant:
+      c == 0 ? node->mutable_vec2_constant()->set_x(value) : node->mutable_vec2_constant()->set_y(value);
+      break;
+    case VisualShader::VisualShaderNode::kVec3Constant: {
+      VisualShaderNodeVec3Constant* v{node->mutable_vec3_constant()};
+      c == 0 ? v->set_x(value) : (c == 1 ? v->set_y(value) : v->set_z(value));
+    } break;
+    case VisualShader::VisualShaderNode::kVec4Constant: {
+      VisualShaderNodeVec4Constant* v{node->mutable_vec4_constant()};
+      c == 0 ? v->set_x(value) : (c == 1 ? v->set_y(value) : (c == 2 ? v->set_z(value) : v->set_w(value)));
+    } break;
+    case VisualShader::VisualShaderNode::kColorConstant: {
+      VisualShaderNodeColorConstant* v{node->mutable_color_constant()};
+      c == 0 ? v->set_r(value) : (c == 1 ? v->set_g(value) : (c == 2 ? v->set_b(value) : v->set_a(value)));
+    } break;
+    case VisualShader::VisualShaderNode::kValueNoise:
+      node->mutable_value_noise()->set_scale(value);
+      break;
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+      node->mutable_perlin_noise()->set_scale(value);
+      break;
+    case VisualShader::VisualShaderNode::kVoronoiNoise:
+      c == 0 ? node->mutable_voronoi_noise()->set_angle_offset(value)
+             : node->mutable_voronoi_noise()->set_cell_density(value);
+      break;
+    default:
+      break;
+  }
+
+  return true;
+}
+
+/*************************************/
+/* Derivatives                       */
+/*************************************/
+
+static inline bool is_float_type(const VisualShaderNodePortType& type) noexcept {
+  return type == VisualShaderNodePortType::PORT_TYPE_SCALAR || type == VisualShaderNodePortType::PORT_TYPE_VECTOR_2D ||
+         type == VisualShaderNodePortType::PORT_TYPE_VECTOR_3D || type == VisualShaderNodePortType::PORT_TYPE_VECTOR_4D;
+}
+
+// A zero tangent stays zero even where the partial derivative is infinite.
+static inline float chain(const float& partial, const float& tangent) noexcept {
+  return tangent == 0.0f ? 0.0f : partial * tangent;
+}
+
+static void get_float_op_partials(const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType& op, const float& a,
+                                  const float& b, float& da, float& db) noexcept {
+  da = db = 0.0f;
+  switch (op) {
+    case VisualShaderNodeFloatOp::OP_ADD:
+      da = db = 1.0f;
+      break;
+    case VisualShaderNodeFloatOp::OP_SUB:
+      da = 1.0f;
+      db = -1.0f;
+      break;
+    case VisualShaderNodeFloatOp::OP_MUL:
+      da = b;
+      db = a;
+      break;
+    case VisualShaderNodeFloatOp::OP_DIV:
+      da = 1.0f / b;
+      db = -a / (b * b);
+      break;
+    case VisualShaderNodeFloatOp::OP_MOD:
+      da = 1.0f;
+      db = -std::floor(a / b);
+      break;
+    case VisualShaderNodeFloatOp::OP_POW:
+      da = b * std::pow(a, b - 1.0f);
+      db = a > 0.0f ? std::pow(a, b) * std::log(a) : 0.0f;
+      break;
+    case VisualShaderNodeFloatOp::OP_MAX:
+      (a >= b ? da : db) = 1.0f;
+      break;
+    case VisualShaderNodeFloatOp::OP_MIN:
+      (a <= b ? da : db) = 1.0f;
+      break;
+    case VisualShaderNodeFloatOp::OP_ATAN2: {
+      const float d{a * a + b * b};
+      if (d > 0.0f) {
+        da = b / d;
+        db = -a / d;
+      }
+    } break;
+    default:
+      break;
+  }
+}
+
+static float get_float_func_derivative(const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType& func,
+                                       const float& x) noexcept {
+  switch (func) {
+    case VisualShaderNodeFloatFunc::FUNC_SIN:
+      return evaluator_utils::cos(x);
+    case VisualShaderNodeFloatFunc::FUNC_COS:
+      return -evaluator_utils::sin(x);
+    case VisualShaderNodeFloatFunc::FUNC_TAN: {
+      const float t{std::tan(x)};
+      return 1.0f + t * t;
+    }
+    case VisualShaderNodeFloatFunc::FUNC_ASIN:
+      return 1.0f / std::sqrt(1.0f - x * x);
+    case VisualShaderNodeFloatFunc::FUNC_ACOS:
+      return -1.0f / std::sqrt(1.0f - x * x);
+    case VisualShaderNodeFloatFunc::FUNC_ATAN:
+      return 1.0f / (1.0f + x * x);
+    case VisualShaderNodeFloatFunc::FUNC_SINH:
+      return std::cosh(x);
+    case VisualShaderNodeFloatFunc::FUNC_COSH:
+      return std::sinh(x);
+    case VisualShaderNodeFloatFunc::FUNC_TANH: {
+      const float t{std::tanh(x)};
+      return 1.0f - t * t;
+    }
+    case VisualShaderNodeFloatFunc::FUNC_LOG:
+      return 1.0f / x;
+    case VisualShaderNodeFloatFunc::FUNC_EXP:
+      return std::exp(x);
+    case VisualShaderNodeFloatFunc::FUNC_SQRT:
+      return 0.5f / std::sqrt(x);
+    case VisualShaderNodeFloatFunc::FUNC_ABS:
+      return evaluator_utils::sign(x);
+    case VisualShaderNodeFloatFunc::FUNC_FRACT:
+      return 1.0f;
+    case VisualShaderNodeFloatFunc::FUNC_SATURATE:
+      return x > 0.0f && x < 1.0f ? 1.0f : 0.0f;
+    case VisualShaderNodeFloatFunc::FUNC_NEGATE:
+      return -1.0f;
+    case VisualShaderNodeFloatFunc::FUNC_ACOSH:
+      return 1.0f / std::sqrt(x * x - 1.0f);
+    case VisualShaderNodeFloatFunc::FUNC_ASINH:
+      return 1.0f / std::sqrt(x * x + 1.0f);
+    case VisualShaderNodeFloatFunc::FUNC_ATANH:
+      return 1.0f / (1.0f - x * x);
+    case VisualShaderNodeFloatFunc::FUNC_DEGREES:
+      return evaluator_utils::degrees(1.0f);
+    case VisualShaderNodeFloatFunc::FUNC_EXP2:
+      return std::exp2(x) * 0.69314718055994530942f;
+    case VisualShaderNodeFloatFunc::FUNC_INVERSE_SQRT:
+      return -0.5f / (x * std::sqrt(x));
+    case VisualShaderNodeFloatFunc::FUNC_LOG2:
+      return 1.0f / (x * 0.69314718055994530942f);
+    case VisualShaderNodeFloatFunc::FUNC_RADIANS:
+      return evaluator_utils::radians(1.0f);
+    case VisualShaderNodeFloatFunc::FUNC_RECIPROCAL:
+      return -1.0f / (x * x);
+    case VisualShaderNodeFloatFunc::FUNC_ONEMINUS:
+      return -1.0f;
+    default:
+      break;
+  }
+
+  // Sign, floor, round, ceil, roundEven and trunc are piecewise constant.
+  return 0.0f;
+}
+
+// Evaluates a noise node at (u, v) with the given values of its tunable fields.
+static float evaluate_noise(const VisualShader::VisualShaderNode& node, const float& u, const float& v,
+                            const float* fields) noexcept {
+  switch (node.node_type_case()) {
+    case VisualShader::VisualShaderNode::kValueNoise:
+      return generate_value_noise_float(u, v, fields[0]);
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+      return generate_perlin_noise_float(u, v, fields[0]);
+    case VisualShader::VisualShaderNode::kVoronoiNoise:
+      return generate_voronoi_noise_float(u, v, fields[0], fields[1]);
+    default:
+      break;
+  }
+  return 0.0f;
+}
+
+// Converts tangents the same way convert_value converts the value: copied and
+// splatted components keep their tangent, injected constants and integer or
+// boolean values have none.
+static void convert_tangents(const VisualShaderNodePortType& from_type, const float* from,
+                             const VisualShaderNodePortType& to_type, const int& parameter_count,
+                             float* to) noexcept {
+  const int size{parameter_count * 4};
+
+  if (from_type == to_type || to_type == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED) {
+    std::copy(from, from + size, to);
+    return;
+  }
+
+  std::fill(to, to + size, 0.0f);
+  if (!is_float_type(from_type) || !is_float_type(to_type)) return;
+
+  const int from_count{get_port_type_component_count(from_type)};
+
+  for (int k{0}; k < parameter_count; k++) {
+    const float* f{from + k * 4};
+    float* t{to + k * 4};
+
+    if (to_type == VisualShaderNodePortType::PORT_TYPE_SCALAR) {
+      t[0] = f[0];
+    } else if (from_count == 1) {
+      t[0] = t[1] = t[2] = t[3] = f[0];
+    } else {
+      for (int c{0}; c < from_count && c < 4; c++) t[c] = f[c];
+      if (to_type == VisualShaderNodePortType::PORT_TYPE_VECTOR_4D) t[3] = 0.0f;
+    }
+  }
+}
+
+/**
+ * Computes the tangents of the outputs of a node from the tangents of its
+ * inputs, @p inputs and @p outputs are the values it was evaluated with.
+ */
+static void differentiate_node(const EvaluationNode& e_node, const Value* inputs, const Value* outputs,
+                               const float* input_tangents, const std::vector<std::pair<int, int>>& seeds,
+                               const bool& has_input_tangents, const int& parameter_count,
+                               float* output_tangents) noexcept {
+  const VisualShader::VisualShaderNode& node{*e_node.node};
+  const int& K{parameter_count};
+
+  auto in{[&](const int& port, const int& k) -> const float* { return input_tangents + (port * K + k) * 4; }};
+  auto out{[&](const int& port, const int& k) -> float* { return output_tangents + (port * K + k) * 4; }};
+
+  std::fill(output_tangents, output_tangents + e_node.output_port_types.size() * K * 4, 0.0f);
+
+  switch (node.node_type_case()) {
+    /*************************************/
+    /* CONSTANTS                         */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kFloatConstant:
+    case VisualShader::VisualShaderNode::kColorConstant:
+    case VisualShader::VisualShaderNode::kVec2Constant:
+    case VisualShader::VisualShaderNode::kVec3Constant:
+    case VisualShader::VisualShaderNode::kVec4Constant:
+      for (const std::pair<int, int>& seed : seeds) out(0, seed.second)[seed.first] = 1.0f;
+      break;
+
+    /*************************************/
+    /* OPERATORS                         */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kFloatOp: {
+      float pa, pb;
+      get_float_op_partials(node.float_op().op(), inputs[0].f[0], inputs[1].f[0], pa, pb);
+      for (int k{0}; k < K; k++) out(0, k)[0] = chain(pa, in(0, k)[0]) + chain(pb, in(1, k)[0]);
+    } break;
+    case VisualShader::VisualShaderNode::kVectorOp: {
+      const float* a{inputs[0].f};
+      const float* b{inputs[1].f};
+      const int n{get_port_type_component_count(outputs[0].type)};
+
+      switch (node.vector_op().op()) {
+        case VisualShaderNodeVectorOp::OP_CROSS:
+          if (n != 3) break;
+          for (int k{0}; k < K; k++) {
+            const float* da{in(0, k)};
+            const float* db{in(1, k)};
+            float* r{out(0, k)};
+            r[0] = da[1] * b[2] + a[1] * db[2] - db[1] * a[2] - b[1] * da[2];
+            r[1] = da[2] * b[0] + a[2] * db[0] - db[2] * a[0] - b[2] * da[0];
+            r[2] = da[0] * b[1] + a[0] * db[1] - db[0] * a[1] - b[0] * da[1];
+          }
+          break;
+        case VisualShaderNodeVectorOp::OP_REFLECT: {
+          // I - 2.0 * dot(N, I) * N
+          float d{0.0f};
+          for (int c{0}; c < n; ++c) d += b[c] * a[c];
+          for (int k{0}; k < K; k++) {
+            const float* da{in(0, k)};
+            const float* db{in(1, k)};
+            float dd{0.0f};
+            for (int c{0}; c < n; ++c) dd += db[c] * a[c] + b[c] * da[c];
+            for (int c{0}; c < n; ++c) out(0, k)[c] = da[c] - 2.0f * (dd * b[c] + d * db[c]);
+          }
+        } break;
+        default: {
+          const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType op{to_float_op(node.vector_op().op())};
+          for (int c{0}; c < n; ++c) {
+            float pa, pb;
+            get_float_op_partials(op, a[c], b[c], pa, pb);
+            for (int k{0}; k < K; k++) out(0, k)[c] = chain(pa, in(0, k)[c]) + chain(pb, in(1, k)[c]);
+          }
+        } break;
+      }
+    } break;
+
+    /*************************************/
+    /* Funcs Node                        */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kFloatFunc: {
+      const float d{get_float_func_derivative(node.float_func().func(), inputs[0].f[0])};
+      for (int k{0}; k < K; k++) out(0, k)[0] = chain(d, in(0, k)[0]);
+    } break;
+    case VisualShader::VisualShaderNode::kVectorFunc: {
+      const float* x{inputs[0].f};
+      const int n{get_port_type_component_count(outputs[0].type)};
+
+      switch (node.vector_func().func()) {
+        case VisualShaderNodeVectorFunc::FUNC_NORMALIZE: {
+          // d(x / |x|) = (dx - r * dot(r, dx)) / |x|
+          float len{0.0f};
+          for (int c{0}; c < n; ++c) len += x[c] * x[c];
+          len = std::sqrt(len);
+          if (len <= 0.0f) break;
+
+          const float* r{outputs[0].f};
+          for (int k{0}; k < K; k++) {
+            const float* dx{in(0, k)};
+            float d{0.0f};
+            for (int c{0}; c < n; ++c) d += r[c] * dx[c];
+            for (int c{0}; c < n; ++c) out(0, k)[c] = (dx[c] - r[c] * d) / len;
+          }
+        } break;
+        default: {
+          const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType func{
+              node.vector_func().func() == VisualShaderNodeVectorFunc::FUNC_SATURATE
+                  ? VisualShaderNodeFloatFunc::FUNC_SATURATE
+                  : to_float_func(node.vector_func().func())};
+          for (int c{0}; c < n; ++c) {
+            const float d{get_float_func_derivative(func, x[c])};
+            for (int k{0}; k < K; k++) out(0, k)[c] = chain(d, in(0, k)[c]);
+          }
+        } break;
+      }
+    } break;
+
+    /*************************************/
+    /* NOISE                             */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kValueNoise:
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+    case VisualShader::VisualShaderNode::kVoronoiNoise: {
+      const float u{inputs[0].f[0]}, v{inputs[0].f[1]};
+
+      float fields[2]{0.0f, 0.0f};
+      const int field_count{get_tunable_component_count(node)};
+      for (int c{0}; c < field_count; c++) fields[c] = get_component(node, c);
+
+      // The frequency is the scale, or the cell density of a voronoi noise.
+      const float frequency{std::max(1.0f, std::fabs(fields[field_count - 1]))};
+
+      if (has_input_tangents) {
+        const float h{NOISE_DIFFERENCE_STEP / frequency};
+        const float du{(evaluate_noise(node, u + h, v, fields) - evaluate_noise(node, u - h, v, fields)) / (2.0f * h)};
+        const float dv{(evaluate_noise(node, u, v + h, fields) - evaluate_noise(node, u, v - h, fields)) / (2.0f * h)};
+        for (int k{0}; k < K; k++) out(0, k)[0] = du * in(0, k)[0] + dv * in(0, k)[1];
+      }
+
+      for (const std::pair<int, int>& seed : seeds) {
+        const float h{NOISE_DIFFERENCE_STEP * std::max(1.0f, std::fabs(fields[seed.first]))};
+        float plus[2]{fields[0], fields[1]}, minus[2]{fields[0], fields[1]};
+        plus[seed.first] += h;
+        minus[seed.first] -= h;
+        out(0, seed.second)[0] += (evaluate_noise(node, u, v, plus) - evaluate_noise(node, u, v, minus)) / (2.0f * h);
+      }
+
+      // splat(noise) with an alpha of 1.0
+      for (int k{0}; k < K; k++) out(0, k)[1] = out(0, k)[2] = out(0, k)[0];
+    } break;
+
+    /*************************************/
+    /* MISC                              */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kDotProduct:
+      for (int k{0}; k < K; k++) {
+        float d{0.0f};
+        for (int c{0}; c < 3; ++c) d += in(0, k)[c] * inputs[1].f[c] + inputs[0].f[c] * in(1, k)[c];
+        out(0, k)[0] = d;
+      }
+      break;
+    case VisualShader::VisualShaderNode::kVectorLen: {
+      const float len{outputs[0].f[0]};
+      if (len <= 0.0f) break;
+
+      const int n{get_port_type_component_count(inputs[0].type)};
+      for (int k{0}; k < K; k++) {
+        float d{0.0f};
+        for (int c{0}; c < n; ++c) d += inputs[0].f[c] * in(0, k)[c];
+        out(0, k)[0] = d / len;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kVectorDistance: {
+      const float len{outputs[0].f[0]};
+      if (len <= 0.0f) break;
+
+      for (int k{0}; k < K; k++) {
+        float d{0.0f};
+        for (int c{0}; c < 3; ++c) d += (inputs[0].f[c] - inputs[1].f[c]) * (in(0, k)[c] - in(1, k)[c]);
+        out(0, k)[0] = d / len;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kClamp: {
+      if (!is_float_type(outputs[0].type)) break;
+
+      // min(max(x, min_val), max_val)
+      const int n{get_port_type_component_count(outputs[0].type)};
+      for (int c{0}; c < n; ++c) {
+        const float x{inputs[0].f[c]}, lo{inputs[1].f[c]}, hi{inputs[2].f[c]};
+        const int lower_port{x >= lo ? 0 : 1};
+        const int port{std::fmax(x, lo) <= hi ? lower_port : 2};
+        for (int k{0}; k < K; k++) out(0, k)[c] = in(port, k)[c];
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kSmoothStep:
+    case VisualShader::VisualShaderNode::kMix: {
+      if (!is_float_type(outputs[0].type)) break;
+
+      // Scalars are evaluated as splatted vectors, only the first component is used.
+      const int n{get_port_type_component_count(outputs[0].type) > 1 ? 4 : 1};
+      const bool is_mix{node.node_type_case() == VisualShader::VisualShaderNode::kMix};
+
+      for (int c{0}; c < n; ++c) {
+        const float a{inputs[0].f[c]}, b{inputs[1].f[c]}, x{inputs[2].f[c]};
+
+        if (is_mix) {
+          // x * (1.0 - a) + y * a
+          for (int k{0}; k < K; k++) {
+            out(0, k)[c] = in(0, k)[c] * (1.0f - x) + in(1, k)[c] * x + chain(b - a, in(2, k)[c]);
+          }
+          continue;
+        }
+
+        const float t{(x - a) / (b - a)};
+        if (!(t > 0.0f && t < 1.0f)) continue;
+
+        // t * t * (3.0 - 2.0 * t), t = (x - edge0) / (edge1 - edge0)
+        const float dr{6.0f * t * (1.0f - t)};
+        for (int k{0}; k < K; k++) {
+          const float dt{(in(2, k)[c] - in(0, k)[c] - t * (in(1, k)[c] - in(0, k)[c])) / (b - a)};
+          out(0, k)[c] = dr * dt;
+        }
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kVector2DCompose:
+    case VisualShader::VisualShaderNode::kVector3DCompose:
+    case VisualShader::VisualShaderNode::kVector4DCompose: {
+      const int n{(int)e_node.input_port_types.size()};
+      for (int k{0}; k < K; k++) {
+        for (int c{0}; c < n; ++c) out(0, k)[c] = in(c, k)[0];
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kVector2DDecompose:
+    case VisualShader::VisualShaderNode::kVector3DDecompose:
+    case VisualShader::VisualShaderNode::kVector4DDecompose: {
+      const int n{(int)e_node.output_port_types.size()};
+      for (int k{0}; k < K; k++) {
+        for (int c{0}; c < n; ++c) out(c, k)[0] = in(0, k)[c];
+      }
+    } break;
+
+    /*************************************/
+    /* Logic                             */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kIfNode: {
+      const float p1{inputs[0].f[0]}, p2{inputs[1].f[0]}, tolerance{inputs[2].f[0]};
+      const int port{std::fabs(p1 - p2) < tolerance ? 3 : (p1 < p2 ? 5 : 4)};
+      std::copy(in(port, 0), in(port, 0) + K * 4, out(0, 0));
+    } break;
+    case VisualShader::VisualShaderNode::kSwitchNode: {
+      if (!is_float_type(outputs[0].type)) break;
+      const int port{inputs[0].b ? 1 : 2};
+      std::copy(in(port, 0), in(port, 0) + K * 4, out(0, 0));
+    } break;
+    default:
+      // Inputs, steps, comparisons and integer nodes have a zero derivative.
+      break;
+  }
+}
+
+/*************************************/
+/* Evaluation                        */
+/*************************************/
+
+bool make_dual_evaluation_state(const EvaluationGraph& graph, const std::vector<TunableParameter>& parameters,
+                                DualEvaluationState& state) noexcept {
+  make_evaluation_state(graph, state.values);
+
+  const int node_count{(int)graph.nodes.size()};
+  state.parameter_count = (int)parameters.size();
+  state.seeds.assign(node_count, {});
+  state.tangent_offsets.assign(node_count, -1);
+
+  std::unordered_map<int, int> node_indices;
+  for (int i{0}; i < node_count; i++) node_indices[graph.nodes.at(i).id] = i;
+
+  for (int k{0}; k < state.parameter_count; k++) {
+    const TunableParameter& parameter{parameters.at(k)};
+    SILENT_CONTINUE_IF_TRUE(node_indices.find(parameter.node_id) == node_indices.end());
+
+    const int node_index{node_indices.at(parameter.node_id)};
+    VALIDATE_INDEX_NON_VOID(parameter.component, get_tunable_component_count(*graph.nodes.at(node_index).node), false,
+                            "Invalid component of node " + std::to_string(parameter.node_id) + ".");
+
+    state.seeds.at(node_index).push_back({parameter.component, k});
+  }
+
+  // A node has tangents if it is a parameter or one of its inputs has tangents.
+  int tangent_count{0};
+  size_t max_input_port_count{0};
+  for (int i{0}; i < node_count; i++) {
+    const EvaluationNode& e_node{graph.nodes.at(i)};
+    max_input_port_count = std::max(max_input_port_count, e_node.input_port_types.size());
+
+    bool is_active{!state.seeds.at(i).empty()};
+    for (const std::pair<int, int>& source : e_node.input_sources) {
+      is_active = is_active || (source.first >= 0 && state.tangent_offsets.at(source.first) >= 0);
+    }
+    if (!is_active) continue;
+
+    state.tangent_offsets.at(i) = tangent_count;
+    tangent_count += (int)e_node.output_port_types.size() * state.parameter_count * 4;
+  }
+
+  state.tangents.assign(tangent_count, 0.0f);
+  state.input_tangents.assign(max_input_port_count * state.parameter_count * 4, 0.0f);
+
+  return true;
+}
+
+Value get_input_dual_value(const EvaluationGraph& graph, const DualEvaluationState& state, const int& node_index,
+                           const int& port, float* tangents) noexcept {
+  const EvaluationNode& e_node{graph.nodes.at(node_index)};
+  const std::pair<int, int>& source{e_node.input_sources.at(port)};
+  const int size{state.parameter_count * 4};
+
+  if (source.first < 0 || state.tangent_offsets.at(source.first) < 0) {
+    std::fill(tangents, tangents + size, 0.0f);
+  } else {
+    const float* from{state.tangents.data() + state.tangent_offsets.at(source.first) + source.second * size};
+    convert_tangents(graph.nodes.at(source.first).output_port_types.at(source.second), from,
+                     e_node.input_port_types.at(port), state.parameter_count, tangents);
+  }
+
+  return get_input_value(graph, state.values, node_index, port);
+}
+
+bool evaluate_graph_dual(const EvaluationGraph& graph, const EvaluationContext& context,
+                         DualEvaluationState& state) noexcept {
+  const int node_count{(int)graph.nodes.size()};
+  const int size{state.parameter_count * 4};
+
+  for (int i{0}; i < node_count; i++) {
+    const EvaluationNode& e_node{graph.nodes.at(i)};
+    const int input_port_count{(int)e_node.input_port_types.size()};
+    const bool is_active{state.tangent_offsets.at(i) >= 0};
+
+    bool has_input_tangents{false};
+    for (int j{0}; j < input_port_count; j++) {
+      if (!is_active) {
+        state.values.inputs.at(j) = get_input_value(graph, state.values, i, j);
+        continue;
+      }
+
+      state.values.inputs.at(j) = get_input_dual_value(graph, state, i, j, state.input_tangents.data() + j * size);
+
+      const std::pair<int, int>& source{e_node.input_sources.at(j)};
+      has_input_tangents = has_input_tangents || (source.first >= 0 && state.tangent_offsets.at(source.first) >= 0);
+    }
+
+    bool status{evaluate_node(*e_node.node, state.values.inputs.data(), state.values.outputs.at(i).data(), context)};
+    CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to evaluate node " + std::to_string(e_node.id) + ".");
+
+    if (!is_active) continue;
+
+    differentiate_node(e_node, state.values.inputs.data(), state.values.outputs.at(i).data(),
+                       state.input_tangents.data(), state.seeds.at(i), has_input_tangents, state.parameter_count,
+                       state.tangents.data() + state.tangent_offsets.at(i));
+  }
+
+  return true;
+}
+
+/*************************************/
+/* Tuning                            */
+/*************************************/
+
+bool compute_loss_gradient(const VisualShader& visual_shader, const std::vector<TunableParameter>& parameters,
+                           const Image& target, float& loss, std::vector<float>& gradient) noexcept {
+  const int width{target.width}, height{target.height};
+  CHECK_CONDITION_TRUE_NON_VOID(width <= 0 || height <= 0, false, "Invalid target size.");
+
+  EvaluationGraph graph;
+  bool status{to_evaluation_graph(visual_shader, 0, graph)};
+  CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to build the evaluation graph.");
+  CHECK_CONDITION_TRUE_NON_VOID(graph.nodes.back().node->node_type_case() != VisualShader::VisualShaderNode::kOutput,
+                                false, "Node 0 is not an output node.");
+
+  const int parameter_count{(int)parameters.size()};
+  const int root_index{(int)graph.nodes.size() - 1};
+
+  evaluator_utils::ThreadPool& pool{evaluator_utils::get_thread_pool()};
+
+  // Each thread accumulates its rows, the sums are reduced once at the end.
+  struct ThreadSums {
+    DualEvaluationState state;
+    std::vector<float> tangents;
+    double loss{0.0};
+    std::vector<double> gradient;
+  };
+
+  std::vector<ThreadSums> thread_sums(pool.get_thread_count());
+  for (ThreadSums& sums : thread_sums) {
+    status = make_dual_evaluation_state(graph, parameters, sums.state);
+    CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to create the evaluation state.");
+    sums.tangents.resize(parameter_count * 4);
+    sums.gradient.assign(parameter_count, 0.0);
+  }
+
+  std::atomic<bool> failed{false};
+
+  pool.run(height, [&](const int& y, const int& thread_index) {
+    if (failed.load(std::memory_order_relaxed)) return;
+
+    ThreadSums& sums{thread_sums.at(thread_index)};
+
+    EvaluationContext context;
+    context.uv[1] = 1.0f - (float(y) + 0.5f) / float(height);
+
+    for (int x{0}; x < width; x++) {
+      context.uv[0] = (float(x) + 0.5f) / float(width);
+
+      if (!evaluate_graph_dual(graph, context, sums.state)) {
+        failed = true;
+        return;
+      }
+
+      const Value value{get_input_dual_value(graph, sums.state, root_index, 0, sums.tangents.data())};
+      const float* pixel{target.at(x, y)};
+
+      for (int c{0}; c < 3; c++) {
+        const float error{value.f[c] - pixel[c]};
+        sums.loss += (double)(error * error);
+        for (int k{0}; k < parameter_count; k++) {
+          sums.gradient[k] += (double)(2.0f * error * sums.tangents[k * 4 + c]);
+        }
+      }
+    }
+  });
+
+  CHECK_CONDITION_TRUE_NON_VOID(failed, false, "Failed to evaluate the graph.");
+
+  const double count{(double)(width * height * 3)};
+
+  double total_loss{0.0};
+  gradient.assign(parameter_count, 0.0f);
+  std::vector<double> total_gradient(parameter_count, 0.0);
+  for (const ThreadSums& sums : thread_sums) {
+    total_loss += sums.loss;
+    for (int k{0}; k < parameter_count; k++) total_gradient[k] += sums.gradient[k];
+  }
+
+  loss = (float)(total_loss / count);
+  for (int k{0}; k < parameter_count; k++) gradient[k] = (float)(total_gradient[k] / count);
+
+  return true;
+}
+
+bool tune_parameters(VisualShader& visual_shader, const std::vector<TunableParameter>& parameters,
+                     const Image& target, const ParameterTuningOptions& options, float& loss) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(options.image_size <= 0, false, "Invalid image size.");
+
+  const int parameter_count{(int)parameters.size()};
+
+  Image scaled_target;
+  resize_image(target, options.image_size, options.image_size, scaled_target);
+
+  std::vector<float> values(parameter_count), best_values(parameter_count), steps(parameter_count);
+  for (int k{0}; k < parameter_count; k++) {
+    bool status{get_parameter_value(visual_shader, parameters.at(k), values[k])};
+    CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to read parameter " + std::to_string(k) + ".");
+
+    // Steps are relative to the magnitude of each parameter, so colors and
+    // noise scales move at comparable rates.
+    steps[k] = options.learning_rate * std::max(1.0f, std::fabs(values[k]));
+  }
+
+  std::vector<float> m(parameter_count, 0.0f), v(parameter_count, 0.0f), gradient;
+  float beta1_power{1.0f}, beta2_power{1.0f};
+
+  loss = std::numeric_limits<float>::infinity();
+
+  for (int i{0}; i <= options.iteration_count; i++) {
+    float current_loss{0.0f};
+    bool status{compute_loss_gradient(visual_shader, parameters, scaled_target, current_loss, gradient)};
+    CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to compute the gradient.");
+
+    if (current_loss < loss) {
+      loss = current_loss;
+      best_values = values;
+    }
+
+    if (i == options.iteration_count) break;
+
+    beta1_power *= options.beta1;
+    beta2_power *= options.beta2;
+
+    for (int k{0}; k < parameter_count; k++) {
+      SILENT_CONTINUE_IF_TRUE(!std::isfinite(gradient[k]));
+
+      m[k] = options.beta1 * m[k] + (1.0f - options.beta1) * gradient[k];
+      v[k] = options.beta2 * v[k] + (1.0f - options.beta2) * gradient[k] * gradient[k];
+
+      const float m_hat{m[k] / (1.0f - beta1_power)}, v_hat{v[k] / (1.0f - beta2_power)};
+      values[k] -= steps[k] * m_hat / (std::sqrt(v_hat) + 1e-8f);
+      set_parameter_value(visual_shader, parameters.at(k), values[k]);
+    }
+  }
+
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!std::isfinite(loss), false);
+
+  for (int k{0}; k < parameter_count; k++) set_parameter_value(visual_shader, parameters.at(k), best_values[k]);
+
+  return true;
+}
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,159 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_AUTODIFF_HPP
+#define ENIGMA_VISUAL_SHADER_AUTODIFF_HPP
+
+#include <utility>
+#include <vector>
+
+#include "evaluator/image.hpp"
+#include "evaluator/visual_shader_evaluator.hpp"
+
+/**
+ * @brief Forward-mode differentiation of the CPU reference evaluator with
+ *        respect to the constants of a graph, and a gradient descent that
+ *        tunes them against a target image without changing the topology.
+ *
+ * Each port carries, next to its value, one tangent per tuned parameter
+ * (a dual number). Tangents are only propagated through the nodes a
+ * parameter reaches, so the cost of a gradient evaluation grows with the
+ * number of parameters and the size of their downstream subgraph, not with
+ * the size of the whole graph.
+ */
+namespace shadergen_visual_shader_evaluator {
+/**
+ * @brief A scalar field of a node that can be tuned: a component of a
+ *        FloatConstant, Vec*Constant or ColorConstant (x, y, z, w or r, g, b, a),
+ *        the scale of a value or perlin noise, or the angle offset (0) and
+ *        cell density (1) of a voronoi noise.
+ */
+struct TunableParameter {
+  int node_id{-1};
+  int component{0};
+};
+
+/**
+ * @brief Returns the number of tunable fields of a node, 0 if it has none.
+ */
+int get_tunable_component_count(const VisualShader::VisualShaderNode& node) noexcept;
+
+/**
+ * @brief Lists all tunable fields of the nodes of @p visual_shader, in node order.
+ */
+void get_tunable_parameters(const VisualShader& visual_shader, std::vector<TunableParameter>& parameters) noexcept;
+
+bool get_parameter_value(const VisualShader& visual_shader, const TunableParameter& parameter, float& value) noexcept;
+
+bool set_parameter_value(VisualShader& visual_shader, const TunableParameter& parameter, const float& value) noexcept;
+
+/**
+ * @brief Scratch values and tangents of a dual evaluation, reused across pixels.
+ *
+ * Tangents of a port are stored as 4 components per parameter.
+ */
+struct DualEvaluationState {
+  EvaluationState values;
+  int parameter_count{0};
+
+  /**
+   * @brief For each node, the offset of the tangents of its first output port
+   *        in @c tangents, or -1 if no parameter reaches the node.
+   */
+  std::vector<int> tangent_offsets;
+
+  /**
+   * @brief For each node, the (component, parameter index) pairs it seeds.
+   */
+  std::vector<std::vector<std::pair<int, int>>> seeds;
+
+  std::vector<float> tangents;
+  std::vector<float> input_tangents;
+};
+
+/**
+ * @brief Prepares @p state to differentiate @p graph with respect to
+ *        @p parameters. Parameters of nodes that are not in the graph get a
+ *        zero gradient.
+ */
+bool make_dual_evaluation_state(const EvaluationGraph& graph, const std::vector<TunableParameter>& parameters,
+                                DualEvaluationState& state) noexcept;
+
+/**
+ * @brief Evaluates the graph for a single pixel along with the derivatives of
+ *        every port with respect to the parameters.
+ *
+ * Derivatives are exact for arithmetic, functions, mix, clamp and vector
+ * nodes. Noise nodes are differentiated with central differences around the
+ * evaluated point. Comparisons, steps and integer values have a zero
+ * derivative, conditionals differentiate the selected branch.
+ */
+bool evaluate_graph_dual(const EvaluationGraph& graph, const EvaluationContext& context,
+                         DualEvaluationState& state) noexcept;
+
+/**
+ * @brief Same as @c get_input_value, @p tangents receives 4 components per
+ *        parameter.
+ */
+Value get_input_dual_value(const EvaluationGraph& graph, const DualEvaluationState& state, const int& node_index,
+                           const int& port, float* tangents) noexcept;
+
+/**
+ * @brief Renders the output node (id 0) at the size of @p target and returns
+ *        the MSE against it (see @c compute_mse) and its gradient with
+ *        respect to @p parameters.
+ */
+bool compute_loss_gradient(const VisualShader& visual_shader, const std::vector<TunableParameter>& parameters,
+                           const Image& target, float& loss, std::vector<float>& gradient) noexcept;
+
+struct ParameterTuningOptions {
+  int iteration_count{100};
+
+  /**
+   * @brief Adam step size and decay rates of the moment estimates.
+   */
+  float learning_rate{0.02f};
+  float beta1{0.9f};
+  float beta2{0.999f};
+
+  /**
+   * @brief The target is downscaled to this size and the loss computed on it.
+   */
+  int image_size{32};
+};
+
+/**
+ * @brief Tunes @p parameters of @p visual_shader with Adam to minimize the
+ *        MSE against @p target. The graph is left with the best values found.
+ *
+ * @param loss The loss of the best values found.
+ */
+bool tune_parameters(VisualShader& visual_shader, const std::vector<TunableParameter>& parameters,
+                     const Image& target, const ParameterTuningOptions& options, float& loss) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_AUTODIFF_HPP
@@ -0,0 +1,693 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/visual_shader_compiler.hpp"
+
+#include <algorithm>
+#include <map>
+
+#include "byte_utils.hpp"
+#include "error_macros.hpp"
+#include "evaluator/simd/batch_kernels.hpp"
+
+#define BATCH_SIZE SHADER_GEN_EVALUATOR_BATCH_SIZE
+
+namespace shadergen_visual_shader_evaluator {
+
+/*************************************/
+/* Key                               */
+/*************************************/
+
+template <typename T>
+static inline void append_bytes(std::string& key, const T& value) noexcept {
+  key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+std::string get_program_key(const EvaluationGraph& graph) noexcept {
+  std::string key;
+
+  for (const EvaluationNode& e_node : graph.nodes) {
+    const google::protobuf::FieldDescriptor* oneof_field{
+        VisualShader::VisualShaderNode::descriptor()->FindFieldByNumber(e_node.node->node_type_case())};
+    CHECK_PARAM_NULLPTR_NON_VOID(oneof_field, std::string(), "Node type is not set.");
+
+    const std::string payload{
+        e_node.node->GetReflection()->GetMessage(*e_node.node, oneof_field).SerializeAsString()};
+
+    append_bytes(key, (int32_t)oneof_field->number());
+    append_bytes(key, (uint32_t)payload.size());
+    key += payload;
+
+    for (const std::pair<int, int>& source : e_node.input_sources) {
+      append_bytes(key, (int32_t)source.first);
+      append_bytes(key, (int32_t)source.second);
+    }
+  }
+
+  return key;
+}
+
+/*************************************/
+/* Compilation                       */
+/*************************************/
+
+namespace {
+class RegisterAllocator {
+ public:
+  explicit RegisterAllocator(Program& program) : program(program) {}
+
+  int allocate(const VisualShaderNodePortType& type) noexcept {
+    std::vector<int>& free_list{free_registers[type]};
+    if (!free_list.empty()) {
+      const int r{free_list.back()};
+      free_list.pop_back();
+      return r;
+    }
+
+    return allocate_new(type);
+  }
+
+  /**
+   * @brief Constant registers are never recycled.
+   */
+  int allocate_constant(const VisualShaderNodePortType& type) noexcept {
+    const int r{allocate_new(type)};
+    constant_registers.resize(program.registers.size(), false);
+    constant_registers.at(r) = true;
+    return r;
+  }
+
+  int get_zero_constant(const VisualShaderNodePortType& type) noexcept {
+    auto it{zero_constants.find(type)};
+    if (it != zero_constants.end()) return it->second;
+
+    const int r{allocate_constant(type)};
+    zero_constants[type] = r;
+    return r;
+  }
+
+  /**
+   * @brief A scalar constant register holding @p value, for the slots of
+   *        missing components.
+   */
+  int get_scalar_constant(const float& value) noexcept {
+    auto it{scalar_constants.find(value)};
+    if (it != scalar_constants.end()) return it->second;
+
+    const int r{allocate_constant(VisualShaderNodePortType::PORT_TYPE_SCALAR)};
+    for (float& x : program.registers.at(r).f[0]) x = value;
+    scalar_constants[value] = r;
+    return r;
+  }
+
+  bool is_constant(const int& r) const noexcept {
+    return r < (int)constant_registers.size() && constant_registers.at(r);
+  }
+
+  void release(const int& r) noexcept {
+    if (is_constant(r)) return;
+    free_registers[program.registers.at(r).type].push_back(r);
+  }
+
+ private:
+  Program& program;
+
+  std::map<VisualShaderNodePortType, std::vector<int>> free_registers;
+  std::map<VisualShaderNodePortType, int> zero_constants;
+  std::map<float, int> scalar_constants;
+  std::vector<bool> constant_registers;
+
+  int allocate_new(const VisualShaderNodePortType& type) noexcept {
+    program.registers.emplace_back();
+    make_zero_batch_value(type, program.registers.back());
+    return (int)program.registers.size() - 1;
+  }
+};
+
+/*************************************/
+/* Lowering                          */
+/*************************************/
+
+bool can_lower_node(const EvaluationNode& e_node) noexcept {
+  for (const VisualShaderNodePortType& type : e_node.input_port_types) {
+    if (!is_float_port_type(type)) return false;
+  }
+  for (const VisualShaderNodePortType& type : e_node.output_port_types) {
+    if (!is_float_port_type(type)) return false;
+  }
+
+  const VisualShader::VisualShaderNode& node{*e_node.node};
+
+  switch (node.node_type_case()) {
+    case VisualShader::VisualShaderNode::kInput:
+      return node.input().type() == VisualShaderNodeInputType::INPUT_TYPE_UV ||
+             node.input().type() == VisualShaderNodeInputType::INPUT_TYPE_TIME;
+    case VisualShader::VisualShaderNode::kVectorOp:
+      return node.vector_op().op() != VisualShaderNodeVectorOp::OP_CROSS &&
+             node.vector_op().op() != VisualShaderNodeVectorOp::OP_REFLECT;
+    case VisualShader::VisualShaderNode::kVectorFunc:
+      return node.vector_func().func() != VisualShaderNodeVectorFunc::FUNC_NORMALIZE &&
+             node.vector_func().func() != VisualShaderNodeVectorFunc::FUNC_SATURATE;
+    case VisualShader::VisualShaderNode::kFloatOp:
+    case VisualShader::VisualShaderNode::kFloatFunc:
+    case VisualShader::VisualShaderNode::kValueNoise:
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+    case VisualShader::VisualShaderNode::kVoronoiNoise:
+    case VisualShader::VisualShaderNode::kClamp:
+    case VisualShader::VisualShaderNode::kStep:
+    case VisualShader::VisualShaderNode::kSmoothStep:
+    case VisualShader::VisualShaderNode::kMix:
+    case VisualShader::VisualShaderNode::kVector2DCompose:
+    case VisualShader::VisualShaderNode::kVector3DCompose:
+    case VisualShader::VisualShaderNode::kVector4DCompose:
+    case VisualShader::VisualShaderNode::kVector2DDecompose:
+    case VisualShader::VisualShaderNode::kVector3DDecompose:
+    case VisualShader::VisualShaderNode::kVector4DDecompose:
+      return true;
+    default:
+      break;
+  }
+
+  return false;
+}
+
+/**
+ * @brief The slot version of @c convert_batch_value between floating point
+ *        types: fills @p slots with the slots of the 4 components of
+ *        register @p r converted to @p to_type.
+ */
+void get_converted_slots(const int& r, const VisualShaderNodePortType& to_type, RegisterAllocator& allocator,
+                         const Program& program, int* slots) noexcept {
+  const VisualShaderNodePortType from_type{program.registers.at(r).type};
+  const int from_count{get_port_type_component_count(from_type)};
+
+  for (int c{0}; c < 4; c++) {
+    if (from_type == to_type || c < from_count) {
+      slots[c] = to_slot(r, c);
+    } else if (from_count == 1) {
+      slots[c] = to_slot(r, 0);  // Splat
+    } else if (to_type == VisualShaderNodePortType::PORT_TYPE_VECTOR_4D && c == 3) {
+      slots[c] = to_slot(allocator.get_scalar_constant(1.0f), 0);  // vec4(v2, 0.0, 1.0) and vec4(v3, 1.0)
+    } else {
+      slots[c] = to_slot(allocator.get_scalar_constant(0.0f), 0);
+    }
+  }
+}
+
+void emit(Program& program, const OpCode& opcode, const int& result, const std::initializer_list<int>& operands,
+          const int& function = 0) noexcept {
+  Instruction instruction;
+  instruction.opcode = opcode;
+  instruction.function = function;
+  instruction.input_count = (int)operands.size();
+  instruction.output_count = 1;
+  std::copy(operands.begin(), operands.end(), instruction.inputs);
+  instruction.outputs[0] = result;
+  program.instructions.push_back(instruction);
+}
+
+void emit_float_op(Program& program, const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType& op, const int& a,
+                   const int& b, const int& result) noexcept {
+  switch (op) {
+    case VisualShaderNodeFloatOp::OP_ADD:
+      emit(program, OpCode::ADD, result, {a, b});
+      break;
+    case VisualShaderNodeFloatOp::OP_SUB:
+      emit(program, OpCode::SUB, result, {a, b});
+      break;
+    case VisualShaderNodeFloatOp::OP_MUL:
+      emit(program, OpCode::MUL, result, {a, b});
+      break;
+    case VisualShaderNodeFloatOp::OP_DIV:
+      emit(program, OpCode::DIV, result, {a, b});
+      break;
+    default:
+      emit(program, OpCode::FLOAT_OP, result, {a, b}, op);
+      break;
+  }
+}
+
+/**
+ * @brief Emits the primitive operations of a node accepted by
+ *        @c can_lower_node, the same computation as @c evaluate_node_batch.
+ *
+ * @param input_slots The 4 component slots of each input port, converted.
+ * @param output_registers The register of each output port.
+ */
+void lower_node(const VisualShader::VisualShaderNode& node, const int (*input_slots)[4],
+                const std::vector<int>& output_registers, RegisterAllocator& allocator, Program& program) noexcept {
+  const int r{output_registers.at(0)};
+  const int n{get_port_type_component_count(program.registers.at(r).type)};
+
+  switch (node.node_type_case()) {
+    case VisualShader::VisualShaderNode::kInput:
+      if (node.input().type() == VisualShaderNodeInputType::INPUT_TYPE_UV) {
+        emit(program, OpCode::LOAD_UV, to_slot(r, 0), {}, 0);
+        emit(program, OpCode::LOAD_UV, to_slot(r, 1), {}, 1);
+      } else {
+        emit(program, OpCode::LOAD_TIME, to_slot(r, 0), {});
+      }
+      break;
+    case VisualShader::VisualShaderNode::kFloatOp:
+      emit_float_op(program, node.float_op().op(), input_slots[0][0], input_slots[1][0], to_slot(r, 0));
+      break;
+    case VisualShader::VisualShaderNode::kVectorOp:
+      for (int c{0}; c < n; c++) {
+        emit_float_op(program, to_float_op(node.vector_op().op()), input_slots[0][c], input_slots[1][c],
+                      to_slot(r, c));
+      }
+      break;
+    case VisualShader::VisualShaderNode::kFloatFunc:
+      emit(program, OpCode::FLOAT_FUNC, to_slot(r, 0), {input_slots[0][0]}, node.float_func().func());
+      break;
+    case VisualShader::VisualShaderNode::kVectorFunc:
+      for (int c{0}; c < n; c++) {
+        emit(program, OpCode::FLOAT_FUNC, to_slot(r, c), {input_slots[0][c]},
+             to_float_func(node.vector_func().func()));
+      }
+      break;
+    case VisualShader::VisualShaderNode::kValueNoise:
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+    case VisualShader::VisualShaderNode::kVoronoiNoise: {
+      Instruction instruction;
+      instruction.input_count = 2;
+      instruction.output_count = 1;
+      instruction.inputs[0] = input_slots[0][0];
+      instruction.inputs[1] = input_slots[0][1];
+      instruction.outputs[0] = to_slot(r, 0);
+
+      switch (node.node_type_case()) {
+        case VisualShader::VisualShaderNode::kValueNoise:
+          instruction.opcode = OpCode::VALUE_NOISE;
+          instruction.parameters[0] = node.value_noise().scale();
+          break;
+        case VisualShader::VisualShaderNode::kPerlinNoise:
+          instruction.opcode = OpCode::PERLIN_NOISE;
+          instruction.parameters[0] = node.perlin_noise().scale();
+          break;
+        default:
+          instruction.opcode = OpCode::VORONOI_NOISE;
+          instruction.parameters[0] = node.voronoi_noise().angle_offset();
+          instruction.parameters[1] = node.voronoi_noise().cell_density();
+          break;
+      }
+      program.instructions.push_back(instruction);
+
+      emit(program, OpCode::COPY, to_slot(r, 1), {to_slot(r, 0)});
+      emit(program, OpCode::COPY, to_slot(r, 2), {to_slot(r, 0)});
+      emit(program, OpCode::COPY, to_slot(r, 3), {to_slot(allocator.get_scalar_constant(1.0f), 0)});
+    } break;
+    case VisualShader::VisualShaderNode::kClamp:
+    case VisualShader::VisualShaderNode::kStep:
+    case VisualShader::VisualShaderNode::kSmoothStep:
+    case VisualShader::VisualShaderNode::kMix:
+      for (int c{0}; c < n; c++) {
+        switch (node.node_type_case()) {
+          case VisualShader::VisualShaderNode::kClamp:
+            emit(program, OpCode::CLAMP, to_slot(r, c), {input_slots[0][c], input_slots[1][c], input_slots[2][c]});
+            break;
+          case VisualShader::VisualShaderNode::kStep:
+            emit(program, OpCode::FLOAT_OP, to_slot(r, c), {input_slots[0][c], input_slots[1][c]},
+                 VisualShaderNodeFloatOp::OP_STEP);
+            break;
+          case VisualShader::VisualShaderNode::kSmoothStep:
+            emit(program, OpCode::SMOOTHSTEP, to_slot(r, c),
+                 {input_slots[0][c], input_slots[1][c], input_slots[2][c]});
+            break;
+          default:
+            emit(program, OpCode::MIX, to_slot(r, c), {input_slots[0][c], input_slots[1][c], input_slots[2][c]});
+            break;
+        }
+      }
+      break;
+    case VisualShader::VisualShaderNode::kVector2DCompose:
+    case VisualShader::VisualShaderNode::kVector3DCompose:
+    case VisualShader::VisualShaderNode::kVector4DCompose:
+      for (int c{0}; c < n; c++) emit(program, OpCode::COPY, to_slot(r, c), {input_slots[c][0]});
+      break;
+    case VisualShader::VisualShaderNode::kVector2DDecompose:
+    case VisualShader::VisualShaderNode::kVector3DDecompose:
+    case VisualShader::VisualShaderNode::kVector4DDecompose:
+      for (int c{0}; c < (int)output_registers.size(); c++) {
+        emit(program, OpCode::COPY, to_slot(output_registers.at(c), 0), {input_slots[0][c]});
+      }
+      break;
+    default:
+      break;
+  }
+}
+}  // namespace
+
+bool compile_program(const EvaluationGraph& graph, Program& program) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(graph.nodes.empty(), false, "Empty graph.");
+
+  program = Program();
+  program.key = get_program_key(graph);
+
+  const int node_count{(int)graph.nodes.size()};
+  const int root_index{node_count - 1};
+
+  // Last node reading each output, -1 if none. The root's ports stay alive
+  // until the end of the program.
+  std::vector<std::vector<int>> last_uses(node_count);
+  for (int i{0}; i < node_count; i++) {
+    last_uses.at(i).assign(graph.nodes.at(i).output_port_types.size(), -1);
+  }
+  for (int i{0}; i < node_count; i++) {
+    for (const std::pair<int, int>& source : graph.nodes.at(i).input_sources) {
+      if (source.first >= 0) last_uses.at(source.first).at(source.second) = i;
+    }
+  }
+
+  RegisterAllocator allocator{program};
+  std::vector<std::vector<int>> output_registers(node_count);
+
+  BatchEvaluationContext constant_context;
+
+  // Releases the inputs of node i read for the last time and its outputs
+  // nobody reads.
+  auto release_registers{[&](const int& i) {
+    for (const std::pair<int, int>& source : graph.nodes.at(i).input_sources) {
+      if (source.first < 0 || last_uses.at(source.first).at(source.second) != i) continue;
+
+      // Release once even if the same output feeds several ports.
+      last_uses.at(source.first).at(source.second) = -2;
+      allocator.release(output_registers.at(source.first).at(source.second));
+    }
+
+    for (int j{0}; j < (int)output_registers.at(i).size(); j++) {
+      if (last_uses.at(i).at(j) == -1) allocator.release(output_registers.at(i).at(j));  // Never read.
+    }
+  }};
+
+  for (int i{0}; i < node_count; i++) {
+    const EvaluationNode& e_node{graph.nodes.at(i)};
+    const bool is_root{i == root_index};
+
+    const int input_port_count{(int)e_node.input_port_types.size()};
+    const int output_port_count{(int)e_node.output_port_types.size()};
+    CHECK_CONDITION_TRUE_NON_VOID(input_port_count > SHADER_GEN_EVALUATOR_MAX_PORT_COUNT ||
+                                      output_port_count > SHADER_GEN_EVALUATOR_MAX_PORT_COUNT,
+                                  false, "Too many ports.");
+
+    // Inputs that are not connected read zero constants.
+    bool is_constant{e_node.node->node_type_case() != VisualShader::VisualShaderNode::kInput};
+    bool is_lowered{!is_root && can_lower_node(e_node)};
+    for (const std::pair<int, int>& source : e_node.input_sources) {
+      if (source.first < 0) continue;
+
+      const int from_register{output_registers.at(source.first).at(source.second)};
+      is_constant = is_constant && allocator.is_constant(from_register);
+      is_lowered = is_lowered && is_float_port_type(program.registers.at(from_register).type);
+    }
+
+    if (is_lowered && !is_constant) {
+      int input_slots[SHADER_GEN_EVALUATOR_MAX_PORT_COUNT][4];
+      for (int j{0}; j < input_port_count; j++) {
+        const std::pair<int, int>& source{e_node.input_sources.at(j)};
+        const VisualShaderNodePortType& to_type{e_node.input_port_types.at(j)};
+        const int from_register{source.first < 0 ? allocator.get_zero_constant(to_type)
+                                                 : output_registers.at(source.first).at(source.second)};
+        get_converted_slots(from_register, to_type, allocator, program, input_slots[j]);
+      }
+
+      output_registers.at(i).resize(output_port_count);
+      for (int j{0}; j < output_port_count; j++) {
+        output_registers.at(i).at(j) = allocator.allocate(e_node.output_port_types.at(j));
+      }
+
+      lower_node(*e_node.node, input_slots, output_registers.at(i), allocator, program);
+      release_registers(i);
+      continue;
+    }
+
+    Instruction instruction;
+    instruction.opcode = OpCode::EVALUATE_NODE;
+    instruction.node_index = (int)program.nodes.size();
+    instruction.input_count = input_port_count;
+    instruction.output_count = output_port_count;
+
+    std::vector<int> temporaries;
+
+    for (int j{0}; j < input_port_count; j++) {
+      const std::pair<int, int>& source{e_node.input_sources.at(j)};
+      const VisualShaderNodePortType& to_type{e_node.input_port_types.at(j)};
+
+      if (source.first < 0) {
+        instruction.inputs[j] = allocator.get_zero_constant(to_type);
+        continue;
+      }
+
+      const int from_register{output_registers.at(source.first).at(source.second)};
+      const VisualShaderNodePortType from_type{program.registers.at(from_register).type};
+
+      if (from_type == to_type) {
+        instruction.inputs[j] = from_register;
+      } else if (allocator.is_constant(from_register)) {
+        // Fold the conversion of constants.
+        const int r{allocator.allocate_constant(to_type)};
+        convert_batch_value(program.registers.at(from_register), to_type, program.registers.at(r));
+        instruction.inputs[j] = r;
+      } else {
+        Instruction convert;
+        convert.opcode = OpCode::CONVERT;
+        convert.type = to_type;
+        convert.input_count = 1;
+        convert.output_count = 1;
+        convert.inputs[0] = from_register;
+        convert.outputs[0] = allocator.allocate(to_type);
+        program.instructions.push_back(convert);
+
+        instruction.inputs[j] = convert.outputs[0];
+        if (!is_root) temporaries.push_back(convert.outputs[0]);
+      }
+    }
+
+    // Outputs are allocated before the inputs are released so that a node
+    // never writes into a register it reads.
+    output_registers.at(i).resize(output_port_count);
+    for (int j{0}; j < output_port_count; j++) {
+      const VisualShaderNodePortType& type{e_node.output_port_types.at(j)};
+      instruction.outputs[j] = is_constant ? allocator.allocate_constant(type) : allocator.allocate(type);
+      output_registers.at(i).at(j) = instruction.outputs[j];
+    }
+
+    if (is_constant) {
+      const BatchValue* inputs[SHADER_GEN_EVALUATOR_MAX_PORT_COUNT];
+      BatchValue* outputs[SHADER_GEN_EVALUATOR_MAX_PORT_COUNT];
+      for (int j{0}; j < input_port_count; j++) inputs[j] = &program.registers.at(instruction.inputs[j]);
+      for (int j{0}; j < output_port_count; j++) outputs[j] = &program.registers.at(instruction.outputs[j]);
+
+      bool status{evaluate_node_batch(*e_node.node, inputs, input_port_count, outputs, output_port_count,
+                                      constant_context)};
+      CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to fold node " + std::to_string(e_node.id) + ".");
+    } else if (e_node.node->node_type_case() != VisualShader::VisualShaderNode::kOutput) {
+      program.nodes.push_back(*e_node.node);
+      program.instructions.push_back(instruction);
+    }
+
+    if (is_root) {
+      program.root_input_registers.assign(instruction.inputs, instruction.inputs + input_port_count);
+      program.root_output_registers.assign(instruction.outputs, instruction.outputs + output_port_count);
+      break;
+    }
+
+    for (const int& r : temporaries) allocator.release(r);
+    release_registers(i);
+  }
+
+  return true;
+}
+
+bool compile_program(const VisualShader& visual_shader, const int& root_node_id, Program& program) noexcept {
+  EvaluationGraph graph;
+  bool status{to_evaluation_graph(visual_shader, root_node_id, graph)};
+  CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to build the evaluation graph.");
+
+  return compile_program(graph, program);
+}
+
+/*************************************/
+/* Execution                         */
+/*************************************/
+
+void make_program_state(const Program& program, ProgramState& state) noexcept {
+  state.registers = program.registers;
+  state.inputs.resize(SHADER_GEN_EVALUATOR_MAX_PORT_COUNT);
+  state.outputs.resize(SHADER_GEN_EVALUATOR_MAX_PORT_COUNT);
+}
+
+template <typename F>
+static inline void apply_binary(BatchValue* registers, const Instruction& instruction, F f) noexcept {
+  const float* a{get_slot(registers, instruction.inputs[0])};
+  const float* b{get_slot(registers, instruction.inputs[1])};
+  float* r{get_slot(registers, instruction.outputs[0])};
+  for (int l{0}; l < BATCH_SIZE; l++) r[l] = f(a[l], b[l]);
+}
+
+bool execute_program(const Program& program, const BatchEvaluationContext& context, ProgramState& state) noexcept {
+  const BatchKernels& kernels{get_batch_kernels()};
+
+  BatchValue* registers{state.registers.data()};
+  const BatchValue** inputs{state.inputs.data()};
+  BatchValue** outputs{state.outputs.data()};
+
+  for (const Instruction& instruction : program.instructions) {
+    // Operand and result slots of the primitive operations.
+    auto slot{[&](const int& j) { return get_slot(registers, instruction.inputs[j]); }};
+    auto result{[&]() { return get_slot(registers, instruction.outputs[0]); }};
+
+    switch (instruction.opcode) {
+      case OpCode::CONVERT:
+        convert_batch_value(registers[instruction.inputs[0]], instruction.type, registers[instruction.outputs[0]]);
+        break;
+      case OpCode::EVALUATE_NODE: {
+        for (int j{0}; j < instruction.input_count; j++) inputs[j] = &registers[instruction.inputs[j]];
+        for (int j{0}; j < instruction.output_count; j++) outputs[j] = &registers[instruction.outputs[j]];
+
+        bool status{evaluate_node_batch(program.nodes[instruction.node_index], inputs, instruction.input_count,
+                                        outputs, instruction.output_count, context)};
+        CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to execute instruction.");
+      } break;
+      case OpCode::LOAD_UV:
+        std::copy(context.uv[instruction.function], context.uv[instruction.function] + BATCH_SIZE, result());
+        break;
+      case OpCode::LOAD_TIME:
+        std::fill(result(), result() + BATCH_SIZE, context.time);
+        break;
+      case OpCode::COPY:
+        std::copy(slot(0), slot(0) + BATCH_SIZE, result());
+        break;
+      case OpCode::ADD:
+        apply_binary(registers, instruction, [](const float& a, const float& b) { return a + b; });
+        break;
+      case OpCode::SUB:
+        apply_binary(registers, instruction, [](const float& a, const float& b) { return a - b; });
+        break;
+      case OpCode::MUL:
+        apply_binary(registers, instruction, [](const float& a, const float& b) { return a * b; });
+        break;
+      case OpCode::DIV:
+        apply_binary(registers, instruction, [](const float& a, const float& b) { return a / b; });
+        break;
+      case OpCode::FLOAT_OP:
+        kernels.float_op(static_cast<VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType>(instruction.function),
+                         slot(0), slot(1), result(), BATCH_SIZE);
+        break;
+      case OpCode::FLOAT_FUNC:
+        kernels.float_func(static_cast<VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType>(instruction.function),
+                           slot(0), result(), BATCH_SIZE);
+        break;
+      case OpCode::CLAMP:
+        kernels.clamp(slot(0), slot(1), slot(2), result(), BATCH_SIZE);
+        break;
+      case OpCode::MIX:
+        kernels.mix(slot(0), slot(1), slot(2), result(), BATCH_SIZE);
+        break;
+      case OpCode::SMOOTHSTEP:
+        kernels.smoothstep(slot(0), slot(1), slot(2), result(), BATCH_SIZE);
+        break;
+      case OpCode::VALUE_NOISE:
+        kernels.value_noise(slot(0), slot(1), instruction.parameters[0], result(), BATCH_SIZE);
+        break;
+      case OpCode::PERLIN_NOISE:
+        kernels.perlin_noise(slot(0), slot(1), instruction.parameters[0], result(), BATCH_SIZE);
+        break;
+      case OpCode::VORONOI_NOISE:
+        kernels.voronoi_noise(slot(0), slot(1), instruction.parameters[0], instruction.parameters[1], result(),
+                              BATCH_SIZE);
+        break;
+      default:
+        FAIL_AND_RETURN_NON_VOID(false, "Invalid opcode.");
+    }
+  }
+
+  return true;
+}
+
+/*************************************/
+/* Cache                             */
+/*************************************/
+
+std::shared_ptr<const Program> ProgramCache::get_program(const VisualShader& visual_shader,
+                                                         const int& root_node_id) noexcept {
+  EvaluationGraph graph;
+  bool status{to_evaluation_graph(visual_shader, root_node_id, graph)};
+  CHECK_CONDITION_TRUE_NON_VOID(!status, nullptr, "Failed to build the evaluation graph.");
+
+  const std::string key{get_program_key(graph)};
+  const uint64_t hash{shadergen_utils::hash_bytes(key)};
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto it{entries_by_hash.find(hash)};
+    if (it != entries_by_hash.end() && it->second->second->key == key) {
+      entries.splice(entries.begin(), entries, it->second);
+      return it->second->second;
+    }
+  }
+
+  // Compile outside of the lock, other threads may hit the cache meanwhile.
+  std::shared_ptr<Program> program{std::make_shared<Program>()};
+  status = compile_program(graph, *program);
+  CHECK_CONDITION_TRUE_NON_VOID(!status, nullptr, "Failed to compile the program.");
+
+  std::lock_guard<std::mutex> lock{mutex};
+
+  auto it{entries_by_hash.find(hash)};
+  if (it != entries_by_hash.end()) {
+    entries.erase(it->second);
+    entries_by_hash.erase(it);
+  }
+
+  entries.emplace_front(hash, program);
+  entries_by_hash[hash] = entries.begin();
+
+  while (entries.size() > capacity) {
+    entries_by_hash.erase(entries.back().first);
+    entries.pop_back();
+  }
+
+  return program;
+}
+
+size_t ProgramCache::get_size() const noexcept {
+  std::lock_guard<std::mutex> lock{mutex};
+  return entries.size();
+}
+
+void ProgramCache::clear() noexcept {
+  std::lock_guard<std::mutex> lock{mutex};
+  entries.clear();
+  entries_by_hash.clear();
+}
+
+ProgramCache& get_program_cache() noexcept {
+  static ProgramCache cache;
+  return cache;
+}
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,210 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_COMPILER_HPP
+#define ENIGMA_VISUAL_SHADER_COMPILER_HPP
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "evaluator/visual_shader_evaluator.hpp"
+
+/**
+ * @brief Compiles the evaluation graph into a linear register program so
+ *        that evaluating a batch is a single loop over instructions instead
+ *        of a graph walk.
+ *
+ * Each node output lives in a register typed by its port type. Registers
+ * are recycled once their last reader ran (only between values of the same
+ * type) and nodes whose inputs are all constant are evaluated once at compile
+ * time.
+ *
+ * Nodes over floating point ports are lowered into primitive operations on
+ * slots, the float arrays of one register component (see @c get_slot).
+ * Conversions between floating point types are folded into the operand slots
+ * (a splat reads the same slot for every component, missing components read
+ * a constant), so they cost nothing at run time. The other nodes are
+ * evaluated whole by @c evaluate_node_batch and their operands are converted
+ * by explicit instructions.
+ */
+namespace shadergen_visual_shader_evaluator {
+enum class OpCode {
+  // Whole nodes and values, on registers.
+  EVALUATE_NODE,
+  CONVERT,
+
+  // Primitive operations, on slots.
+  LOAD_UV,
+  LOAD_TIME,
+  COPY,
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  FLOAT_OP,
+  FLOAT_FUNC,
+  CLAMP,
+  MIX,
+  SMOOTHSTEP,
+  VALUE_NOISE,
+  PERLIN_NOISE,
+  VORONOI_NOISE
+};
+
+struct Instruction {
+  OpCode opcode{OpCode::EVALUATE_NODE};
+
+  /**
+   * @brief Index in @c Program::nodes, only used by @c EVALUATE_NODE.
+   */
+  int node_index{-1};
+
+  /**
+   * @brief Target type, only used by @c CONVERT.
+   */
+  VisualShaderNodePortType type{VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED};
+
+  /**
+   * @brief The @c VisualShaderNodeFloatOp of @c FLOAT_OP, the
+   *        @c VisualShaderNodeFloatFunc of @c FLOAT_FUNC or the UV component of
+   *        @c LOAD_UV.
+   */
+  int function{0};
+
+  /**
+   * @brief The scale of @c VALUE_NOISE and @c PERLIN_NOISE, the angle offset
+   *        and cell density of @c VORONOI_NOISE.
+   */
+  float parameters[2]{};
+
+  /**
+   * @brief Registers of @c EVALUATE_NODE and @c CONVERT, slots of the
+   *        primitive operations.
+   */
+  int input_count{0};
+  int output_count{0};
+  int inputs[SHADER_GEN_EVALUATOR_MAX_PORT_COUNT]{};
+  int outputs[SHADER_GEN_EVALUATOR_MAX_PORT_COUNT]{};
+};
+
+/**
+ * @brief Slots number the components of the register file: slot
+ *        @c r * 4 + @c c is component @c c of register @c r.
+ */
+inline int to_slot(const int& r, const int& c) noexcept { return r * 4 + c; }
+
+inline float* get_slot(BatchValue* registers, const int& slot) noexcept { return registers[slot / 4].f[slot % 4]; }
+
+/**
+ * @brief A compiled graph. It owns copies of its nodes so it stays valid after
+ *        the @c VisualShader it was compiled from changes.
+ */
+struct Program {
+  std::vector<VisualShader::VisualShaderNode> nodes;
+  std::vector<Instruction> instructions;
+
+  /**
+   * @brief Initial content of the register file: constant registers hold their
+   *        folded values, the others are zero values of their type.
+   */
+  std::vector<BatchValue> registers;
+
+  /**
+   * @brief Registers holding the inputs (converted to the input port types)
+   *        and the outputs of the root node.
+   */
+  std::vector<int> root_input_registers;
+  std::vector<int> root_output_registers;
+
+  /**
+   * @brief The structural key the program was compiled from, see
+   *        @c get_program_key.
+   */
+  std::string key;
+};
+
+/**
+ * @brief Per-thread register file of a program.
+ */
+struct ProgramState {
+  std::vector<BatchValue> registers;
+  std::vector<const BatchValue*> inputs;
+  std::vector<BatchValue*> outputs;
+};
+
+/**
+ * @brief Serializes what the program depends on: the node payloads in
+ *        evaluation order and how they are connected. Positions and ids are
+ *        left out, so moving nodes around does not invalidate the cache.
+ */
+std::string get_program_key(const EvaluationGraph& graph) noexcept;
+
+bool compile_program(const EvaluationGraph& graph, Program& program) noexcept;
+
+bool compile_program(const VisualShader& visual_shader, const int& root_node_id, Program& program) noexcept;
+
+void make_program_state(const Program& program, ProgramState& state) noexcept;
+
+bool execute_program(const Program& program, const BatchEvaluationContext& context, ProgramState& state) noexcept;
+
+/**
+ * @brief A thread-safe LRU cache of compiled programs keyed by the hash of
+ *        @c get_program_key.
+ */
+class ProgramCache {
+ public:
+  explicit ProgramCache(const size_t& capacity = 256) : capacity(capacity) {}
+
+  /**
+   * @brief Returns the program of the graph rooted at @p root_node_id,
+   *        compiling it on a miss. Returns @c nullptr if compilation fails.
+   */
+  std::shared_ptr<const Program> get_program(const VisualShader& visual_shader, const int& root_node_id) noexcept;
+
+  size_t get_size() const noexcept;
+
+  void clear() noexcept;
+
+ private:
+  using Entry = std::pair<uint64_t, std::shared_ptr<const Program>>;
+
+  const size_t capacity;
+
+  mutable std::mutex mutex;
+  std::list<Entry> entries;  // Most recently used first.
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> entries_by_hash;
+};
+
+ProgramCache& get_program_cache() noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_COMPILER_HPP
@@ -0,0 +1,335 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/visual_shader_dataset.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <random>
+
+#include "byte_utils.hpp"
+#include "error_macros.hpp"
+#include "evaluator/utils/thread_pool.hpp"
+#include "evaluator/visual_shader_evaluator.hpp"
+#include "evaluator/visual_shader_graph_search.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+
+/*************************************/
+/* Encoding                          */
+/*************************************/
+
+static inline size_t get_pixel_byte_size(const DatasetImageEncoding& encoding) noexcept {
+  return encoding == DatasetImageEncoding::RGBA8 ? 4 : 4 * sizeof(float);
+}
+
+bool encode_dataset_record(const VisualShader& visual_shader, const Image& image,
+                           const DatasetImageEncoding& encoding, std::string& data) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(image.width <= 0 || image.height <= 0, false, "Empty image.");
+
+  std::string graph;
+  CHECK_CONDITION_TRUE_NON_VOID(!visual_shader.SerializeToString(&graph), false, "Failed to serialize the graph.");
+
+  data.clear();
+  data.reserve(5 * sizeof(uint32_t) + graph.size() + image.width * image.height * get_pixel_byte_size(encoding));
+
+  shadergen_utils::append_u32(data, (uint32_t)graph.size());
+  data.append(graph);
+  shadergen_utils::append_u32(data, (uint32_t)image.width);
+  shadergen_utils::append_u32(data, (uint32_t)image.height);
+  shadergen_utils::append_u32(data, (uint32_t)encoding);
+
+  switch (encoding) {
+    case DatasetImageEncoding::RGBA32F:
+      // Floats are stored as they are in memory, the format assumes a
+      // little-endian host.
+      data.append(reinterpret_cast<const char*>(image.pixels.data()), image.pixels.size() * sizeof(float));
+      break;
+    case DatasetImageEncoding::RGBA8: {
+      std::vector<uint8_t> bytes;
+      image.to_rgba8(bytes);
+      data.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    } break;
+    default:
+      FAIL_AND_RETURN_NON_VOID(false, "Unknown image encoding.");
+  }
+
+  return true;
+}
+
+std::string get_dataset_shard_path(const std::string& directory, const int& shard_index) noexcept {
+  char name[32];
+  std::snprintf(name, sizeof(name), "shard-%05d.bin", shard_index);
+  return (std::filesystem::path(directory) / name).string();
+}
+
+/*************************************/
+/* Writer                            */
+/*************************************/
+
+bool DatasetWriter::open() noexcept {
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  CHECK_CONDITION_TRUE_NON_VOID(error, false, "Failed to create directory: " + directory);
+
+  // Shards of a previous dataset would not be in the new index.
+  for (int i{0}; std::filesystem::exists(get_dataset_shard_path(directory, i), error); i++) {
+    std::filesystem::remove(get_dataset_shard_path(directory, i), error);
+  }
+
+  const std::string index_path{(std::filesystem::path(directory) / SHADER_GEN_DATASET_INDEX_FILE_NAME).string()};
+  index.open(index_path, std::ios::binary | std::ios::trunc);
+  CHECK_CONDITION_TRUE_NON_VOID(!index, false, "Failed to open file for writing: " + index_path);
+
+  std::string header;
+  shadergen_utils::append_u32(header, SHADER_GEN_DATASET_INDEX_MAGIC);
+  shadergen_utils::append_u32(header, SHADER_GEN_DATASET_VERSION);
+  index.write(header.data(), header.size());
+
+  shard_index = -1;
+  record_count = 0;
+  return open_next_shard();
+}
+
+bool DatasetWriter::open_next_shard() noexcept {
+  if (shard.is_open()) shard.close();
+
+  shard_index++;
+  const std::string path{get_dataset_shard_path(directory, shard_index)};
+  shard.open(path, std::ios::binary | std::ios::trunc);
+  CHECK_CONDITION_TRUE_NON_VOID(!shard, false, "Failed to open file for writing: " + path);
+
+  std::string header;
+  shadergen_utils::append_u32(header, SHADER_GEN_DATASET_SHARD_MAGIC);
+  shadergen_utils::append_u32(header, SHADER_GEN_DATASET_VERSION);
+  shard.write(header.data(), header.size());
+  shard_size = header.size();
+
+  return (bool)shard;
+}
+
+bool DatasetWriter::add_record(const std::string& data) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(!shard.is_open() || !index.is_open(), false, "Dataset is not open.");
+
+  const uint64_t header_size{2 * sizeof(uint32_t)};
+  if (shard_size > header_size && shard_size + data.size() > max_shard_size) {
+    SILENT_CHECK_CONDITION_TRUE_NON_VOID(!open_next_shard(), false);
+  }
+
+  std::string entry;
+  shadergen_utils::append_u32(entry, (uint32_t)shard_index);
+  shadergen_utils::append_u64(entry, shard_size);
+  index.write(entry.data(), entry.size());
+
+  shard.write(data.data(), data.size());
+  shard_size += data.size();
+  record_count++;
+
+  CHECK_CONDITION_TRUE_NON_VOID(!shard || !index, false, "Failed to write record " + std::to_string(record_count) + ".");
+
+  return true;
+}
+
+bool DatasetWriter::close() noexcept {
+  bool ok{true};
+  if (shard.is_open()) {
+    shard.flush();
+    ok = ok && (bool)shard;
+    shard.close();
+  }
+  if (index.is_open()) {
+    index.flush();
+    ok = ok && (bool)index;
+    index.close();
+  }
+  return ok;
+}
+
+/*************************************/
+/* Reader                            */
+/*************************************/
+
+bool DatasetReader::open(const std::string& directory) noexcept {
+  this->directory = directory;
+  entries.clear();
+  if (shard.is_open()) shard.close();
+  open_shard_index = -1;
+
+  const std::string index_path{(std::filesystem::path(directory) / SHADER_GEN_DATASET_INDEX_FILE_NAME).string()};
+  std::ifstream index(index_path, std::ios::binary);
+  CHECK_CONDITION_TRUE_NON_VOID(!index, false, "Failed to open file for reading: " + index_path);
+
+  char header[8];
+  index.read(header, sizeof(header));
+  CHECK_CONDITION_TRUE_NON_VOID(!index || shadergen_utils::read_u32(header) != SHADER_GEN_DATASET_INDEX_MAGIC, false,
+                                "Not a dataset index: " + index_path);
+  CHECK_CONDITION_TRUE_NON_VOID(shadergen_utils::read_u32(header + 4) != SHADER_GEN_DATASET_VERSION, false,
+                                "Unsupported dataset version: " + index_path);
+
+  char entry[12];
+  while (index.read(entry, sizeof(entry))) {
+    entries.push_back({shadergen_utils::read_u32(entry), shadergen_utils::read_u64(entry + 4)});
+  }
+
+  return true;
+}
+
+bool DatasetReader::read_record(const uint64_t& index, VisualShader& visual_shader, Image& image) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(index >= entries.size(), false, "Record index out of range.");
+  const Entry& entry{entries.at(index)};
+
+  if (open_shard_index != (int)entry.shard_index) {
+    if (shard.is_open()) shard.close();
+    open_shard_index = -1;
+
+    const std::string path{get_dataset_shard_path(directory, (int)entry.shard_index)};
+    shard.open(path, std::ios::binary);
+    CHECK_CONDITION_TRUE_NON_VOID(!shard, false, "Failed to open file for reading: " + path);
+
+    char header[8];
+    shard.read(header, sizeof(header));
+    CHECK_CONDITION_TRUE_NON_VOID(!shard || shadergen_utils::read_u32(header) != SHADER_GEN_DATASET_SHARD_MAGIC ||
+                                      shadergen_utils::read_u32(header + 4) != SHADER_GEN_DATASET_VERSION,
+                                  false, "Not a dataset shard: " + path);
+    open_shard_index = (int)entry.shard_index;
+  }
+
+  shard.clear();
+  shard.seekg((std::streamoff)entry.offset);
+
+  char size[4];
+  shard.read(size, sizeof(size));
+  std::string graph(shadergen_utils::read_u32(size), '\0');
+  shard.read(graph.data(), graph.size());
+  CHECK_CONDITION_TRUE_NON_VOID(!shard || !visual_shader.ParseFromString(graph), false,
+                                "Failed to read the graph of record " + std::to_string(index) + ".");
+
+  char image_header[12];
+  shard.read(image_header, sizeof(image_header));
+  const int width{(int)shadergen_utils::read_u32(image_header)};
+  const int height{(int)shadergen_utils::read_u32(image_header + 4)};
+  const DatasetImageEncoding encoding{(DatasetImageEncoding)shadergen_utils::read_u32(image_header + 8)};
+  CHECK_CONDITION_TRUE_NON_VOID(!shard || width <= 0 || height <= 0 ||
+                                    (encoding != DatasetImageEncoding::RGBA32F &&
+                                     encoding != DatasetImageEncoding::RGBA8),
+                                false, "Invalid image in record " + std::to_string(index) + ".");
+
+  image.resize(width, height);
+  if (encoding == DatasetImageEncoding::RGBA32F) {
+    shard.read(reinterpret_cast<char*>(image.pixels.data()), image.pixels.size() * sizeof(float));
+  } else {
+    std::vector<uint8_t> bytes(image.pixels.size());
+    shard.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+    for (size_t i{0}; i < bytes.size(); i++) image.pixels[i] = (float)bytes[i] / 255.0f;
+  }
+  CHECK_CONDITION_TRUE_NON_VOID(!shard, false, "Failed to read the image of record " + std::to_string(index) + ".");
+
+  return true;
+}
+
+/*************************************/
+/* Generation                        */
+/*************************************/
+
+// Retries with another graph when one cannot be rendered.
+#define MAX_RECORD_ATTEMPT_COUNT 8
+
+static std::mt19937 make_record_rng(const uint64_t& seed, const uint64_t& record_index, const int& attempt) noexcept {
+  // splitmix64 finalizer.
+  uint64_t h{seed ^ (record_index * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)(uint32_t)attempt << 56)};
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+  h ^= h >> 31;
+  return std::mt19937((uint32_t)(h ^ (h >> 32)));
+}
+
+static bool generate_record(const uint64_t& record_index, const DatasetOptions& options, Image& image,
+                            std::string& data) noexcept {
+  VisualShader visual_shader;
+  for (int attempt{0}; attempt < MAX_RECORD_ATTEMPT_COUNT; attempt++) {
+    std::mt19937 rng{make_record_rng(options.seed, record_index, attempt)};
+    const int node_count{std::uniform_int_distribution<int>(options.min_node_count, options.max_node_count)(rng)};
+    generate_random_graph(node_count, rng, visual_shader);
+
+    SILENT_CONTINUE_IF_TRUE(!render_shader(visual_shader, options.image_size, options.image_size, options.time, image));
+
+    return encode_dataset_record(visual_shader, image, options.encoding, data);
+  }
+
+  FAIL_AND_RETURN_NON_VOID(false, "Failed to generate record " + std::to_string(record_index) + ".");
+}
+
+bool generate_dataset(const std::string& directory, const DatasetOptions& options, const std::atomic<bool>& cancelled,
+                      const DatasetProgressCallback& progress) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(options.image_size <= 0 || options.min_node_count < 0 ||
+                                    options.max_node_count < options.min_node_count,
+                                false, "Invalid dataset options.");
+
+  DatasetWriter writer{directory, options.max_shard_size};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!writer.open(), false);
+
+  evaluator_utils::ThreadPool& pool{evaluator_utils::get_thread_pool()};
+  std::vector<Image> images(pool.get_thread_count());
+
+  const uint64_t chunk_size{(uint64_t)std::max(options.chunk_size, 1) * pool.get_thread_count()};
+
+  // One chunk is written on another thread while the next one is rendered.
+  std::vector<std::string> chunks[2];
+  std::future<bool> write;
+  bool ok{true};
+
+  for (uint64_t first{0}, k{0}; ok && first < options.record_count && !cancelled; first += chunk_size, k++) {
+    std::vector<std::string>& records{chunks[k % 2]};
+    records.resize(std::min(chunk_size, options.record_count - first));
+
+    pool.run((int)records.size(), [&](const int& i, const int& thread_index) {
+      if (!generate_record(first + i, options, images.at(thread_index), records.at(i))) records.at(i).clear();
+    });
+
+    if (write.valid()) ok = write.get();
+
+    write = std::async(std::launch::async, [&writer, &records]() {
+      for (const std::string& record : records) {
+        if (!record.empty() && !writer.add_record(record)) return false;
+      }
+      return true;
+    });
+
+    if (progress) progress(first + records.size());
+  }
+
+  if (write.valid()) ok = write.get() && ok;
+  ok = writer.close() && ok;
+
+  CHECK_CONDITION_TRUE_NON_VOID(!ok, false, "Failed to write the dataset to " + directory + ".");
+
+  return true;
+}
+}  // namespace shadergen_visual_shader_evaluator
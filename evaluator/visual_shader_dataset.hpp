@@ -0,0 +1,184 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_DATASET_HPP
+#define ENIGMA_VISUAL_SHADER_DATASET_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "evaluator/image.hpp"
+#include "evaluator/visual_shader_node_evaluators.hpp"
+
+/**
+ * @brief Synthetic datasets of (graph, rendered image) pairs.
+ *
+ * A dataset is a directory of shard files and an index. Records are appended
+ * to the current shard until it would grow past the maximum shard size, then
+ * the next shard is started. All values are little-endian.
+ *
+ * A shard starts with @c SHADER_GEN_DATASET_SHARD_MAGIC and the format
+ * version, followed by records:
+ *
+ *   uint32 graph size | serialized VisualShader |
+ *   uint32 width | uint32 height | uint32 encoding | pixels
+ *
+ * The index starts with @c SHADER_GEN_DATASET_INDEX_MAGIC and the format
+ * version, followed by one (uint32 shard, uint64 offset) entry per record, so
+ * record @c i is found without reading the shards.
+ */
+#define SHADER_GEN_DATASET_SHARD_MAGIC 0x53444753  // "SGDS"
+#define SHADER_GEN_DATASET_INDEX_MAGIC 0x49444753  // "SGDI"
+#define SHADER_GEN_DATASET_VERSION 1
+
+#define SHADER_GEN_DATASET_INDEX_FILE_NAME "index.bin"
+
+namespace shadergen_visual_shader_evaluator {
+enum class DatasetImageEncoding : uint32_t {
+  RGBA32F = 0,  // 4 floats per pixel.
+  RGBA8 = 1,    // 4 bytes per pixel, see @c Image::to_rgba8.
+};
+
+/**
+ * @brief Serializes a record in the shard format.
+ */
+bool encode_dataset_record(const VisualShader& visual_shader, const Image& image,
+                           const DatasetImageEncoding& encoding, std::string& data) noexcept;
+
+/**
+ * @brief Returns the path of the shard with the given index in @p directory.
+ */
+std::string get_dataset_shard_path(const std::string& directory, const int& shard_index) noexcept;
+
+/**
+ * @brief Appends encoded records to the shards and the index of a dataset,
+ *        replacing any dataset already in the directory.
+ */
+class DatasetWriter {
+ public:
+  /**
+   * @param max_shard_size A shard holding a single record may be larger.
+   */
+  DatasetWriter(const std::string& directory, const uint64_t& max_shard_size) noexcept
+      : directory(directory), max_shard_size(max_shard_size) {}
+  ~DatasetWriter() { close(); }
+
+  bool open() noexcept;
+
+  bool add_record(const std::string& data) noexcept;
+
+  /**
+   * @brief Flushes and closes the files. Returns false if a write failed.
+   */
+  bool close() noexcept;
+
+  int get_shard_count() const noexcept { return shard_index + 1; }
+  uint64_t get_record_count() const noexcept { return record_count; }
+
+ private:
+  const std::string directory;
+  const uint64_t max_shard_size;
+
+  std::ofstream index;
+  std::ofstream shard;
+  int shard_index{-1};
+  uint64_t shard_size{0};
+  uint64_t record_count{0};
+
+  bool open_next_shard() noexcept;
+};
+
+/**
+ * @brief Reads records of a dataset by index. Only the index is kept in memory.
+ */
+class DatasetReader {
+ public:
+  bool open(const std::string& directory) noexcept;
+
+  uint64_t get_record_count() const noexcept { return entries.size(); }
+
+  /**
+   * @brief Reads a record, 8 bit images are converted back to floats.
+   */
+  bool read_record(const uint64_t& index, VisualShader& visual_shader, Image& image) noexcept;
+
+ private:
+  struct Entry {
+    uint32_t shard_index{0};
+    uint64_t offset{0};
+  };
+
+  std::string directory;
+  std::vector<Entry> entries;
+
+  std::ifstream shard;
+  int open_shard_index{-1};
+};
+
+struct DatasetOptions {
+  uint64_t record_count{1000};
+  int image_size{64};
+  float time{0.0f};
+
+  /**
+   * @brief Each graph has a random number of nodes besides the output in
+   *        this range.
+   */
+  int min_node_count{2};
+  int max_node_count{16};
+
+  DatasetImageEncoding encoding{DatasetImageEncoding::RGBA8};
+  uint64_t max_shard_size{256 * 1024 * 1024};
+
+  /**
+   * @brief Records are generated in chunks of this many per thread. A chunk
+   *        is written while the next one is rendered, so at most two chunks
+   *        are in memory.
+   */
+  int chunk_size{16};
+
+  uint64_t seed{0};
+};
+
+using DatasetProgressCallback = std::function<void(const uint64_t& written_count)>;
+
+/**
+ * @brief Generates random graphs with @c generate_random_graph, renders them
+ *        on @c evaluator_utils::get_thread_pool and writes them to
+ *        @p directory. Record @c i only depends on the seed and @c i.
+ *
+ * @param progress Called on the calling thread after every chunk.
+ */
+bool generate_dataset(const std::string& directory, const DatasetOptions& options, const std::atomic<bool>& cancelled,
+                      const DatasetProgressCallback& progress) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_DATASET_HPP
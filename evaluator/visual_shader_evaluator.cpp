@@ -0,0 +1,292 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/visual_shader_evaluator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+#include "error_macros.hpp"
+#include "evaluator/utils/thread_pool.hpp"
+#include "evaluator/visual_shader_compiler.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+
+enum class VisitState { NOT_VISITED, VISITING, VISITED };
+
+static bool add_evaluation_node(const VisualShader& visual_shader, const std::unordered_map<int, int>& node_rows,
+                                const std::unordered_map<uint64_t, int>& input_connections, const int& node_id,
+                                std::unordered_map<int, VisitState>& visit_states,
+                                std::unordered_map<int, int>& node_indices, EvaluationGraph& graph) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(node_rows.find(node_id) == node_rows.end(), false,
+                                "Node id " + std::to_string(node_id) + " not found.");
+
+  VisitState& visit_state{visit_states[node_id]};
+  if (visit_state == VisitState::VISITED) return true;
+  CHECK_CONDITION_TRUE_NON_VOID(visit_state == VisitState::VISITING, false,
+                                "Cycle detected at node " + std::to_string(node_id) + ".");
+  visit_state = VisitState::VISITING;
+
+  EvaluationNode e_node;
+  e_node.id = node_id;
+  e_node.node = &visual_shader.nodes(node_rows.at(node_id));
+
+  bool status{get_node_port_types(*e_node.node, e_node.input_port_types, e_node.output_port_types)};
+  CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to resolve port types of node " + std::to_string(node_id) + ".");
+
+  const int input_port_count{(int)e_node.input_port_types.size()};
+  e_node.input_sources.assign(input_port_count, {-1, -1});
+
+  // Check inputs recursively.
+  for (int i{0}; i < input_port_count; i++) {
+    const uint64_t key{(uint64_t)(uint32_t)node_id | ((uint64_t)(uint32_t)i << 32)};
+    if (input_connections.find(key) == input_connections.end()) continue;
+
+    const VisualShader::VisualShaderConnection& c{visual_shader.connections(input_connections.at(key))};
+
+    status = add_evaluation_node(visual_shader, node_rows, input_connections, c.from_node_id(), visit_states,
+                                 node_indices, graph);
+    CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to add node " + std::to_string(c.from_node_id()) + ".");
+
+    const EvaluationNode& from_node{graph.nodes.at(node_indices.at(c.from_node_id()))};
+    VALIDATE_INDEX_NON_VOID(c.from_port_index(), (int)from_node.output_port_types.size(), false,
+                            "Invalid output port of node " + std::to_string(c.from_node_id()) + ".");
+
+    e_node.input_sources.at(i) = {node_indices.at(c.from_node_id()), c.from_port_index()};
+  }
+
+  node_indices[node_id] = (int)graph.nodes.size();
+  graph.nodes.push_back(std::move(e_node));
+
+  visit_states[node_id] = VisitState::VISITED;
+
+  return true;
+}
+
+bool to_evaluation_graph(const VisualShader& visual_shader, const int& root_node_id, EvaluationGraph& graph) noexcept {
+  std::unordered_map<int, int> node_rows;
+  for (int i{0}; i < visual_shader.nodes_size(); i++) {
+    node_rows[visual_shader.nodes(i).id()] = i;
+  }
+
+  // Key is (to_node_id, to_port_index), same as the generator's input connections.
+  std::unordered_map<uint64_t, int> input_connections;
+  for (int i{0}; i < visual_shader.connections_size(); i++) {
+    const VisualShader::VisualShaderConnection& c{visual_shader.connections(i)};
+    const uint64_t key{(uint64_t)(uint32_t)c.to_node_id() | ((uint64_t)(uint32_t)c.to_port_index() << 32)};
+    input_connections[key] = i;
+  }
+
+  std::unordered_map<int, VisitState> visit_states;
+  std::unordered_map<int, int> node_indices;
+
+  graph.nodes.clear();
+
+  return add_evaluation_node(visual_shader, node_rows, input_connections, root_node_id, visit_states, node_indices,
+                             graph);
+}
+
+void make_evaluation_state(const EvaluationGraph& graph, EvaluationState& state) noexcept {
+  size_t max_input_port_count{0};
+
+  state.outputs.resize(graph.nodes.size());
+  for (size_t i{0}; i < graph.nodes.size(); i++) {
+    const EvaluationNode& e_node{graph.nodes.at(i)};
+
+    state.outputs.at(i).clear();
+    for (const VisualShaderNodePortType& type : e_node.output_port_types) {
+      state.outputs.at(i).push_back(make_zero_value(type));
+    }
+
+    max_input_port_count = std::max(max_input_port_count, e_node.input_port_types.size());
+  }
+
+  state.inputs.resize(max_input_port_count);
+}
+
+Value get_input_value(const EvaluationGraph& graph, const EvaluationState& state, const int& node_index,
+                      const int& port) noexcept {
+  const EvaluationNode& e_node{graph.nodes.at(node_index)};
+  const std::pair<int, int>& source{e_node.input_sources.at(port)};
+
+  if (source.first < 0) {
+    return make_zero_value(e_node.input_port_types.at(port));
+  }
+
+  return convert_value(state.outputs.at(source.first).at(source.second), e_node.input_port_types.at(port));
+}
+
+bool evaluate_graph(const EvaluationGraph& graph, const EvaluationContext& context, EvaluationState& state) noexcept {
+  const int node_count{(int)graph.nodes.size()};
+  for (int i{0}; i < node_count; i++) {
+    const EvaluationNode& e_node{graph.nodes.at(i)};
+
+    const int input_port_count{(int)e_node.input_port_types.size()};
+    for (int j{0}; j < input_port_count; j++) {
+      state.inputs.at(j) = get_input_value(graph, state, i, j);
+    }
+
+    bool status{evaluate_node(*e_node.node, state.inputs.data(), state.outputs.at(i).data(), context)};
+    CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to evaluate node " + std::to_string(e_node.id) + ".");
+  }
+
+  return true;
+}
+
+/*************************************/
+/* Rendering                         */
+/*************************************/
+
+// A tile is a few batches wide so threads work on contiguous rows of the image.
+#define TILE_WIDTH (4 * SHADER_GEN_EVALUATOR_BATCH_SIZE)
+#define TILE_HEIGHT 16
+
+// The preview quad covers the viewport and maps FragCoord to [0, 1] with the
+// origin at the bottom-left corner, evaluate at pixel centers. Lanes past the
+// end of the row repeat the last pixel.
+void set_batch_uv(const int& x, const int& y, const int& width, const int& height,
+                  BatchEvaluationContext& context) noexcept {
+  const float v{1.0f - (float(y) + 0.5f) / float(height)};
+  for (int l{0}; l < SHADER_GEN_EVALUATOR_BATCH_SIZE; l++) {
+    context.uv[0][l] = (float(std::min(x + l, width - 1)) + 0.5f) / float(width);
+    context.uv[1][l] = v;
+  }
+}
+
+// Output values of a batch are written to up to 16 consecutive pixels.
+using BatchWriter = void (*)(const BatchValue& value, const int& count, float* pixel);
+
+// Renders the image in tiles on the thread pool. Each thread evaluates in
+// its own register file, allocated once per render.
+static bool render_program(const Program& program, const int& value_register, const BatchWriter& write,
+                           const float& time, Image& image) noexcept {
+  evaluator_utils::ThreadPool& pool{evaluator_utils::get_thread_pool()};
+
+  std::vector<ProgramState> states(pool.get_thread_count());
+  for (ProgramState& state : states) make_program_state(program, state);
+
+  const int width{image.width}, height{image.height};
+  const int tile_count_x{(width + TILE_WIDTH - 1) / TILE_WIDTH};
+  const int tile_count_y{(height + TILE_HEIGHT - 1) / TILE_HEIGHT};
+
+  std::atomic<bool> failed{false};
+
+  pool.run(tile_count_x * tile_count_y, [&](const int& tile_index, const int& thread_index) {
+    if (failed.load(std::memory_order_relaxed)) return;
+
+    ProgramState& state{states.at(thread_index)};
+    const BatchValue& value{state.registers.at(value_register)};
+
+    BatchEvaluationContext context;
+    context.time = time;
+
+    const int x_begin{(tile_index % tile_count_x) * TILE_WIDTH}, x_end{std::min(x_begin + TILE_WIDTH, width)};
+    const int y_begin{(tile_index / tile_count_x) * TILE_HEIGHT}, y_end{std::min(y_begin + TILE_HEIGHT, height)};
+
+    for (int y{y_begin}; y < y_end; y++) {
+      for (int x{x_begin}; x < x_end; x += SHADER_GEN_EVALUATOR_BATCH_SIZE) {
+        set_batch_uv(x, y, width, height, context);
+
+        if (!execute_program(program, context, state)) {
+          failed = true;
+          return;
+        }
+
+        write(value, std::min(SHADER_GEN_EVALUATOR_BATCH_SIZE, x_end - x), image.at(x, y));
+      }
+    }
+  });
+
+  CHECK_CONDITION_TRUE_NON_VOID(failed, false, "Failed to evaluate the graph.");
+
+  return true;
+}
+
+static void write_color(const BatchValue& value, const int& count, float* pixel) noexcept {
+  for (int l{0}; l < count; l++, pixel += 4) {
+    for (int c{0}; c < 4; c++) pixel[c] = value.f[c][l];
+  }
+}
+
+static void write_preview(const BatchValue& value, const int& count, float* pixel) noexcept {
+  // Scalars are shown as grayscale.
+  BatchValue scalar;
+  const bool is_vector{get_port_type_component_count(value.type) > 1};
+  if (!is_vector) convert_batch_value(value, VisualShaderNodePortType::PORT_TYPE_SCALAR, scalar);
+
+  for (int l{0}; l < count; l++, pixel += 4) {
+    switch (value.type) {
+      case VisualShaderNodePortType::PORT_TYPE_VECTOR_2D:
+        pixel[0] = value.f[0][l];
+        pixel[1] = value.f[1][l];
+        pixel[2] = 0.0f;
+        break;
+      case VisualShaderNodePortType::PORT_TYPE_VECTOR_3D:
+      case VisualShaderNodePortType::PORT_TYPE_VECTOR_4D:
+        for (int c{0}; c < 3; c++) pixel[c] = value.f[c][l];
+        break;
+      default:
+        for (int c{0}; c < 3; c++) pixel[c] = scalar.f[0][l];
+        break;
+    }
+    pixel[3] = 1.0f;
+  }
+}
+
+bool render_shader(const VisualShader& visual_shader, const int& width, const int& height, const float& time,
+                   Image& image) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(width <= 0 || height <= 0, false, "Invalid image size.");
+
+  EvaluationGraph graph;
+  bool status{to_evaluation_graph(visual_shader, 0, graph)};
+  CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to build the evaluation graph.");
+  CHECK_CONDITION_TRUE_NON_VOID(graph.nodes.back().node->node_type_case() != VisualShader::VisualShaderNode::kOutput,
+                                false, "Node 0 is not an output node.");
+
+  std::shared_ptr<const Program> program{get_program_cache().get_program(visual_shader, 0)};
+  CHECK_PARAM_NULLPTR_NON_VOID(program, false, "Failed to compile the graph.");
+
+  // Every pixel is written, so a scratch image of the right size is reused as is.
+  if (image.width != width || image.height != height) image.resize(width, height);
+
+  return render_program(*program, program->root_input_registers.at(0), write_color, time, image);
+}
+
+bool render_preview_shader(const VisualShader& visual_shader, const int& node_id, const int& port, const int& width,
+                           const int& height, const float& time, Image& image) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(width <= 0 || height <= 0, false, "Invalid image size.");
+
+  std::shared_ptr<const Program> program{get_program_cache().get_program(visual_shader, node_id)};
+  CHECK_PARAM_NULLPTR_NON_VOID(program, false, "Failed to compile the graph.");
+  VALIDATE_INDEX_NON_VOID(port, (int)program->root_output_registers.size(), false, "Invalid port.");
+
+  if (image.width != width || image.height != height) image.resize(width, height);
+
+  return render_program(*program, program->root_output_registers.at(port), write_preview, time, image);
+}
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,126 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_EVALUATOR_HPP
+#define ENIGMA_VISUAL_SHADER_EVALUATOR_HPP
+
+#include <utility>
+#include <vector>
+
+#include "evaluator/image.hpp"
+#include "evaluator/visual_shader_node_batch_evaluators.hpp"
+#include "evaluator/visual_shader_node_evaluators.hpp"
+
+/**
+ * @brief CPU reference interpreter for visual shader graphs. It evaluates the
+ *        graph per pixel with the same semantics as the GLSL produced by
+ *        @c shadergen_visual_shader_generator, so results can be compared
+ *        against the preview without a GL context.
+ */
+namespace shadergen_visual_shader_evaluator {
+/**
+ * @brief A node ready for evaluation: its port types are resolved and each
+ *        input points to the node that feeds it.
+ */
+struct EvaluationNode {
+  int id{-1};
+  const VisualShader::VisualShaderNode* node{nullptr};
+
+  std::vector<VisualShaderNodePortType> input_port_types;
+  std::vector<VisualShaderNodePortType> output_port_types;
+
+  /**
+   * @brief For each input port, the index of the source node in
+   *        @c EvaluationGraph::nodes and its output port, or (-1, -1) if the
+   *        port is not connected.
+   */
+  std::vector<std::pair<int, int>> input_sources;
+};
+
+/**
+ * @brief The nodes reachable from a root node, in the same topological order
+ *        the generator emits them (inputs first). The root is the last node.
+ *
+ * @note The graph points into the @c VisualShader it was built from, which
+ *       must outlive it.
+ */
+struct EvaluationGraph {
+  std::vector<EvaluationNode> nodes;
+};
+
+/**
+ * @brief Scratch values of an evaluation, reused across pixels.
+ */
+struct EvaluationState {
+  std::vector<std::vector<Value>> outputs;
+  std::vector<Value> inputs;
+};
+
+bool to_evaluation_graph(const VisualShader& visual_shader, const int& root_node_id, EvaluationGraph& graph) noexcept;
+
+void make_evaluation_state(const EvaluationGraph& graph, EvaluationState& state) noexcept;
+
+/**
+ * @brief Returns the value of an input port of a node after the graph has been
+ *        evaluated, converted to the port's type.
+ */
+Value get_input_value(const EvaluationGraph& graph, const EvaluationState& state, const int& node_index,
+                      const int& port) noexcept;
+
+/**
+ * @brief Evaluates the graph for a single pixel. This is the reference
+ *        implementation, rendering goes through the compiled program (see
+ *        @c compile_program).
+ */
+bool evaluate_graph(const EvaluationGraph& graph, const EvaluationContext& context, EvaluationState& state) noexcept;
+
+/**
+ * @brief Sets the FragCoord of the batch of pixels starting at (@p x, @p y)
+ *        the way the renderers do. Lanes past the end of the row repeat the
+ *        last pixel.
+ */
+void set_batch_uv(const int& x, const int& y, const int& width, const int& height,
+                  BatchEvaluationContext& context) noexcept;
+
+/**
+ * @brief Renders the output node (id 0) of the shader into @p image.
+ *
+ * @note The image is split into tiles rendered on @c evaluator_utils::get_thread_pool,
+ *       so calls from several threads are serialized.
+ */
+bool render_shader(const VisualShader& visual_shader, const int& width, const int& height, const float& time,
+                   Image& image) noexcept;
+
+/**
+ * @brief Renders an output port of a node the same way
+ *        @c generate_preview_shader does.
+ */
+bool render_preview_shader(const VisualShader& visual_shader, const int& node_id, const int& port, const int& width,
+                           const int& height, const float& time, Image& image) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_EVALUATOR_HPP
@@ -0,0 +1,747 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/visual_shader_graph_search.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "error_macros.hpp"
+#include "evaluator/utils/thread_pool.hpp"
+#include "evaluator/visual_shader_autodiff.hpp"
+#include "evaluator/visual_shader_evaluator.hpp"
+#include "evaluator/visual_shader_node_cache.hpp"
+#include "generator/utils/utils.hpp"
+
+using OneofDescriptor = google::protobuf::OneofDescriptor;
+using FieldDescriptor = google::protobuf::FieldDescriptor;
+using EnumDescriptor = google::protobuf::EnumDescriptor;
+using Message = google::protobuf::Message;
+
+namespace shadergen_visual_shader_evaluator {
+
+/*************************************/
+/* Graph Helpers                     */
+/*************************************/
+
+static int find_node(const VisualShader& visual_shader, const int& node_id) noexcept {
+  for (int i{0}; i < visual_shader.nodes_size(); i++) {
+    if (visual_shader.nodes(i).id() == node_id) return i;
+  }
+  return -1;
+}
+
+static int get_new_node_id(const VisualShader& visual_shader) noexcept {
+  int id{0};
+  for (const VisualShader::VisualShaderNode& node : visual_shader.nodes()) id = std::max(id, node.id() + 1);
+  return id;
+}
+
+static int get_new_connection_id(const VisualShader& visual_shader) noexcept {
+  int id{0};
+  for (const VisualShader::VisualShaderConnection& c : visual_shader.connections()) id = std::max(id, c.id() + 1);
+  return id;
+}
+
+// Whether the node reads, directly or not, from another one.
+static bool depends_on(const VisualShader& visual_shader, const int& node_id, const int& other_node_id) noexcept {
+  std::vector<int> stack{node_id};
+  std::unordered_set<int> visited{node_id};
+
+  while (!stack.empty()) {
+    const int id{stack.back()};
+    stack.pop_back();
+    if (id == other_node_id) return true;
+
+    for (const VisualShader::VisualShaderConnection& c : visual_shader.connections()) {
+      if (c.to_node_id() == id && visited.insert(c.from_node_id()).second) stack.push_back(c.from_node_id());
+    }
+  }
+
+  return false;
+}
+
+static void disconnect_input(VisualShader& visual_shader, const int& to_node_id, const int& to_port_index) noexcept {
+  google::protobuf::RepeatedPtrField<VisualShader::VisualShaderConnection>* connections{
+      visual_shader.mutable_connections()};
+  for (int i{connections->size() - 1}; i >= 0; i--) {
+    if (connections->Get(i).to_node_id() == to_node_id && connections->Get(i).to_port_index() == to_port_index) {
+      connections->DeleteSubrange(i, 1);
+    }
+  }
+}
+
+static void connect(VisualShader& visual_shader, const int& from_node_id, const int& from_port_index,
+                    const int& to_node_id, const int& to_port_index) noexcept {
+  disconnect_input(visual_shader, to_node_id, to_port_index);
+
+  VisualShader::VisualShaderConnection* c{visual_shader.add_connections()};
+  c->set_id(get_new_connection_id(visual_shader));
+  c->set_from_node_id(from_node_id);
+  c->set_from_port_index(from_port_index);
+  c->set_to_node_id(to_node_id);
+  c->set_to_port_index(to_port_index);
+}
+
+static void remove_node(VisualShader& visual_shader, const int& node_id) noexcept {
+  google::protobuf::RepeatedPtrField<VisualShader::VisualShaderConnection>* connections{
+      visual_shader.mutable_connections()};
+  for (int i{connections->size() - 1}; i >= 0; i--) {
+    if (connections->Get(i).from_node_id() == node_id || connections->Get(i).to_node_id() == node_id) {
+      connections->DeleteSubrange(i, 1);
+    }
+  }
+
+  const int index{find_node(visual_shader, node_id)};
+  if (index != -1) visual_shader.mutable_nodes()->DeleteSubrange(index, 1);
+}
+
+struct PortTypes {
+  std::vector<VisualShaderNodePortType> inputs;
+  std::vector<VisualShaderNodePortType> outputs;
+};
+
+static std::unordered_map<int, PortTypes> get_port_types(const VisualShader& visual_shader) noexcept {
+  std::unordered_map<int, PortTypes> port_types;
+  for (const VisualShader::VisualShaderNode& node : visual_shader.nodes()) {
+    PortTypes& types{port_types[node.id()]};
+    if (!get_node_port_types(node, types.inputs, types.outputs)) types = PortTypes();
+  }
+  return port_types;
+}
+
+/**
+ * @brief Drops the connections that became invalid (a node changed its type,
+ *        a port disappeared) and the nodes that do not feed the output node.
+ */
+static void sanitize_graph(VisualShader& visual_shader) noexcept {
+  const std::unordered_map<int, PortTypes> port_types{get_port_types(visual_shader)};
+
+  google::protobuf::RepeatedPtrField<VisualShader::VisualShaderConnection>* connections{
+      visual_shader.mutable_connections()};
+  std::unordered_set<uint64_t> connected_inputs;
+  for (int i{connections->size() - 1}; i >= 0; i--) {
+    const VisualShader::VisualShaderConnection& c{connections->Get(i)};
+    auto from{port_types.find(c.from_node_id())};
+    auto to{port_types.find(c.to_node_id())};
+
+    const uint64_t input_key{((uint64_t)(uint32_t)c.to_node_id() << 32) | (uint32_t)c.to_port_index()};
+
+    const bool valid{from != port_types.end() && to != port_types.end() && c.from_port_index() >= 0 &&
+                     c.from_port_index() < (int)from->second.outputs.size() && c.to_port_index() >= 0 &&
+                     c.to_port_index() < (int)to->second.inputs.size() &&
+                     generator_utils::is_valid_connection(from->second.outputs.at(c.from_port_index()),
+                                                          to->second.inputs.at(c.to_port_index())) &&
+                     connected_inputs.insert(input_key).second};  // The newest connection of an input wins.
+    if (!valid) connections->DeleteSubrange(i, 1);
+  }
+
+  std::vector<int> stack{0};
+  std::unordered_set<int> reachable{0};
+  while (!stack.empty()) {
+    const int id{stack.back()};
+    stack.pop_back();
+    for (const VisualShader::VisualShaderConnection& c : visual_shader.connections()) {
+      if (c.to_node_id() == id && reachable.insert(c.from_node_id()).second) stack.push_back(c.from_node_id());
+    }
+  }
+
+  std::vector<int> unreachable;
+  for (const VisualShader::VisualShaderNode& node : visual_shader.nodes()) {
+    if (reachable.find(node.id()) == reachable.end()) unreachable.push_back(node.id());
+  }
+  for (const int& id : unreachable) remove_node(visual_shader, id);
+}
+
+/*************************************/
+/* Parameters                        */
+/*************************************/
+
+static int get_random_enum_value(const EnumDescriptor* enum_desc, std::mt19937& rng) noexcept {
+  std::vector<int> values;
+  for (int i{0}; i < enum_desc->value_count(); i++) {
+    const std::string& name{enum_desc->value(i)->name()};
+    const std::string suffix{"UNSPECIFIED"};
+    const bool is_unspecified{name.size() >= suffix.size() &&
+                              name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0};
+    if (!is_unspecified) values.push_back(enum_desc->value(i)->number());
+  }
+
+  if (values.empty()) return 0;
+  return values.at(std::uniform_int_distribution<int>(0, (int)values.size() - 1)(rng));
+}
+
+static void randomize_field(Message& payload, const FieldDescriptor* field, std::mt19937& rng) noexcept {
+  const google::protobuf::Reflection* refl{payload.GetReflection()};
+  std::uniform_real_distribution<float> unit;
+
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      refl->SetFloat(&payload, field, unit(rng));
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      refl->SetDouble(&payload, field, (double)unit(rng));
+      break;
+    case FieldDescriptor::CPPTYPE_INT32:
+      refl->SetInt32(&payload, field, std::uniform_int_distribution<int32_t>(0, 4)(rng));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      refl->SetUInt32(&payload, field, std::uniform_int_distribution<uint32_t>(0, 4)(rng));
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      refl->SetBool(&payload, field, unit(rng) < 0.5f);
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      refl->SetEnumValue(&payload, field, get_random_enum_value(field->enum_type(), rng));
+      break;
+    default:
+      break;
+  }
+}
+
+static void perturb_field(Message& payload, const FieldDescriptor* field, std::mt19937& rng) noexcept {
+  const google::protobuf::Reflection* refl{payload.GetReflection()};
+  std::normal_distribution<float> normal;
+
+  // Steps are relative to the value so scales like 100 move as fast as colors.
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_FLOAT: {
+      const float value{refl->GetFloat(payload, field)};
+      refl->SetFloat(&payload, field, value + normal(rng) * (0.1f + 0.2f * std::fabs(value)));
+    } break;
+    case FieldDescriptor::CPPTYPE_DOUBLE: {
+      const double value{refl->GetDouble(payload, field)};
+      refl->SetDouble(&payload, field, value + (double)normal(rng) * (0.1 + 0.2 * std::fabs(value)));
+    } break;
+    case FieldDescriptor::CPPTYPE_INT32:
+      refl->SetInt32(&payload, field, refl->GetInt32(payload, field) + (normal(rng) < 0.0f ? -1 : 1));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32: {
+      const uint32_t value{refl->GetUInt32(payload, field)};
+      refl->SetUInt32(&payload, field, normal(rng) < 0.0f && value > 0 ? value - 1 : value + 1);
+    } break;
+    default:
+      randomize_field(payload, field, rng);
+      break;
+  }
+}
+
+static Message* get_payload(VisualShader::VisualShaderNode& node) noexcept {
+  const FieldDescriptor* field{VisualShader::VisualShaderNode::descriptor()->FindFieldByNumber(node.node_type_case())};
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(field, nullptr);
+  return node.GetReflection()->MutableMessage(&node, field);
+}
+
+/*************************************/
+/* Mutations                         */
+/*************************************/
+
+struct PortRef {
+  int node_id;
+  int port_index;
+  VisualShaderNodePortType type;
+};
+
+template <typename T>
+static const T& pick(const std::vector<T>& values, std::mt19937& rng) noexcept {
+  return values.at(std::uniform_int_distribution<int>(0, (int)values.size() - 1)(rng));
+}
+
+static std::vector<PortRef> get_input_ports(const VisualShader& visual_shader,
+                                            const std::unordered_map<int, PortTypes>& port_types) noexcept {
+  std::vector<PortRef> ports;
+  for (const VisualShader::VisualShaderNode& node : visual_shader.nodes()) {
+    const PortTypes& types{port_types.at(node.id())};
+    for (int i{0}; i < (int)types.inputs.size(); i++) ports.push_back({node.id(), i, types.inputs.at(i)});
+  }
+  return ports;
+}
+
+// Outputs that can feed the given input without creating a cycle.
+static std::vector<PortRef> get_source_ports(const VisualShader& visual_shader,
+                                             const std::unordered_map<int, PortTypes>& port_types,
+                                             const PortRef& input) noexcept {
+  std::vector<PortRef> ports;
+  for (const VisualShader::VisualShaderNode& node : visual_shader.nodes()) {
+    if (node.id() == input.node_id || depends_on(visual_shader, node.id(), input.node_id)) continue;
+
+    const PortTypes& types{port_types.at(node.id())};
+    for (int i{0}; i < (int)types.outputs.size(); i++) {
+      if (generator_utils::is_valid_connection(types.outputs.at(i), input.type)) {
+        ports.push_back({node.id(), i, types.outputs.at(i)});
+      }
+    }
+  }
+  return ports;
+}
+
+static void add_random_node(VisualShader& visual_shader, std::mt19937& rng) noexcept {
+  const OneofDescriptor* oneof{VisualShader::VisualShaderNode::descriptor()->FindOneofByName("node_type")};
+  CHECK_PARAM_NULLPTR(oneof, "Node type oneof not found.");
+
+  std::vector<const FieldDescriptor*> node_types;
+  for (int i{0}; i < oneof->field_count(); i++) {
+    if (oneof->field(i)->number() != VisualShader::VisualShaderNode::kOutputFieldNumber) {
+      node_types.push_back(oneof->field(i));
+    }
+  }
+
+  VisualShader::VisualShaderNode node;
+  node.set_id(get_new_node_id(visual_shader));
+  Message* payload{node.GetReflection()->MutableMessage(&node, pick(node_types, rng))};
+  for (int i{0}; i < payload->GetDescriptor()->field_count(); i++) {
+    randomize_field(*payload, payload->GetDescriptor()->field(i), rng);
+  }
+
+  PortTypes types;
+  SILENT_CHECK_CONDITION_TRUE(!get_node_port_types(node, types.inputs, types.outputs) || types.outputs.empty());
+
+  // Insert the node in front of a random input.
+  std::unordered_map<int, PortTypes> port_types{get_port_types(visual_shader)};
+  std::vector<std::pair<PortRef, int>> targets;
+  for (const PortRef& input : get_input_ports(visual_shader, port_types)) {
+    for (int i{0}; i < (int)types.outputs.size(); i++) {
+      if (generator_utils::is_valid_connection(types.outputs.at(i), input.type)) {
+        targets.push_back({input, i});
+        break;
+      }
+    }
+  }
+  SILENT_CHECK_CONDITION_TRUE(targets.empty());
+
+  const std::pair<PortRef, int> target{pick(targets, rng)};
+
+  const VisualShader::VisualShaderNode& target_node{visual_shader.nodes(find_node(visual_shader, target.first.node_id))};
+  node.set_x_coordinate(target_node.x_coordinate() - 300.0);
+  node.set_y_coordinate(target_node.y_coordinate() + std::uniform_real_distribution<double>(-150.0, 150.0)(rng));
+
+  *visual_shader.add_nodes() = node;
+  port_types[node.id()] = types;
+  connect(visual_shader, node.id(), target.second, target.first.node_id, target.first.port_index);
+
+  // Feed some of its inputs from the existing graph.
+  for (int i{0}; i < (int)types.inputs.size(); i++) {
+    if (std::uniform_real_distribution<float>()(rng) < 0.3f) continue;
+
+    const std::vector<PortRef> sources{get_source_ports(visual_shader, port_types, {node.id(), i, types.inputs.at(i)})};
+    if (sources.empty()) continue;
+
+    const PortRef& source{pick(sources, rng)};
+    connect(visual_shader, source.node_id, source.port_index, node.id(), i);
+  }
+}
+
+static void remove_random_node(VisualShader& visual_shader, std::mt19937& rng) noexcept {
+  std::vector<int> node_ids;
+  for (const VisualShader::VisualShaderNode& node : visual_shader.nodes()) {
+    if (node.id() != 0) node_ids.push_back(node.id());
+  }
+  SILENT_CHECK_CONDITION_TRUE(node_ids.empty());
+
+  const int node_id{pick(node_ids, rng)};
+  const std::unordered_map<int, PortTypes> port_types{get_port_types(visual_shader)};
+
+  // Bypass the node: its consumers read from its first compatible input source.
+  std::vector<std::pair<PortRef, PortRef>> bypasses;
+  for (const VisualShader::VisualShaderConnection& out : visual_shader.connections()) {
+    if (out.from_node_id() != node_id) continue;
+
+    const VisualShaderNodePortType to_type{port_types.at(out.to_node_id()).inputs.at(out.to_port_index())};
+    for (const VisualShader::VisualShaderConnection& in : visual_shader.connections()) {
+      if (in.to_node_id() != node_id) continue;
+
+      const VisualShaderNodePortType from_type{port_types.at(in.from_node_id()).outputs.at(in.from_port_index())};
+      if (generator_utils::is_valid_connection(from_type, to_type)) {
+        bypasses.push_back({{in.from_node_id(), in.from_port_index(), from_type},
+                            {out.to_node_id(), out.to_port_index(), to_type}});
+        break;
+      }
+    }
+  }
+
+  remove_node(visual_shader, node_id);
+
+  for (const std::pair<PortRef, PortRef>& bypass : bypasses) {
+    connect(visual_shader, bypass.first.node_id, bypass.first.port_index, bypass.second.node_id,
+            bypass.second.port_index);
+  }
+}
+
+static void rewire_random_input(VisualShader& visual_shader, std::mt19937& rng) noexcept {
+  const std::unordered_map<int, PortTypes> port_types{get_port_types(visual_shader)};
+  const std::vector<PortRef> inputs{get_input_ports(visual_shader, port_types)};
+  SILENT_CHECK_CONDITION_TRUE(inputs.empty());
+
+  const PortRef& input{pick(inputs, rng)};
+
+  const std::vector<PortRef> sources{get_source_ports(visual_shader, port_types, input)};
+  if (sources.empty() || std::uniform_real_distribution<float>()(rng) < 0.1f) {
+    disconnect_input(visual_shader, input.node_id, input.port_index);
+    return;
+  }
+
+  const PortRef& source{pick(sources, rng)};
+  connect(visual_shader, source.node_id, source.port_index, input.node_id, input.port_index);
+}
+
+static void perturb_random_node(VisualShader& visual_shader, std::mt19937& rng) noexcept {
+  std::vector<int> indices;
+  for (int i{0}; i < visual_shader.nodes_size(); i++) {
+    Message* payload{get_payload(*visual_shader.mutable_nodes(i))};
+    if (payload && payload->GetDescriptor()->field_count() > 0) indices.push_back(i);
+  }
+  SILENT_CHECK_CONDITION_TRUE(indices.empty());
+
+  Message* payload{get_payload(*visual_shader.mutable_nodes(pick(indices, rng)))};
+  const int field_count{payload->GetDescriptor()->field_count()};
+  perturb_field(*payload, payload->GetDescriptor()->field(std::uniform_int_distribution<int>(0, field_count - 1)(rng)),
+                rng);
+}
+
+void mutate_graph(VisualShader& visual_shader, const int& max_node_count, std::mt19937& rng) noexcept {
+  enum class Mutation { ADD_NODE, REMOVE_NODE, REWIRE, PERTURB };
+
+  Mutation mutation;
+  const float r{std::uniform_real_distribution<float>()(rng)};
+  if (visual_shader.nodes_size() <= 1) {
+    mutation = Mutation::ADD_NODE;
+  } else if (visual_shader.nodes_size() >= max_node_count) {
+    mutation = Mutation::REMOVE_NODE;
+  } else if (r < 0.3f) {
+    mutation = Mutation::ADD_NODE;
+  } else if (r < 0.45f) {
+    mutation = Mutation::REMOVE_NODE;
+  } else if (r < 0.65f) {
+    mutation = Mutation::REWIRE;
+  } else {
+    mutation = Mutation::PERTURB;
+  }
+
+  switch (mutation) {
+    case Mutation::ADD_NODE:
+      add_random_node(visual_shader, rng);
+      break;
+    case Mutation::REMOVE_NODE:
+      remove_random_node(visual_shader, rng);
+      break;
+    case Mutation::REWIRE:
+      rewire_random_input(visual_shader, rng);
+      break;
+    case Mutation::PERTURB:
+      perturb_random_node(visual_shader, rng);
+      break;
+  }
+
+  sanitize_graph(visual_shader);
+}
+
+void generate_random_graph(const int& node_count, std::mt19937& rng, VisualShader& visual_shader) noexcept {
+  visual_shader.Clear();
+
+  VisualShader::VisualShaderNode* output{visual_shader.add_nodes()};
+  output->set_id(0);
+  output->mutable_output();
+
+  // Nodes without outputs or compatible inputs are not added, give up after
+  // a few attempts per node.
+  for (int attempt{0}; visual_shader.nodes_size() <= node_count && attempt < 4 * node_count; attempt++) {
+    add_random_node(visual_shader, rng);
+  }
+
+  // Connect more inputs than the insertions alone do.
+  for (int i{0}; i < node_count / 2; i++) rewire_random_input(visual_shader, rng);
+
+  sanitize_graph(visual_shader);
+}
+
+void crossover_graphs(const VisualShader& parent, const VisualShader& donor, std::mt19937& rng,
+                      VisualShader& child) noexcept {
+  child = parent;
+
+  std::vector<int> roots;
+  for (const VisualShader::VisualShaderNode& node : donor.nodes()) {
+    if (node.id() != 0) roots.push_back(node.id());
+  }
+  SILENT_CHECK_CONDITION_TRUE(roots.empty());
+
+  // Collect the subgraph feeding a random donor node, with new ids.
+  const int root_id{pick(roots, rng)};
+  std::unordered_map<int, int> new_ids{{root_id, get_new_node_id(child)}};
+  std::vector<int> stack{root_id};
+  while (!stack.empty()) {
+    const int id{stack.back()};
+    stack.pop_back();
+    for (const VisualShader::VisualShaderConnection& c : donor.connections()) {
+      if (c.to_node_id() == id && new_ids.find(c.from_node_id()) == new_ids.end()) {
+        new_ids.emplace(c.from_node_id(), new_ids.at(root_id) + (int)new_ids.size());
+        stack.push_back(c.from_node_id());
+      }
+    }
+  }
+
+  for (const VisualShader::VisualShaderNode& node : donor.nodes()) {
+    auto it{new_ids.find(node.id())};
+    if (it == new_ids.end()) continue;
+
+    VisualShader::VisualShaderNode* copy{child.add_nodes()};
+    *copy = node;
+    copy->set_id(it->second);
+  }
+
+  for (const VisualShader::VisualShaderConnection& c : donor.connections()) {
+    auto from{new_ids.find(c.from_node_id())};
+    auto to{new_ids.find(c.to_node_id())};
+    if (from == new_ids.end() || to == new_ids.end()) continue;
+
+    connect(child, from->second, c.from_port_index(), to->second, c.to_port_index());
+  }
+
+  // Plug the grafted subgraph into the parent's nodes, which cannot depend on it.
+  const std::unordered_map<int, PortTypes> port_types{get_port_types(child)};
+  const int graft_id{new_ids.at(root_id)};
+  const std::vector<VisualShaderNodePortType>& graft_outputs{port_types.at(graft_id).outputs};
+
+  std::vector<std::pair<PortRef, int>> targets;
+  for (const PortRef& input : get_input_ports(parent, port_types)) {
+    for (int i{0}; i < (int)graft_outputs.size(); i++) {
+      if (generator_utils::is_valid_connection(graft_outputs.at(i), input.type)) {
+        targets.push_back({input, i});
+        break;
+      }
+    }
+  }
+
+  if (!targets.empty()) {
+    const std::pair<PortRef, int>& target{pick(targets, rng)};
+    connect(child, graft_id, target.second, target.first.node_id, target.first.port_index);
+  }
+
+  sanitize_graph(child);
+}
+
+/*************************************/
+/* Search                            */
+/*************************************/
+
+namespace {
+struct Candidate {
+  VisualShader graph;
+
+  /**
+   * @brief Loss at each pyramid level the candidate was promoted to, from the
+   *        coarsest. Empty if it could not be rendered.
+   */
+  std::vector<float> losses;
+};
+}  // namespace
+
+// Candidates that went through more levels rank first, the ones that stopped
+// at the same level are compared by their loss there.
+static bool is_better(const Candidate& a, const Candidate& b) noexcept {
+  if (a.losses.size() != b.losses.size()) return a.losses.size() > b.losses.size();
+  return !a.losses.empty() && a.losses.back() < b.losses.back();
+}
+
+static uint64_t mix_seed(uint64_t x) noexcept {
+  // splitmix64 finalizer
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Each candidate gets its own generator so the search does not depend on how
+// tasks are spread over threads. Seeding through std::seed_seq cost more than
+// scoring a candidate at the coarsest pyramid level.
+static std::mt19937 make_rng(const uint64_t& seed, const int& generation, const int& index) noexcept {
+  const uint64_t h{mix_seed(mix_seed(seed ^ (uint64_t)(uint32_t)generation) ^ ((uint64_t)(uint32_t)index << 32))};
+  return std::mt19937((uint32_t)(h ^ (h >> 32)));
+}
+
+// Scores on the pyramid levels from the coarsest, stops at the first level
+// where the loss is not below the threshold of that level.
+static void score_graph(const ImagePyramid& pyramid, const ImageLossType& type, const std::vector<float>& thresholds,
+                        NodeImageCache* cache, Image& scratch, Candidate& candidate) noexcept {
+  candidate.losses.clear();
+
+  for (size_t l{0}; l < pyramid.levels.size(); l++) {
+    const Image& level{pyramid.levels.at(l)};
+    const bool status{cache ? render_shader_cached(candidate.graph, level.width, level.height, 0.0f, *cache, scratch)
+                            : render_shader(candidate.graph, level.width, level.height, 0.0f, scratch)};
+    if (!status) {
+      candidate.losses.clear();
+      return;
+    }
+
+    candidate.losses.emplace_back(compute_image_loss(scratch, level, type));
+    if (candidate.losses.back() >= thresholds.at(l)) return;
+  }
+}
+
+static int select_parent(const std::vector<Candidate>& population, const int& tournament_size,
+                         std::mt19937& rng) noexcept {
+  std::uniform_int_distribution<int> index(0, (int)population.size() - 1);
+
+  int best{index(rng)};
+  for (int i{1}; i < tournament_size; i++) {
+    const int other{index(rng)};
+    if (is_better(population.at(other), population.at(best))) best = other;
+  }
+  return best;
+}
+
+bool search_graph(const VisualShader& initial_graph, const Image& target, const GraphSearchOptions& options,
+                  const std::atomic<bool>& cancelled, const GraphSearchProgressCallback& progress,
+                  VisualShader& best_graph, float& best_loss) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(options.population_size <= 0 || options.image_size <= 0, false,
+                                "Invalid search options.");
+  CHECK_CONDITION_TRUE_NON_VOID(target.width <= 0 || target.height <= 0, false, "Empty target image.");
+
+  ImagePyramid pyramid;
+  build_image_pyramid(target, options.image_size, options.image_size, options.min_image_size, pyramid);
+
+  evaluator_utils::ThreadPool& pool{evaluator_utils::get_thread_pool()};
+  std::vector<Image> images(pool.get_thread_count());
+
+  NodeImageCache node_cache{options.node_cache_capacity};
+  NodeImageCache* cache{options.node_cache_capacity > 0 ? &node_cache : nullptr};
+
+  const int population_size{options.population_size};
+  const int elite_count{std::min(options.elite_count, population_size)};
+  const int max_mutation_count{std::max(options.max_mutation_count, 1)};
+
+  std::vector<Candidate> population(population_size), next_population(population_size);
+
+  const std::vector<float> no_thresholds(pyramid.levels.size(), std::numeric_limits<float>::infinity());
+  std::vector<float> thresholds(no_thresholds);
+
+  // The initial population is made of variations of the initial graph.
+  pool.run(population_size, [&](const int& i, const int& thread_index) {
+    Candidate& candidate{population.at(i)};
+    candidate.graph = initial_graph;
+
+    if (i > 0) {
+      std::mt19937 rng{make_rng(options.seed, 0, i)};
+      for (int m{std::uniform_int_distribution<int>(1, max_mutation_count)(rng)}; m > 0; m--) {
+        mutate_graph(candidate.graph, options.max_node_count, rng);
+      }
+    }
+
+    // Nothing to compare against yet, every candidate is scored at full resolution.
+    candidate.losses.clear();
+    if (!cancelled) score_graph(pyramid, options.loss_type, no_thresholds, cache, images.at(thread_index), candidate);
+  });
+
+  std::vector<int> order(population_size);
+
+  auto update_best = [&]() {
+    for (int i{0}; i < population_size; i++) order.at(i) = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](const int& a, const int& b) { return is_better(population.at(a), population.at(b)); });
+
+    const Candidate& best{population.at(order.at(0))};
+    if (best.losses.size() == pyramid.levels.size() && best.losses.back() < best_loss) {
+      best_loss = best.losses.back();
+      best_graph = best.graph;
+    }
+  };
+
+  best_loss = std::numeric_limits<float>::infinity();
+  update_best();
+  if (progress) progress({0, options.generation_count, best_loss});
+
+  for (int generation{1}; generation <= options.generation_count && !cancelled; generation++) {
+    // Children are promoted to a finer level only while they could replace
+    // the worst elite, which went through every level.
+    thresholds = no_thresholds;
+    if (elite_count > 0) {
+      const Candidate& worst_elite{population.at(order.at(elite_count - 1))};
+      for (size_t l{0}; l < worst_elite.losses.size(); l++) {
+        thresholds.at(l) = worst_elite.losses.at(l) * options.promotion_threshold;
+      }
+    }
+
+    pool.run(population_size, [&](const int& i, const int& thread_index) {
+      Candidate& child{next_population.at(i)};
+
+      if (i < elite_count) {
+        child = population.at(order.at(i));
+        return;
+      }
+
+      std::mt19937 rng{make_rng(options.seed, generation, i)};
+
+      const Candidate& parent{population.at(select_parent(population, options.tournament_size, rng))};
+      if (std::uniform_real_distribution<float>()(rng) < options.crossover_rate) {
+        const Candidate& donor{population.at(select_parent(population, options.tournament_size, rng))};
+        crossover_graphs(parent.graph, donor.graph, rng, child.graph);
+      } else {
+        child.graph = parent.graph;
+      }
+
+      for (int m{std::uniform_int_distribution<int>(1, max_mutation_count)(rng)}; m > 0; m--) {
+        mutate_graph(child.graph, options.max_node_count, rng);
+      }
+
+      child.losses.clear();
+      if (!cancelled) score_graph(pyramid, options.loss_type, thresholds, cache, images.at(thread_index), child);
+    });
+
+    std::swap(population, next_population);
+    update_best();
+
+    if (progress) progress({generation, options.generation_count, best_loss});
+  }
+
+  // Tuning minimizes the MSE, the tuned graph is kept only if it also lowers
+  // the search loss.
+  if (options.tuning_iteration_count > 0 && !cancelled && !std::isinf(best_loss)) {
+    VisualShader tuned_graph{best_graph};
+    std::vector<TunableParameter> parameters;
+    get_tunable_parameters(tuned_graph, parameters);
+
+    ParameterTuningOptions tuning_options;
+    tuning_options.iteration_count = options.tuning_iteration_count;
+    tuning_options.image_size = options.image_size;
+
+    float tuned_loss{0.0f};
+    Image& image{images.at(0)};
+    if (tune_parameters(tuned_graph, parameters, pyramid.levels.back(), tuning_options, tuned_loss) &&
+        render_shader(tuned_graph, options.image_size, options.image_size, 0.0f, image)) {
+      tuned_loss = compute_image_loss(image, pyramid.levels.back(), options.loss_type);
+      if (tuned_loss < best_loss) {
+        best_loss = tuned_loss;
+        best_graph = std::move(tuned_graph);
+      }
+    }
+  }
+
+  return !std::isinf(best_loss);
+}
+}  // namespace shadergen_visual_shader_evaluator
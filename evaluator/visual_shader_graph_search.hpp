@@ -0,0 +1,157 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_GRAPH_SEARCH_HPP
+#define ENIGMA_VISUAL_SHADER_GRAPH_SEARCH_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <random>
+
+#include "evaluator/image.hpp"
+#include "evaluator/image_loss.hpp"
+#include "evaluator/visual_shader_node_evaluators.hpp"
+
+/**
+ * @brief Genetic search for a graph whose render matches a target image.
+ *
+ * Candidates are whole @c VisualShader graphs. Each generation keeps the best
+ * candidates and breeds the rest by grafting subgraphs of one parent into
+ * another and by mutating them (adding, removing and rewiring nodes and
+ * perturbing their parameters). Candidates are rendered with the CPU
+ * evaluator and scored in parallel on @c evaluator_utils::get_thread_pool.
+ */
+namespace shadergen_visual_shader_evaluator {
+struct GraphSearchOptions {
+  int population_size{64};
+  int generation_count{200};
+
+  /**
+   * @brief Number of best candidates copied unchanged to the next generation.
+   */
+  int elite_count{4};
+  int tournament_size{3};
+
+  /**
+   * @brief Probability of a child being bred from two parents instead of one.
+   */
+  float crossover_rate{0.3f};
+  int max_mutation_count{3};
+
+  /**
+   * @brief Graphs larger than this only lose nodes when mutated.
+   */
+  int max_node_count{24};
+
+  /**
+   * @brief Candidates are rendered and compared at this resolution, the
+   *        target is downscaled to it.
+   */
+  int image_size{64};
+
+  ImageLossType loss_type{ImageLossType::MSE};
+
+  /**
+   * @brief Candidates are first scored on the coarsest level of a pyramid of
+   *        the target that is at least this size. A child is promoted to the
+   *        next level only while its loss stays below @c promotion_threshold
+   *        times the loss of the worst elite at the same level, so most
+   *        children are only rendered at the coarsest level. Candidates that
+   *        went through more levels rank first. Set it to @c image_size to
+   *        always score at full resolution.
+   */
+  int min_image_size{16};
+  float promotion_threshold{1.0f};
+
+  /**
+   * @brief Size in bytes of the cache of node images shared by all the
+   *        candidates of the search (see @c NodeImageCache), so a child only
+   *        evaluates the nodes that differ from its parent. 0 renders every
+   *        candidate from scratch with the compiled program.
+   */
+  size_t node_cache_capacity{64 * 1024 * 1024};
+
+  /**
+   * @brief Once the search ends, the constants of the best graph are tuned
+   *        with @c tune_parameters for this many iterations. 0 disables it.
+   */
+  int tuning_iteration_count{0};
+
+  uint64_t seed{0};
+};
+
+struct GraphSearchProgress {
+  /**
+   * @brief Number of generations bred so far, 0 once the initial population
+   *        has been scored.
+   */
+  int generation{0};
+  int generation_count{0};
+  float best_loss{0.0f};
+};
+
+using GraphSearchProgressCallback = std::function<void(const GraphSearchProgress&)>;
+
+/**
+ * @brief Applies one random mutation to @p visual_shader. The graph stays
+ *        acyclic, every connection is valid according to
+ *        @c generator_utils::is_valid_connection and nodes that do not feed
+ *        the output node are removed.
+ */
+void mutate_graph(VisualShader& visual_shader, const int& max_node_count, std::mt19937& rng) noexcept;
+
+/**
+ * @brief Replaces @p visual_shader with a random graph of an output node and
+ *        up to @p node_count other nodes, all feeding the output. The same
+ *        guarantees as @c mutate_graph hold.
+ */
+void generate_random_graph(const int& node_count, std::mt19937& rng, VisualShader& visual_shader) noexcept;
+
+/**
+ * @brief Copies @p parent and grafts into it a random subgraph of @p donor,
+ *        connected to a random compatible input.
+ */
+void crossover_graphs(const VisualShader& parent, const VisualShader& donor, std::mt19937& rng,
+                      VisualShader& child) noexcept;
+
+/**
+ * @brief Searches for the graph that best matches @p target, starting from
+ *        @p initial_graph, until @c GraphSearchOptions::generation_count
+ *        generations have been bred or @p cancelled is set.
+ *
+ * @param progress Called on the calling thread after every generation.
+ * @param best_graph The best graph found, even if the search was cancelled.
+ *
+ * @return false if no candidate could be rendered.
+ */
+bool search_graph(const VisualShader& initial_graph, const Image& target, const GraphSearchOptions& options,
+                  const std::atomic<bool>& cancelled, const GraphSearchProgressCallback& progress,
+                  VisualShader& best_graph, float& best_loss) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_GRAPH_SEARCH_HPP
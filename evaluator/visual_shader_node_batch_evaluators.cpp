@@ -0,0 +1,325 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/visual_shader_node_batch_evaluators.hpp"
+
+#include <cmath>
+
+#include "error_macros.hpp"
+#include "evaluator/simd/batch_kernels.hpp"
+
+#define BATCH_SIZE SHADER_GEN_EVALUATOR_BATCH_SIZE
+#define MAX_PORT_COUNT SHADER_GEN_EVALUATOR_MAX_PORT_COUNT
+
+namespace shadergen_visual_shader_evaluator {
+
+/*************************************/
+/* Helpers                           */
+/*************************************/
+
+static inline void fill(float* r, const float& x) noexcept {
+  for (int l{0}; l < BATCH_SIZE; ++l) r[l] = x;
+}
+
+static inline void copy(const float* x, float* r) noexcept {
+  for (int l{0}; l < BATCH_SIZE; ++l) r[l] = x[l];
+}
+
+static bool evaluate_node_per_lane(const VisualShader::VisualShaderNode& node, const BatchValue* const* inputs,
+                                   const int& input_port_count, BatchValue* const* outputs, const int& output_port_count,
+                                   const BatchEvaluationContext& context) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(input_port_count > MAX_PORT_COUNT || output_port_count > MAX_PORT_COUNT, false,
+                                "Too many ports.");
+
+  Value lane_inputs[MAX_PORT_COUNT];
+  Value lane_outputs[MAX_PORT_COUNT];
+  EvaluationContext lane_context;
+  lane_context.time = context.time;
+
+  for (int l{0}; l < BATCH_SIZE; ++l) {
+    for (int j{0}; j < input_port_count; ++j) lane_inputs[j] = get_lane_value(*inputs[j], l);
+    for (int j{0}; j < output_port_count; ++j) lane_outputs[j] = get_lane_value(*outputs[j], l);
+
+    lane_context.uv[0] = context.uv[0][l];
+    lane_context.uv[1] = context.uv[1][l];
+
+    bool status{evaluate_node(node, lane_inputs, lane_outputs, lane_context)};
+    CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to evaluate node.");
+
+    for (int j{0}; j < output_port_count; ++j) set_lane_value(*outputs[j], l, lane_outputs[j]);
+  }
+
+  return true;
+}
+
+/*************************************/
+/* Values                            */
+/*************************************/
+
+bool is_float_port_type(const VisualShaderNodePortType& type) noexcept {
+  switch (type) {
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR:
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_2D:
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_3D:
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_4D:
+      return true;
+    default:
+      break;
+  }
+  return false;
+}
+
+Value get_lane_value(const BatchValue& value, const int& lane) noexcept {
+  Value result;
+  result.type = value.type;
+  for (int c{0}; c < 4; ++c) result.f[c] = value.f[c][lane];
+  result.i = value.i[lane];
+  result.u = value.u[lane];
+  result.b = value.b[lane];
+  return result;
+}
+
+void set_lane_value(BatchValue& value, const int& lane, const Value& lane_value) noexcept {
+  for (int c{0}; c < 4; ++c) value.f[c][lane] = lane_value.f[c];
+  value.i[lane] = lane_value.i;
+  value.u[lane] = lane_value.u;
+  value.b[lane] = lane_value.b;
+}
+
+void make_zero_batch_value(const VisualShaderNodePortType& type, BatchValue& value) noexcept {
+  value = BatchValue();
+  value.type = type;
+}
+
+void convert_batch_value(const BatchValue& value, const VisualShaderNodePortType& to_type,
+                         BatchValue& result) noexcept {
+  if (value.type == to_type || to_type == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED) {
+    result = value;
+    return;
+  }
+
+  result.type = to_type;
+
+  // Conversions between floating point types only move components around.
+  if (is_float_port_type(value.type) && is_float_port_type(to_type)) {
+    const int from_count{get_port_type_component_count(value.type)};
+    const int to_count{get_port_type_component_count(to_type)};
+
+    for (int c{0}; c < to_count; ++c) {
+      if (from_count == 1) {
+        copy(value.f[0], result.f[c]);  // Splat
+      } else if (c < from_count) {
+        copy(value.f[c], result.f[c]);
+      } else {
+        fill(result.f[c], 0.0f);
+      }
+    }
+
+    // vec4(v2, 0.0, 1.0) and vec4(v3, 1.0)
+    if (to_type == VisualShaderNodePortType::PORT_TYPE_VECTOR_4D && from_count > 1) fill(result.f[3], 1.0f);
+    return;
+  }
+
+  for (int l{0}; l < BATCH_SIZE; ++l) set_lane_value(result, l, convert_value(get_lane_value(value, l), to_type));
+}
+
+/*************************************/
+/* Evaluation                        */
+/*************************************/
+
+bool evaluate_node_batch(const VisualShader::VisualShaderNode& node, const BatchValue* const* inputs,
+                         const int& input_port_count, BatchValue* const* outputs, const int& output_port_count,
+                         const BatchEvaluationContext& context) noexcept {
+  const BatchKernels& kernels{get_batch_kernels()};
+
+  switch (node.node_type_case()) {
+    case VisualShader::VisualShaderNode::kInput: {
+      switch (node.input().type()) {
+        case VisualShaderNodeInputType::INPUT_TYPE_UV:
+          copy(context.uv[0], outputs[0]->f[0]);
+          copy(context.uv[1], outputs[0]->f[1]);
+          break;
+        case VisualShaderNodeInputType::INPUT_TYPE_TIME:
+          fill(outputs[0]->f[0], context.time);
+          break;
+        default:
+          break;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kOutput:
+      break;
+
+    /*************************************/
+    /* OPERATORS                         */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kFloatOp:
+      kernels.float_op(node.float_op().op(), inputs[0]->f[0], inputs[1]->f[0], outputs[0]->f[0], BATCH_SIZE);
+      break;
+    case VisualShader::VisualShaderNode::kVectorOp: {
+      const BatchValue& a{*inputs[0]};
+      const BatchValue& b{*inputs[1]};
+      BatchValue& r{*outputs[0]};
+      const int n{get_port_type_component_count(r.type)};
+
+      switch (node.vector_op().op()) {
+        case VisualShaderNodeVectorOp::OP_CROSS:
+          if (n == 3) {
+            for (int l{0}; l < BATCH_SIZE; ++l) {
+              r.f[0][l] = a.f[1][l] * b.f[2][l] - b.f[1][l] * a.f[2][l];
+              r.f[1][l] = a.f[2][l] * b.f[0][l] - b.f[2][l] * a.f[0][l];
+              r.f[2][l] = a.f[0][l] * b.f[1][l] - b.f[0][l] * a.f[1][l];
+            }
+          } else {
+            for (int c{0}; c < n; ++c) fill(r.f[c], 0.0f);  // Not supported.
+          }
+          break;
+        case VisualShaderNodeVectorOp::OP_REFLECT:
+          // I - 2.0 * dot(N, I) * N
+          for (int l{0}; l < BATCH_SIZE; ++l) {
+            float d{0.0f};
+            for (int c{0}; c < n; ++c) d += b.f[c][l] * a.f[c][l];
+            for (int c{0}; c < n; ++c) r.f[c][l] = a.f[c][l] - 2.0f * d * b.f[c][l];
+          }
+          break;
+        default: {
+          const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType op{to_float_op(node.vector_op().op())};
+          for (int c{0}; c < n; ++c) kernels.float_op(op, a.f[c], b.f[c], r.f[c], BATCH_SIZE);
+        } break;
+      }
+    } break;
+
+    /*************************************/
+    /* Funcs Node                        */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kFloatFunc:
+      kernels.float_func(node.float_func().func(), inputs[0]->f[0], outputs[0]->f[0], BATCH_SIZE);
+      break;
+    case VisualShader::VisualShaderNode::kVectorFunc: {
+      const BatchValue& x{*inputs[0]};
+      BatchValue& r{*outputs[0]};
+      const int n{get_port_type_component_count(r.type)};
+
+      switch (node.vector_func().func()) {
+        case VisualShaderNodeVectorFunc::FUNC_NORMALIZE:
+          for (int l{0}; l < BATCH_SIZE; ++l) {
+            float len{0.0f};
+            for (int c{0}; c < n; ++c) len += x.f[c][l] * x.f[c][l];
+            len = std::sqrt(len);
+            for (int c{0}; c < n; ++c) r.f[c][l] = x.f[c][l] / len;
+          }
+          break;
+        case VisualShaderNodeVectorFunc::FUNC_SATURATE:
+          for (int c{0}; c < n; ++c) {
+            for (int l{0}; l < BATCH_SIZE; ++l) r.f[c][l] = std::fmax(std::fmin(x.f[c][l], 1.0f), 0.0f);
+          }
+          break;
+        default: {
+          const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType func{to_float_func(node.vector_func().func())};
+          for (int c{0}; c < n; ++c) kernels.float_func(func, x.f[c], r.f[c], BATCH_SIZE);
+        } break;
+      }
+    } break;
+
+    /*************************************/
+    /* NOISE                             */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kValueNoise:
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+    case VisualShader::VisualShaderNode::kVoronoiNoise: {
+      const float* u{inputs[0]->f[0]};
+      const float* v{inputs[0]->f[1]};
+      BatchValue& r{*outputs[0]};
+
+      switch (node.node_type_case()) {
+        case VisualShader::VisualShaderNode::kValueNoise:
+          kernels.value_noise(u, v, node.value_noise().scale(), r.f[0], BATCH_SIZE);
+          break;
+        case VisualShader::VisualShaderNode::kPerlinNoise:
+          kernels.perlin_noise(u, v, node.perlin_noise().scale(), r.f[0], BATCH_SIZE);
+          break;
+        default:
+          kernels.voronoi_noise(u, v, node.voronoi_noise().angle_offset(), node.voronoi_noise().cell_density(),
+                                r.f[0], BATCH_SIZE);
+          break;
+      }
+
+      copy(r.f[0], r.f[1]);
+      copy(r.f[0], r.f[2]);
+      fill(r.f[3], 1.0f);
+    } break;
+
+    /*************************************/
+    /* MISC                              */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kClamp:
+    case VisualShader::VisualShaderNode::kStep:
+    case VisualShader::VisualShaderNode::kSmoothStep:
+    case VisualShader::VisualShaderNode::kMix: {
+      BatchValue& r{*outputs[0]};
+      if (!is_float_port_type(r.type)) {
+        return evaluate_node_per_lane(node, inputs, input_port_count, outputs, output_port_count, context);
+      }
+
+      const int n{get_port_type_component_count(r.type)};
+      for (int c{0}; c < n; ++c) {
+        switch (node.node_type_case()) {
+          case VisualShader::VisualShaderNode::kClamp:
+            kernels.clamp(inputs[0]->f[c], inputs[1]->f[c], inputs[2]->f[c], r.f[c], BATCH_SIZE);
+            break;
+          case VisualShader::VisualShaderNode::kStep:
+            kernels.float_op(VisualShaderNodeFloatOp::OP_STEP, inputs[0]->f[c], inputs[1]->f[c], r.f[c], BATCH_SIZE);
+            break;
+          case VisualShader::VisualShaderNode::kSmoothStep:
+            kernels.smoothstep(inputs[0]->f[c], inputs[1]->f[c], inputs[2]->f[c], r.f[c], BATCH_SIZE);
+            break;
+          default:
+            kernels.mix(inputs[0]->f[c], inputs[1]->f[c], inputs[2]->f[c], r.f[c], BATCH_SIZE);
+            break;
+        }
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kVector2DCompose:
+    case VisualShader::VisualShaderNode::kVector3DCompose:
+    case VisualShader::VisualShaderNode::kVector4DCompose:
+      for (int c{0}; c < input_port_count; ++c) copy(inputs[c]->f[0], outputs[0]->f[c]);
+      break;
+    case VisualShader::VisualShaderNode::kVector2DDecompose:
+    case VisualShader::VisualShaderNode::kVector3DDecompose:
+    case VisualShader::VisualShaderNode::kVector4DDecompose:
+      for (int c{0}; c < output_port_count; ++c) copy(inputs[0]->f[c], outputs[c]->f[0]);
+      break;
+    default:
+      return evaluate_node_per_lane(node, inputs, input_port_count, outputs, output_port_count, context);
+  }
+
+  return true;
+}
+}  // namespace shadergen_visual_shader_evaluator
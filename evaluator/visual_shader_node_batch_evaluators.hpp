@@ -0,0 +1,91 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_NODE_BATCH_EVALUATORS_HPP
+#define ENIGMA_VISUAL_SHADER_NODE_BATCH_EVALUATORS_HPP
+
+#include <cstdint>
+
+#include "evaluator/visual_shader_node_evaluators.hpp"
+
+// Number of pixels evaluated together, a multiple of the widest SIMD vector.
+#define SHADER_GEN_EVALUATOR_BATCH_SIZE 16
+
+// Largest port count of a node, see VisualShaderNodeIf.
+#define SHADER_GEN_EVALUATOR_MAX_PORT_COUNT 8
+
+namespace shadergen_visual_shader_evaluator {
+/**
+ * @brief The structure-of-arrays version of @c Value: @c f[c][lane] holds
+ *        component @c c of each pixel of the batch.
+ */
+struct BatchValue {
+  VisualShaderNodePortType type{VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED};
+  alignas(32) float f[4][SHADER_GEN_EVALUATOR_BATCH_SIZE]{};
+  alignas(32) int32_t i[SHADER_GEN_EVALUATOR_BATCH_SIZE]{};
+  alignas(32) uint32_t u[SHADER_GEN_EVALUATOR_BATCH_SIZE]{};
+  bool b[SHADER_GEN_EVALUATOR_BATCH_SIZE]{};
+};
+
+struct BatchEvaluationContext {
+  alignas(32) float uv[2][SHADER_GEN_EVALUATOR_BATCH_SIZE]{};
+  float time{0.0f};
+};
+
+/**
+ * @brief Whether values of @p type are held in the @c f components.
+ */
+bool is_float_port_type(const VisualShaderNodePortType& type) noexcept;
+
+Value get_lane_value(const BatchValue& value, const int& lane) noexcept;
+
+void set_lane_value(BatchValue& value, const int& lane, const Value& lane_value) noexcept;
+
+void make_zero_batch_value(const VisualShaderNodePortType& type, BatchValue& value) noexcept;
+
+/**
+ * @brief Batch version of @c convert_value.
+ */
+void convert_batch_value(const BatchValue& value, const VisualShaderNodePortType& to_type,
+                         BatchValue& result) noexcept;
+
+/**
+ * @brief Evaluates a single node for a batch of pixels.
+ *
+ * Floating point operators and functions, clamp/step/smoothstep/mix and the
+ * noise nodes run on the SIMD kernels of @c get_batch_kernels, the remaining
+ * nodes fall back to @c evaluate_node lane by lane.
+ *
+ * @param inputs Input values, already converted to the resolved input port types.
+ * @param outputs Output values, initialized with the resolved output port types.
+ */
+bool evaluate_node_batch(const VisualShader::VisualShaderNode& node, const BatchValue* const* inputs,
+                         const int& input_port_count, BatchValue* const* outputs, const int& output_port_count,
+                         const BatchEvaluationContext& context) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_NODE_BATCH_EVALUATORS_HPP
@@ -0,0 +1,336 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/visual_shader_node_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include "byte_utils.hpp"
+#include "error_macros.hpp"
+#include "evaluator/utils/thread_pool.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+
+/*************************************/
+/* Keys                              */
+/*************************************/
+
+template <typename T>
+static inline void append_bytes(std::string& key, const T& value) noexcept {
+  key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void get_subgraph_keys(const EvaluationGraph& graph, const float& time, std::vector<std::string>& keys,
+                       std::vector<uint64_t>& hashes) noexcept {
+  const int node_count{(int)graph.nodes.size()};
+  keys.assign(node_count, std::string());
+  hashes.assign(node_count, 0);
+
+  std::vector<bool> depends_on_time(node_count, false);
+
+  for (int i{0}; i < node_count; i++) {
+    const EvaluationNode& e_node{graph.nodes.at(i)};
+    std::string& key{keys.at(i)};
+
+    const google::protobuf::FieldDescriptor* oneof_field{
+        VisualShader::VisualShaderNode::descriptor()->FindFieldByNumber(e_node.node->node_type_case())};
+    CHECK_PARAM_NULLPTR(oneof_field, "Node type is not set.");
+
+    const std::string payload{
+        e_node.node->GetReflection()->GetMessage(*e_node.node, oneof_field).SerializeAsString()};
+
+    append_bytes(key, (int32_t)oneof_field->number());
+    append_bytes(key, (uint32_t)payload.size());
+    key += payload;
+
+    depends_on_time.at(i) = e_node.node->node_type_case() == VisualShader::VisualShaderNode::kInput &&
+                            e_node.node->input().type() == VisualShaderNodeInputType::INPUT_TYPE_TIME;
+
+    for (const std::pair<int, int>& source : e_node.input_sources) {
+      append_bytes(key, source.first < 0 ? (uint64_t)0 : hashes.at(source.first));
+      append_bytes(key, (int32_t)source.second);
+      depends_on_time.at(i) = depends_on_time.at(i) || (source.first >= 0 && depends_on_time.at(source.first));
+    }
+
+    if (depends_on_time.at(i)) append_bytes(key, time);
+
+    hashes.at(i) = shadergen_utils::hash_bytes(key);
+  }
+}
+
+/*************************************/
+/* Cache                             */
+/*************************************/
+
+size_t NodeImages::get_byte_size() const noexcept {
+  size_t size{0};
+  for (const std::vector<BatchValue>& port : ports) size += port.size() * sizeof(BatchValue);
+  return size;
+}
+
+// The same subgraph at another resolution is another entry.
+static inline uint64_t get_entry_id(const uint64_t& hash, const int& width, const int& height) noexcept {
+  uint64_t id{hash ^ ((uint64_t)(uint32_t)width << 32 | (uint64_t)(uint32_t)height)};
+  id = (id ^ (id >> 30)) * 0xbf58476d1ce4e5b9ull;
+  id = (id ^ (id >> 27)) * 0x94d049bb133111ebull;
+  return id ^ (id >> 31);
+}
+
+std::shared_ptr<const NodeImages> NodeImageCache::get_images(const std::string& key, const uint64_t& hash,
+                                                             const int& width, const int& height) noexcept {
+  std::lock_guard<std::mutex> lock{mutex};
+
+  auto it{entries_by_id.find(get_entry_id(hash, width, height))};
+  if (it == entries_by_id.end() || it->second->key != key || it->second->images->width != width ||
+      it->second->images->height != height) {
+    miss_count++;
+    return nullptr;
+  }
+
+  hit_count++;
+  entries.splice(entries.begin(), entries, it->second);
+  return it->second->images;
+}
+
+void NodeImageCache::add_images(const std::string& key, const uint64_t& hash,
+                                const std::shared_ptr<const NodeImages>& images) noexcept {
+  CHECK_PARAM_NULLPTR(images, "Images are null.");
+
+  const size_t size{images->get_byte_size()};
+  SILENT_CHECK_CONDITION_TRUE(size > capacity);
+
+  const uint64_t id{get_entry_id(hash, images->width, images->height)};
+
+  std::lock_guard<std::mutex> lock{mutex};
+
+  auto it{entries_by_id.find(id)};
+  if (it != entries_by_id.end()) {
+    byte_size -= it->second->images->get_byte_size();
+    entries.erase(it->second);
+    entries_by_id.erase(it);
+  }
+
+  entries.push_front({id, key, images});
+  entries_by_id[id] = entries.begin();
+  byte_size += size;
+
+  while (byte_size > capacity) {
+    byte_size -= entries.back().images->get_byte_size();
+    entries_by_id.erase(entries.back().id);
+    entries.pop_back();
+  }
+}
+
+size_t NodeImageCache::get_size() const noexcept {
+  std::lock_guard<std::mutex> lock{mutex};
+  return entries.size();
+}
+
+size_t NodeImageCache::get_byte_size() const noexcept {
+  std::lock_guard<std::mutex> lock{mutex};
+  return byte_size;
+}
+
+uint64_t NodeImageCache::get_hit_count() const noexcept {
+  std::lock_guard<std::mutex> lock{mutex};
+  return hit_count;
+}
+
+uint64_t NodeImageCache::get_miss_count() const noexcept {
+  std::lock_guard<std::mutex> lock{mutex};
+  return miss_count;
+}
+
+void NodeImageCache::clear() noexcept {
+  std::lock_guard<std::mutex> lock{mutex};
+  entries.clear();
+  entries_by_id.clear();
+  byte_size = 0;
+  hit_count = miss_count = 0;
+}
+
+/*************************************/
+/* Rendering                         */
+/*************************************/
+
+using NodeImagesList = std::vector<std::shared_ptr<const NodeImages>>;
+
+// Returns the batch feeding an input port, converted to the port type in
+// @p scratch if needed. Unconnected ports read @p scratch, which must hold
+// the zero value of the port type.
+static const BatchValue* get_input_batch(const EvaluationGraph& graph, const NodeImagesList& images,
+                                         const int& node_index, const int& port, const int& batch_index,
+                                         BatchValue& scratch) noexcept {
+  const EvaluationNode& e_node{graph.nodes.at(node_index)};
+  const std::pair<int, int>& source{e_node.input_sources.at(port)};
+  if (source.first < 0) return &scratch;
+
+  const NodeImages& source_images{*images.at(source.first)};
+  const BatchValue& value{source_images.ports.at(source.second).at(source_images.is_constant ? 0 : batch_index)};
+  if (value.type == e_node.input_port_types.at(port)) return &value;
+
+  convert_batch_value(value, e_node.input_port_types.at(port), scratch);
+  return &scratch;
+}
+
+static bool evaluate_node_images(const EvaluationGraph& graph, const NodeImagesList& images, const int& node_index,
+                                 const int& width, const int& height, const float& time,
+                                 NodeImages& node_images) noexcept {
+  const EvaluationNode& e_node{graph.nodes.at(node_index)};
+  const int input_port_count{(int)e_node.input_port_types.size()};
+  const int output_port_count{(int)e_node.output_port_types.size()};
+  CHECK_CONDITION_TRUE_NON_VOID(input_port_count > SHADER_GEN_EVALUATOR_MAX_PORT_COUNT ||
+                                    output_port_count > SHADER_GEN_EVALUATOR_MAX_PORT_COUNT,
+                                false, "Too many ports.");
+
+  // Like the compiler, a node that no input reaches has the same value at
+  // every pixel and is evaluated once.
+  bool is_constant{e_node.node->node_type_case() != VisualShader::VisualShaderNode::NodeTypeCase::kInput};
+  for (const std::pair<int, int>& source : e_node.input_sources) {
+    if (source.first >= 0) is_constant = is_constant && images.at(source.first)->is_constant;
+  }
+
+  const int row_batch_count{is_constant ? 1
+                                        : (width + SHADER_GEN_EVALUATOR_BATCH_SIZE - 1) /
+                                              SHADER_GEN_EVALUATOR_BATCH_SIZE};
+  const int row_count{is_constant ? 1 : height};
+
+  node_images.width = width;
+  node_images.height = height;
+  node_images.is_constant = is_constant;
+  node_images.ports.resize(output_port_count);
+  for (int j{0}; j < output_port_count; j++) {
+    BatchValue zero;
+    make_zero_batch_value(e_node.output_port_types.at(j), zero);
+    node_images.ports.at(j).assign(row_batch_count * row_count, zero);
+  }
+
+  std::atomic<bool> failed{false};
+
+  evaluator_utils::get_thread_pool().run(row_count, [&](const int& y, const int&) {
+    if (failed.load(std::memory_order_relaxed)) return;
+
+    BatchEvaluationContext context;
+    context.time = time;
+
+    BatchValue scratch[SHADER_GEN_EVALUATOR_MAX_PORT_COUNT];
+    const BatchValue* inputs[SHADER_GEN_EVALUATOR_MAX_PORT_COUNT];
+    BatchValue* outputs[SHADER_GEN_EVALUATOR_MAX_PORT_COUNT];
+
+    for (int j{0}; j < input_port_count; j++) {
+      if (e_node.input_sources.at(j).first < 0) make_zero_batch_value(e_node.input_port_types.at(j), scratch[j]);
+    }
+
+    for (int bx{0}; bx < row_batch_count; bx++) {
+      const int batch_index{y * row_batch_count + bx};
+      set_batch_uv(bx * SHADER_GEN_EVALUATOR_BATCH_SIZE, y, width, height, context);
+
+      for (int j{0}; j < input_port_count; j++) {
+        inputs[j] = get_input_batch(graph, images, node_index, j, batch_index, scratch[j]);
+      }
+      for (int j{0}; j < output_port_count; j++) outputs[j] = &node_images.ports.at(j).at(batch_index);
+
+      if (!evaluate_node_batch(*e_node.node, inputs, input_port_count, outputs, output_port_count, context)) {
+        failed = true;
+        return;
+      }
+    }
+  });
+
+  CHECK_CONDITION_TRUE_NON_VOID(failed, false, "Failed to evaluate node " + std::to_string(e_node.id) + ".");
+
+  return true;
+}
+
+bool render_shader_cached(const VisualShader& visual_shader, const int& width, const int& height, const float& time,
+                          NodeImageCache& cache, Image& image) noexcept {
+  CHECK_CONDITION_TRUE_NON_VOID(width <= 0 || height <= 0, false, "Invalid image size.");
+
+  EvaluationGraph graph;
+  bool status{to_evaluation_graph(visual_shader, 0, graph)};
+  CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to build the evaluation graph.");
+  CHECK_CONDITION_TRUE_NON_VOID(graph.nodes.back().node->node_type_case() != VisualShader::VisualShaderNode::kOutput,
+                                false, "Node 0 is not an output node.");
+
+  std::vector<std::string> keys;
+  std::vector<uint64_t> hashes;
+  get_subgraph_keys(graph, time, keys, hashes);
+
+  const int root_index{(int)graph.nodes.size() - 1};
+
+  // Walk up from the root, nothing upstream of a cached node is needed.
+  NodeImagesList images(graph.nodes.size());
+  std::vector<bool> is_needed(graph.nodes.size(), false);
+  is_needed.at(root_index) = true;
+
+  for (int i{root_index}; i >= 0; i--) {
+    if (!is_needed.at(i)) continue;
+
+    if (i != root_index) {
+      images.at(i) = cache.get_images(keys.at(i), hashes.at(i), width, height);
+      if (images.at(i)) continue;
+    }
+
+    for (const std::pair<int, int>& source : graph.nodes.at(i).input_sources) {
+      if (source.first >= 0) is_needed.at(source.first) = true;
+    }
+  }
+
+  for (int i{0}; i < root_index; i++) {
+    if (!is_needed.at(i) || images.at(i)) continue;
+
+    std::shared_ptr<NodeImages> node_images{std::make_shared<NodeImages>()};
+    status = evaluate_node_images(graph, images, i, width, height, time, *node_images);
+    CHECK_CONDITION_TRUE_NON_VOID(!status, false, "Failed to evaluate the graph.");
+
+    cache.add_images(keys.at(i), hashes.at(i), node_images);
+    images.at(i) = std::move(node_images);
+  }
+
+  if (image.width != width || image.height != height) image.resize(width, height);
+
+  const int row_batch_count{(width + SHADER_GEN_EVALUATOR_BATCH_SIZE - 1) / SHADER_GEN_EVALUATOR_BATCH_SIZE};
+
+  BatchValue scratch;
+  make_zero_batch_value(graph.nodes.back().input_port_types.at(0), scratch);
+
+  for (int y{0}; y < height; y++) {
+    for (int bx{0}; bx < row_batch_count; bx++) {
+      const BatchValue* value{get_input_batch(graph, images, root_index, 0, y * row_batch_count + bx, scratch)};
+
+      const int x{bx * SHADER_GEN_EVALUATOR_BATCH_SIZE};
+      float* pixel{image.at(x, y)};
+      for (int l{0}; l < std::min(SHADER_GEN_EVALUATOR_BATCH_SIZE, width - x); l++, pixel += 4) {
+        for (int c{0}; c < 4; c++) pixel[c] = value->f[c][l];
+      }
+    }
+  }
+
+  return true;
+}
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,141 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_NODE_CACHE_HPP
+#define ENIGMA_VISUAL_SHADER_NODE_CACHE_HPP
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "evaluator/image.hpp"
+#include "evaluator/visual_shader_evaluator.hpp"
+
+/**
+ * @brief Caches the output images of nodes across graphs, so graphs that
+ *        share an upstream subgraph (a search candidate and its parent) only
+ *        evaluate the nodes that differ.
+ *
+ * A node is identified by a structural hash of the subgraph feeding it: its
+ * payload and the hashes of its input nodes, recursively. Ids and positions
+ * are left out, so identical subgraphs of different graphs share entries.
+ */
+namespace shadergen_visual_shader_evaluator {
+/**
+ * @brief The outputs of a node over a whole image. Each output port holds one
+ *        batch per @c SHADER_GEN_EVALUATOR_BATCH_SIZE pixels of each row, rows
+ *        one after the other.
+ */
+struct NodeImages {
+  int width{0};
+  int height{0};
+
+  /**
+   * @brief Set when no input reaches the node. Each port then holds a single
+   *        batch, the value of every pixel.
+   */
+  bool is_constant{false};
+
+  std::vector<std::vector<BatchValue>> ports;
+
+  size_t get_byte_size() const noexcept;
+};
+
+/**
+ * @brief Structural keys of the nodes of a graph.
+ *
+ * @param time Only mixed into the keys of the nodes that depend on the
+ *             @c TIME input.
+ * @param keys Receives, for each node, its payload followed by the hashes and
+ *             ports of its sources.
+ * @param hashes Receives the hash of each key.
+ */
+void get_subgraph_keys(const EvaluationGraph& graph, const float& time, std::vector<std::string>& keys,
+                       std::vector<uint64_t>& hashes) noexcept;
+
+/**
+ * @brief A thread-safe LRU cache of node images bounded by their total size.
+ */
+class NodeImageCache {
+ public:
+  explicit NodeImageCache(const size_t& capacity = 64 * 1024 * 1024) : capacity(capacity) {}
+
+  /**
+   * @brief Returns the images of the node with the given key and hash at the
+   *        given size, or @c nullptr on a miss.
+   */
+  std::shared_ptr<const NodeImages> get_images(const std::string& key, const uint64_t& hash, const int& width,
+                                               const int& height) noexcept;
+
+  /**
+   * @brief Stores the images of a node, evicting the least recently used
+   *        entries to stay within the capacity. Images larger than the
+   *        capacity are not stored.
+   */
+  void add_images(const std::string& key, const uint64_t& hash, const std::shared_ptr<const NodeImages>& images) noexcept;
+
+  size_t get_size() const noexcept;
+  size_t get_byte_size() const noexcept;
+
+  uint64_t get_hit_count() const noexcept;
+  uint64_t get_miss_count() const noexcept;
+
+  void clear() noexcept;
+
+ private:
+  struct Entry {
+    uint64_t id{0};
+    std::string key;
+    std::shared_ptr<const NodeImages> images;
+  };
+
+  const size_t capacity;
+
+  mutable std::mutex mutex;
+  std::list<Entry> entries;  // Most recently used first.
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> entries_by_id;
+  size_t byte_size{0};
+
+  uint64_t hit_count{0};
+  uint64_t miss_count{0};
+};
+
+/**
+ * @brief Renders the output node (id 0) like @c render_shader, node by node
+ *        over the whole image. Nodes found in @p cache are not evaluated, nor
+ *        is anything upstream of them, and the images of the evaluated nodes
+ *        are added to it.
+ */
+bool render_shader_cached(const VisualShader& visual_shader, const int& width, const int& height, const float& time,
+                          NodeImageCache& cache, Image& image) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_NODE_CACHE_HPP
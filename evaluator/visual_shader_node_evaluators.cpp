@@ -0,0 +1,1034 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/visual_shader_node_evaluators.hpp"
+
+#include <cmath>
+#include <limits>
+
+#include "error_macros.hpp"
+#include "evaluator/utils/utils.hpp"
+#include "evaluator/vs_node_noise_evaluators.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+
+/*************************************/
+/* Helpers                           */
+/*************************************/
+
+// GLSL leaves out of range float to int conversions undefined, make them
+// deterministic instead of relying on C++ undefined behavior.
+static inline int32_t float_to_int(const float& x) noexcept {
+  if (std::isnan(x)) return 0;
+  if (x >= 2147483647.0f) return std::numeric_limits<int32_t>::max();
+  if (x <= -2147483648.0f) return std::numeric_limits<int32_t>::min();
+  return static_cast<int32_t>(x);
+}
+
+static inline uint32_t float_to_uint(const float& x) noexcept {
+  if (x < 0.0f) return static_cast<uint32_t>(float_to_int(x));
+  if (std::isnan(x)) return 0u;
+  if (x >= 4294967295.0f) return std::numeric_limits<uint32_t>::max();
+  return static_cast<uint32_t>(x);
+}
+
+static inline float as_float(const Value& value) noexcept {
+  switch (value.type) {
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR_INT:
+      return float(value.i);
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR_UINT:
+      return float(value.u);
+    case VisualShaderNodePortType::PORT_TYPE_BOOLEAN:
+      return value.b ? 1.0f : 0.0f;
+    default:
+      break;
+  }
+  return value.f[0];
+}
+
+static inline void splat(Value& value, const float& x) noexcept {
+  value.f[0] = value.f[1] = value.f[2] = value.f[3] = x;
+}
+
+float apply_float_op(const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType& op, const float& a,
+                     const float& b) noexcept {
+  switch (op) {
+    case VisualShaderNodeFloatOp::OP_ADD:
+      return a + b;
+    case VisualShaderNodeFloatOp::OP_SUB:
+      return a - b;
+    case VisualShaderNodeFloatOp::OP_MUL:
+      return a * b;
+    case VisualShaderNodeFloatOp::OP_DIV:
+      return a / b;
+    case VisualShaderNodeFloatOp::OP_MOD:
+      return evaluator_utils::mod(a, b);
+    case VisualShaderNodeFloatOp::OP_POW:
+      return std::pow(a, b);
+    case VisualShaderNodeFloatOp::OP_MAX:
+      return std::fmax(a, b);
+    case VisualShaderNodeFloatOp::OP_MIN:
+      return std::fmin(a, b);
+    case VisualShaderNodeFloatOp::OP_ATAN2:
+      return std::atan2(a, b);
+    case VisualShaderNodeFloatOp::OP_STEP:
+      return evaluator_utils::step(a, b);
+    default:
+      break;
+  }
+
+  return 0.0f;
+}
+
+float apply_float_func(const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType& func, const float& x) noexcept {
+  switch (func) {
+    case VisualShaderNodeFloatFunc::FUNC_SIN:
+      return evaluator_utils::sin(x);
+    case VisualShaderNodeFloatFunc::FUNC_COS:
+      return evaluator_utils::cos(x);
+    case VisualShaderNodeFloatFunc::FUNC_TAN:
+      return std::tan(x);
+    case VisualShaderNodeFloatFunc::FUNC_ASIN:
+      return std::asin(x);
+    case VisualShaderNodeFloatFunc::FUNC_ACOS:
+      return std::acos(x);
+    case VisualShaderNodeFloatFunc::FUNC_ATAN:
+      return std::atan(x);
+    case VisualShaderNodeFloatFunc::FUNC_SINH:
+      return std::sinh(x);
+    case VisualShaderNodeFloatFunc::FUNC_COSH:
+      return std::cosh(x);
+    case VisualShaderNodeFloatFunc::FUNC_TANH:
+      return std::tanh(x);
+    case VisualShaderNodeFloatFunc::FUNC_LOG:
+      return std::log(x);
+    case VisualShaderNodeFloatFunc::FUNC_EXP:
+      return std::exp(x);
+    case VisualShaderNodeFloatFunc::FUNC_SQRT:
+      return std::sqrt(x);
+    case VisualShaderNodeFloatFunc::FUNC_ABS:
+      return std::fabs(x);
+    case VisualShaderNodeFloatFunc::FUNC_SIGN:
+      return evaluator_utils::sign(x);
+    case VisualShaderNodeFloatFunc::FUNC_FLOOR:
+      return std::floor(x);
+    case VisualShaderNodeFloatFunc::FUNC_ROUND:
+      return std::round(x);
+    case VisualShaderNodeFloatFunc::FUNC_CEIL:
+      return std::ceil(x);
+    case VisualShaderNodeFloatFunc::FUNC_FRACT:
+      return evaluator_utils::fract(x);
+    case VisualShaderNodeFloatFunc::FUNC_SATURATE:
+      return std::fmin(std::fmax(x, 0.0f), 1.0f);
+    case VisualShaderNodeFloatFunc::FUNC_NEGATE:
+      return -x;
+    case VisualShaderNodeFloatFunc::FUNC_ACOSH:
+      return std::acosh(x);
+    case VisualShaderNodeFloatFunc::FUNC_ASINH:
+      return std::asinh(x);
+    case VisualShaderNodeFloatFunc::FUNC_ATANH:
+      return std::atanh(x);
+    case VisualShaderNodeFloatFunc::FUNC_DEGREES:
+      return evaluator_utils::degrees(x);
+    case VisualShaderNodeFloatFunc::FUNC_EXP2:
+      return std::exp2(x);
+    case VisualShaderNodeFloatFunc::FUNC_INVERSE_SQRT:
+      return evaluator_utils::inversesqrt(x);
+    case VisualShaderNodeFloatFunc::FUNC_LOG2:
+      return std::log2(x);
+    case VisualShaderNodeFloatFunc::FUNC_RADIANS:
+      return evaluator_utils::radians(x);
+    case VisualShaderNodeFloatFunc::FUNC_RECIPROCAL:
+      return 1.0f / x;
+    case VisualShaderNodeFloatFunc::FUNC_ROUNDEVEN:
+      return evaluator_utils::round_even(x);
+    case VisualShaderNodeFloatFunc::FUNC_TRUNC:
+      return std::trunc(x);
+    case VisualShaderNodeFloatFunc::FUNC_ONEMINUS:
+      return 1.0f - x;
+    default:
+      break;
+  }
+  return 0.0f;
+}
+
+VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType to_float_func(
+    const VisualShaderNodeVectorFunc::VisualShaderNodeVectorFuncType& func) noexcept {
+  switch (func) {
+    case VisualShaderNodeVectorFunc::FUNC_NEGATE:
+      return VisualShaderNodeFloatFunc::FUNC_NEGATE;
+    case VisualShaderNodeVectorFunc::FUNC_RECIPROCAL:
+      return VisualShaderNodeFloatFunc::FUNC_RECIPROCAL;
+    case VisualShaderNodeVectorFunc::FUNC_ABS:
+      return VisualShaderNodeFloatFunc::FUNC_ABS;
+    case VisualShaderNodeVectorFunc::FUNC_ACOS:
+      return VisualShaderNodeFloatFunc::FUNC_ACOS;
+    case VisualShaderNodeVectorFunc::FUNC_ACOSH:
+      return VisualShaderNodeFloatFunc::FUNC_ACOSH;
+    case VisualShaderNodeVectorFunc::FUNC_ASIN:
+      return VisualShaderNodeFloatFunc::FUNC_ASIN;
+    case VisualShaderNodeVectorFunc::FUNC_ASINH:
+      return VisualShaderNodeFloatFunc::FUNC_ASINH;
+    case VisualShaderNodeVectorFunc::FUNC_ATAN:
+      return VisualShaderNodeFloatFunc::FUNC_ATAN;
+    case VisualShaderNodeVectorFunc::FUNC_ATANH:
+      return VisualShaderNodeFloatFunc::FUNC_ATANH;
+    case VisualShaderNodeVectorFunc::FUNC_CEIL:
+      return VisualShaderNodeFloatFunc::FUNC_CEIL;
+    case VisualShaderNodeVectorFunc::FUNC_COS:
+      return VisualShaderNodeFloatFunc::FUNC_COS;
+    case VisualShaderNodeVectorFunc::FUNC_COSH:
+      return VisualShaderNodeFloatFunc::FUNC_COSH;
+    case VisualShaderNodeVectorFunc::FUNC_DEGREES:
+      return VisualShaderNodeFloatFunc::FUNC_DEGREES;
+    case VisualShaderNodeVectorFunc::FUNC_EXP:
+      return VisualShaderNodeFloatFunc::FUNC_EXP;
+    case VisualShaderNodeVectorFunc::FUNC_EXP2:
+      return VisualShaderNodeFloatFunc::FUNC_EXP2;
+    case VisualShaderNodeVectorFunc::FUNC_FLOOR:
+      return VisualShaderNodeFloatFunc::FUNC_FLOOR;
+    case VisualShaderNodeVectorFunc::FUNC_FRACT:
+      return VisualShaderNodeFloatFunc::FUNC_FRACT;
+    case VisualShaderNodeVectorFunc::FUNC_INVERSE_SQRT:
+      return VisualShaderNodeFloatFunc::FUNC_INVERSE_SQRT;
+    case VisualShaderNodeVectorFunc::FUNC_LOG:
+      return VisualShaderNodeFloatFunc::FUNC_LOG;
+    case VisualShaderNodeVectorFunc::FUNC_LOG2:
+      return VisualShaderNodeFloatFunc::FUNC_LOG2;
+    case VisualShaderNodeVectorFunc::FUNC_RADIANS:
+      return VisualShaderNodeFloatFunc::FUNC_RADIANS;
+    case VisualShaderNodeVectorFunc::FUNC_ROUND:
+      return VisualShaderNodeFloatFunc::FUNC_ROUND;
+    case VisualShaderNodeVectorFunc::FUNC_ROUNDEVEN:
+      return VisualShaderNodeFloatFunc::FUNC_ROUNDEVEN;
+    case VisualShaderNodeVectorFunc::FUNC_SIGN:
+      return VisualShaderNodeFloatFunc::FUNC_SIGN;
+    case VisualShaderNodeVectorFunc::FUNC_SIN:
+      return VisualShaderNodeFloatFunc::FUNC_SIN;
+    case VisualShaderNodeVectorFunc::FUNC_SINH:
+      return VisualShaderNodeFloatFunc::FUNC_SINH;
+    case VisualShaderNodeVectorFunc::FUNC_SQRT:
+      return VisualShaderNodeFloatFunc::FUNC_SQRT;
+    case VisualShaderNodeVectorFunc::FUNC_TAN:
+      return VisualShaderNodeFloatFunc::FUNC_TAN;
+    case VisualShaderNodeVectorFunc::FUNC_TANH:
+      return VisualShaderNodeFloatFunc::FUNC_TANH;
+    case VisualShaderNodeVectorFunc::FUNC_TRUNC:
+      return VisualShaderNodeFloatFunc::FUNC_TRUNC;
+    case VisualShaderNodeVectorFunc::FUNC_ONEMINUS:
+      return VisualShaderNodeFloatFunc::FUNC_ONEMINUS;
+    default:
+      break;
+  }
+  return VisualShaderNodeFloatFunc::FUNC_UNSPECIFIED;
+}
+
+VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType to_float_op(
+    const VisualShaderNodeVectorOp::VisualShaderNodeVectorOpType& op) noexcept {
+  switch (op) {
+    case VisualShaderNodeVectorOp::OP_ADD:
+      return VisualShaderNodeFloatOp::OP_ADD;
+    case VisualShaderNodeVectorOp::OP_SUB:
+      return VisualShaderNodeFloatOp::OP_SUB;
+    case VisualShaderNodeVectorOp::OP_MUL:
+      return VisualShaderNodeFloatOp::OP_MUL;
+    case VisualShaderNodeVectorOp::OP_DIV:
+      return VisualShaderNodeFloatOp::OP_DIV;
+    case VisualShaderNodeVectorOp::OP_MOD:
+      return VisualShaderNodeFloatOp::OP_MOD;
+    case VisualShaderNodeVectorOp::OP_POW:
+      return VisualShaderNodeFloatOp::OP_POW;
+    case VisualShaderNodeVectorOp::OP_MAX:
+      return VisualShaderNodeFloatOp::OP_MAX;
+    case VisualShaderNodeVectorOp::OP_MIN:
+      return VisualShaderNodeFloatOp::OP_MIN;
+    case VisualShaderNodeVectorOp::OP_ATAN2:
+      return VisualShaderNodeFloatOp::OP_ATAN2;
+    case VisualShaderNodeVectorOp::OP_STEP:
+      return VisualShaderNodeFloatOp::OP_STEP;
+    default:
+      break;
+  }
+  return VisualShaderNodeFloatOp::OP_UNSPECIFIED;
+}
+
+VisualShaderNodePortType to_port_type(const VisualShaderNodeVectorType& type) noexcept {
+  switch (type) {
+    case VisualShaderNodeVectorType::TYPE_VECTOR_2D:
+      return VisualShaderNodePortType::PORT_TYPE_VECTOR_2D;
+    case VisualShaderNodeVectorType::TYPE_VECTOR_4D:
+      return VisualShaderNodePortType::PORT_TYPE_VECTOR_4D;
+    default:
+      break;
+  }
+  // Vector nodes default to 3D vectors.
+  return VisualShaderNodePortType::PORT_TYPE_VECTOR_3D;
+}
+
+static inline int32_t apply_int_op(const VisualShaderNodeIntOp::VisualShaderNodeIntOpType& op, const int32_t& a,
+                                   const int32_t& b) noexcept {
+  // Do the wrapping arithmetic on unsigned integers to avoid signed overflow.
+  const uint32_t ua{static_cast<uint32_t>(a)}, ub{static_cast<uint32_t>(b)};
+  switch (op) {
+    case VisualShaderNodeIntOp::OP_ADD:
+      return static_cast<int32_t>(ua + ub);
+    case VisualShaderNodeIntOp::OP_SUB:
+      return static_cast<int32_t>(ua - ub);
+    case VisualShaderNodeIntOp::OP_MUL:
+      return static_cast<int32_t>(ua * ub);
+    case VisualShaderNodeIntOp::OP_DIV:
+      if (b == 0) return 0;
+      if (b == -1) return static_cast<int32_t>(0u - ua);
+      return a / b;
+    case VisualShaderNodeIntOp::OP_MOD:
+      if (b == 0 || b == -1) return 0;
+      return a % b;
+    case VisualShaderNodeIntOp::OP_MAX:
+      return a > b ? a : b;
+    case VisualShaderNodeIntOp::OP_MIN:
+      return a < b ? a : b;
+    case VisualShaderNodeIntOp::OP_BITWISE_AND:
+      return a & b;
+    case VisualShaderNodeIntOp::OP_BITWISE_OR:
+      return a | b;
+    case VisualShaderNodeIntOp::OP_BITWISE_XOR:
+      return a ^ b;
+    case VisualShaderNodeIntOp::OP_BITWISE_LEFT_SHIFT:
+      return static_cast<int32_t>(ua << (ub & 31u));
+    case VisualShaderNodeIntOp::OP_BITWISE_RIGHT_SHIFT:
+      return a >> (ub & 31u);
+    default:
+      break;
+  }
+  return 0;
+}
+
+static inline uint32_t apply_uint_op(const VisualShaderNodeUIntOp::VisualShaderNodeUIntOpType& op, const uint32_t& a,
+                                     const uint32_t& b) noexcept {
+  switch (op) {
+    case VisualShaderNodeUIntOp::OP_ADD:
+      return a + b;
+    case VisualShaderNodeUIntOp::OP_SUB:
+      return a - b;
+    case VisualShaderNodeUIntOp::OP_MUL:
+      return a * b;
+    case VisualShaderNodeUIntOp::OP_DIV:
+      return b == 0u ? 0u : a / b;
+    case VisualShaderNodeUIntOp::OP_MOD:
+      return b == 0u ? 0u : a % b;
+    case VisualShaderNodeUIntOp::OP_MAX:
+      return a > b ? a : b;
+    case VisualShaderNodeUIntOp::OP_MIN:
+      return a < b ? a : b;
+    case VisualShaderNodeUIntOp::OP_BITWISE_AND:
+      return a & b;
+    case VisualShaderNodeUIntOp::OP_BITWISE_OR:
+      return a | b;
+    case VisualShaderNodeUIntOp::OP_BITWISE_XOR:
+      return a ^ b;
+    case VisualShaderNodeUIntOp::OP_BITWISE_LEFT_SHIFT:
+      return a << (b & 31u);
+    case VisualShaderNodeUIntOp::OP_BITWISE_RIGHT_SHIFT:
+      return a >> (b & 31u);
+    default:
+      break;
+  }
+  return 0u;
+}
+
+static inline bool compare_floats(const VisualShaderNodeCompare::Function& func, const float& a,
+                                  const float& b) noexcept {
+  switch (func) {
+    case VisualShaderNodeCompare::FUNC_EQUAL:
+      return a == b;
+    case VisualShaderNodeCompare::FUNC_NOT_EQUAL:
+      return a != b;
+    case VisualShaderNodeCompare::FUNC_GREATER_THAN:
+      return a > b;
+    case VisualShaderNodeCompare::FUNC_GREATER_THAN_EQUAL:
+      return a >= b;
+    case VisualShaderNodeCompare::FUNC_LESS_THAN:
+      return a < b;
+    case VisualShaderNodeCompare::FUNC_LESS_THAN_EQUAL:
+      return a <= b;
+    default:
+      break;
+  }
+  return false;
+}
+
+template <typename T>
+static inline bool compare_integers(const VisualShaderNodeCompare::Function& func, const T& a, const T& b) noexcept {
+  switch (func) {
+    case VisualShaderNodeCompare::FUNC_EQUAL:
+      return a == b;
+    case VisualShaderNodeCompare::FUNC_NOT_EQUAL:
+      return a != b;
+    case VisualShaderNodeCompare::FUNC_GREATER_THAN:
+      return a > b;
+    case VisualShaderNodeCompare::FUNC_GREATER_THAN_EQUAL:
+      return a >= b;
+    case VisualShaderNodeCompare::FUNC_LESS_THAN:
+      return a < b;
+    case VisualShaderNodeCompare::FUNC_LESS_THAN_EQUAL:
+      return a <= b;
+    default:
+      break;
+  }
+  return false;
+}
+
+/*************************************/
+/* Values                            */
+/*************************************/
+
+int get_port_type_component_count(const VisualShaderNodePortType& type) noexcept {
+  switch (type) {
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR:
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR_INT:
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR_UINT:
+    case VisualShaderNodePortType::PORT_TYPE_BOOLEAN:
+      return 1;
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_2D:
+      return 2;
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_3D:
+      return 3;
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_4D:
+      return 4;
+    default:
+      break;
+  }
+  return 0;
+}
+
+Value make_zero_value(const VisualShaderNodePortType& type) noexcept {
+  Value value;
+  value.type = type;
+  return value;
+}
+
+Value convert_value(const Value& value, const VisualShaderNodePortType& to_type) noexcept {
+  if (value.type == to_type || to_type == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED) {
+    return value;
+  }
+
+  Value result;
+  result.type = to_type;
+
+  const int from_count{get_port_type_component_count(value.type)};
+  const bool is_from_vector{value.type == VisualShaderNodePortType::PORT_TYPE_VECTOR_2D ||
+                            value.type == VisualShaderNodePortType::PORT_TYPE_VECTOR_3D ||
+                            value.type == VisualShaderNodePortType::PORT_TYPE_VECTOR_4D};
+
+  switch (to_type) {
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR:
+      result.f[0] = as_float(value);
+      break;
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR_INT:
+      switch (value.type) {
+        case VisualShaderNodePortType::PORT_TYPE_SCALAR_UINT:
+          result.i = static_cast<int32_t>(value.u);
+          break;
+        case VisualShaderNodePortType::PORT_TYPE_BOOLEAN:
+          result.i = value.b ? 1 : 0;
+          break;
+        default:
+          result.i = float_to_int(value.f[0]);
+          break;
+      }
+      break;
+    case VisualShaderNodePortType::PORT_TYPE_SCALAR_UINT:
+      switch (value.type) {
+        case VisualShaderNodePortType::PORT_TYPE_SCALAR_INT:
+          result.u = static_cast<uint32_t>(value.i);
+          break;
+        case VisualShaderNodePortType::PORT_TYPE_BOOLEAN:
+          result.u = value.b ? 1u : 0u;
+          break;
+        default:
+          result.u = float_to_uint(value.f[0]);
+          break;
+      }
+      break;
+    case VisualShaderNodePortType::PORT_TYPE_BOOLEAN:
+      if (is_from_vector) {
+        // all(bvecN(v))
+        result.b = true;
+        for (int c{0}; c < from_count; ++c) result.b = result.b && (value.f[c] != 0.0f);
+      } else {
+        switch (value.type) {
+          case VisualShaderNodePortType::PORT_TYPE_SCALAR_INT:
+            result.b = value.i > 0;
+            break;
+          case VisualShaderNodePortType::PORT_TYPE_SCALAR_UINT:
+            result.b = value.u > 0u;
+            break;
+          default:
+            result.b = value.f[0] > 0.0f;
+            break;
+        }
+      }
+      break;
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_2D:
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_3D:
+    case VisualShaderNodePortType::PORT_TYPE_VECTOR_4D:
+      if (!is_from_vector) {
+        splat(result, as_float(value));
+        break;
+      }
+
+      for (int c{0}; c < 4; ++c) result.f[c] = c < from_count ? value.f[c] : 0.0f;
+
+      // vec4(v2, 0.0, 1.0) and vec4(v3, 1.0)
+      if (to_type == VisualShaderNodePortType::PORT_TYPE_VECTOR_4D) result.f[3] = 1.0f;
+      break;
+    default:
+      break;
+  }
+
+  return result;
+}
+
+/*************************************/
+/* Port Types                        */
+/*************************************/
+
+bool get_node_port_types(const VisualShader::VisualShaderNode& node,
+                         std::vector<VisualShaderNodePortType>& input_port_types,
+                         std::vector<VisualShaderNodePortType>& output_port_types) noexcept {
+  const google::protobuf::FieldDescriptor* oneof_field{
+      VisualShader::VisualShaderNode::descriptor()->FindFieldByNumber(node.node_type_case())};
+  CHECK_PARAM_NULLPTR_NON_VOID(oneof_field, false, "Node type is not set.");
+
+  const google::protobuf::MessageOptions& options{oneof_field->message_type()->options()};
+
+  const int input_port_count{options.GetExtension(gui::model::schema::node_input_port_count)};
+  const int output_port_count{options.GetExtension(gui::model::schema::node_output_port_count)};
+
+  input_port_types.assign(input_port_count, VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED);
+  output_port_types.assign(output_port_count, VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED);
+
+  for (int i{0}; i < input_port_count && i < options.ExtensionSize(gui::model::schema::node_input_port_type); ++i) {
+    input_port_types[i] = options.GetExtension(gui::model::schema::node_input_port_type, i);
+  }
+
+  for (int i{0}; i < output_port_count && i < options.ExtensionSize(gui::model::schema::node_output_port_type); ++i) {
+    output_port_types[i] = options.GetExtension(gui::model::schema::node_output_port_type, i);
+  }
+
+  auto set_all{[&](const VisualShaderNodePortType& type) {
+    input_port_types.assign(input_port_count, type);
+    output_port_types.assign(output_port_count, type);
+  }};
+
+  switch (node.node_type_case()) {
+    case VisualShader::VisualShaderNode::kInput: {
+      const google::protobuf::EnumValueDescriptor* value{
+          VisualShaderNodeInputType_descriptor()->FindValueByNumber(node.input().type())};
+      CHECK_PARAM_NULLPTR_NON_VOID(value, false, "Invalid input type.");
+      output_port_types.assign(output_port_count, value->options().GetExtension(gui::model::schema::value_port_type));
+    } break;
+    case VisualShader::VisualShaderNode::kVectorOp:
+      set_all(to_port_type(node.vector_op().type()));
+      break;
+    case VisualShader::VisualShaderNode::kVectorFunc:
+      set_all(to_port_type(node.vector_func().type()));
+      break;
+    case VisualShader::VisualShaderNode::kVectorLen:
+      if (node.vector_len().type() != VisualShaderNodeVectorType::TYPE_VECTOR_UNSPECIFIED) {
+        input_port_types.assign(input_port_count, to_port_type(node.vector_len().type()));
+      }
+      break;
+    case VisualShader::VisualShaderNode::kClamp:
+      set_all(node.clamp().type() == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED
+                  ? VisualShaderNodePortType::PORT_TYPE_SCALAR
+                  : node.clamp().type());
+      break;
+    case VisualShader::VisualShaderNode::kStep:
+      set_all(node.step().type() == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED
+                  ? VisualShaderNodePortType::PORT_TYPE_SCALAR
+                  : node.step().type());
+      break;
+    case VisualShader::VisualShaderNode::kSmoothStep:
+      set_all(node.smooth_step().type() == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED
+                  ? VisualShaderNodePortType::PORT_TYPE_SCALAR
+                  : node.smooth_step().type());
+      break;
+    case VisualShader::VisualShaderNode::kMix:
+      set_all(node.mix().type() == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED
+                  ? VisualShaderNodePortType::PORT_TYPE_SCALAR
+                  : node.mix().type());
+      break;
+    case VisualShader::VisualShaderNode::kSwitchNode: {
+      // The values of VisualShaderNodeSwitchOpType match VisualShaderNodePortType.
+      VisualShaderNodePortType type{static_cast<VisualShaderNodePortType>(node.switch_node().type())};
+      if (type == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED) type = VisualShaderNodePortType::PORT_TYPE_SCALAR;
+      input_port_types[1] = input_port_types[2] = type;
+      output_port_types[0] = type;
+    } break;
+    case VisualShader::VisualShaderNode::kCompare: {
+      // The values of ComparisonType match VisualShaderNodePortType.
+      VisualShaderNodePortType type{static_cast<VisualShaderNodePortType>(node.compare().type())};
+      if (type == VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED) type = VisualShaderNodePortType::PORT_TYPE_SCALAR;
+      input_port_types[0] = input_port_types[1] = type;
+    } break;
+    default:
+      break;
+  }
+
+  return true;
+}
+
+/*************************************/
+/* Evaluation                        */
+/*************************************/
+
+bool evaluate_node(const VisualShader::VisualShaderNode& node, const Value* inputs, Value* outputs,
+                   const EvaluationContext& context) noexcept {
+  switch (node.node_type_case()) {
+    case VisualShader::VisualShaderNode::kInput: {
+      switch (node.input().type()) {
+        case VisualShaderNodeInputType::INPUT_TYPE_UV:
+          outputs[0].f[0] = context.uv[0];
+          outputs[0].f[1] = context.uv[1];
+          break;
+        case VisualShaderNodeInputType::INPUT_TYPE_TIME:
+          outputs[0].f[0] = context.time;
+          break;
+        default:
+          break;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kOutput:
+      break;
+
+    /*************************************/
+    /* CONSTANTS                         */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kFloatConstant:
+      outputs[0].f[0] = node.float_constant().value();
+      break;
+    case VisualShader::VisualShaderNode::kIntConstant:
+      outputs[0].i = node.int_constant().value();
+      break;
+    case VisualShader::VisualShaderNode::kUintConstant:
+      outputs[0].u = node.uint_constant().value();
+      break;
+    case VisualShader::VisualShaderNode::kBooleanConstant:
+      outputs[0].b = node.boolean_constant().value();
+      break;
+    case VisualShader::VisualShaderNode::kColorConstant: {
+      const VisualShaderNodeColorConstant& c{node.color_constant()};
+      outputs[0].f[0] = c.r();
+      outputs[0].f[1] = c.g();
+      outputs[0].f[2] = c.b();
+      outputs[0].f[3] = c.a();
+    } break;
+    case VisualShader::VisualShaderNode::kVec2Constant:
+      outputs[0].f[0] = node.vec2_constant().x();
+      outputs[0].f[1] = node.vec2_constant().y();
+      break;
+    case VisualShader::VisualShaderNode::kVec3Constant:
+      outputs[0].f[0] = node.vec3_constant().x();
+      outputs[0].f[1] = node.vec3_constant().y();
+      outputs[0].f[2] = node.vec3_constant().z();
+      break;
+    case VisualShader::VisualShaderNode::kVec4Constant:
+      outputs[0].f[0] = node.vec4_constant().x();
+      outputs[0].f[1] = node.vec4_constant().y();
+      outputs[0].f[2] = node.vec4_constant().z();
+      outputs[0].f[3] = node.vec4_constant().w();
+      break;
+
+    /*************************************/
+    /* OPERATORS                         */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kFloatOp:
+      outputs[0].f[0] = apply_float_op(node.float_op().op(), inputs[0].f[0], inputs[1].f[0]);
+      break;
+    case VisualShader::VisualShaderNode::kIntOp:
+      outputs[0].i = apply_int_op(node.int_op().op(), inputs[0].i, inputs[1].i);
+      break;
+    case VisualShader::VisualShaderNode::kUintOp:
+      outputs[0].u = apply_uint_op(node.uint_op().op(), inputs[0].u, inputs[1].u);
+      break;
+    case VisualShader::VisualShaderNode::kVectorOp: {
+      const float* a{inputs[0].f};
+      const float* b{inputs[1].f};
+      float* r{outputs[0].f};
+      const int n{get_port_type_component_count(outputs[0].type)};
+
+      switch (node.vector_op().op()) {
+        case VisualShaderNodeVectorOp::OP_ADD:
+          for (int c{0}; c < n; ++c) r[c] = a[c] + b[c];
+          break;
+        case VisualShaderNodeVectorOp::OP_SUB:
+          for (int c{0}; c < n; ++c) r[c] = a[c] - b[c];
+          break;
+        case VisualShaderNodeVectorOp::OP_MUL:
+          for (int c{0}; c < n; ++c) r[c] = a[c] * b[c];
+          break;
+        case VisualShaderNodeVectorOp::OP_DIV:
+          for (int c{0}; c < n; ++c) r[c] = a[c] / b[c];
+          break;
+        case VisualShaderNodeVectorOp::OP_MOD:
+          for (int c{0}; c < n; ++c) r[c] = evaluator_utils::mod(a[c], b[c]);
+          break;
+        case VisualShaderNodeVectorOp::OP_POW:
+          for (int c{0}; c < n; ++c) r[c] = std::pow(a[c], b[c]);
+          break;
+        case VisualShaderNodeVectorOp::OP_MAX:
+          for (int c{0}; c < n; ++c) r[c] = std::fmax(a[c], b[c]);
+          break;
+        case VisualShaderNodeVectorOp::OP_MIN:
+          for (int c{0}; c < n; ++c) r[c] = std::fmin(a[c], b[c]);
+          break;
+        case VisualShaderNodeVectorOp::OP_CROSS:
+          if (n == 3) {
+            r[0] = a[1] * b[2] - b[1] * a[2];
+            r[1] = a[2] * b[0] - b[2] * a[0];
+            r[2] = a[0] * b[1] - b[0] * a[1];
+          } else {
+            for (int c{0}; c < n; ++c) r[c] = 0.0f;  // Not supported.
+          }
+          break;
+        case VisualShaderNodeVectorOp::OP_ATAN2:
+          for (int c{0}; c < n; ++c) r[c] = std::atan2(a[c], b[c]);
+          break;
+        case VisualShaderNodeVectorOp::OP_REFLECT: {
+          // I - 2.0 * dot(N, I) * N
+          float d{0.0f};
+          for (int c{0}; c < n; ++c) d += b[c] * a[c];
+          for (int c{0}; c < n; ++c) r[c] = a[c] - 2.0f * d * b[c];
+        } break;
+        case VisualShaderNodeVectorOp::OP_STEP:
+          for (int c{0}; c < n; ++c) r[c] = evaluator_utils::step(a[c], b[c]);
+          break;
+        default:
+          break;
+      }
+    } break;
+
+    /*************************************/
+    /* Funcs Node                        */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kFloatFunc:
+      outputs[0].f[0] = apply_float_func(node.float_func().func(), inputs[0].f[0]);
+      break;
+    case VisualShader::VisualShaderNode::kIntFunc: {
+      const int32_t x{inputs[0].i};
+      switch (node.int_func().func()) {
+        case VisualShaderNodeIntFunc::FUNC_ABS:
+          outputs[0].i = x < 0 ? static_cast<int32_t>(0u - static_cast<uint32_t>(x)) : x;
+          break;
+        case VisualShaderNodeIntFunc::FUNC_NEGATE:
+          outputs[0].i = static_cast<int32_t>(0u - static_cast<uint32_t>(x));
+          break;
+        case VisualShaderNodeIntFunc::FUNC_SIGN:
+          outputs[0].i = x > 0 ? 1 : (x < 0 ? -1 : 0);
+          break;
+        case VisualShaderNodeIntFunc::FUNC_BITWISE_NOT:
+          outputs[0].i = ~x;
+          break;
+        default:
+          break;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kUintFunc: {
+      const uint32_t x{inputs[0].u};
+      switch (node.uint_func().func()) {
+        case VisualShaderNodeUIntFunc::FUNC_NEGATE:
+          outputs[0].u = 0u - x;
+          break;
+        case VisualShaderNodeUIntFunc::FUNC_BITWISE_NOT:
+          outputs[0].u = ~x;
+          break;
+        default:
+          break;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kVectorFunc: {
+      const float* x{inputs[0].f};
+      float* r{outputs[0].f};
+      const int n{get_port_type_component_count(outputs[0].type)};
+
+      switch (node.vector_func().func()) {
+        case VisualShaderNodeVectorFunc::FUNC_NORMALIZE: {
+          float len{0.0f};
+          for (int c{0}; c < n; ++c) len += x[c] * x[c];
+          len = std::sqrt(len);
+          for (int c{0}; c < n; ++c) r[c] = x[c] / len;
+        } break;
+        case VisualShaderNodeVectorFunc::FUNC_SATURATE:
+          for (int c{0}; c < n; ++c) r[c] = std::fmax(std::fmin(x[c], 1.0f), 0.0f);
+          break;
+        default: {
+          const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType func{to_float_func(node.vector_func().func())};
+          for (int c{0}; c < n; ++c) r[c] = apply_float_func(func, x[c]);
+        } break;
+      }
+    } break;
+
+    /*************************************/
+    /* NOISE                             */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kValueNoise:
+      splat(outputs[0], generate_value_noise_float(inputs[0].f[0], inputs[0].f[1], node.value_noise().scale()));
+      outputs[0].f[3] = 1.0f;
+      break;
+    case VisualShader::VisualShaderNode::kPerlinNoise:
+      splat(outputs[0], generate_perlin_noise_float(inputs[0].f[0], inputs[0].f[1], node.perlin_noise().scale()));
+      outputs[0].f[3] = 1.0f;
+      break;
+    case VisualShader::VisualShaderNode::kVoronoiNoise:
+      splat(outputs[0], generate_voronoi_noise_float(inputs[0].f[0], inputs[0].f[1],
+                                                     node.voronoi_noise().angle_offset(),
+                                                     node.voronoi_noise().cell_density()));
+      outputs[0].f[3] = 1.0f;
+      break;
+
+    /*************************************/
+    /* MISC                              */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kDotProduct:
+      outputs[0].f[0] = inputs[0].f[0] * inputs[1].f[0] + inputs[0].f[1] * inputs[1].f[1] +
+                        inputs[0].f[2] * inputs[1].f[2];
+      break;
+    case VisualShader::VisualShaderNode::kVectorLen: {
+      const int n{get_port_type_component_count(inputs[0].type)};
+      float len{0.0f};
+      for (int c{0}; c < n; ++c) len += inputs[0].f[c] * inputs[0].f[c];
+      outputs[0].f[0] = std::sqrt(len);
+    } break;
+    case VisualShader::VisualShaderNode::kClamp: {
+      switch (outputs[0].type) {
+        case VisualShaderNodePortType::PORT_TYPE_SCALAR_INT:
+          outputs[0].i = std::min(std::max(inputs[0].i, inputs[1].i), inputs[2].i);
+          break;
+        case VisualShaderNodePortType::PORT_TYPE_SCALAR_UINT:
+          outputs[0].u = std::min(std::max(inputs[0].u, inputs[1].u), inputs[2].u);
+          break;
+        case VisualShaderNodePortType::PORT_TYPE_BOOLEAN:
+          outputs[0].b = evaluator_utils::clamp(as_float(inputs[0]), as_float(inputs[1]), as_float(inputs[2])) > 0.0f;
+          break;
+        default: {
+          const int n{get_port_type_component_count(outputs[0].type)};
+          for (int c{0}; c < n; ++c) {
+            outputs[0].f[c] = evaluator_utils::clamp(inputs[0].f[c], inputs[1].f[c], inputs[2].f[c]);
+          }
+        } break;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kStep:
+    case VisualShader::VisualShaderNode::kSmoothStep:
+    case VisualShader::VisualShaderNode::kMix: {
+      const bool is_three_args{node.node_type_case() != VisualShader::VisualShaderNode::kStep};
+
+      // These functions only have floating point overloads in GLSL, evaluate
+      // other types as floats and convert the result back.
+      Value a{convert_value(inputs[0], VisualShaderNodePortType::PORT_TYPE_VECTOR_4D)};
+      Value b{convert_value(inputs[1], VisualShaderNodePortType::PORT_TYPE_VECTOR_4D)};
+      Value t{is_three_args ? convert_value(inputs[2], VisualShaderNodePortType::PORT_TYPE_VECTOR_4D) : Value()};
+      if (get_port_type_component_count(outputs[0].type) > 1) {
+        a = inputs[0];
+        b = inputs[1];
+        if (is_three_args) t = inputs[2];
+      }
+
+      Value r;
+      r.type = VisualShaderNodePortType::PORT_TYPE_VECTOR_4D;
+      for (int c{0}; c < 4; ++c) {
+        switch (node.node_type_case()) {
+          case VisualShader::VisualShaderNode::kStep:
+            r.f[c] = evaluator_utils::step(a.f[c], b.f[c]);
+            break;
+          case VisualShader::VisualShaderNode::kSmoothStep:
+            r.f[c] = evaluator_utils::smoothstep(a.f[c], b.f[c], t.f[c]);
+            break;
+          default:
+            r.f[c] = evaluator_utils::mix(a.f[c], b.f[c], t.f[c]);
+            break;
+        }
+      }
+
+      if (get_port_type_component_count(outputs[0].type) > 1) {
+        for (int c{0}; c < 4; ++c) outputs[0].f[c] = r.f[c];
+      } else {
+        Value s{make_zero_value(VisualShaderNodePortType::PORT_TYPE_SCALAR)};
+        s.f[0] = r.f[0];
+        outputs[0] = convert_value(s, outputs[0].type);
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kVectorDistance: {
+      float len{0.0f};
+      for (int c{0}; c < 3; ++c) {
+        const float d{inputs[0].f[c] - inputs[1].f[c]};
+        len += d * d;
+      }
+      outputs[0].f[0] = std::sqrt(len);
+    } break;
+    case VisualShader::VisualShaderNode::kVector2DCompose:
+      outputs[0].f[0] = inputs[0].f[0];
+      outputs[0].f[1] = inputs[1].f[0];
+      break;
+    case VisualShader::VisualShaderNode::kVector3DCompose:
+      outputs[0].f[0] = inputs[0].f[0];
+      outputs[0].f[1] = inputs[1].f[0];
+      outputs[0].f[2] = inputs[2].f[0];
+      break;
+    case VisualShader::VisualShaderNode::kVector4DCompose:
+      outputs[0].f[0] = inputs[0].f[0];
+      outputs[0].f[1] = inputs[1].f[0];
+      outputs[0].f[2] = inputs[2].f[0];
+      outputs[0].f[3] = inputs[3].f[0];
+      break;
+    case VisualShader::VisualShaderNode::kVector2DDecompose:
+      for (int c{0}; c < 2; ++c) outputs[c].f[0] = inputs[0].f[c];
+      break;
+    case VisualShader::VisualShaderNode::kVector3DDecompose:
+      for (int c{0}; c < 3; ++c) outputs[c].f[0] = inputs[0].f[c];
+      break;
+    case VisualShader::VisualShaderNode::kVector4DDecompose:
+      for (int c{0}; c < 4; ++c) outputs[c].f[0] = inputs[0].f[c];
+      break;
+
+    /*************************************/
+    /* Logic                             */
+    /*************************************/
+
+    case VisualShader::VisualShaderNode::kIfNode: {
+      const float p1{inputs[0].f[0]}, p2{inputs[1].f[0]}, tolerance{inputs[2].f[0]};
+      if (std::fabs(p1 - p2) < tolerance) {
+        outputs[0] = inputs[3];
+      } else if (p1 < p2) {
+        outputs[0] = inputs[5];
+      } else {
+        outputs[0] = inputs[4];
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kSwitchNode: {
+      switch (node.switch_node().type()) {
+        case VisualShaderNodeSwitch::OP_TYPE_FLOAT:
+        case VisualShaderNodeSwitch::OP_TYPE_VECTOR_2D:
+        case VisualShaderNodeSwitch::OP_TYPE_VECTOR_3D:
+        case VisualShaderNodeSwitch::OP_TYPE_VECTOR_4D: {
+          // mix(false_value, true_value, float(condition))
+          const float t{inputs[0].b ? 1.0f : 0.0f};
+          const int n{get_port_type_component_count(outputs[0].type)};
+          for (int c{0}; c < n; ++c) outputs[0].f[c] = evaluator_utils::mix(inputs[2].f[c], inputs[1].f[c], t);
+        } break;
+        default:
+          outputs[0] = inputs[0].b ? inputs[1] : inputs[2];
+          break;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kIs: {
+      switch (node.is().func()) {
+        case VisualShaderNodeIs::FUNC_IS_INF:
+          outputs[0].b = std::isinf(inputs[0].f[0]);
+          break;
+        case VisualShaderNodeIs::FUNC_IS_NAN:
+          outputs[0].b = std::isnan(inputs[0].f[0]);
+          break;
+        default:
+          break;
+      }
+    } break;
+    case VisualShader::VisualShaderNode::kCompare: {
+      const VisualShaderNodeCompare& compare{node.compare()};
+      bool& r{outputs[0].b};
+      switch (compare.type()) {
+        case VisualShaderNodeCompare::CMP_TYPE_SCALAR: {
+          const float a{inputs[0].f[0]}, b{inputs[1].f[0]}, tolerance{inputs[2].f[0]};
+          switch (compare.func()) {
+            case VisualShaderNodeCompare::FUNC_EQUAL:
+              r = std::fabs(a - b) < tolerance;
+              break;
+            case VisualShaderNodeCompare::FUNC_NOT_EQUAL:
+              r = !(std::fabs(a - b) < tolerance);
+              break;
+            default:
+              r = compare_floats(compare.func(), a, b);
+              break;
+          }
+        } break;
+        case VisualShaderNodeCompare::CMP_TYPE_SCALAR_INT:
+          r = compare_integers(compare.func(), inputs[0].i, inputs[1].i);
+          break;
+        case VisualShaderNodeCompare::CMP_TYPE_SCALAR_UINT:
+          r = compare_integers(compare.func(), inputs[0].u, inputs[1].u);
+          break;
+        case VisualShaderNodeCompare::CMP_TYPE_VECTOR_2D:
+        case VisualShaderNodeCompare::CMP_TYPE_VECTOR_3D:
+        case VisualShaderNodeCompare::CMP_TYPE_VECTOR_4D: {
+          const int n{get_port_type_component_count(inputs[0].type)};
+          bool all{true}, any{false};
+          for (int c{0}; c < n; ++c) {
+            const bool bv{compare_floats(compare.func(), inputs[0].f[c], inputs[1].f[c])};
+            all = all && bv;
+            any = any || bv;
+          }
+          switch (compare.cond()) {
+            case VisualShaderNodeCompare::COND_ALL:
+              r = all;
+              break;
+            case VisualShaderNodeCompare::COND_ANY:
+              r = any;
+              break;
+            default:
+              break;
+          }
+        } break;
+        case VisualShaderNodeCompare::CMP_TYPE_BOOLEAN:
+          switch (compare.func()) {
+            case VisualShaderNodeCompare::FUNC_EQUAL:
+              r = inputs[0].b == inputs[1].b;
+              break;
+            case VisualShaderNodeCompare::FUNC_NOT_EQUAL:
+              r = inputs[0].b != inputs[1].b;
+              break;
+            default:
+              r = false;
+              break;
+          }
+          break;
+        default:
+          break;
+      }
+    } break;
+    default:
+      FAIL_AND_RETURN_NON_VOID(false, "Unsupported node type: " + std::to_string(node.node_type_case()));
+  }
+
+  return true;
+}
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,120 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_NODE_EVALUATORS_HPP
+#define ENIGMA_VISUAL_SHADER_NODE_EVALUATORS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "gui/model/schema/visual_shader.pb.h"
+#include "gui/model/schema/visual_shader_nodes.pb.h"
+
+using namespace gui::model::schema;
+
+namespace shadergen_visual_shader_evaluator {
+/**
+ * @brief A GLSL value flowing through a port. Only the member matching
+ *        @c type is meaningful: @c f holds scalars and vectors (using as many
+ *        components as the type has), @c i, @c u and @c b hold int, uint and
+ *        bool values respectively.
+ */
+struct Value {
+  VisualShaderNodePortType type{VisualShaderNodePortType::PORT_TYPE_UNSPECIFIED};
+  float f[4]{0.0f, 0.0f, 0.0f, 0.0f};
+  int32_t i{0};
+  uint32_t u{0};
+  bool b{false};
+};
+
+/**
+ * @brief Per-pixel inputs of the shader. @c uv is the value of @c FragCoord
+ *        and @c time is the value of @c uTime.
+ */
+struct EvaluationContext {
+  float uv[2]{0.0f, 0.0f};
+  float time{0.0f};
+};
+
+int get_port_type_component_count(const VisualShaderNodePortType& type) noexcept;
+
+float apply_float_op(const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType& op, const float& a,
+                     const float& b) noexcept;
+
+float apply_float_func(const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType& func, const float& x) noexcept;
+
+/**
+ * @brief Maps the component-wise vector operators and functions to their
+ *        scalar counterparts. Returns the unspecified value for the ones that
+ *        are not component-wise (cross, reflect, normalize, ...).
+ */
+VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType to_float_op(
+    const VisualShaderNodeVectorOp::VisualShaderNodeVectorOpType& op) noexcept;
+
+VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType to_float_func(
+    const VisualShaderNodeVectorFunc::VisualShaderNodeVectorFuncType& func) noexcept;
+
+/**
+ * @brief Vector nodes with an unspecified vector type are treated as 3D.
+ */
+VisualShaderNodePortType to_port_type(const VisualShaderNodeVectorType& type) noexcept;
+
+/**
+ * @brief Creates the default value the generator assigns to an unconnected
+ *        input port of the given type (zero).
+ */
+Value make_zero_value(const VisualShaderNodePortType& type) noexcept;
+
+/**
+ * @brief Converts a value to another port type using the same rules the
+ *        generator uses when connecting two ports of different types.
+ */
+Value convert_value(const Value& value, const VisualShaderNodePortType& to_type) noexcept;
+
+/**
+ * @brief Resolves the types of the input and output ports of a node.
+ *
+ * @note Ports declared as @c PORT_TYPE_UNSPECIFIED in the schema are resolved
+ *       from the node's own type field (for example @c VisualShaderNodeVectorOp::type
+ *       or @c VisualShaderNodeMix::type). The output type of an Input node is
+ *       resolved from its input type.
+ */
+bool get_node_port_types(const VisualShader::VisualShaderNode& node,
+                         std::vector<VisualShaderNodePortType>& input_port_types,
+                         std::vector<VisualShaderNodePortType>& output_port_types) noexcept;
+
+/**
+ * @brief Evaluates a single node for one pixel.
+ *
+ * @param inputs Input values, already converted to the resolved input port types.
+ * @param outputs Output values, must have room for all output ports of the node.
+ */
+bool evaluate_node(const VisualShader::VisualShaderNode& node, const Value* inputs, Value* outputs,
+                   const EvaluationContext& context) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_NODE_EVALUATORS_HPP
@@ -0,0 +1,165 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "evaluator/vs_node_noise_evaluators.hpp"
+
+#include <cmath>
+
+#include "evaluator/utils/utils.hpp"
+
+namespace shadergen_visual_shader_evaluator {
+
+/*************************************/
+/* Value (Simple) Noise              */
+/*************************************/
+
+float noise_random_value(const float& x, const float& y) noexcept {
+  return evaluator_utils::fract(evaluator_utils::sin(x * 12.9898f + y * 78.233f) * 43758.5453f);
+}
+
+float value_noise(const float& x, const float& y) noexcept {
+  const float ix{std::floor(x)}, iy{std::floor(y)};
+  float fx{evaluator_utils::fract(x)}, fy{evaluator_utils::fract(y)};
+  fx = fx * fx * (3.0f - 2.0f * fx);
+  fy = fy * fy * (3.0f - 2.0f * fy);
+
+  const float r0{noise_random_value(ix, iy)};
+  const float r1{noise_random_value(ix + 1.0f, iy)};
+  const float r2{noise_random_value(ix, iy + 1.0f)};
+  const float r3{noise_random_value(ix + 1.0f, iy + 1.0f)};
+
+  // noise_interpolate(a, b, t) is (1.0-t)*a + (t*b)
+  const float bottom_of_grid{(1.0f - fx) * r0 + (fx * r1)};
+  const float top_of_grid{(1.0f - fx) * r2 + (fx * r3)};
+  return (1.0f - fy) * bottom_of_grid + (fy * top_of_grid);
+}
+
+float generate_value_noise_float(const float& u, const float& v, const float& scale) noexcept {
+  float t{0.0f};
+
+  for (int i{0}; i < 3; ++i) {
+    const float freq{std::pow(2.0f, float(i))};
+    const float amp{std::pow(0.5f, float(3 - i))};
+    t += value_noise(u * scale / freq, v * scale / freq) * amp;
+  }
+
+  return t;
+}
+
+/*************************************/
+/* Perlin (Gradient) Noise           */
+/*************************************/
+
+void perlin_noise_dir(const float& x, const float& y, float& dir_x, float& dir_y) noexcept {
+  const float px{evaluator_utils::mod(x, 289.0f)};
+  const float py{evaluator_utils::mod(y, 289.0f)};
+
+  float t{evaluator_utils::mod((34.0f * px + 1.0f) * px, 289.0f) + py};
+  t = evaluator_utils::mod((34.0f * t + 1.0f) * t, 289.0f);
+  t = evaluator_utils::fract(t / 41.0f) * 2.0f - 1.0f;
+
+  dir_x = t - std::floor(t + 0.5f);
+  dir_y = std::fabs(t) - 0.5f;
+
+  const float len{std::sqrt(dir_x * dir_x + dir_y * dir_y)};
+  dir_x /= len;
+  dir_y /= len;
+}
+
+float perlin_noise(const float& x, const float& y) noexcept {
+  const float ipx{std::floor(x)}, ipy{std::floor(y)};
+  float fpx{evaluator_utils::fract(x)}, fpy{evaluator_utils::fract(y)};
+
+  float dx, dy;
+
+  perlin_noise_dir(ipx, ipy, dx, dy);
+  const float d00{dx * fpx + dy * fpy};
+
+  perlin_noise_dir(ipx, ipy + 1.0f, dx, dy);
+  const float d01{dx * fpx + dy * (fpy - 1.0f)};
+
+  perlin_noise_dir(ipx + 1.0f, ipy, dx, dy);
+  const float d10{dx * (fpx - 1.0f) + dy * fpy};
+
+  perlin_noise_dir(ipx + 1.0f, ipy + 1.0f, dx, dy);
+  const float d11{dx * (fpx - 1.0f) + dy * (fpy - 1.0f)};
+
+  fpx = fpx * fpx * fpx * (fpx * (fpx * 6.0f - 15.0f) + 10.0f);
+  fpy = fpy * fpy * fpy * (fpy * (fpy * 6.0f - 15.0f) + 10.0f);
+
+  return evaluator_utils::mix(evaluator_utils::mix(d00, d01, fpy), evaluator_utils::mix(d10, d11, fpy), fpx);
+}
+
+float generate_perlin_noise_float(const float& u, const float& v, const float& scale) noexcept {
+  return perlin_noise(u * scale, v * scale) + 0.5f;
+}
+
+/*************************************/
+/* Voronoi (Worley) Noise            */
+/*************************************/
+
+void voronoi_noise_random_vector(const float& x, const float& y, const float& offset, float& out_x,
+                                 float& out_y) noexcept {
+  // mat2(15.27, 47.63, 99.41, 89.98) is column-major.
+  const float mx{15.27f * x + 99.41f * y};
+  const float my{47.63f * x + 89.98f * y};
+
+  const float ux{evaluator_utils::fract(evaluator_utils::sin(mx) * 46839.32f)};
+  const float uy{evaluator_utils::fract(evaluator_utils::sin(my) * 46839.32f)};
+
+  out_x = evaluator_utils::sin(uy * offset) * 0.5f + 0.5f;
+  out_y = evaluator_utils::cos(ux * offset) * 0.5f + 0.5f;
+}
+
+float generate_voronoi_noise_float(const float& u, const float& v, const float& angle_offset,
+                                   const float& cell_density) noexcept {
+  const float gx{std::floor(u * cell_density)}, gy{std::floor(v * cell_density)};
+  const float fx{evaluator_utils::fract(u * cell_density)}, fy{evaluator_utils::fract(v * cell_density)};
+
+  float out_buffer{0.0f};
+  float res{8.0f};
+
+  for (int y{-1}; y <= 1; y++) {
+    for (int x{-1}; x <= 1; x++) {
+      const float lx{float(x)}, ly{float(y)};
+
+      float ox, oy;
+      voronoi_noise_random_vector(lx + gx, ly + gy, angle_offset, ox, oy);
+
+      const float dx{lx + ox - fx}, dy{ly + oy - fy};
+      const float d{std::sqrt(dx * dx + dy * dy)};
+
+      if (d < res) {
+        res = d;
+        out_buffer = res;
+      }
+    }
+  }
+
+  return out_buffer;
+}
+}  // namespace shadergen_visual_shader_evaluator
@@ -0,0 +1,69 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef ENIGMA_VISUAL_SHADER_NODE_NOISE_EVALUATORS_HPP
+#define ENIGMA_VISUAL_SHADER_NODE_NOISE_EVALUATORS_HPP
+
+/**
+ * @brief CPU ports of the noise functions emitted by
+ *        @c generator/vs_node_noise_generators.cpp. Each function mirrors
+ *        its GLSL counterpart line by line, keep them in sync.
+ */
+namespace shadergen_visual_shader_evaluator {
+
+/*************************************/
+/* Value (Simple) Noise              */
+/*************************************/
+
+float noise_random_value(const float& x, const float& y) noexcept;
+
+float value_noise(const float& x, const float& y) noexcept;
+
+float generate_value_noise_float(const float& u, const float& v, const float& scale) noexcept;
+
+/*************************************/
+/* Perlin (Gradient) Noise           */
+/*************************************/
+
+void perlin_noise_dir(const float& x, const float& y, float& dir_x, float& dir_y) noexcept;
+
+float perlin_noise(const float& x, const float& y) noexcept;
+
+float generate_perlin_noise_float(const float& u, const float& v, const float& scale) noexcept;
+
+/*************************************/
+/* Voronoi (Worley) Noise            */
+/*************************************/
+
+void voronoi_noise_random_vector(const float& x, const float& y, const float& offset, float& out_x,
+                                 float& out_y) noexcept;
+
+float generate_voronoi_noise_float(const float& u, const float& v, const float& angle_offset,
+                                   const float& cell_density) noexcept;
+}  // namespace shadergen_visual_shader_evaluator
+
+#endif  // ENIGMA_VISUAL_SHADER_NODE_NOISE_EVALUATORS_HPP
@@ -43,24 +43,27 @@ std::unordered_map<int, std::shared_ptr<IVisualShaderProtoNode>> to_proto_nodes(
   std::unordered_map<int, std::shared_ptr<IVisualShaderProtoNode>> proto_nodes;
 
   // Cast to ReapeatedMessageModel
-  const RepeatedMessageModel* repeated_nodes{dynamic_cast<const RepeatedMessageModel*>(nodes)};
+  const RepeatedMessageModel* repeated_nodes{model_cast<RepeatedMessageModel>(nodes)};
   CHECK_PARAM_NULLPTR_NON_VOID(repeated_nodes, proto_nodes, "Nodes is not a repeated message model.");
 
+  // Built once, looked up for every node.
+  static const CompiledFieldPath id_path{CompiledFieldPath::Of<VisualShader::VisualShaderNode>(
+      FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber))};
+  // I don't care about the field number, just send any field number inside the oneof model you want to get
+  static const CompiledFieldPath oneof_path{CompiledFieldPath::Of<VisualShader::VisualShaderNode>(
+      FieldPath::FieldNumber(VisualShader::VisualShaderNode::kInputFieldNumber))};
+
   for (int i{0}; i < size; ++i) {
     const MessageModel* node_model{repeated_nodes->get_sub_model(i)};
 
-    const int n_id{node_model->get_sub_model(FieldPath::Of<VisualShader::VisualShaderNode>(
-        FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber)))->data().toInt()};
+    int n_id{0};
+    CHECK_CONDITION_TRUE_NON_VOID(!node_model->get(id_path.bind(), n_id), proto_nodes, "Failed to get node id.");
 
     if (proto_nodes.find(n_id) != proto_nodes.end()) {
       FAIL_AND_RETURN_NON_VOID(proto_nodes, "Node id already exists.");
     }
 
-    // I don't care about the field number, just send any field number inside the oneof model you want to get
-    const ProtoModel* oneof_model{
-        node_model->get_sub_model(FieldPath::Of<VisualShader::VisualShaderNode>(
-                                      FieldPath::FieldNumber(VisualShader::VisualShaderNode::kInputFieldNumber)),
-                                  false, true)};
+    const ProtoModel* oneof_model{node_model->get_sub_model(oneof_path.bind(), false, true)};
     CHECK_PARAM_NULLPTR_NON_VOID(oneof_model, proto_nodes, "Oneof Model is nullptr.");
     const int oneof_value_field_number{oneof_model->get_oneof_value_field_number()};
 
@@ -76,24 +79,27 @@ std::unordered_map<int, std::shared_ptr<VisualShaderNodeGenerator>> to_generator
   std::unordered_map<int, std::shared_ptr<VisualShaderNodeGenerator>> generators;
 
   // Cast to ReapeatedMessageModel
-  const RepeatedMessageModel* repeated_nodes{dynamic_cast<const RepeatedMessageModel*>(nodes)};
+  const RepeatedMessageModel* repeated_nodes{model_cast<RepeatedMessageModel>(nodes)};
   CHECK_PARAM_NULLPTR_NON_VOID(repeated_nodes, generators, "Nodes is not a repeated message model.");
 
+  // Built once, looked up for every node.
+  static const CompiledFieldPath id_path{CompiledFieldPath::Of<VisualShader::VisualShaderNode>(
+      FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber))};
+  // I don't care about the field number, just send any field number inside the oneof model you want to get
+  static const CompiledFieldPath oneof_path{CompiledFieldPath::Of<VisualShader::VisualShaderNode>(
+      FieldPath::FieldNumber(VisualShader::VisualShaderNode::kInputFieldNumber))};
+
   for (int i{0}; i < size; ++i) {
     const MessageModel* node_model{repeated_nodes->get_sub_model(i)};
 
-    const int n_id{node_model->get_sub_model(FieldPath::Of<VisualShader::VisualShaderNode>(
-        FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber)))->data().toInt()};
+    int n_id{0};
+    CHECK_CONDITION_TRUE_NON_VOID(!node_model->get(id_path.bind(), n_id), generators, "Failed to get node id.");
 
     if (generators.find(n_id) != generators.end()) {
       FAIL_AND_RETURN_NON_VOID(generators, "Node ID already exists in the generators map.");
     }
 
-    // I don't care about the field number, just send any field number inside the oneof model you want to get
-    const ProtoModel* oneof_model{
-        node_model->get_sub_model(FieldPath::Of<VisualShader::VisualShaderNode>(
-                                      FieldPath::FieldNumber(VisualShader::VisualShaderNode::kInputFieldNumber)),
-                                  false, true)};
+    const ProtoModel* oneof_model{node_model->get_sub_model(oneof_path.bind(), false, true)};
     CHECK_PARAM_NULLPTR_NON_VOID(oneof_model, generators, "Oneof Model is nullptr.");
     const int oneof_value_field_number{oneof_model->get_oneof_value_field_number()};
 
@@ -375,21 +381,41 @@ std::pair<std::map<ConnectionKey, std::shared_ptr<Connection>>, std::map<Connect
   int size{connections->rowCount()};
 
   // Cast to ReapeatedMessageModel
-  const RepeatedMessageModel* repeated_connections{dynamic_cast<const RepeatedMessageModel*>(connections)};
+  const RepeatedMessageModel* repeated_connections{model_cast<RepeatedMessageModel>(connections)};
   CHECK_PARAM_NULLPTR_NON_VOID(repeated_connections, std::make_pair(input_connections, output_connections), "Connections is not a repeated message model.");
 
+  // Built once, looked up for every connection.
+  static const CompiledFieldPath from_node_id_path{CompiledFieldPath::Of<VisualShader::VisualShaderConnection>(
+      FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kFromNodeIdFieldNumber))};
+  static const CompiledFieldPath from_port_index_path{CompiledFieldPath::Of<VisualShader::VisualShaderConnection>(
+      FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kFromPortIndexFieldNumber))};
+  static const CompiledFieldPath to_node_id_path{CompiledFieldPath::Of<VisualShader::VisualShaderConnection>(
+      FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kToNodeIdFieldNumber))};
+  static const CompiledFieldPath to_port_index_path{CompiledFieldPath::Of<VisualShader::VisualShaderConnection>(
+      FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kToPortIndexFieldNumber))};
+
   for (int i{0}; i < size; ++i) {
     const MessageModel* connection_model{repeated_connections->get_sub_model(i)};
 
+    int from_node_id{0}, from_port_index{0}, to_node_id{0}, to_port_index{0};
+    CHECK_CONDITION_TRUE_NON_VOID(!connection_model->get(from_node_id_path.bind(), from_node_id),
+                                  std::make_pair(input_connections, output_connections),
+                                  "Failed to get connection from node id.");
+    CHECK_CONDITION_TRUE_NON_VOID(!connection_model->get(from_port_index_path.bind(), from_port_index),
+                                  std::make_pair(input_connections, output_connections),
+                                  "Failed to get connection from port index.");
+    CHECK_CONDITION_TRUE_NON_VOID(!connection_model->get(to_node_id_path.bind(), to_node_id),
+                                  std::make_pair(input_connections, output_connections),
+                                  "Failed to get connection to node id.");
+    CHECK_CONDITION_TRUE_NON_VOID(!connection_model->get(to_port_index_path.bind(), to_port_index),
+                                  std::make_pair(input_connections, output_connections),
+                                  "Failed to get connection to port index.");
+
     std::shared_ptr<Connection> c = std::make_shared<Connection>();
-    c->from.f_key.node = connection_model->get_sub_model(FieldPath::Of<VisualShader::VisualShaderConnection>(
-        FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kFromNodeIdFieldNumber)))->data().toInt();
-    c->from.f_key.port = connection_model->get_sub_model(FieldPath::Of<VisualShader::VisualShaderConnection>(
-        FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kFromPortIndexFieldNumber)))->data().toInt();
-    c->to.f_key.node = connection_model->get_sub_model(FieldPath::Of<VisualShader::VisualShaderConnection>(
-        FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kToNodeIdFieldNumber)))->data().toInt();
-    c->to.f_key.port = connection_model->get_sub_model(FieldPath::Of<VisualShader::VisualShaderConnection>(
-        FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kToPortIndexFieldNumber)))->data().toInt();
+    c->from.f_key.node = from_node_id;
+    c->from.f_key.port = from_port_index;
+    c->to.f_key.node = to_node_id;
+    c->to.f_key.port = to_port_index;
 
     ConnectionKey from_key;
     from_key.f_key.node = c->from.f_key.node;
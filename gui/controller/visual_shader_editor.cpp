@@ -27,11 +27,17 @@
 
 #include "gui/controller/visual_shader_editor.hpp"
 
+#include <QtGui/QImage>
+#include <QtWidgets/QFileDialog>
+#include <QtWidgets/QMessageBox>
+
+#include <random>
 #include <sstream>
 #include <unordered_map>
 #include "error_macros.hpp"
 #include "gui/model/utils/utils.hpp"
 #include "gui/model/oneof_model.hpp"
+#include "gui/model/primitive_model.hpp"
 
 #include "generator/visual_shader_generator.hpp"
 
@@ -70,6 +76,8 @@ VisualShaderEditor::VisualShaderEditor(MessageModel* model, QWidget* parent)
       load_image_button(nullptr),
       match_image_button(nullptr),
       create_node_action(nullptr),
+      match_image_cancelled(false),
+      match_image_progress_dialog(nullptr),
       code_previewer_dialog(nullptr),
       code_previewer_layout(nullptr),
       code_previewer(nullptr),
@@ -80,7 +88,11 @@ VisualShaderEditor::VisualShaderEditor(MessageModel* model, QWidget* parent)
   VisualShaderEditor::init();
 }
 
-VisualShaderEditor::~VisualShaderEditor() {}
+VisualShaderEditor::~VisualShaderEditor() {
+  // Results posted by the search after this point are dropped with the editor.
+  match_image_cancelled = true;
+  if (match_image_thread.joinable()) match_image_thread.join();
+}
 
 void VisualShaderEditor::init() {
   // Create the main layout.
@@ -394,7 +406,7 @@ void VisualShaderEditor::init() {
 }
 
 bool VisualShaderEditor::add_output_node() {
-  int node_entry{VisualShaderGraphicsScene::find_node_entry(visual_shader_model, nodes_model, 0)};
+  int node_entry{VisualShaderGraphicsScene::find_node_entry(nodes_model, 0)};
 
   // If the output node exists in the model, don't add it because it will be added by the load_graph function
   SILENT_CHECK_CONDITION_TRUE_NON_VOID(node_entry != -1, true);
@@ -403,27 +415,55 @@ bool VisualShaderEditor::add_output_node() {
   return scene->add_node(std::make_shared<VisualShaderProtoNode<VisualShaderNodeOutput>>(), QPointF(0, 0), 0);
 }
 
+/*************************************/
+/* Field Paths                       */
+/*************************************/
+
+// Paths to a field of a node or a connection, validated once and bound to a
+// row on each access.
+static CompiledFieldPath make_node_field_path(const int& field_number) {
+  return CompiledFieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
+                                             FieldPath::RepeatedAt(), FieldPath::FieldNumber(field_number));
+}
+
+static CompiledFieldPath make_connection_field_path(const int& field_number) {
+  return CompiledFieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
+                                             FieldPath::RepeatedAt(), FieldPath::FieldNumber(field_number));
+}
+
+static const CompiledFieldPath node_id_path{make_node_field_path(VisualShader::VisualShaderNode::kIdFieldNumber)};
+static const CompiledFieldPath node_x_coordinate_path{
+    make_node_field_path(VisualShader::VisualShaderNode::kXCoordinateFieldNumber)};
+static const CompiledFieldPath node_y_coordinate_path{
+    make_node_field_path(VisualShader::VisualShaderNode::kYCoordinateFieldNumber)};
+
+// Any field of the node type oneof leads to its oneof model.
+static const CompiledFieldPath node_type_path{
+    make_node_field_path(VisualShader::VisualShaderNode::kInputFieldNumber)};
+
+static const CompiledFieldPath connection_id_path{
+    make_connection_field_path(VisualShader::VisualShaderConnection::kIdFieldNumber)};
+static const CompiledFieldPath connection_from_node_id_path{
+    make_connection_field_path(VisualShader::VisualShaderConnection::kFromNodeIdFieldNumber)};
+static const CompiledFieldPath connection_from_port_index_path{
+    make_connection_field_path(VisualShader::VisualShaderConnection::kFromPortIndexFieldNumber)};
+static const CompiledFieldPath connection_to_node_id_path{
+    make_connection_field_path(VisualShader::VisualShaderConnection::kToNodeIdFieldNumber)};
+static const CompiledFieldPath connection_to_port_index_path{
+    make_connection_field_path(VisualShader::VisualShaderConnection::kToPortIndexFieldNumber)};
+
 void VisualShaderEditor::load_graph() {
-  const RepeatedMessageModel* repeated_nodes{dynamic_cast<const RepeatedMessageModel*>(nodes_model)};
+  const RepeatedMessageModel* repeated_nodes{model_cast<RepeatedMessageModel>(nodes_model)};
   CHECK_PARAM_NULLPTR(repeated_nodes, "Nodes is not a repeated message model.");
 
   // Load the nodes
   int nodes_size{nodes_model->rowCount()};
   for (int i{0}; i < nodes_size; ++i) {
-    int n_id = visual_shader_model->data(
-        FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                    FieldPath::RepeatedAt(i),
-                                    FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber))).toInt();
-
-    double x = visual_shader_model->data(
-        FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                    FieldPath::RepeatedAt(i),
-                                    FieldPath::FieldNumber(VisualShader::VisualShaderNode::kXCoordinateFieldNumber))).toDouble();
-
-    double y = visual_shader_model->data(
-        FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                    FieldPath::RepeatedAt(i),
-                                    FieldPath::FieldNumber(VisualShader::VisualShaderNode::kYCoordinateFieldNumber))).toDouble();
+    int n_id{0};
+    double x{0.0}, y{0.0};
+    visual_shader_model->get(node_id_path.bind(i), n_id);
+    visual_shader_model->get(node_x_coordinate_path.bind(i), x);
+    visual_shader_model->get(node_y_coordinate_path.bind(i), y);
 
     std::shared_ptr<IVisualShaderProtoNode> proto_node;
 
@@ -447,36 +487,116 @@ void VisualShaderEditor::load_graph() {
   // Load the connections
   int connections_size{connections_model->rowCount()};
   for (int i{0}; i < connections_size; ++i)  {
-    int c_id = visual_shader_model->data(
-        FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                    FieldPath::RepeatedAt(i),
-                                    FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kIdFieldNumber))).toInt();
-
-    int from_node_id = visual_shader_model->data(
-        FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                    FieldPath::RepeatedAt(i),
-                                    FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kFromNodeIdFieldNumber))).toInt();
-
-    int from_port_index = visual_shader_model->data(
-        FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                    FieldPath::RepeatedAt(i),
-                                    FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kFromPortIndexFieldNumber))).toInt();
-
-    int to_node_id = visual_shader_model->data(
-        FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                    FieldPath::RepeatedAt(i),
-                                    FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kToNodeIdFieldNumber))).toInt();
-
-    int to_port_index = visual_shader_model->data(
-        FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                    FieldPath::RepeatedAt(i),
-                                    FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kToPortIndexFieldNumber))).toInt();
+    int c_id{0}, from_node_id{0}, from_port_index{0}, to_node_id{0}, to_port_index{0};
+    visual_shader_model->get(
+        connection_id_path.bind(i), c_id);
+    visual_shader_model->get(
+        connection_from_node_id_path.bind(i), from_node_id);
+    visual_shader_model->get(
+        connection_from_port_index_path.bind(i),
+        from_port_index);
+    visual_shader_model->get(
+        connection_to_node_id_path.bind(i), to_node_id);
+    visual_shader_model->get(
+        connection_to_port_index_path.bind(i),
+        to_port_index);
 
     bool result{scene->add_connection_to_scene(c_id, from_node_id, from_port_index, to_node_id, to_port_index)};
     CONTINUE_IF_TRUE(!result, "Failed to add connection to scene");
   }
 }
 
+const VisualShader* VisualShaderEditor::get_visual_shader() const {
+  const Message* buffer{visual_shader_model->get_message_buffer()};
+  CHECK_PARAM_NULLPTR_NON_VOID(buffer, nullptr, "Message buffer is null.");
+
+  // Generated messages share the reflection of their default instance.
+  CHECK_CONDITION_TRUE_NON_VOID(buffer->GetReflection() != VisualShader::default_instance().GetReflection(),
+                                nullptr, "Message buffer is not a visual shader.");
+
+  return static_cast<const VisualShader*>(buffer);
+}
+
+bool VisualShaderEditor::load_visual_shader(const VisualShader& visual_shader) {
+  // Work on a copy, deleting from the scene edits the buffer.
+  const VisualShader* buffer{get_visual_shader()};
+  CHECK_PARAM_NULLPTR_NON_VOID(buffer, false, "Visual shader is nullptr");
+  const VisualShader current{*buffer};
+
+  // Saved once, when the whole graph is replaced.
+  ProtoModel::BatchGuard batch{visual_shader_model};
+
+  // Delete all the connections first so deleting the nodes doesn't touch them.
+  for (const VisualShader::VisualShaderConnection& c : current.connections()) {
+    const bool result{
+        scene->delete_connection(c.id(), c.from_node_id(), c.from_port_index(), c.to_node_id(), c.to_port_index())};
+    CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to delete connection");
+  }
+
+  // The output node is kept, it can't be deleted.
+  for (const VisualShader::VisualShaderNode& node : current.nodes()) {
+    SILENT_CONTINUE_IF_TRUE(node.id() == 0);
+
+    const std::shared_ptr<IVisualShaderProtoNode> proto_node{
+        shadergen_utils::get_proto_node_by_oneof_value_field_number((int)node.node_type_case())};
+    CONTINUE_IF_TRUE(!proto_node, "Proto node is nullptr");
+
+    const bool result{
+        scene->delete_node(node.id(), proto_node->get_input_port_count(), proto_node->get_output_port_count())};
+    CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to delete node");
+  }
+
+  // Add the new nodes: the model first so the embed widgets pick up the loaded values.
+  for (const VisualShader::VisualShaderNode& node : visual_shader.nodes()) {
+    CONTINUE_IF_TRUE(node.node_type_case() == VisualShader::VisualShaderNode::NODE_TYPE_NOT_SET, "Node type is not set");
+    SILENT_CONTINUE_IF_TRUE(node.id() == 0);
+
+    const int oneof_value_field_number{(int)node.node_type_case()};
+
+    const std::shared_ptr<IVisualShaderProtoNode> proto_node{
+        shadergen_utils::get_proto_node_by_oneof_value_field_number(oneof_value_field_number)};
+    CONTINUE_IF_TRUE(!proto_node, "Proto node is nullptr");
+
+    const QPointF coordinate(node.x_coordinate(), node.y_coordinate());
+
+    bool result{scene->add_node_to_model(node.id(), proto_node, coordinate)};
+    CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to add node to model");
+
+    const int row_entry{VisualShaderGraphicsScene::find_node_entry(nodes_model, node.id())};
+    CHECK_CONDITION_TRUE_NON_VOID(row_entry == -1, false, "Failed to find node entry");
+
+    const Reflection* refl{node.GetReflection()};
+    const Message& payload{refl->GetMessage(node, node.GetDescriptor()->FindFieldByNumber(oneof_value_field_number))};
+    const Descriptor* payload_desc{payload.GetDescriptor()};
+    for (int i{0}; i < payload_desc->field_count(); ++i) {
+      const FieldDescriptor* field{payload_desc->field(i)};
+      SILENT_CONTINUE_IF_TRUE(field->is_repeated() || field->cpp_type() == FieldDescriptor::CppType::CPPTYPE_MESSAGE);
+
+      // Unset fields keep the defaults of the new node.
+      const QVariant value{PrimitiveModel::get_field_value(payload, field)};
+      SILENT_CONTINUE_IF_TRUE(!value.isValid());
+
+      result = visual_shader_model->set_data(
+          FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
+                                      FieldPath::RepeatedAt(row_entry), FieldPath::FieldNumber(oneof_value_field_number),
+                                      FieldPath::FieldNumber(field->number())),
+          value);
+      CONTINUE_IF_TRUE(!result, "Failed to set node field: " + field->name());
+    }
+
+    result = scene->add_node_to_scene(node.id(), proto_node, coordinate);
+    CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to add node to scene");
+  }
+
+  for (const VisualShader::VisualShaderConnection& c : visual_shader.connections()) {
+    const bool result{scene->add_connection(c.id(), c.from_node_id(), c.from_port_index(), c.to_node_id(),
+                                            c.to_port_index())};
+    CONTINUE_IF_TRUE(!result, "Failed to add connection");
+  }
+
+  return true;
+}
+
 void VisualShaderEditor::create_node(const QPointF& coordinate) {
   QTreeWidgetItem* selected_item{create_node_dialog->get_selected_item()};
 
@@ -547,16 +667,116 @@ void VisualShaderEditor::on_menu_button_pressed() {
 
 void VisualShaderEditor::on_load_image_button_pressed() {
   // TODO: Decide on how to load an image
-  // For example, use QFileDialog to open an image file or
+  // For now, the image is loaded from a file. Another option is to
   // load an existing sprite or background from the project.
-  // Then, send the image to OriginalMatchingImageWidget widget to display it.
   // R0bert — 27/09/2024 at 22:10
   // i would use resource picker and let user pick a sprite or background that exists in the project
   // Josh — 27/09/2024 at 22:13
   // sprites have multiple frames, which is a headache for this project because it's a lot more behavior we need to define
+  VisualShaderNodeGraphicsObject* n_o{scene->get_node_graphics_object(0)};
+  CHECK_PARAM_NULLPTR(n_o, "Output node is nullptr");
+
+  OriginalMatchingImageWidget* matching_image_widget{n_o->get_matching_image_widget()};
+  CHECK_PARAM_NULLPTR(matching_image_widget, "Matching image widget is nullptr");
+
+  const QString file_path{
+      QFileDialog::getOpenFileName(this, "Load Image", QString(), "Images (*.png *.jpg *.jpeg *.bmp)")};
+  SILENT_CHECK_CONDITION_TRUE(file_path.isEmpty());
+
+  QImage image;
+  CHECK_CONDITION_TRUE(!image.load(file_path), "Failed to load image: " + file_path.toStdString());
+
+  matching_image_widget->set_image(image);
 }
 
-void VisualShaderEditor::on_match_image_button_pressed() {}
+void VisualShaderEditor::on_match_image_button_pressed() {
+  SILENT_CHECK_CONDITION_TRUE(match_image_thread.joinable());  // A search is already running
+
+  VisualShaderNodeGraphicsObject* n_o{scene->get_node_graphics_object(0)};
+  CHECK_PARAM_NULLPTR(n_o, "Output node is nullptr");
+
+  OriginalMatchingImageWidget* matching_image_widget{n_o->get_matching_image_widget()};
+  CHECK_PARAM_NULLPTR(matching_image_widget, "Matching image widget is nullptr");
+
+  const QImage q_image{matching_image_widget->get_image().convertToFormat(QImage::Format_RGBA8888)};
+  CHECK_CONDITION_TRUE(q_image.isNull(), "No image to match");
+
+  shadergen_visual_shader_evaluator::Image target(q_image.width(), q_image.height());
+  for (int y{0}; y < q_image.height(); y++) {
+    const uchar* line{q_image.constScanLine(y)};
+    for (int x{0}; x < q_image.width(); x++) {
+      for (int c{0}; c < 4; c++) target.at(x, y)[c] = float(line[x * 4 + c]) / 255.0f;
+    }
+  }
+
+  // The search works on a copy so the user can keep editing the graph.
+  const VisualShader* visual_shader{get_visual_shader()};
+  CHECK_PARAM_NULLPTR(visual_shader, "Visual shader is nullptr");
+  const VisualShader initial_graph{*visual_shader};
+
+  shadergen_visual_shader_evaluator::GraphSearchOptions options;
+  options.seed = std::random_device{}();
+
+  match_image_cancelled = false;
+
+  match_image_progress_dialog = new QProgressDialog("Searching for a matching graph...", "Cancel", 0,
+                                                    options.generation_count, this);
+  match_image_progress_dialog->setWindowModality(Qt::WindowModal);
+  match_image_progress_dialog->setMinimumDuration(0);
+  match_image_progress_dialog->setValue(0);
+  QObject::connect(match_image_progress_dialog, &QProgressDialog::canceled, this,
+                   [this]() { match_image_cancelled = true; });
+
+  match_image_button->setEnabled(false);
+
+  match_image_thread = std::thread([this, initial_graph, target, options]() {
+    VisualShader best_graph;
+    float best_loss{0.0f};
+    const bool result{shadergen_visual_shader_evaluator::search_graph(
+        initial_graph, target, options, match_image_cancelled,
+        [this](const shadergen_visual_shader_evaluator::GraphSearchProgress& progress) {
+          QMetaObject::invokeMethod(
+              this, [this, progress]() { on_match_image_progress(progress); }, Qt::QueuedConnection);
+        },
+        best_graph, best_loss)};
+
+    QMetaObject::invokeMethod(
+        this, [this, result, best_graph, best_loss]() { on_match_image_finished(result, best_graph, best_loss); },
+        Qt::QueuedConnection);
+  });
+}
+
+void VisualShaderEditor::on_match_image_progress(
+    const shadergen_visual_shader_evaluator::GraphSearchProgress& progress) {
+  SILENT_CHECK_PARAM_NULLPTR(match_image_progress_dialog);
+
+  match_image_progress_dialog->setLabelText(QString("Generation %1/%2, loss: %3")
+                                                .arg(progress.generation)
+                                                .arg(progress.generation_count)
+                                                .arg(progress.best_loss));
+  match_image_progress_dialog->setValue(progress.generation);
+}
+
+void VisualShaderEditor::on_match_image_finished(const bool& result, const VisualShader& best_graph,
+                                                 const float& best_loss) {
+  if (match_image_thread.joinable()) match_image_thread.join();
+
+  if (match_image_progress_dialog) {
+    match_image_progress_dialog->deleteLater();
+    match_image_progress_dialog = nullptr;
+  }
+
+  match_image_button->setEnabled(true);
+
+  CHECK_CONDITION_TRUE(!result, "Failed to find a graph matching the image");
+
+  const QMessageBox::StandardButton answer{
+      QMessageBox::question(this, "Match Image",
+                            QString("Found a graph with loss %1. Replace the current graph?").arg(best_loss))};
+  SILENT_CHECK_CONDITION_TRUE(answer != QMessageBox::Yes);
+
+  CHECK_CONDITION_TRUE(!load_visual_shader(best_graph), "Failed to load the matching graph");
+}
 
 std::vector<std::string> VisualShaderEditor::parse_node_category_path(const std::string& node_category_path) {
   std::vector<std::string> tokens;
@@ -927,35 +1147,31 @@ VisualShaderGraphicsScene::VisualShaderGraphicsScene(QObject* parent)
 }
 
 bool VisualShaderGraphicsScene::add_node_to_model(const int& n_id, const std::shared_ptr<IVisualShaderProtoNode>& proto_node, const QPointF& coordinate) {
-  CHECK_CONDITION_TRUE_NON_VOID(find_node_entry(visual_shader_model, connections_model, n_id) != -1, false, "Node already exists");
+  CHECK_CONDITION_TRUE_NON_VOID(find_node_entry(nodes_model, n_id) != -1, false, "Node already exists");
+
+  ProtoModel::BatchGuard batch{visual_shader_model};
 
   int row_entry{nodes_model->append_row()};
 
   bool result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber)),
+      node_id_path.bind(row_entry),
       n_id);
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set node id");
 
   result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(VisualShader::VisualShaderNode::kXCoordinateFieldNumber)),
+      node_x_coordinate_path.bind(row_entry),
       coordinate.x());
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set node x coordinate");
 
   result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(VisualShader::VisualShaderNode::kYCoordinateFieldNumber)),
+      node_y_coordinate_path.bind(row_entry),
       coordinate.y());
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set node y coordinate");
 
   // Pass any field number that is inside the oneof to enter te OneofModel.
   // You must also to pass true for `for_get_oneof` parameter.
-  ProtoModel* oneof_model{const_cast<ProtoModel*>(visual_shader_model->get_sub_model(FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),FieldPath::RepeatedAt(row_entry), FieldPath::FieldNumber(VisualShader::VisualShaderNode::kInputFieldNumber)), false, true))};
-  OneofModel* oneof{dynamic_cast<OneofModel*>(oneof_model)};
+  ProtoModel* oneof_model{const_cast<ProtoModel*>(visual_shader_model->get_sub_model(node_type_path.bind(row_entry), false, true))};
+  OneofModel* oneof{model_cast<OneofModel>(oneof_model)};
   CHECK_PARAM_NULLPTR_NON_VOID(oneof, false, "Failed to get oneof model");
 
   if (auto input_node = std::dynamic_pointer_cast<VisualShaderProtoNode<VisualShaderNodeInput>>(proto_node)) {
@@ -1172,7 +1388,8 @@ bool VisualShaderGraphicsScene::add_node(const std::shared_ptr<IVisualShaderProt
   int temp_n_id{n_id};
 
   if (temp_n_id == -1)  {
-    temp_n_id = VisualShaderGraphicsScene::get_new_node_id(visual_shader_model, nodes_model);
+    temp_n_id = VisualShaderGraphicsScene::get_new_node_id(nodes_model);
+    CHECK_CONDITION_TRUE_NON_VOID(temp_n_id < 0, false, "Failed to get a new node id");
     CHECK_CONDITION_TRUE_NON_VOID(temp_n_id == 0, false, "The id " + std::to_string(temp_n_id) + " is reserved for the output node");
   }
 
@@ -1180,7 +1397,7 @@ bool VisualShaderGraphicsScene::add_node(const std::shared_ptr<IVisualShaderProt
 }
 
 bool VisualShaderGraphicsScene::delete_node_from_model(const int& n_id) {
-  int row_entry{find_node_entry(visual_shader_model, nodes_model, n_id)};
+  int row_entry{find_node_entry(nodes_model, n_id)};
   VALIDATE_INDEX_NON_VOID(row_entry, nodes_model->rowCount(), false, "Node entry not found");
 
   // Remove the node from the model
@@ -1233,7 +1450,7 @@ bool VisualShaderGraphicsScene::delete_node(const int& n_id, const int& in_port_
 }
 
 bool VisualShaderGraphicsScene::update_node_in_model(const int& n_id, const int& field_number, const QVariant& value) {
-  int row_entry{find_node_entry(visual_shader_model, nodes_model, n_id)};
+  int row_entry{find_node_entry(nodes_model, n_id)};
   CHECK_CONDITION_TRUE_NON_VOID(row_entry == -1, false, "Failed to find node entry");
 
   const int oneof_value_field_number{get_node_type_field_number(nodes_model, row_entry)};
@@ -1364,70 +1581,38 @@ void VisualShaderGraphicsScene::on_out_port_remove_requested(VisualShaderOutputP
   remove_item(out_port);
 }
 
-int VisualShaderGraphicsScene::get_new_node_id(ProtoModel* visual_shader_model, ProtoModel* nodes_model) {
-  int size{nodes_model->rowCount()};
-
-  int max_id{0};
-  for (int i{0}; i < size; i++) {
-    // Path to the id field of the node
-    FieldPath path{FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                               FieldPath::RepeatedAt(i),
-                                               FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber))};
-    int n_id{visual_shader_model->data(path).toInt()};
-    if (n_id > max_id) max_id = n_id;
-  }
+int VisualShaderGraphicsScene::get_new_node_id(ProtoModel* nodes_model, const int& count) {
+  const RepeatedMessageModel* repeated_nodes{model_cast<RepeatedMessageModel>(nodes_model)};
+  CHECK_PARAM_NULLPTR_NON_VOID(repeated_nodes, -1, "Nodes is not a repeated message model.");
 
-  return max_id + 1;  // Minimum id is 1 (0 is reserved for the output node)
+  // Minimum id is 1 (0 is reserved for the output node)
+  return (int)repeated_nodes->reserve_keys(VisualShader::VisualShaderNode::kIdFieldNumber, count, 1);
 }
 
-int VisualShaderGraphicsScene::get_new_connection_id(ProtoModel* visual_shader_model, ProtoModel* connections_model) {
-  int size{connections_model->rowCount()};
+int VisualShaderGraphicsScene::get_new_connection_id(ProtoModel* connections_model, const int& count) {
+  const RepeatedMessageModel* repeated_connections{model_cast<RepeatedMessageModel>(connections_model)};
+  CHECK_PARAM_NULLPTR_NON_VOID(repeated_connections, -1, "Connections is not a repeated message model.");
 
-  int max_id{-1};
-  for (int i{0}; i < size; i++) {
-    // Path to the id field of the connection
-    FieldPath path{FieldPath::Of<VisualShader>(
-        FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber), FieldPath::RepeatedAt(i),
-        FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kIdFieldNumber))};
-    int c_id{visual_shader_model->data(path).toInt()};
-    if (c_id > max_id) max_id = c_id;
-  }
-
-  return max_id + 1;  // Minimum id is 0
+  // Minimum id is 0
+  return (int)repeated_connections->reserve_keys(VisualShader::VisualShaderConnection::kIdFieldNumber, count, 0);
 }
 
-int VisualShaderGraphicsScene::find_node_entry(ProtoModel* visual_shader_model, ProtoModel* nodes_model,
-                                               const int& n_id) {
-  int size{nodes_model->rowCount()};
-
-  for (int i{0}; i < size; i++) {
-    // Path to the id field of the node
-    FieldPath path{FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                               FieldPath::RepeatedAt(i),
-                                               FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber))};
-    if (visual_shader_model->data(path).toInt() == n_id) return i;
-  }
+int VisualShaderGraphicsScene::find_node_entry(ProtoModel* nodes_model, const int& n_id) {
+  const RepeatedMessageModel* repeated_nodes{model_cast<RepeatedMessageModel>(nodes_model)};
+  CHECK_PARAM_NULLPTR_NON_VOID(repeated_nodes, -1, "Nodes is not a repeated message model.");
 
-  return -1;
+  return repeated_nodes->find_row(VisualShader::VisualShaderNode::kIdFieldNumber, n_id);
 }
 
-int VisualShaderGraphicsScene::find_connection_entry(ProtoModel* visual_shader_model, ProtoModel* connections_model,
-                                                     const int& c_id) {
-  int size{connections_model->rowCount()};
-
-  for (int i{0}; i < size; i++) {
-    // Path to the id field of the connection
-    FieldPath path{FieldPath::Of<VisualShader>(
-        FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber), FieldPath::RepeatedAt(i),
-        FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kIdFieldNumber))};
-    if (visual_shader_model->data(path).toInt() == c_id) return i;
-  }
+int VisualShaderGraphicsScene::find_connection_entry(ProtoModel* connections_model, const int& c_id) {
+  const RepeatedMessageModel* repeated_connections{model_cast<RepeatedMessageModel>(connections_model)};
+  CHECK_PARAM_NULLPTR_NON_VOID(repeated_connections, -1, "Connections is not a repeated message model.");
 
-  return -1;
+  return repeated_connections->find_row(VisualShader::VisualShaderConnection::kIdFieldNumber, c_id);
 }
 
 int VisualShaderGraphicsScene::get_node_type_field_number(ProtoModel* nodes_model, const int& row_entry) {
-  const RepeatedMessageModel* repeated_nodes{dynamic_cast<const RepeatedMessageModel*>(nodes_model)};
+  const RepeatedMessageModel* repeated_nodes{model_cast<RepeatedMessageModel>(nodes_model)};
   CHECK_PARAM_NULLPTR_NON_VOID(repeated_nodes, -1, "Nodes is not a repeated message model.");
 
   const MessageModel* node_model{repeated_nodes->get_sub_model(row_entry)};
@@ -1444,42 +1629,34 @@ int VisualShaderGraphicsScene::get_node_type_field_number(ProtoModel* nodes_mode
 
 bool VisualShaderGraphicsScene::add_connection_to_model(const int& c_id, const int& from_node_id, const int& from_port_index, const int& to_node_id,
                               const int& to_port_index) {
-  CHECK_CONDITION_TRUE_NON_VOID(find_connection_entry(visual_shader_model, connections_model, c_id) != -1, false, "Connection already exists");
+  CHECK_CONDITION_TRUE_NON_VOID(find_connection_entry(connections_model, c_id) != -1, false, "Connection already exists");
+
+  ProtoModel::BatchGuard batch{visual_shader_model};
 
   int row_entry{connections_model->append_row()};
 
   bool result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kIdFieldNumber)),
+      connection_id_path.bind(row_entry),
       c_id);
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set connection id");
 
   result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(
-          FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber), FieldPath::RepeatedAt(row_entry),
-          FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kFromNodeIdFieldNumber)),
+      connection_from_node_id_path.bind(row_entry),
       from_node_id);
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set connection from node id");
 
   result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(
-          FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber), FieldPath::RepeatedAt(row_entry),
-          FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kFromPortIndexFieldNumber)),
+      connection_from_port_index_path.bind(row_entry),
       from_port_index);
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set connection from port index");
 
   result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kToNodeIdFieldNumber)),
+      connection_to_node_id_path.bind(row_entry),
       to_node_id);
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set connection to node id");
 
   result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(
-          FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber), FieldPath::RepeatedAt(row_entry),
-          FieldPath::FieldNumber(VisualShader::VisualShaderConnection::kToPortIndexFieldNumber)),
+      connection_to_port_index_path.bind(row_entry),
       to_port_index);
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set connection to port index");
 
@@ -1570,7 +1747,7 @@ bool VisualShaderGraphicsScene::add_connection(const int& c_id, const int& from_
 }
 
 bool VisualShaderGraphicsScene::delete_connection_from_model(const int& c_id) {
-  int row_entry{find_connection_entry(visual_shader_model, connections_model, c_id)};
+  int row_entry{find_connection_entry(connections_model, c_id)};
   VALIDATE_INDEX_NON_VOID(row_entry, connections_model->rowCount(), false, "Connection entry not found");
 
   return connections_model->remove_row(row_entry);
@@ -1626,7 +1803,8 @@ bool VisualShaderGraphicsScene::add_temporary_connection(const int& from_node_id
   VisualShaderOutputPortGraphicsObject* from_o_port{from_n_o->get_output_port_graphics_object(from_port_index)};
   CHECK_PARAM_NULLPTR_NON_VOID(from_o_port, false, "Failed to get from output port graphics object");
 
-  int c_id{get_new_connection_id(visual_shader_model, connections_model)};
+  int c_id{get_new_connection_id(connections_model)};
+  CHECK_CONDITION_TRUE_NON_VOID(c_id < 0, false, "Failed to get a new connection id");
   CHECK_CONDITION_TRUE_NON_VOID(!from_o_port->connect(c_id), false, "Failed to connect connection");
   this->temporary_connection_graphics_object = new VisualShaderConnectionGraphicsObject(
       c_id, from_node_id, from_port_index, from_o_port->get_global_coordinate());
@@ -1678,20 +1856,25 @@ bool VisualShaderGraphicsScene::convert_to_temporary_connection(const int& c_id,
 }
 
 bool VisualShaderGraphicsScene::update_connection_in_model(const int& c_id, const int& node_id_field_number, const int& port_index_field_number, const int& node_id, const int& port_index) {
-  int row_entry{find_connection_entry(visual_shader_model, connections_model, c_id)};
+  int row_entry{find_connection_entry(connections_model, c_id)};
   VALIDATE_INDEX_NON_VOID(row_entry, connections_model->rowCount(), false, "Connection entry not found");
 
+  const bool is_from{node_id_field_number == VisualShader::VisualShaderConnection::kFromNodeIdFieldNumber};
+  CHECK_CONDITION_TRUE_NON_VOID(
+      !is_from && node_id_field_number != VisualShader::VisualShaderConnection::kToNodeIdFieldNumber, false,
+      "Invalid node id field number: " + std::to_string(node_id_field_number));
+  CHECK_CONDITION_TRUE_NON_VOID(
+      port_index_field_number != (is_from ? VisualShader::VisualShaderConnection::kFromPortIndexFieldNumber
+                                          : VisualShader::VisualShaderConnection::kToPortIndexFieldNumber),
+      false, "Invalid port index field number: " + std::to_string(port_index_field_number));
+
   bool result{visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(node_id_field_number)),
+      (is_from ? connection_from_node_id_path : connection_to_node_id_path).bind(row_entry),
       node_id)};
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to update connection in model");
 
   result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kConnectionsFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(port_index_field_number)),
+      (is_from ? connection_from_port_index_path : connection_to_port_index_path).bind(row_entry),
       port_index);
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to update connection in model");
 
@@ -1789,12 +1972,13 @@ void VisualShaderGraphicsScene::on_scene_update_requested() { update(); }
 void VisualShaderGraphicsScene::on_node_deleted(const int& n_id, const int& in_port_count, const int& out_port_count) {
   CHECK_CONDITION_TRUE(n_id == 0, "Cannot delete the output node");
 
+  // The node and its connections are removed in one change.
+  ProtoModel::BatchGuard batch{visual_shader_model};
+
   bool result{delete_node(n_id, in_port_count, out_port_count)};
   if (!result) {
     ERROR_PRINT("Failed to delete node");
   }
-
-  Q_EMIT visual_shader_model->dataChanged(QModelIndex(), QModelIndex());  // To update the serialized data
 }
 
 void VisualShaderGraphicsScene::on_port_pressed(QGraphicsObject* port, const QPointF& coordinate) {
@@ -1936,21 +2120,20 @@ void VisualShaderGraphicsScene::on_port_dropped(QGraphicsObject* port, const QPo
 
 void VisualShaderGraphicsScene::on_node_moved(const int& n_id, const int& in_port_count, const int& out_port_count,
                                               const QPointF& new_coordinate) {
-  int row_entry{find_node_entry(visual_shader_model, nodes_model, n_id)};
+  int row_entry{find_node_entry(nodes_model, n_id)};
   VALIDATE_INDEX(row_entry, nodes_model->rowCount(), "Node entry not found");
 
-  bool result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(VisualShader::VisualShaderNode::kXCoordinateFieldNumber)),
-      new_coordinate.x());
+  ProtoModel::BatchGuard batch{visual_shader_model};
+
+  // Called on every mouse move of a drag, both coordinates are a single change.
+  bool result = visual_shader_model->set(
+      node_x_coordinate_path.bind(row_entry),
+      (double)new_coordinate.x());
   CHECK_CONDITION_TRUE(!result, "Failed to set node x coordinate");
 
-  result = visual_shader_model->set_data(
-      FieldPath::Of<VisualShader>(FieldPath::FieldNumber(VisualShader::kNodesFieldNumber),
-                                  FieldPath::RepeatedAt(row_entry),
-                                  FieldPath::FieldNumber(VisualShader::VisualShaderNode::kYCoordinateFieldNumber)),
-      new_coordinate.y());
+  result = visual_shader_model->set(
+      node_y_coordinate_path.bind(row_entry),
+      (double)new_coordinate.y());
   CHECK_CONDITION_TRUE(!result, "Failed to set node y coordinate");
 
   // Update coordinates of all connected connections
@@ -3514,7 +3697,7 @@ VisualShaderNodeEmbedComboBox::VisualShaderNodeEmbedComboBox(ProtoModel* visual_
         shadergen_utils::get_enum_value_caption_by_value(enum_descriptor, input_type)));
   }
 
-  int row_entry{VisualShaderGraphicsScene::find_node_entry(visual_shader_model, nodes_model, n_id)};
+  int row_entry{VisualShaderGraphicsScene::find_node_entry(nodes_model, n_id)};
   setCurrentIndex(visual_shader_model
                       ->data(FieldPath::Of<VisualShader>(
                           FieldPath::FieldNumber(VisualShader::kNodesFieldNumber), FieldPath::RepeatedAt(row_entry),
@@ -3540,7 +3723,7 @@ VisualShaderNodeEmbedLineEditFloat::VisualShaderNodeEmbedLineEditFloat(
   setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
   setContentsMargins(0, 0, 0, 0);  // Left, top, right, bottom
 
-  int row_entry{VisualShaderGraphicsScene::find_node_entry(visual_shader_model, nodes_model, n_id)};
+  int row_entry{VisualShaderGraphicsScene::find_node_entry(nodes_model, n_id)};
   setText(
       QString::number(visual_shader_model
                           ->data(FieldPath::Of<VisualShader>(
@@ -3573,7 +3756,7 @@ VisualShaderNodeEmbedLineEditInt::VisualShaderNodeEmbedLineEditInt(
   setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
   setContentsMargins(0, 0, 0, 0);  // Left, top, right, bottom
 
-  int row_entry{VisualShaderGraphicsScene::find_node_entry(visual_shader_model, nodes_model, n_id)};
+  int row_entry{VisualShaderGraphicsScene::find_node_entry(nodes_model, n_id)};
   setText(
       QString::number(visual_shader_model
                           ->data(FieldPath::Of<VisualShader>(
@@ -3606,7 +3789,7 @@ VisualShaderNodeEmbedLineEditUInt::VisualShaderNodeEmbedLineEditUInt(
   setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
   setContentsMargins(0, 0, 0, 0);  // Left, top, right, bottom
 
-  int row_entry{VisualShaderGraphicsScene::find_node_entry(visual_shader_model, nodes_model, n_id)};
+  int row_entry{VisualShaderGraphicsScene::find_node_entry(nodes_model, n_id)};
   setText(
       QString::number(visual_shader_model
                           ->data(FieldPath::Of<VisualShader>(
@@ -3639,7 +3822,7 @@ VisualShaderNodeEmbedCheckBox::VisualShaderNodeEmbedCheckBox(
   setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
   setContentsMargins(0, 0, 0, 0);  // Left, top, right, bottom
 
-  int row_entry{VisualShaderGraphicsScene::find_node_entry(visual_shader_model, nodes_model, n_id)};
+  int row_entry{VisualShaderGraphicsScene::find_node_entry(nodes_model, n_id)};
   setChecked(visual_shader_model
                  ->data(FieldPath::Of<VisualShader>(
                      FieldPath::FieldNumber(VisualShader::kNodesFieldNumber), FieldPath::RepeatedAt(row_entry),
@@ -3667,7 +3850,7 @@ VisualShaderNodeEmbedColorPicker::VisualShaderNodeEmbedColorPicker(
   QObject::connect(this, &QPushButton::pressed, this, &VisualShaderNodeEmbedColorPicker::on_pressed);
 
   {
-    const int row_entry{VisualShaderGraphicsScene::find_node_entry(visual_shader_model, nodes_model, n_id)};
+    const int row_entry{VisualShaderGraphicsScene::find_node_entry(nodes_model, n_id)};
     const int node_type_field_number{ VisualShaderGraphicsScene::get_node_type_field_number(nodes_model, row_entry)};
     float r = visual_shader_model
                   ->data(FieldPath::Of<VisualShader>(
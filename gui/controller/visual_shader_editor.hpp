@@ -44,6 +44,7 @@
 #include <QtWidgets/QLineEdit>
 #include <QtWidgets/QMenu>
 #include <QtWidgets/QPlainTextEdit>
+#include <QtWidgets/QProgressDialog>
 #include <QtWidgets/QPushButton>
 #include <QtWidgets/QTextEdit>
 #include <QtWidgets/QTreeWidget>
@@ -55,7 +56,9 @@
 #include <QOpenGLFunctions_4_3_Core>  // https://stackoverflow.com/a/64288966/14629018 explains why we need this.
 #include <QOpenGLShaderProgram>
 
+#include <atomic>
 #include <string>
+#include <thread>
 #include <variant>
 #include <vector>
 #include <unordered_set>
@@ -69,6 +72,8 @@
 
 #include "gui/controller/vs_proto_node.hpp"
 
+#include "evaluator/visual_shader_graph_search.hpp"
+
 using EnumDescriptor = google::protobuf::EnumDescriptor;
 
 class VisualShaderGraphicsScene;
@@ -105,6 +110,13 @@ class VisualShaderEditor : public QWidget {
   VisualShaderGraphicsScene* get_scene() const { return scene; }
   VisualShaderGraphicsView* get_view() const { return view; }
 
+  /**
+   * @brief Replaces the graph in the model and the scene with @p visual_shader.
+   *        The output node is kept, the other nodes and all the connections
+   *        are recreated.
+   */
+  bool load_visual_shader(const VisualShader& visual_shader);
+
  Q_SIGNALS:
   /**
    * @brief Request the dialog that has all kinds of nodes we can
@@ -166,6 +178,21 @@ class VisualShaderEditor : public QWidget {
 
   QAction* create_node_action;
 
+  ////////////////////////////////////
+  // Image Matching
+  ////////////////////////////////////
+
+  /**
+   * @brief Runs @c shadergen_visual_shader_evaluator::search_graph, results
+   *        are sent back to the GUI thread with queued invocations.
+   */
+  std::thread match_image_thread;
+  std::atomic<bool> match_image_cancelled;
+  QProgressDialog* match_image_progress_dialog;
+
+  void on_match_image_progress(const shadergen_visual_shader_evaluator::GraphSearchProgress& progress);
+  void on_match_image_finished(const bool& result, const VisualShader& best_graph, const float& best_loss);
+
   ////////////////////////////////////
   // Code Previewer
   ////////////////////////////////////
@@ -206,6 +233,12 @@ class VisualShaderEditor : public QWidget {
    */
   void init();
 
+  /**
+   * @brief The graph held by the main model, nullptr if the buffer is not a
+   *        generated @c VisualShader.
+   */
+  const VisualShader* get_visual_shader() const;
+
   bool add_output_node();
   void load_graph();
 
@@ -281,11 +314,21 @@ class OriginalMatchingImageWidget : public QWidget {
     pixmap.fill(Qt::red);  // Fill it with the red color
   }
 
+  /**
+   * @brief The image the shader should match.
+   */
+  QImage get_image() const { return pixmap.toImage(); }
+
+  void set_image(const QImage& image) {
+    pixmap = QPixmap::fromImage(image);
+    update();
+  }
+
  protected:
   // Override the paintEvent to display the pixmap
   void paintEvent([[maybe_unused]] QPaintEvent* event) override {
     QPainter painter(this);
-    painter.drawPixmap(0, 0, pixmap);  // Draw the pixmap starting at (0, 0)
+    painter.drawPixmap(rect(), pixmap);  // Scale the pixmap to the widget
   }
 
  private:
@@ -421,10 +464,14 @@ class VisualShaderGraphicsScene : public QGraphicsScene {
   VisualShaderNodeGraphicsObject* get_node_graphics_object(const int& n_id) const;
   VisualShaderConnectionGraphicsObject* get_connection_graphics_object(const int& c_id) const;
 
-  static int get_new_node_id(ProtoModel* visual_shader_model, ProtoModel* nodes_model);
-  static int get_new_connection_id(ProtoModel* visual_shader_model, ProtoModel* connections_model);
-  static int find_node_entry(ProtoModel* visual_shader_model, ProtoModel* nodes_model, const int& n_id);
-  static int find_connection_entry(ProtoModel* visual_shader_model, ProtoModel* connections_model, const int& c_id);
+  /**
+   * @brief Reserves @p count consecutive ids and returns the first one. Ids
+   *        are never reused, even after the node or connection is deleted.
+   */
+  static int get_new_node_id(ProtoModel* nodes_model, const int& count = 1);
+  static int get_new_connection_id(ProtoModel* connections_model, const int& count = 1);
+  static int find_node_entry(ProtoModel* nodes_model, const int& n_id);
+  static int find_connection_entry(ProtoModel* connections_model, const int& c_id);
   static int get_node_type_field_number(ProtoModel* nodes_model, const int& n_id);
 
  public Q_SLOTS:
@@ -612,6 +659,11 @@ class VisualShaderNodeGraphicsObject : public QGraphicsObject {
 
   ShaderPreviewerWidget* get_shader_previewer_widget() const { return shader_previewer_widget; }
 
+  /**
+   * @brief Only the output node has a matching image widget.
+   */
+  OriginalMatchingImageWidget* get_matching_image_widget() const { return matching_image_widget; }
+
   void update_layout();
 
  Q_SIGNALS:
@@ -40,89 +40,114 @@
 using OneofDescriptor = google::protobuf::OneofDescriptor;
 
 MessageModel::MessageModel(Message* message_buffer, ProtoModel* parent_model, const int& index_in_parent)
-    : ProtoModel(parent_model, index_in_parent), m_message_buffer(message_buffer), m_desc(message_buffer->GetDescriptor()), last_accessed_field_index(-1) {}
+    : MessageModel(Kind::MESSAGE, message_buffer, message_buffer->GetDescriptor(), parent_model, index_in_parent) {}
 
 MessageModel::MessageModel(const Descriptor* desc, ProtoModel* parent_model, const int& index_in_parent) 
-    : ProtoModel(parent_model, index_in_parent), m_message_buffer(nullptr), m_desc(desc), last_accessed_field_index(-1) {}
+    : MessageModel(Kind::MESSAGE, nullptr, desc, parent_model, index_in_parent) {}
+
+MessageModel::MessageModel(const Kind& kind, Message* message_buffer, const Descriptor* desc,
+                           ProtoModel* parent_model, const int& index_in_parent)
+    : ProtoModel(kind, parent_model, index_in_parent),
+      m_message_buffer(message_buffer),
+      m_unset_field_desc(nullptr),
+      m_desc(desc),
+      m_sub_models(desc->field_count(), nullptr),
+      m_oneof_sub_models(desc->oneof_decl_count(), nullptr),
+      last_accessed_field_index(-1) {}
 
 void MessageModel::build_sub_models() {
+  // Sub-models are created on first access, see get_or_create_sub_model().
   SILENT_CHECK_PARAM_NULLPTR(m_message_buffer);
+}
+
+ProtoModel* MessageModel::get_or_create_sub_model(const FieldDescriptor* field_desc) const {
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(m_message_buffer, nullptr);
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(field_desc, nullptr);
+
+  MessageModel* self{const_cast<MessageModel*>(this)};
+
+  if (!field_desc->is_repeated() && shadergen_utils::is_inside_real_oneof(field_desc)) {
+    ProtoModel*& oneof_sub_model{m_oneof_sub_models.at(field_desc->real_containing_oneof()->index())};
+    SILENT_CHECK_CONDITION_TRUE_NON_VOID(oneof_sub_model != nullptr, oneof_sub_model);
+
+    // The oneof takes the column of its first field.
+    const OneofDescriptor* oneof_desc{field_desc->real_containing_oneof()};
+    oneof_sub_model = new OneofModel(m_message_buffer, oneof_desc, self, oneof_desc->field(0)->index());
+    oneof_sub_model->build_sub_models();
+    return oneof_sub_model;
+  }
+
+  ProtoModel*& existing_sub_model{m_sub_models.at(field_desc->index())};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(existing_sub_model != nullptr, existing_sub_model);
 
   // https://protobuf.dev/reference/cpp/api-docs/google.protobuf.message/#Reflection
   const Reflection* refl{m_message_buffer->GetReflection()};
 
-  int total_fields{columnCount()};
-
-  // Iterate through all fields in the message
-  for (int i{0}; i < total_fields; i++) {
-    // https://protobuf.dev/reference/cpp/api-docs/google.protobuf.descriptor/#FieldDescriptor
-    const FieldDescriptor* field_desc{get_column_descriptor(i)};
-
-    SILENT_CONTINUE_IF_TRUE(m_sub_models_by_field_number.find(field_desc->number()) !=
-                            m_sub_models_by_field_number.end());
-
-    if (field_desc->is_repeated()) {
-      switch (field_desc->cpp_type()) {
-        case FieldDescriptor::CppType::CPPTYPE_MESSAGE: {
-          ProtoModel* sub_model{new RepeatedMessageModel(m_message_buffer, field_desc, this, i)};
-          sub_model->build_sub_models();
-          m_sub_models_by_field_number[field_desc->number()] = sub_model;
-          break;
-        }
-        case FieldDescriptor::CppType::CPPTYPE_INT32:
-        case FieldDescriptor::CppType::CPPTYPE_INT64:
-        case FieldDescriptor::CppType::CPPTYPE_UINT32:
-        case FieldDescriptor::CppType::CPPTYPE_UINT64:
-        case FieldDescriptor::CppType::CPPTYPE_DOUBLE:
-        case FieldDescriptor::CppType::CPPTYPE_FLOAT:
-        case FieldDescriptor::CppType::CPPTYPE_BOOL:
-        case FieldDescriptor::CppType::CPPTYPE_STRING:
-        case FieldDescriptor::CppType::CPPTYPE_ENUM: {
-          ProtoModel* sub_model{new RepeatedPrimitiveModel(m_message_buffer, field_desc, this, i)};
-          sub_model->build_sub_models();
-          m_sub_models_by_field_number[field_desc->number()] = sub_model;
-          break;
-        }
-        default:
-          WARN_PRINT("Unsupported field type: " + std::to_string(field_desc->cpp_type()));
-          break;
-      }
-    } else {
-      if (shadergen_utils::is_inside_real_oneof(field_desc)) {
-        const OneofDescriptor* oneof_desc{field_desc->real_containing_oneof()};
-        auto it = m_sub_models_by_oneof_name.find(oneof_desc->name());
-        SILENT_CONTINUE_IF_TRUE(it != m_sub_models_by_oneof_name.end());
-        ProtoModel* sub_model{new OneofModel(m_message_buffer, oneof_desc, this, i)};
-        sub_model->build_sub_models();
-        m_sub_models_by_oneof_name[oneof_desc->name()] = sub_model;
+  const int i{field_desc->index()};
+
+  ProtoModel* sub_model{nullptr};
+
+  switch (field_desc->cpp_type()) {
+    case FieldDescriptor::CppType::CPPTYPE_MESSAGE: {
+      if (field_desc->is_repeated()) {
+        sub_model = new RepeatedMessageModel(m_message_buffer, field_desc, self, i);
+      } else if (refl->HasField(*m_message_buffer, field_desc)) {
+        sub_model = new MessageModel(refl->MutableMessage(m_message_buffer, field_desc), self, i);
       } else {
-        switch (field_desc->cpp_type()) {
-          case FieldDescriptor::CppType::CPPTYPE_MESSAGE: {
-            ProtoModel* sub_model{new MessageModel(refl->MutableMessage(m_message_buffer, field_desc), this, i)};
-            sub_model->build_sub_models();
-            m_sub_models_by_field_number[field_desc->number()] = sub_model;
-            break;
-          }
-          case FieldDescriptor::CppType::CPPTYPE_INT32:
-          case FieldDescriptor::CppType::CPPTYPE_INT64:
-          case FieldDescriptor::CppType::CPPTYPE_UINT32:
-          case FieldDescriptor::CppType::CPPTYPE_UINT64:
-          case FieldDescriptor::CppType::CPPTYPE_DOUBLE:
-          case FieldDescriptor::CppType::CPPTYPE_FLOAT:
-          case FieldDescriptor::CppType::CPPTYPE_BOOL:
-          case FieldDescriptor::CppType::CPPTYPE_STRING:
-          case FieldDescriptor::CppType::CPPTYPE_ENUM: {
-            ProtoModel* sub_model{new PrimitiveModel(m_message_buffer, field_desc, this, i)};
-            m_sub_models_by_field_number[field_desc->number()] = sub_model;
-            break;
-          }
-          default:
-            WARN_PRINT("Unsupported field type: " + std::to_string(field_desc->cpp_type()));
-            break;
-        }
+        // Set by the first change, see make_present().
+        MessageModel* message_model{
+            new MessageModel(const_cast<Message*>(&refl->GetMessage(*m_message_buffer, field_desc)), self, i)};
+        message_model->m_unset_field_desc = field_desc;
+        sub_model = message_model;
       }
+      break;
     }
+    case FieldDescriptor::CppType::CPPTYPE_INT32:
+    case FieldDescriptor::CppType::CPPTYPE_INT64:
+    case FieldDescriptor::CppType::CPPTYPE_UINT32:
+    case FieldDescriptor::CppType::CPPTYPE_UINT64:
+    case FieldDescriptor::CppType::CPPTYPE_DOUBLE:
+    case FieldDescriptor::CppType::CPPTYPE_FLOAT:
+    case FieldDescriptor::CppType::CPPTYPE_BOOL:
+    case FieldDescriptor::CppType::CPPTYPE_STRING:
+    case FieldDescriptor::CppType::CPPTYPE_ENUM: {
+      if (field_desc->is_repeated())
+        sub_model = new RepeatedPrimitiveModel(m_message_buffer, field_desc, self, i);
+      else
+        sub_model = new PrimitiveModel(m_message_buffer, field_desc, self, i);
+      break;
+    }
+    default:
+      FAIL_AND_RETURN_NON_VOID(nullptr, "Unsupported field type: " + std::to_string(field_desc->cpp_type()));
   }
+
+  sub_model->build_sub_models();
+  existing_sub_model = sub_model;
+  return sub_model;
+}
+
+bool MessageModel::make_present() const {
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(m_unset_field_desc, true);
+
+  // Only a message model creates a model for an unset message.
+  const ProtoModel* parent{get_parent_model()};
+  CHECK_CONDITION_TRUE_NON_VOID(!parent || parent->get_kind() != Kind::MESSAGE, false,
+                                "Unset message " + m_desc->full_name() + " is not in a message model.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!ProtoModel::make_present(), false);
+
+  Message* parent_buffer{parent->get_message_buffer()};
+  m_message_buffer = parent_buffer->GetReflection()->MutableMessage(parent_buffer, m_unset_field_desc);
+  m_unset_field_desc = nullptr;
+
+  // The models of unset messages inside keep reading their default instance.
+  for (ProtoModel* sub_model : m_sub_models) {
+    if (sub_model && sub_model->get_kind() != Kind::MESSAGE) sub_model->set_message_buffer(m_message_buffer);
+  }
+  for (ProtoModel* sub_model : m_oneof_sub_models) {
+    if (sub_model) sub_model->set_message_buffer(m_message_buffer);
+  }
+
+  return true;
 }
 
 void MessageModel::parent_data_changed() const {
@@ -134,18 +159,32 @@ void MessageModel::parent_data_changed() const {
 
   ProtoModel* t{const_cast<ProtoModel*>(parent)};
 
-  if (RepeatedMessageModel * repeated_m{dynamic_cast<RepeatedMessageModel*>(t)}) {
-    Q_EMIT repeated_m->dataChanged(index, index);
-    repeated_m->parent_data_changed();
-    return;
-  } else if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    Q_EMIT message_m->dataChanged(index, index);
-    message_m->parent_data_changed();
-    return;
-  } else if (OneofModel * oneof_m{dynamic_cast<OneofModel*>(t)}) {
-    Q_EMIT oneof_m->dataChanged(index, index);
-    oneof_m->parent_data_changed();
-    return;
+  // Within a batch the row indices are still updated, only the signals wait for the batch to end.
+  const bool batched{is_in_batch()};
+
+  // The kind is the concrete class, so the calls up the tree are not virtual.
+  switch (t->get_kind()) {
+    case Kind::REPEATED_MESSAGE: {
+      RepeatedMessageModel* repeated_m{static_cast<RepeatedMessageModel*>(t)};
+      repeated_m->row_data_changed(m_index_in_parent);
+      if (!batched) Q_EMIT repeated_m->dataChanged(index, index);
+      repeated_m->RepeatedMessageModel::parent_data_changed();
+      return;
+    }
+    case Kind::MESSAGE: {
+      MessageModel* message_m{static_cast<MessageModel*>(t)};
+      if (!batched) Q_EMIT message_m->dataChanged(index, index);
+      message_m->MessageModel::parent_data_changed();
+      return;
+    }
+    case Kind::ONEOF: {
+      OneofModel* oneof_m{static_cast<OneofModel*>(t)};
+      if (!batched) Q_EMIT oneof_m->dataChanged(index, index);
+      oneof_m->OneofModel::parent_data_changed();
+      return;
+    }
+    default:
+      break;
   }
 
   ERROR_PRINT("Parent model is not a repeated message model, message model, or oneof model.");
@@ -159,49 +198,39 @@ bool MessageModel::set_data([[maybe_unused]] const QVariant& value) {
 
 const ProtoModel* MessageModel::get_sub_model(const int& field_number) const {
   CHECK_PARAM_NULLPTR_NON_VOID(m_desc, nullptr, "Message descriptor is null.");
-  const FieldDescriptor* field_desc{m_desc->FindFieldByNumber(field_number)};
-  if (shadergen_utils::is_inside_real_oneof(field_desc)) {
-    const OneofDescriptor* oneof_desc{field_desc->real_containing_oneof()};
-    auto it{m_sub_models_by_oneof_name.find(oneof_desc->name())};
-    SILENT_CHECK_CONDITION_TRUE_NON_VOID(it == m_sub_models_by_oneof_name.end(), nullptr);
-    return it->second;
-  }
-
-  auto it{m_sub_models_by_field_number.find(field_number)};
-  SILENT_CHECK_CONDITION_TRUE_NON_VOID(it == m_sub_models_by_field_number.end(), nullptr);
-  return it->second;
+  return get_or_create_sub_model(m_desc->FindFieldByNumber(field_number));
 }
 
-const ProtoModel* MessageModel::get_sub_model(const FieldPath& path, const bool& for_set_data,
+const ProtoModel* MessageModel::get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data,
                                               const bool& for_get_oneof) const {
   SILENT_CHECK_PARAM_NULLPTR_NON_VOID(m_message_buffer, nullptr);
   CHECK_PARAM_NULLPTR_NON_VOID(m_desc, nullptr, "Message descriptor is null.");
-  CHECK_CONDITION_TRUE_NON_VOID(!path.is_valid(), nullptr, "Invalid path for " + m_desc->full_name());
-  SILENT_CHECK_CONDITION_TRUE_NON_VOID(path.is_empty(), this);
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.is_valid(), nullptr, "Invalid path for " + m_desc->full_name());
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(cursor.is_empty(), this);
 
   int fn{-1};
 
-  CHECK_CONDITION_TRUE_NON_VOID(!path.get_upcoming_field_num(fn), nullptr, "Next component is not a field number.");
-
-  const FieldDescriptor* field_desc{m_desc->FindFieldByNumber(fn)};
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.get_upcoming_field_num(fn), nullptr, "Next component is not a field number.");
 
-  if (shadergen_utils::is_inside_real_oneof(field_desc)) {
-    const OneofDescriptor* oneof_desc{field_desc->real_containing_oneof()};
-    auto it{m_sub_models_by_oneof_name.find(oneof_desc->name())};
-    SILENT_CHECK_CONDITION_TRUE_NON_VOID(it == m_sub_models_by_oneof_name.end(), nullptr);
-    return it->second->get_sub_model(path, for_set_data, for_get_oneof);
-  }
+  // Resolved when the path was built, unless the path is rooted elsewhere.
+  const FieldDescriptor* field_desc{cursor.get_upcoming_field_desc()};
+  if (!field_desc || field_desc->containing_type() != m_desc) field_desc = m_desc->FindFieldByNumber(fn);
+  CHECK_PARAM_NULLPTR_NON_VOID(field_desc, nullptr, "Field " + std::to_string(fn) + " not found in " + m_desc->full_name());
 
-  auto it{m_sub_models_by_field_number.find(fn)};
-  CHECK_CONDITION_TRUE_NON_VOID(
-      it == m_sub_models_by_field_number.end(), nullptr,
+  const ProtoModel* sub_model{get_or_create_sub_model(field_desc)};
+  CHECK_PARAM_NULLPTR_NON_VOID(
+      sub_model, nullptr,
       "Sub-model under " + m_desc->full_name() + " not found for field number " + std::to_string(fn));
 
-  CHECK_CONDITION_TRUE_NON_VOID(!path.skip_component(), nullptr, "Failed to skip field number.");
+  // The oneof model skips the field number itself
+  if (shadergen_utils::is_inside_real_oneof(field_desc)) return sub_model->get_sub_model(cursor, for_set_data, for_get_oneof);
+
+  FieldPath::Cursor next{cursor};
+  CHECK_CONDITION_TRUE_NON_VOID(!next.skip_component(), nullptr, "Failed to skip field number.");
 
   last_accessed_field_index = field_desc->index();  // This is important for back propagation of dataChanged signal
 
-  return it->second->get_sub_model(path, for_set_data, for_get_oneof);
+  return sub_model->get_sub_model(next, for_set_data, for_get_oneof);
 }
 
 const FieldDescriptor* MessageModel::get_column_descriptor(const int& column) const {
@@ -233,12 +262,22 @@ QModelIndex MessageModel::parent([[maybe_unused]] const QModelIndex& child) cons
         as primitive models cannot have children except for repeated primitive models which are
         only allowed to have children of type PrimitiveModel.
     */
-  if (RepeatedMessageModel * repeated_m{dynamic_cast<RepeatedMessageModel*>(t)}) {
-    return repeated_m->index(m_index_in_parent, last_accessed_field_index, repeated_m->parent(QModelIndex()));
-  } else if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    return message_m->index(0, m_index_in_parent, message_m->parent(QModelIndex()));
-  } else if (OneofModel * oneof_m{dynamic_cast<OneofModel*>(t)}) {
-    return oneof_m->index(0, m_index_in_parent, oneof_m->parent(QModelIndex()));
+  switch (t->get_kind()) {
+    case Kind::REPEATED_MESSAGE: {
+      RepeatedMessageModel* repeated_m{static_cast<RepeatedMessageModel*>(t)};
+      return repeated_m->index(m_index_in_parent, last_accessed_field_index,
+                               repeated_m->RepeatedMessageModel::parent(QModelIndex()));
+    }
+    case Kind::MESSAGE: {
+      MessageModel* message_m{static_cast<MessageModel*>(t)};
+      return message_m->index(0, m_index_in_parent, message_m->MessageModel::parent(QModelIndex()));
+    }
+    case Kind::ONEOF: {
+      OneofModel* oneof_m{static_cast<OneofModel*>(t)};
+      return oneof_m->index(0, m_index_in_parent, oneof_m->OneofModel::parent(QModelIndex()));
+    }
+    default:
+      break;
   }
 
   FAIL_AND_RETURN_NON_VOID(QModelIndex(),
@@ -264,9 +303,6 @@ QVariant MessageModel::data(const QModelIndex& index, [[maybe_unused]] int role)
   CHECK_CONDITION_TRUE_NON_VOID(field_desc->is_repeated(), QVariant(), "Field is repeated.");
 
   if (shadergen_utils::is_inside_real_oneof(field_desc)) {
-    const OneofDescriptor* oneof_desc{field_desc->real_containing_oneof()};
-    auto it{m_sub_models_by_oneof_name.find(oneof_desc->name())};
-    SILENT_CHECK_CONDITION_TRUE_NON_VOID(it == m_sub_models_by_oneof_name.end(), QVariant());
     return get_sub_model(field_desc->number())->data(this->index(0, map_to_oneof_index(index.column()), index), role);
   }
 
@@ -289,9 +325,6 @@ bool MessageModel::setData(const QModelIndex& index, const QVariant& value, int
   CHECK_CONDITION_TRUE_NON_VOID(field_desc->is_repeated(), false, "Field is repeated.");
 
   if (shadergen_utils::is_inside_real_oneof(field_desc)) {
-    const OneofDescriptor* oneof_desc{field_desc->real_containing_oneof()};
-    auto it{m_sub_models_by_oneof_name.find(oneof_desc->name())};
-    SILENT_CHECK_CONDITION_TRUE_NON_VOID(it == m_sub_models_by_oneof_name.end(), false);
     return const_cast<ProtoModel*>(get_sub_model(field_desc->number()))
         ->setData(this->index(0, map_to_oneof_index(index.column()), index), value, role);
   }
@@ -315,11 +348,15 @@ QVariant MessageModel::headerData(int section, [[maybe_unused]] Qt::Orientation
 }
 
 void MessageModel::clear_sub_models() {
-  for (auto& [field_number, sub_model] : m_sub_models_by_field_number) delete sub_model;
-  m_sub_models_by_field_number.clear();
+  for (ProtoModel*& sub_model : m_sub_models) {
+    delete sub_model;
+    sub_model = nullptr;
+  }
 
-  for (auto& [oneof_name, sub_model] : m_sub_models_by_oneof_name) delete sub_model;
-  m_sub_models_by_oneof_name.clear();
+  for (ProtoModel*& sub_model : m_oneof_sub_models) {
+    delete sub_model;
+    sub_model = nullptr;
+  }
 }
 
 int MessageModel::map_to_oneof_index(const int& field_index) const {
@@ -336,3 +373,13 @@ int MessageModel::map_to_oneof_index(const int& field_index) const {
 
   return -1;
 }
+
+void MessageModel::add_child_path_component(const int& child_index, FieldPath& path) const {
+  const FieldDescriptor* field_desc{get_column_descriptor(child_index)};
+  SILENT_CHECK_PARAM_NULLPTR(field_desc);
+
+  // A oneof is skipped, its fields are addressed directly.
+  SILENT_CHECK_CONDITION_TRUE(!field_desc->is_repeated() && shadergen_utils::is_inside_real_oneof(field_desc));
+
+  add_path_component(path, FieldPath::FieldNumber(field_desc->number()));
+}
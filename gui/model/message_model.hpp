@@ -51,7 +51,12 @@ using FieldDescriptor = google::protobuf::FieldDescriptor;
 
     @note Oneof fields are represented as a single column.
 
-    @todo Make lazy allocation of sub-models' messages
+    @note Sub-models are created on first access, so a loaded message only pays for
+          the fields that are actually read or written. They live as long as the model,
+          or until the document is loaded again.
+
+    @note Reading an unset message field does not set it. Its model reads the default
+          instance of the message until a change makes it present, see make_present().
 */
 class MessageModel : public ProtoModel {
   Q_OBJECT
@@ -69,7 +74,7 @@ class MessageModel : public ProtoModel {
   bool set_data(const QVariant& value) override;
 
   const ProtoModel* get_sub_model(const int& field_number) const;
-  const ProtoModel* get_sub_model(const FieldPath& path, const bool& for_set_data = false,
+  const ProtoModel* get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data = false,
                                   const bool& for_get_oneof = false) const override;
 
   const FieldDescriptor* get_column_descriptor(const int& column) const override;
@@ -84,11 +89,20 @@ class MessageModel : public ProtoModel {
 
   virtual Message* get_message_buffer() const override { return m_message_buffer; }
 
+  bool make_present() const override;
+
+  static constexpr bool has_kind(const Kind& kind) { return kind == Kind::MESSAGE || kind == Kind::REPEATED_MESSAGE; }
+
+ protected:
+  MessageModel(const Kind& kind, Message* message_buffer, const Descriptor* desc, ProtoModel* parent_model,
+               const int& index_in_parent);
+
  private:
-  Message* m_message_buffer;
+  mutable Message* m_message_buffer;  // The default instance while m_unset_field_desc is set, only read
+  mutable const FieldDescriptor* m_unset_field_desc;  // The unset field of the parent holding the message
   const Descriptor* m_desc; // https://protobuf.dev/reference/cpp/api-docs/google.protobuf.descriptor/#Descriptor
-  std::unordered_map<int, ProtoModel*> m_sub_models_by_field_number;
-  std::unordered_map<std::string, ProtoModel*> m_sub_models_by_oneof_name;
+  mutable std::vector<ProtoModel*> m_sub_models;        // By field index, nullptr until accessed
+  mutable std::vector<ProtoModel*> m_oneof_sub_models;  // By oneof index
 
   /*
         This last_accessed_field_index is only needed in one case: When I need to propagate a
@@ -122,6 +136,9 @@ class MessageModel : public ProtoModel {
 
   virtual void clear_sub_models() override;
   int map_to_oneof_index(const int& field_index) const;
+  void add_child_path_component(const int& child_index, FieldPath& path) const override;
+
+  ProtoModel* get_or_create_sub_model(const FieldDescriptor* field_desc) const;
 };
 
 #endif  // MESSAGE_MODEL_HPP
@@ -0,0 +1,144 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#include "gui/model/model_autosaver.hpp"
+
+#include <google/protobuf/util/json_util.h>
+#include <QSaveFile>
+
+#include "error_macros.hpp"
+#include "gui/model/proto_model.hpp"
+
+using namespace google::protobuf::util;
+
+ModelAutosaver::ModelAutosaver(const ProtoModel* model, const QString& file_path,
+                               const ProtoModel::FileFormat& format, const int& interval)
+    : m_model(model), m_file_path(file_path.toStdString()), m_format(format) {
+  CHECK_PARAM_NULLPTR(m_model, "Model is null.");
+  CHECK_PARAM_NULLPTR(m_model->get_message_buffer(), "Model has no message buffer.");
+
+  m_document.reset(m_model->get_message_buffer()->New());
+
+  m_timer.setSingleShot(true);
+  m_timer.setInterval(interval);
+  QObject::connect(&m_timer, &QTimer::timeout, this, &ModelAutosaver::save);
+
+  m_worker = std::thread(&ModelAutosaver::run, this);
+
+  m_model->set_autosaver(this);
+}
+
+ModelAutosaver::~ModelAutosaver() {
+  if (m_document) {
+    m_model->set_autosaver(nullptr);
+    flush();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_is_stopping = true;
+  }
+  m_condition.notify_one();
+
+  if (m_worker.joinable()) m_worker.join();
+}
+
+void ModelAutosaver::schedule() {
+  SILENT_CHECK_PARAM_NULLPTR(m_document);
+  m_timer.start();  // Restarts it if it is running
+}
+
+bool ModelAutosaver::flush() {
+  if (m_timer.isActive()) {
+    m_timer.stop();
+    save();
+  }
+
+  std::unique_lock<std::mutex> lock{m_mutex};
+  m_done_condition.wait(lock, [this]() { return !m_pending_snapshot && !m_is_writing; });
+  return m_last_write_succeeded;
+}
+
+void ModelAutosaver::save() {
+  std::shared_ptr<const ModelSnapshot> snapshot{m_model->take_snapshot()};
+  CHECK_PARAM_NULLPTR(snapshot, "Failed to take a snapshot of the model.");
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_pending_snapshot = snapshot;  // Replaces an older one that was not written yet
+  }
+  m_condition.notify_one();
+}
+
+void ModelAutosaver::run() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  while (true) {
+    m_condition.wait(lock, [this]() { return m_pending_snapshot || m_is_stopping; });
+    if (!m_pending_snapshot) return;
+
+    std::shared_ptr<const ModelSnapshot> snapshot{std::move(m_pending_snapshot)};
+    m_pending_snapshot.reset();
+    m_is_writing = true;
+
+    lock.unlock();
+    const bool result{write(*snapshot)};
+    snapshot.reset();
+    lock.lock();
+
+    m_is_writing = false;
+    m_last_write_succeeded = result;
+    m_done_condition.notify_all();
+  }
+}
+
+bool ModelAutosaver::write(const ModelSnapshot& snapshot) {
+  CHECK_CONDITION_TRUE_NON_VOID(!snapshot.copy_to(*m_document), false, "Failed to copy the snapshot.");
+
+  std::string data;
+  switch (m_format) {
+    case ProtoModel::FileFormat::JSON: {
+      JsonOptions options;
+      options.add_whitespace = true;  // Same as ProtoModel::saveToJson
+      absl::Status status = MessageToJsonString(*m_document, &data, options);
+      CHECK_CONDITION_TRUE_NON_VOID(!status.ok(), false, "Failed to serialize to JSON: " + status.ToString());
+    } break;
+    case ProtoModel::FileFormat::BINARY:
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!ProtoModel::serialize_to_binary(*m_document, data), false);
+      break;
+    default:
+      FAIL_AND_RETURN_NON_VOID(false, "Unknown file format.");
+  }
+
+  // Written next to the file, then renamed over it.
+  QSaveFile file(QString::fromStdString(m_file_path));
+  CHECK_CONDITION_TRUE_NON_VOID(!file.open(QIODevice::WriteOnly), false,
+                                "Failed to open file for writing: " + m_file_path);
+  file.write(data.data(), data.size());
+  CHECK_CONDITION_TRUE_NON_VOID(!file.commit(), false,
+                                "Failed to write " + m_file_path + ": " + file.errorString().toStdString());
+  return true;
+}
@@ -0,0 +1,109 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#ifndef MODEL_AUTOSAVER_HPP
+#define MODEL_AUTOSAVER_HPP
+
+#include <google/protobuf/message.h>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "gui/model/proto_model.hpp"
+
+#define MODEL_AUTOSAVE_INTERVAL 1000  // Milliseconds without changes before saving
+
+class ModelSnapshot;
+
+/**
+ * @brief Saves the document of a model tree to a file once it stops 
+ *        changing for an interval.
+ * 
+ * Every change restarts a timer on the thread of the models. When it fires, 
+ * the autosaver takes a snapshot of the document, see @c ModelSnapshot, and 
+ * a worker thread writes it to a temporary file that then replaces the file. 
+ * Editing never waits for the disk, and the file always holds a complete 
+ * document.
+ * 
+ * @note Lives on the thread of the models and must be deleted before them,
+ *       deleting it saves the pending changes. One autosaver per tree.
+ */
+class ModelAutosaver : public QObject {
+  Q_OBJECT
+
+ public:
+  ModelAutosaver(const ProtoModel* model, const QString& file_path,
+                 const ProtoModel::FileFormat& format = ProtoModel::FileFormat::BINARY,
+                 const int& interval = MODEL_AUTOSAVE_INTERVAL);
+  ~ModelAutosaver() override;
+
+  ModelAutosaver(const ModelAutosaver&) = delete;
+  ModelAutosaver& operator=(const ModelAutosaver&) = delete;
+
+  void set_interval(const int& interval) { m_timer.setInterval(interval); }
+  int get_interval() const { return m_timer.interval(); }
+
+  /**
+   * @brief Saves after the interval, unless another change comes first.
+   *        Called by the models for every change.
+   */
+  void schedule();
+
+  /**
+   * @brief Saves the pending changes now and waits for the file to be 
+   *        written.
+   * 
+   * @return false if the latest write failed.
+   */
+  bool flush();
+
+ private:
+  const ProtoModel* m_model;
+  std::string m_file_path;
+  ProtoModel::FileFormat m_format;
+  QTimer m_timer;
+
+  // Only used by the worker, an empty message of the type of the document.
+  std::unique_ptr<google::protobuf::Message> m_document;
+
+  std::thread m_worker;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::condition_variable m_done_condition;
+  std::shared_ptr<const ModelSnapshot> m_pending_snapshot;  // The latest not yet written
+  bool m_is_writing{false};
+  bool m_is_stopping{false};
+  bool m_last_write_succeeded{true};
+
+  void save();
+  void run();
+  bool write(const ModelSnapshot& snapshot);
+};
+
+#endif  // MODEL_AUTOSAVER_HPP
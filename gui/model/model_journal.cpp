@@ -0,0 +1,354 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include "gui/model/model_journal.hpp"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <algorithm>
+#include <climits>
+
+#include "error_macros.hpp"
+
+using namespace google::protobuf::io;
+using google::protobuf::internal::WireFormatLite;
+
+// The types of the values given by PrimitiveModel::data().
+enum class ValueTag : uint32_t { INVALID, BOOL, INT, UINT, LONG_LONG, ULONG_LONG, DOUBLE, FLOAT, STRING };
+
+static bool write_value(CodedOutputStream& output, const QVariant& value) {
+  switch (value.userType()) {
+    case QMetaType::UnknownType:
+      output.WriteVarint32((uint32_t)ValueTag::INVALID);
+      return true;
+    case QMetaType::Bool:
+      output.WriteVarint32((uint32_t)ValueTag::BOOL);
+      output.WriteVarint32(value.toBool() ? 1 : 0);
+      return true;
+    case QMetaType::Int:
+      output.WriteVarint32((uint32_t)ValueTag::INT);
+      output.WriteVarint32(WireFormatLite::ZigZagEncode32(value.toInt()));
+      return true;
+    case QMetaType::UInt:
+      output.WriteVarint32((uint32_t)ValueTag::UINT);
+      output.WriteVarint32(value.toUInt());
+      return true;
+    case QMetaType::LongLong:
+      output.WriteVarint32((uint32_t)ValueTag::LONG_LONG);
+      output.WriteVarint64(WireFormatLite::ZigZagEncode64(value.toLongLong()));
+      return true;
+    case QMetaType::ULongLong:
+      output.WriteVarint32((uint32_t)ValueTag::ULONG_LONG);
+      output.WriteVarint64(value.toULongLong());
+      return true;
+    case QMetaType::Double:
+      output.WriteVarint32((uint32_t)ValueTag::DOUBLE);
+      output.WriteLittleEndian64(WireFormatLite::EncodeDouble(value.toDouble()));
+      return true;
+    case QMetaType::Float:
+      output.WriteVarint32((uint32_t)ValueTag::FLOAT);
+      output.WriteLittleEndian32(WireFormatLite::EncodeFloat(value.toFloat()));
+      return true;
+    case QMetaType::QString: {
+      const std::string s{value.toString().toStdString()};
+      output.WriteVarint32((uint32_t)ValueTag::STRING);
+      output.WriteVarint32((uint32_t)s.size());
+      output.WriteString(s);
+      return true;
+    }
+    default:
+      break;
+  }
+
+  FAIL_AND_RETURN_NON_VOID(false, "Unsupported value type: " + std::to_string(value.userType()));
+}
+
+static bool read_value(CodedInputStream& input, QVariant& value) {
+  uint32_t tag;
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&tag), false);
+
+  switch (static_cast<ValueTag>(tag)) {
+    case ValueTag::INVALID:
+      value = QVariant();
+      return true;
+    case ValueTag::BOOL: {
+      uint32_t v;
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&v), false);
+      value = QVariant(v != 0);
+      return true;
+    }
+    case ValueTag::INT: {
+      uint32_t v;
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&v), false);
+      value = QVariant(WireFormatLite::ZigZagDecode32(v));
+      return true;
+    }
+    case ValueTag::UINT: {
+      uint32_t v;
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&v), false);
+      value = QVariant((uint)v);
+      return true;
+    }
+    case ValueTag::LONG_LONG: {
+      uint64_t v;
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint64(&v), false);
+      value = QVariant::fromValue((qlonglong)WireFormatLite::ZigZagDecode64(v));
+      return true;
+    }
+    case ValueTag::ULONG_LONG: {
+      uint64_t v;
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint64(&v), false);
+      value = QVariant::fromValue((qulonglong)v);
+      return true;
+    }
+    case ValueTag::DOUBLE: {
+      uint64_t v;
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadLittleEndian64(&v), false);
+      value = QVariant(WireFormatLite::DecodeDouble(v));
+      return true;
+    }
+    case ValueTag::FLOAT: {
+      uint32_t v;
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadLittleEndian32(&v), false);
+      value = QVariant(WireFormatLite::DecodeFloat(v));
+      return true;
+    }
+    case ValueTag::STRING: {
+      uint32_t size;
+      std::string s;
+      SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&size) || !input.ReadString(&s, (int)size), false);
+      value = QString::fromStdString(s);
+      return true;
+    }
+    default:
+      break;
+  }
+
+  return false;
+}
+
+static bool read_message(CodedInputStream& input, std::string& message) {
+  uint32_t size;
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&size), false);
+  return input.ReadString(&message, (int)size);
+}
+
+ModelChange ModelChange::set_field(const FieldPath& path, const QVariant& old_value, const QVariant& new_value) {
+  ModelChange change;
+  change.type = Type::SET_FIELD;
+  change.path = path;
+  change.old_value = old_value;
+  change.new_value = new_value;
+  return change;
+}
+
+ModelChange ModelChange::insert_row(const FieldPath& path, const int& row, const QVariant& new_value,
+                                    const std::string& new_message) {
+  ModelChange change;
+  change.type = Type::INSERT_ROW;
+  change.path = path;
+  change.row = row;
+  change.new_value = new_value;
+  change.new_message = new_message;
+  return change;
+}
+
+ModelChange ModelChange::remove_row(const FieldPath& path, const int& row, const QVariant& old_value,
+                                    const std::string& old_message) {
+  ModelChange change;
+  change.type = Type::REMOVE_ROW;
+  change.path = path;
+  change.row = row;
+  change.old_value = old_value;
+  change.old_message = old_message;
+  return change;
+}
+
+ModelChange ModelChange::set_oneof(const FieldPath& path, const int& old_field_number, const QVariant& old_value,
+                                   const std::string& old_message, const int& new_field_number,
+                                   const QVariant& new_value, const std::string& new_message) {
+  ModelChange change;
+  change.type = Type::SET_ONEOF;
+  change.path = path;
+  change.old_field_number = old_field_number;
+  change.old_value = old_value;
+  change.old_message = old_message;
+  change.new_field_number = new_field_number;
+  change.new_value = new_value;
+  change.new_message = new_message;
+  return change;
+}
+
+bool ModelChange::serialize(std::string& data) const {
+  StringOutputStream stream{&data};
+  CodedOutputStream output{&stream};
+
+  // A repeated index is told apart from a field number by the lowest bit.
+  output.WriteVarint32(static_cast<uint32_t>(type));
+  output.WriteVarint32((uint32_t)path.m_size);
+  for (int i{0}; i < path.m_size; i++) {
+    const FieldPath::Component& component{path.m_components[i]};
+    output.WriteVarint32(((uint32_t)component.value << 1) | (component.is_repeated_index ? 1 : 0));
+  }
+
+  bool result{true};
+  switch (type) {
+    case Type::SET_FIELD:
+      result = write_value(output, new_value);
+      break;
+    case Type::INSERT_ROW:
+      output.WriteVarint32((uint32_t)row);
+      result = write_value(output, new_value);
+      output.WriteVarint32((uint32_t)new_message.size());
+      output.WriteString(new_message);
+      break;
+    case Type::REMOVE_ROW:
+      output.WriteVarint32((uint32_t)row);
+      break;
+    case Type::SET_ONEOF:
+      // -1 if the oneof is not set.
+      output.WriteVarint32((uint32_t)(old_field_number + 1));
+      output.WriteVarint32((uint32_t)(new_field_number + 1));
+      result = write_value(output, new_value);
+      output.WriteVarint32((uint32_t)new_message.size());
+      output.WriteString(new_message);
+      break;
+    default:
+      FAIL_AND_RETURN_NON_VOID(false, "Unsupported change type: " + std::to_string(static_cast<int>(type)));
+  }
+
+  return result;
+}
+
+bool ModelChange::parse(const char* data, const size_t& size, const google::protobuf::Descriptor* root_descriptor,
+                        ModelChange& change) {
+  CHECK_PARAM_NULLPTR_NON_VOID(root_descriptor, false, "Root descriptor is null.");
+  CHECK_CONDITION_TRUE_NON_VOID(size > INT_MAX, false, "Change is too large.");
+
+  CodedInputStream input{reinterpret_cast<const uint8_t*>(data), (int)size};
+
+  uint32_t type, component_count;
+  CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&type) || type > static_cast<uint32_t>(Type::SET_ONEOF), false,
+                                "Invalid change type.");
+  CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&component_count) || component_count > FIELD_PATH_MAX_COMPONENT_COUNT,
+                                false, "Invalid path size.");
+
+  change = ModelChange();
+  change.type = static_cast<Type>(type);
+
+  FieldPath path;
+  path.m_root_buffer_descriptor = root_descriptor;
+  for (uint32_t i{0}; i < component_count; i++) {
+    uint32_t component;
+    CHECK_CONDITION_TRUE_NON_VOID(!input.ReadVarint32(&component), false, "Truncated path.");
+    if (component & 1) {
+      path.add_component(FieldPath::RepeatedAt((int)(component >> 1)));
+    } else {
+      path.add_component(FieldPath::FieldNumber((int)(component >> 1)));
+    }
+  }
+  CHECK_CONDITION_TRUE_NON_VOID(!path.resolve_path(), false, "Invalid path: " + path.to_string());
+  path.m_is_valid = true;
+  change.path = path;
+
+  bool result{true};
+  uint32_t value{0};
+  switch (change.type) {
+    case Type::SET_FIELD:
+      result = read_value(input, change.new_value);
+      break;
+    case Type::INSERT_ROW:
+      result = input.ReadVarint32(&value) && read_value(input, change.new_value) &&
+               read_message(input, change.new_message);
+      change.row = (int)value;
+      break;
+    case Type::REMOVE_ROW:
+      result = input.ReadVarint32(&value);
+      change.row = (int)value;
+      break;
+    case Type::SET_ONEOF:
+      result = input.ReadVarint32(&value);
+      change.old_field_number = (int)value - 1;
+      result = result && input.ReadVarint32(&value);
+      change.new_field_number = (int)value - 1;
+      result = result && read_value(input, change.new_value) && read_message(input, change.new_message);
+      break;
+    default:
+      break;
+  }
+
+  CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Truncated change.");
+  CHECK_CONDITION_TRUE_NON_VOID(input.CurrentPosition() != (int)size, false, "Unexpected data after the change.");
+
+  return true;
+}
+
+ModelJournal::ModelJournal(const int& capacity)
+    : m_capacity(std::max(capacity, 1)), m_head(0), m_next_sequence(1) {
+  m_changes.reserve(m_capacity);
+}
+
+void ModelJournal::set_capacity(const int& capacity) {
+  CHECK_CONDITION_TRUE(capacity <= 0, "Invalid journal capacity: " + std::to_string(capacity) + ".");
+  SILENT_CHECK_CONDITION_TRUE(capacity == m_capacity);
+
+  // Oldest first, then drop the ones that no longer fit.
+  std::rotate(m_changes.begin(), m_changes.begin() + m_head, m_changes.end());
+  if ((int)m_changes.size() > capacity) m_changes.erase(m_changes.begin(), m_changes.end() - capacity);
+
+  m_capacity = capacity;
+  m_head = 0;
+  m_changes.reserve(m_capacity);
+}
+
+bool ModelJournal::read(const uint64_t& last_seen_sequence, std::vector<ModelChange>& changes) const {
+  CHECK_CONDITION_TRUE_NON_VOID(last_seen_sequence >= m_next_sequence, false,
+                                "Sequence " + std::to_string(last_seen_sequence) + " is not recorded yet.");
+
+  const uint64_t size{m_changes.size()};
+  const uint64_t first_sequence{m_next_sequence - size};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(last_seen_sequence + 1 < first_sequence, false);
+
+  const uint64_t count{m_next_sequence - 1 - last_seen_sequence};
+  changes.reserve(changes.size() + count);
+  for (uint64_t i{size - count}; i < size; i++) changes.push_back(m_changes.at((m_head + i) % size));
+
+  return true;
+}
+
+void ModelJournal::record(ModelChange change) {
+  change.sequence = m_next_sequence++;
+
+  if ((int)m_changes.size() < m_capacity) {
+    m_changes.push_back(std::move(change));
+    return;
+  }
+
+  m_changes.at(m_head) = std::move(change);
+  m_head = (m_head + 1) % m_capacity;
+}
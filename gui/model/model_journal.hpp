@@ -0,0 +1,138 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#ifndef MODEL_JOURNAL_HPP
+#define MODEL_JOURNAL_HPP
+
+#include <QVariant>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "gui/model/utils/field_path.hpp"
+
+/**
+ * @brief A change made through the models, see @c ProtoModel::read_journal.
+ * 
+ * @note Rows are the ones at the time of the change. Removing a row moves the
+ *       last row into its place, so the changes are only consistent when they
+ *       are applied in order.
+ */
+struct ModelChange {
+  enum class Type {
+    SET_FIELD,   // old_value -> new_value, a value is invalid if the field is not set.
+    INSERT_ROW,  // row was inserted in the repeated field at path, see 
+                 // RepeatedMessageModel::insert_row. Its value is new_value for
+                 // primitive rows and new_message for message rows, empty for the
+                 // default value.
+    REMOVE_ROW,  // row was removed from the repeated field at path, its value is old_value
+                 // for primitive rows and old_message for message rows.
+    SET_ONEOF    // The oneof of the message at path switched from old_field_number to
+                 // new_field_number, -1 if not set. The values of the fields are in 
+                 // old_value/new_value for primitive fields and old_message/new_message
+                 // for message fields, empty for the default value.
+  };
+
+  uint64_t sequence{0};
+  Type type{Type::SET_FIELD};
+
+  /**
+   * @brief Copy it before traversing it, a FieldPath is consumed by a lookup.
+   */
+  FieldPath path;
+  int row{-1};
+
+  QVariant old_value;
+  QVariant new_value;
+  std::string old_message;  // Serialized
+  std::string new_message;  // Serialized
+
+  int old_field_number{-1};
+  int new_field_number{-1};
+
+  static ModelChange set_field(const FieldPath& path, const QVariant& old_value, const QVariant& new_value);
+  static ModelChange insert_row(const FieldPath& path, const int& row, const QVariant& new_value,
+                                const std::string& new_message);
+  static ModelChange remove_row(const FieldPath& path, const int& row, const QVariant& old_value,
+                                const std::string& old_message);
+  static ModelChange set_oneof(const FieldPath& path, const int& old_field_number, const QVariant& old_value,
+                               const std::string& old_message, const int& new_field_number,
+                               const QVariant& new_value, const std::string& new_message);
+
+  /**
+   * @brief Appends what @c ProtoModel::apply_change needs to make the change
+   *        again to @p data, in a compact binary form. The old values and
+   *        messages are left out.
+   */
+  bool serialize(std::string& data) const;
+
+  /**
+   * @brief Reads a change written by serialize(), its path is resolved 
+   *        against @p root_descriptor.
+   */
+  static bool parse(const char* data, const size_t& size, const google::protobuf::Descriptor* root_descriptor,
+                    ModelChange& change);
+};
+
+/**
+ * @brief A ring buffer of the latest changes. Every change gets the next 
+ *        sequence number, consumers keep the last one they read and ask 
+ *        for the changes after it.
+ */
+class ModelJournal {
+ public:
+  explicit ModelJournal(const int& capacity);
+
+  int get_capacity() const { return m_capacity; }
+
+  /**
+   * @brief Keeps the latest changes that fit, the sequence numbers go on.
+   */
+  void set_capacity(const int& capacity);
+
+  /**
+   * @brief The sequence number of the latest change, 0 if there is none.
+   */
+  uint64_t get_last_sequence() const { return m_next_sequence - 1; }
+
+  /**
+   * @brief Appends the changes after @p last_seen_sequence to @p changes.
+   * 
+   * @return false if some of them were overwritten, the consumer has to 
+   *         read the whole model again then.
+   */
+  bool read(const uint64_t& last_seen_sequence, std::vector<ModelChange>& changes) const;
+
+  void record(ModelChange change);
+
+ private:
+  std::vector<ModelChange> m_changes;
+  int m_capacity;
+  int m_head;  // The oldest change once the buffer is full.
+  uint64_t m_next_sequence;
+};
+
+#endif  // MODEL_JOURNAL_HPP
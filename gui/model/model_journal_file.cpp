@@ -0,0 +1,387 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#include "gui/model/model_journal_file.hpp"
+
+#include <QFile>
+#include <QSaveFile>
+#include <filesystem>
+#include <iterator>
+
+#include "byte_utils.hpp"
+#include "error_macros.hpp"
+#include "gui/model/model_snapshot.hpp"
+#include "gui/model/utils/mapped_file.hpp"
+
+static std::string make_header(const uint64_t& project_size, const uint64_t& project_hash) {
+  std::string header;
+  header.reserve(MODEL_JOURNAL_FILE_HEADER_SIZE);
+  shadergen_utils::append_u32(header, MODEL_JOURNAL_FILE_MAGIC);
+  shadergen_utils::append_u32(header, MODEL_JOURNAL_FILE_VERSION);
+  shadergen_utils::append_u64(header, project_size);
+  shadergen_utils::append_u64(header, project_hash);
+  return header;
+}
+
+ModelJournalFile::ModelJournalFile(ProtoModel* model, const QString& project_file_path,
+                                   const size_t& compaction_threshold)
+    : m_model(model),
+      m_project_file_path(project_file_path.toStdString()),
+      m_file_path(get_journal_path(project_file_path).toStdString()),
+      m_next_file_path(m_file_path + ".next"),
+      m_compaction_threshold(compaction_threshold) {
+  CHECK_PARAM_NULLPTR(m_model, "Model is null.");
+  CHECK_PARAM_NULLPTR(m_model->get_message_buffer(), "Model has no message buffer.");
+
+  m_document.reset(m_model->get_message_buffer()->New());
+}
+
+ModelJournalFile::~ModelJournalFile() {
+  if (m_is_open) {
+    flush();
+    m_model->set_journal_file(nullptr);
+  }
+
+  // The worker writes what is queued before it stops.
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_is_stopping = true;
+  }
+  m_condition.notify_one();
+
+  if (m_worker.joinable()) m_worker.join();
+}
+
+bool ModelJournalFile::open() {
+  CHECK_CONDITION_TRUE_NON_VOID(m_is_open, false, "Journal is already open: " + m_file_path);
+  CHECK_PARAM_NULLPTR_NON_VOID(m_document, false, "Journal has no document.");
+
+  uint64_t project_size{0};
+  uint64_t project_hash{shadergen_utils::hash_bytes(nullptr, 0)};
+  if (QFile::exists(QString::fromStdString(m_project_file_path))) {
+    MappedFile file(QString::fromStdString(m_project_file_path));
+    CHECK_CONDITION_TRUE_NON_VOID(!file.open(), false, "Failed to open file for reading: " + m_project_file_path);
+    SILENT_CHECK_CONDITION_TRUE_NON_VOID(!m_model->loadFromData(file.get_data(), file.get_size()), false);
+
+    project_size = file.get_size();
+    project_hash = shadergen_utils::hash_bytes(file.get_data(), file.get_size());
+  }
+
+  // The next journal follows the project file only if a compaction 
+  // stopped right after writing it.
+  size_t size{0};
+  bool is_next_replayed{false}, is_replayed{false};
+  {
+    ProtoModel::BatchGuard guard{m_model};
+    is_next_replayed = replay(m_next_file_path, project_size, project_hash, size);
+    if (!is_next_replayed) is_replayed = replay(m_file_path, project_size, project_hash, size);
+  }
+
+  std::string stream_file_path{m_file_path};
+  std::error_code error;
+  if (is_next_replayed) {
+    std::filesystem::rename(m_next_file_path, m_file_path, error);
+    if (error) {
+      WARN_PRINT("Failed to rename " + m_next_file_path + ", appending to it instead: " + error.message());
+      stream_file_path = m_next_file_path;
+    }
+  } else {
+    std::filesystem::remove(m_next_file_path, error);
+  }
+
+  if (is_next_replayed || is_replayed) {
+    // Drops a record cut by a crash, the next ones are appended after the 
+    // replayed ones.
+    std::filesystem::resize_file(stream_file_path, size, error);
+    CHECK_CONDITION_TRUE_NON_VOID(error, false, "Failed to truncate " + stream_file_path + ": " + error.message());
+  } else {
+    if (std::filesystem::exists(m_file_path)) {
+      WARN_PRINT("The journal does not follow " + m_project_file_path + ", it is dropped.");
+    }
+
+    std::ofstream stream{m_file_path, std::ios::binary | std::ios::trunc};
+    const std::string header{make_header(project_size, project_hash)};
+    CHECK_CONDITION_TRUE_NON_VOID(!stream.write(header.data(), header.size()).flush(), false,
+                                  "Failed to write " + m_file_path);
+    size = header.size();
+  }
+
+  m_stream.open(stream_file_path, std::ios::binary | std::ios::app);
+  CHECK_CONDITION_TRUE_NON_VOID(!m_stream.is_open(), false, "Failed to open file for writing: " + stream_file_path);
+
+  m_stream_file_path = stream_file_path;
+  m_size = size;
+  m_is_open = true;
+  m_model->set_journal_file(this);
+
+  m_worker = std::thread(&ModelJournalFile::run, this);
+
+  if (m_size > m_compaction_threshold) compact();
+
+  return true;
+}
+
+bool ModelJournalFile::replay(const std::string& file_path, const uint64_t& project_size,
+                              const uint64_t& project_hash, size_t& size) {
+  std::ifstream stream{file_path, std::ios::binary};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!stream.is_open(), false);
+  const std::string data{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(data.size() < MODEL_JOURNAL_FILE_HEADER_SIZE, false);
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(shadergen_utils::read_u32(data.data()) != MODEL_JOURNAL_FILE_MAGIC, false);
+  CHECK_CONDITION_TRUE_NON_VOID(shadergen_utils::read_u32(data.data() + 4) != MODEL_JOURNAL_FILE_VERSION, false,
+                                "Unsupported journal version: " +
+                                    std::to_string(shadergen_utils::read_u32(data.data() + 4)));
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(shadergen_utils::read_u64(data.data() + 8) != project_size, false);
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(shadergen_utils::read_u64(data.data() + 16) != project_hash, false);
+
+  const Descriptor* root_descriptor{m_model->get_message_buffer()->GetDescriptor()};
+
+  size = MODEL_JOURNAL_FILE_HEADER_SIZE;
+  while (data.size() - size >= MODEL_JOURNAL_FILE_RECORD_HEADER_SIZE) {
+    const char* record{data.data() + size};
+    const uint32_t change_size{shadergen_utils::read_u32(record)};
+    const char* change_data{record + MODEL_JOURNAL_FILE_RECORD_HEADER_SIZE};
+
+    if (data.size() - size - MODEL_JOURNAL_FILE_RECORD_HEADER_SIZE < change_size ||
+        (uint32_t)shadergen_utils::hash_bytes(change_data, change_size) != shadergen_utils::read_u32(record + 4)) {
+      break;
+    }
+
+    ModelChange change;
+    CHECK_CONDITION_TRUE_NON_VOID(!ModelChange::parse(change_data, change_size, root_descriptor, change), true,
+                                  "Failed to read a change of " + file_path + ", the next ones are dropped.");
+    CHECK_CONDITION_TRUE_NON_VOID(!m_model->apply_change(change), true,
+                                  "Failed to replay a change of " + file_path + ", the next ones are dropped.");
+
+    size += MODEL_JOURNAL_FILE_RECORD_HEADER_SIZE + change_size;
+  }
+
+  if (size != data.size()) WARN_PRINT("Dropping the incomplete change at the end of " + file_path + ".");
+
+  return true;
+}
+
+void ModelJournalFile::record(const ModelChange& change) {
+  SILENT_CHECK_CONDITION_TRUE(!m_is_open);
+
+  if (m_model->is_in_batch()) {
+    // A field set again replaces its previous change, unless rows or oneofs
+    // changed in between and the path may address another field.
+    if (change.type != ModelChange::Type::SET_FIELD) {
+      m_batch_field_changes.clear();
+    } else if (auto it{m_batch_field_changes.find(change.path)}; it != m_batch_field_changes.end()) {
+      m_batch_changes.at(it->second).new_value = change.new_value;
+      return;
+    } else {
+      m_batch_field_changes.emplace(change.path, m_batch_changes.size());
+    }
+
+    m_batch_changes.emplace_back(change);
+    return;
+  }
+
+  std::string records;
+  SILENT_CHECK_CONDITION_TRUE(!append_record(change, records));
+  append(records);
+}
+
+void ModelJournalFile::flush() {
+  SILENT_CHECK_CONDITION_TRUE(m_batch_changes.empty());
+
+  std::string records;
+  for (const ModelChange& change : m_batch_changes) append_record(change, records);
+  m_batch_changes.clear();
+  m_batch_field_changes.clear();
+
+  append(records);
+}
+
+bool ModelJournalFile::append_record(const ModelChange& change, std::string& records) {
+  std::string data;
+  CHECK_CONDITION_TRUE_NON_VOID(!change.serialize(data), false, "Failed to serialize a change, it is not journaled.");
+
+  shadergen_utils::append_u32(records, (uint32_t)data.size());
+  shadergen_utils::append_u32(records, (uint32_t)shadergen_utils::hash_bytes(data.data(), data.size()));
+  records += data;
+
+  return true;
+}
+
+void ModelJournalFile::append(std::string& records) {
+  SILENT_CHECK_CONDITION_TRUE(records.empty());
+
+  bool should_compact{false};
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_size += records.size();
+    m_tasks.push_back(Task{std::move(records), nullptr, 0});
+
+    // After a failure, waits for the journal to grow by the threshold again.
+    should_compact = !m_is_compacting && m_size > m_failed_compaction_size + m_compaction_threshold;
+  }
+  m_condition.notify_one();
+
+  if (should_compact) compact();
+}
+
+void ModelJournalFile::compact() {
+  SILENT_CHECK_CONDITION_TRUE(!m_is_open);
+
+  // The snapshot already has the changes of the open batch.
+  flush();
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    SILENT_CHECK_CONDITION_TRUE(m_is_compacting);
+  }
+
+  std::shared_ptr<const ModelSnapshot> snapshot{m_model->take_snapshot()};
+  CHECK_PARAM_NULLPTR(snapshot, "Failed to take a snapshot of the model.");
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_is_compacting = true;
+    m_tasks.push_back(Task{std::string(), std::move(snapshot), m_size});
+  }
+  m_condition.notify_one();
+}
+
+bool ModelJournalFile::wait() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+  m_done_condition.wait(lock, [this]() { return m_tasks.empty() && !m_is_working; });
+  return m_last_compaction_succeeded;
+}
+
+size_t ModelJournalFile::get_size() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_size;
+}
+
+void ModelJournalFile::run() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  while (true) {
+    m_condition.wait(lock, [this]() { return !m_tasks.empty() || m_is_stopping; });
+    if (m_tasks.empty()) return;
+
+    Task task{std::move(m_tasks.front())};
+    m_tasks.pop_front();
+
+    // The records queued one after another are written at once.
+    while (!task.snapshot && !m_tasks.empty() && !m_tasks.front().snapshot) {
+      task.records += m_tasks.front().records;
+      m_tasks.pop_front();
+    }
+    const bool is_compaction{task.snapshot != nullptr};
+    m_is_working = true;
+
+    lock.unlock();
+    bool result{true};
+    if (is_compaction) {
+      result = write_compaction(*task.snapshot, task.size);
+      task.snapshot.reset();
+    } else {
+      write_records(task.records);
+    }
+    lock.lock();
+
+    if (is_compaction) {
+      m_is_compacting = false;
+      m_last_compaction_succeeded = result;
+      m_failed_compaction_size = result ? 0 : m_size;
+    }
+    m_is_working = false;
+    m_done_condition.notify_all();
+  }
+}
+
+bool ModelJournalFile::write_records(const std::string& records) {
+  CHECK_CONDITION_TRUE_NON_VOID(!m_stream.write(records.data(), records.size()).flush(), false,
+                                "Failed to write " + m_stream_file_path);
+  return true;
+}
+
+bool ModelJournalFile::write_compaction(const ModelSnapshot& snapshot, const size_t& size) {
+  CHECK_CONDITION_TRUE_NON_VOID(!snapshot.copy_to(*m_document), false, "Failed to copy the snapshot.");
+
+  std::string data;
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!ProtoModel::serialize_to_binary(*m_document, data), false);
+
+  // The next journal of the previous compaction is still appended to.
+  if (m_stream_file_path == m_next_file_path) SILENT_CHECK_CONDITION_TRUE_NON_VOID(!rename_next_journal(), false);
+
+  // Follows the new project file, loading picks it once that is written.
+  std::error_code error;
+  {
+    std::ofstream next_stream{m_next_file_path, std::ios::binary | std::ios::trunc};
+    const std::string header{make_header(data.size(), shadergen_utils::hash_bytes(data.data(), data.size()))};
+    if (!next_stream.write(header.data(), header.size()).flush()) {
+      next_stream.close();
+      std::filesystem::remove(m_next_file_path, error);
+      FAIL_AND_RETURN_NON_VOID(false, "Failed to write " + m_next_file_path);
+    }
+  }
+
+  // Written next to the file, then renamed over it.
+  QSaveFile file(QString::fromStdString(m_project_file_path));
+  bool is_written{file.open(QIODevice::WriteOnly)};
+  if (is_written) {
+    file.write(data.data(), data.size());
+    is_written = file.commit();
+  }
+
+  if (!is_written) {
+    // The current journal still follows the project file.
+    std::filesystem::remove(m_next_file_path, error);
+    FAIL_AND_RETURN_NON_VOID(false, "Failed to write " + m_project_file_path + ": " + file.errorString().toStdString());
+  }
+
+  // The changes queued after the snapshot go to the next journal.
+  m_stream_file_path = m_next_file_path;
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_size = MODEL_JOURNAL_FILE_HEADER_SIZE + m_size - size;
+  }
+
+  return rename_next_journal();
+}
+
+bool ModelJournalFile::rename_next_journal() {
+  // Windows does not rename a file while it is open.
+  m_stream.close();
+
+  std::error_code error;
+  std::filesystem::rename(m_next_file_path, m_file_path, error);
+  if (!error) m_stream_file_path = m_file_path;
+
+  m_stream.open(m_stream_file_path, std::ios::binary | std::ios::app);
+  CHECK_CONDITION_TRUE_NON_VOID(!m_stream.is_open(), false, "Failed to open file for writing: " + m_stream_file_path);
+  CHECK_CONDITION_TRUE_NON_VOID(error, false,
+                                "Failed to rename " + m_next_file_path + ", appending to it instead: " + error.message());
+
+  return true;
+}
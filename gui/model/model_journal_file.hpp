@@ -0,0 +1,206 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#ifndef MODEL_JOURNAL_FILE_HPP
+#define MODEL_JOURNAL_FILE_HPP
+
+#include <google/protobuf/message.h>
+#include <QString>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "gui/model/proto_model.hpp"
+
+/**
+ * A journal starts with a header naming the project file it follows by its
+ * size and hash, then holds a record per change, see @c ModelChange::serialize.
+ * All values are little-endian.
+ * 
+ *   uint32 magic | uint32 version | uint64 project file size | uint64 project file hash
+ *   uint32 change size | uint32 change hash | change
+ *   ...
+ */
+#define MODEL_JOURNAL_FILE_MAGIC 0x4A504753  // "SGPJ"
+#define MODEL_JOURNAL_FILE_VERSION 1
+#define MODEL_JOURNAL_FILE_HEADER_SIZE 24
+#define MODEL_JOURNAL_FILE_RECORD_HEADER_SIZE 8
+
+#define MODEL_JOURNAL_FILE_COMPACTION_THRESHOLD (1024 * 1024)  // Bytes of journal before compacting it
+
+class ModelSnapshot;
+
+/**
+ * @brief Keeps a project file up to date by appending every change of a 
+ *        model tree to a journal next to it, instead of writing the whole
+ *        document. Loading replays the journal after the project file.
+ * 
+ * The changes are serialized on the thread of the models and written by a
+ * worker thread, editing never waits for the disk. A crash of the application
+ * loses the changes the worker did not write yet, and a record cut while being
+ * written is told apart by its size and hash. The records are flushed to the
+ * operating system but not synced to the disk, a power loss may lose more.
+ * The changes of a batch, see @c ProtoModel::begin_batch, are written 
+ * together when it ends, a field set more than once keeping its last value.
+ * 
+ * Once the journal grows past a threshold, the worker writes a snapshot of
+ * the document, see @c ModelSnapshot, as the new project file, with an empty
+ * second journal following it that then replaces the first one. The changes
+ * made meanwhile wait for the worker and go to the new journal. Only the 
+ * journal following the project file on disk is replayed, so the files are
+ * consistent whenever the application stops. If the second journal cannot
+ * replace the first one, the changes keep going to it until it can.
+ * 
+ * @note Lives on the thread of the models and must be deleted before them.
+ *       One journal file per tree.
+ */
+class ModelJournalFile {
+ public:
+  ModelJournalFile(ProtoModel* model, const QString& project_file_path,
+                   const size_t& compaction_threshold = MODEL_JOURNAL_FILE_COMPACTION_THRESHOLD);
+  ~ModelJournalFile();
+
+  ModelJournalFile(const ModelJournalFile&) = delete;
+  ModelJournalFile& operator=(const ModelJournalFile&) = delete;
+
+  /**
+   * @brief Loads the project file, binary or JSON, replays the journal 
+   *        following it, then appends the changes. A missing project file
+   *        is an empty document.
+   * 
+   * @note Call it before the models are used, same as @c ProtoModel::load.
+   * 
+   * @return false if the project file could not be loaded, nothing is 
+   *         appended then.
+   */
+  bool open();
+  bool is_open() const { return m_is_open; }
+
+  /**
+   * @brief Queues @p change for the worker, or keeps it until the batch it
+   *        was made in ends. Called by the models for every change.
+   */
+  void record(const ModelChange& change);
+
+  /**
+   * @brief Queues the changes kept by record(). Called by the models when
+   *        a batch ends.
+   */
+  void flush();
+
+  /**
+   * @brief Compacts the journal in the background after the queued changes,
+   *        unless a compaction is already queued.
+   */
+  void compact();
+
+  /**
+   * @brief Waits for the worker to write everything queued.
+   * 
+   * @return false if the latest compaction failed.
+   */
+  bool wait();
+
+  void set_compaction_threshold(const size_t& compaction_threshold) { m_compaction_threshold = compaction_threshold; }
+  size_t get_compaction_threshold() const { return m_compaction_threshold; }
+
+  /**
+   * @brief The size of the journal in bytes, with the changes queued for the
+   *        worker.
+   */
+  size_t get_size() const;
+
+  static QString get_journal_path(const QString& project_file_path) { return project_file_path + ".journal"; }
+
+ private:
+  ProtoModel* m_model;
+  std::string m_project_file_path;
+  std::string m_file_path;
+  std::string m_next_file_path;  // Follows the project file being written by a compaction
+  size_t m_compaction_threshold;
+  bool m_is_open{false};
+
+  // The changes of the open batch, and where the last change of each field is.
+  std::vector<ModelChange> m_batch_changes;
+  std::unordered_map<FieldPath, size_t, FieldPath::Hash> m_batch_field_changes;
+
+  /**
+   * @brief Work for the worker, either records to append or a snapshot to
+   *        compact the journal into.
+   */
+  struct Task {
+    std::string records;
+    std::shared_ptr<const ModelSnapshot> snapshot;
+    size_t size{0};  // The size of the journal when the snapshot was taken
+  };
+
+  std::thread m_worker;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::condition_variable m_done_condition;
+  std::deque<Task> m_tasks;
+  size_t m_size{0};
+  bool m_is_working{false};
+  bool m_is_stopping{false};
+  bool m_is_compacting{false};  // From when the snapshot is queued until it is written
+  bool m_last_compaction_succeeded{true};
+  size_t m_failed_compaction_size{0};  // The size of the journal when the last compaction failed
+
+  // Only used by the worker.
+  std::unique_ptr<google::protobuf::Message> m_document;  // An empty message of the type of the document
+  std::ofstream m_stream;
+  std::string m_stream_file_path;  // m_next_file_path while it could not be renamed
+
+  /**
+   * @brief Replays the journal at @p file_path if it follows a project file
+   *        of @p project_size bytes hashed to @p project_hash.
+   * 
+   * @param size The bytes up to the last replayed record.
+   * @return false if there is no such journal.
+   */
+  bool replay(const std::string& file_path, const uint64_t& project_size, const uint64_t& project_hash, size_t& size);
+
+  static bool append_record(const ModelChange& change, std::string& records);
+  void append(std::string& records);
+
+  void run();
+  bool write_records(const std::string& records);
+  bool write_compaction(const ModelSnapshot& snapshot, const size_t& size);
+
+  /**
+   * @brief Renames the next journal over the current one and appends to it.
+   *        If the rename fails, keeps appending to the next journal, which
+   *        loading picks first.
+   */
+  bool rename_next_journal();
+};
+
+#endif  // MODEL_JOURNAL_FILE_HPP
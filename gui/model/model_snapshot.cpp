@@ -0,0 +1,253 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#include "gui/model/model_snapshot.hpp"
+
+#include <google/protobuf/util/field_mask_util.h>
+#include <utility>
+
+#include "error_macros.hpp"
+#include "gui/model/proto_model.hpp"
+
+using FieldMaskUtil = google::protobuf::util::FieldMaskUtil;
+
+int ModelSnapshot::get_row_count(const int& field_number) const {
+  const RepeatedField* field{get_repeated_field(field_number)};
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(field, -1);
+  return field->size;
+}
+
+const Message* ModelSnapshot::get_row(const int& field_number, const int& row) const {
+  const RepeatedField* field{get_repeated_field(field_number)};
+  CHECK_PARAM_NULLPTR_NON_VOID(field, nullptr, "Field " + std::to_string(field_number) + " is not in the snapshot.");
+  VALIDATE_INDEX_NON_VOID(row, field->size, nullptr, "Index out of range.");
+  return field->chunks.at(row / MODEL_SNAPSHOT_CHUNK_SIZE)->at(row % MODEL_SNAPSHOT_CHUNK_SIZE).get();
+}
+
+bool ModelSnapshot::copy_to(Message& message) const {
+  CHECK_PARAM_NULLPTR_NON_VOID(m_fields, false, "Snapshot is empty.");
+  CHECK_CONDITION_TRUE_NON_VOID(message.GetDescriptor() != m_fields->GetDescriptor(), false,
+                                "Expected a " + m_fields->GetDescriptor()->full_name());
+
+  message.CopyFrom(*m_fields);
+
+  const Reflection* refl{message.GetReflection()};
+  for (const RepeatedField& field : m_repeated_fields) {
+    for (const std::shared_ptr<RowChunk>& chunk : field.chunks) {
+      for (const Row& row : *chunk) refl->AddMessage(&message, field.field_desc)->CopyFrom(*row);
+    }
+  }
+
+  return true;
+}
+
+const ModelSnapshot::RepeatedField* ModelSnapshot::get_repeated_field(const int& field_number) const {
+  for (const RepeatedField& field : m_repeated_fields) {
+    if (field.field_desc->number() == field_number) return &field;
+  }
+  return nullptr;
+}
+
+ModelSnapshotTracker::ModelSnapshotTracker(const ProtoModel* model) : m_model(model) {
+  const Message* message{m_model->get_message_buffer()};
+  CHECK_PARAM_NULLPTR(message, "Message buffer is null.");
+
+  const Descriptor* desc{message->GetDescriptor()};
+  for (int i{0}; i < desc->field_count(); i++) {
+    const FieldDescriptor* field_desc{desc->field(i)};
+
+    if (field_desc->is_repeated() && field_desc->cpp_type() == FieldDescriptor::CppType::CPPTYPE_MESSAGE) {
+      ModelSnapshot::RepeatedField field;
+      field.field_desc = field_desc;
+      m_state.m_repeated_fields.emplace_back(std::move(field));
+    } else {
+      m_fields_mask.add_paths(field_desc->name());
+    }
+  }
+
+  m_changed_rows.resize(m_state.m_repeated_fields.size());
+}
+
+void ModelSnapshotTracker::record(const ModelChange& change) {
+  m_is_changed = true;
+  SILENT_CHECK_CONDITION_TRUE(!m_is_valid);
+
+  FieldPath::Cursor cursor{change.path};
+
+  int fn{-1};
+  const int field_index{cursor.get_upcoming_field_num(fn) ? find_repeated_field(fn) : -1};
+  if (field_index == -1) {
+    m_are_fields_changed = true;
+    return;
+  }
+
+  cursor.skip_component();
+
+  // A change inside a row.
+  int row{-1};
+  if (cursor.get_upcoming_repeated_index(row)) {
+    m_changed_rows.at(field_index).insert(row);
+    return;
+  }
+
+  // The rows moved the same way as in the model, see RepeatedMessageModel::insert_row.
+  const ModelSnapshot::RepeatedField& field{m_state.m_repeated_fields.at(field_index)};
+  switch (change.type) {
+    case ModelChange::Type::INSERT_ROW: {
+      push_row(field_index);
+      m_changed_rows.at(field_index).insert(field.size - 1);
+      swap_rows(field_index, change.row, field.size - 1);
+      break;
+    }
+    case ModelChange::Type::REMOVE_ROW: {
+      swap_rows(field_index, change.row, field.size - 1);
+      m_changed_rows.at(field_index).erase(field.size - 1);
+      pop_row(field_index);
+      break;
+    }
+    default:
+      WARN_PRINT("Unexpected change of " + change.path.to_string() + ", copying the whole document.");
+      invalidate();
+      break;
+  }
+}
+
+std::shared_ptr<const ModelSnapshot> ModelSnapshotTracker::take_snapshot() {
+  const Message* message{m_model->get_message_buffer()};
+  CHECK_PARAM_NULLPTR_NON_VOID(message, nullptr, "Message buffer is null.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(m_is_valid && !m_is_changed && m_snapshot, m_snapshot);
+
+  if (!m_is_valid) {
+    const Reflection* refl{message->GetReflection()};
+
+    for (int i{0}; i < (int)m_state.m_repeated_fields.size(); i++) {
+      ModelSnapshot::RepeatedField& field{m_state.m_repeated_fields.at(i)};
+      field.chunks.clear();
+      field.size = 0;
+      m_changed_rows.at(i).clear();
+
+      const int size{refl->FieldSize(*message, field.field_desc)};
+      for (int row{0}; row < size; row++) {
+        push_row(i);
+        copy_row(i, row);
+      }
+    }
+
+    m_are_fields_changed = true;
+    m_is_valid = true;
+  }
+
+  if (m_are_fields_changed) copy_fields();
+
+  for (int i{0}; i < (int)m_changed_rows.size(); i++) {
+    for (const int& row : m_changed_rows.at(i)) copy_row(i, row);
+    m_changed_rows.at(i).clear();
+  }
+
+  m_are_fields_changed = false;
+  m_is_changed = false;
+
+  // Shares the fields and the chunks, the next changes copy the chunks they write to.
+  m_snapshot = std::make_shared<const ModelSnapshot>(m_state);
+  return m_snapshot;
+}
+
+int ModelSnapshotTracker::find_repeated_field(const int& field_number) const {
+  for (int i{0}; i < (int)m_state.m_repeated_fields.size(); i++) {
+    if (m_state.m_repeated_fields.at(i).field_desc->number() == field_number) return i;
+  }
+  return -1;
+}
+
+void ModelSnapshotTracker::copy_fields() {
+  const Message* message{m_model->get_message_buffer()};
+
+  std::unique_ptr<Message> fields{message->New()};
+  FieldMaskUtil::MergeMessageTo(*message, m_fields_mask, FieldMaskUtil::MergeOptions(), fields.get());
+  m_state.m_fields = std::move(fields);
+}
+
+void ModelSnapshotTracker::copy_row(const int& field_index, const int& row) {
+  const Message* message{m_model->get_message_buffer()};
+  const FieldDescriptor* field_desc{m_state.m_repeated_fields.at(field_index).field_desc};
+
+  const Message& live_row{message->GetReflection()->GetRepeatedMessage(*message, field_desc, row)};
+  std::unique_ptr<Message> row_copy{live_row.New()};
+  row_copy->CopyFrom(live_row);
+
+  get_writable_chunk(field_index, row / MODEL_SNAPSHOT_CHUNK_SIZE).at(row % MODEL_SNAPSHOT_CHUNK_SIZE) =
+      std::move(row_copy);
+}
+
+ModelSnapshot::RowChunk& ModelSnapshotTracker::get_writable_chunk(const int& field_index, const int& chunk_index) {
+  std::shared_ptr<ModelSnapshot::RowChunk>& chunk{m_state.m_repeated_fields.at(field_index).chunks.at(chunk_index)};
+
+  // Snapshots only hold on to chunks, they never take more references, so
+  // a count of 1 can't go up concurrently.
+  if (chunk.use_count() > 1) chunk = std::make_shared<ModelSnapshot::RowChunk>(*chunk);
+
+  return *chunk;
+}
+
+void ModelSnapshotTracker::swap_rows(const int& field_index, const int& row, const int& other_row) {
+  SILENT_CHECK_CONDITION_TRUE(row == other_row);
+
+  ModelSnapshot::RowChunk& chunk{get_writable_chunk(field_index, row / MODEL_SNAPSHOT_CHUNK_SIZE)};
+  ModelSnapshot::RowChunk& other_chunk{get_writable_chunk(field_index, other_row / MODEL_SNAPSHOT_CHUNK_SIZE)};
+  std::swap(chunk.at(row % MODEL_SNAPSHOT_CHUNK_SIZE), other_chunk.at(other_row % MODEL_SNAPSHOT_CHUNK_SIZE));
+
+  std::set<int>& changed_rows{m_changed_rows.at(field_index)};
+  const bool is_row_changed{changed_rows.erase(row) > 0};
+  const bool is_other_row_changed{changed_rows.erase(other_row) > 0};
+  if (is_row_changed) changed_rows.insert(other_row);
+  if (is_other_row_changed) changed_rows.insert(row);
+}
+
+void ModelSnapshotTracker::push_row(const int& field_index) {
+  ModelSnapshot::RepeatedField& field{m_state.m_repeated_fields.at(field_index)};
+
+  if (field.size % MODEL_SNAPSHOT_CHUNK_SIZE == 0) {
+    field.chunks.emplace_back(std::make_shared<ModelSnapshot::RowChunk>());
+    field.chunks.back()->reserve(MODEL_SNAPSHOT_CHUNK_SIZE);
+  }
+
+  get_writable_chunk(field_index, field.size / MODEL_SNAPSHOT_CHUNK_SIZE).emplace_back();
+  field.size++;
+}
+
+void ModelSnapshotTracker::pop_row(const int& field_index) {
+  ModelSnapshot::RepeatedField& field{m_state.m_repeated_fields.at(field_index)};
+  CHECK_CONDITION_TRUE(field.size == 0, "No row to remove.");
+
+  field.size--;
+
+  if (field.size % MODEL_SNAPSHOT_CHUNK_SIZE == 0) {
+    field.chunks.pop_back();
+    return;
+  }
+
+  get_writable_chunk(field_index, field.size / MODEL_SNAPSHOT_CHUNK_SIZE).pop_back();
+}
@@ -0,0 +1,132 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#ifndef MODEL_SNAPSHOT_HPP
+#define MODEL_SNAPSHOT_HPP
+
+#include <google/protobuf/field_mask.pb.h>
+#include <google/protobuf/message.h>
+#include <memory>
+#include <set>
+#include <vector>
+#include "gui/model/model_journal.hpp"
+
+#define MODEL_SNAPSHOT_CHUNK_SIZE 64  // Rows per shared chunk
+
+class ProtoModel;
+
+/**
+ * @brief An immutable copy of the document of a model tree, see 
+ *        @c ProtoModel::take_snapshot. Safe to read from any thread while
+ *        the models keep changing, without locks.
+ * 
+ * The rows of the top-level repeated message fields, e.g. the nodes and 
+ * connections of a graph, are shared with the previous snapshot unless they
+ * changed. So are the other top-level fields, as a single message.
+ */
+class ModelSnapshot {
+ public:
+  /**
+   * @brief The top-level fields, except the repeated message fields.
+   */
+  const google::protobuf::Message& get_fields() const { return *m_fields; }
+
+  /**
+   * @brief -1 if @p field_number is not a top-level repeated message field.
+   */
+  int get_row_count(const int& field_number) const;
+  const google::protobuf::Message* get_row(const int& field_number, const int& row) const;
+
+  /**
+   * @brief Copies the whole document into @p message, which has the type 
+   *        of the root message.
+   */
+  bool copy_to(google::protobuf::Message& message) const;
+
+ private:
+  friend class ModelSnapshotTracker;
+
+  using Row = std::shared_ptr<const google::protobuf::Message>;
+  using RowChunk = std::vector<Row>;
+
+  struct RepeatedField {
+    const google::protobuf::FieldDescriptor* field_desc{nullptr};
+
+    // Only written while not shared with a snapshot.
+    std::vector<std::shared_ptr<RowChunk>> chunks;
+    int size{0};
+  };
+
+  std::shared_ptr<const google::protobuf::Message> m_fields;
+  std::vector<RepeatedField> m_repeated_fields;
+
+  const RepeatedField* get_repeated_field(const int& field_number) const;
+};
+
+/**
+ * @brief Follows the changes of a model tree to build the next snapshot from
+ *        the previous one, only copying the rows that changed.
+ */
+class ModelSnapshotTracker {
+ public:
+  explicit ModelSnapshotTracker(const ProtoModel* model);
+
+  /**
+   * @brief Called by the model for every change.
+   */
+  void record(const ModelChange& change);
+
+  /**
+   * @brief The document changed without notifying, the next snapshot 
+   *        copies all of it.
+   */
+  void invalidate() { m_is_valid = false; }
+
+  std::shared_ptr<const ModelSnapshot> take_snapshot();
+
+ private:
+  const ProtoModel* m_model;
+
+  // The next snapshot, sharing its chunks with the latest one.
+  ModelSnapshot m_state;
+  std::shared_ptr<const ModelSnapshot> m_snapshot;
+
+  google::protobuf::FieldMask m_fields_mask;
+  bool m_is_valid{false};
+  bool m_is_changed{false};
+  bool m_are_fields_changed{false};
+  std::vector<std::set<int>> m_changed_rows;  // Per repeated field
+
+  int find_repeated_field(const int& field_number) const;
+  void copy_fields();
+  void copy_row(const int& field_index, const int& row);
+  ModelSnapshot::RowChunk& get_writable_chunk(const int& field_index, const int& chunk_index);
+  void swap_rows(const int& field_index, const int& row, const int& other_row);
+  void push_row(const int& field_index);
+  void pop_row(const int& field_index);
+};
+
+#endif  // MODEL_SNAPSHOT_HPP
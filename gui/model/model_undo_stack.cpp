@@ -0,0 +1,232 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#include "gui/model/model_undo_stack.hpp"
+
+#include <iterator>
+
+#include "error_macros.hpp"
+#include "gui/model/proto_model.hpp"
+
+size_t ModelUndoStack::Delta::get_byte_size() const {
+  size_t size{sizeof(Delta) + message.size()};
+  if (value.userType() == QMetaType::QString) size += static_cast<size_t>(value.toString().size()) * sizeof(QChar);
+  return size;
+}
+
+ModelUndoStack::ModelUndoStack(ProtoModel* model, const size_t& byte_budget)
+    : m_model(model), m_byte_budget(byte_budget) {}
+
+bool ModelUndoStack::undo() { return apply_step(m_undo_steps, m_redo_steps); }
+
+bool ModelUndoStack::redo() { return apply_step(m_redo_steps, m_undo_steps); }
+
+void ModelUndoStack::clear() {
+  m_undo_steps.clear();
+  m_redo_steps.clear();
+  m_byte_size = 0;
+  take_step();
+  m_can_merge = false;
+}
+
+void ModelUndoStack::set_byte_budget(const size_t& byte_budget) {
+  m_byte_budget = byte_budget;
+  enforce_byte_budget();
+}
+
+void ModelUndoStack::end_step() {
+  CHECK_CONDITION_TRUE(m_step_depth == 0, "No step is open.");
+  if (--m_step_depth == 0 && !m_model->is_in_batch()) close_step();
+}
+
+void ModelUndoStack::record(const ModelChange& change) {
+  // A new change makes the undone steps unreachable.
+  if (!m_applying && !m_redo_steps.empty()) {
+    for (const Step& step : m_redo_steps) m_byte_size -= step.byte_size;
+    m_redo_steps.clear();
+  }
+
+  // Removing the row reverts everything done inside it.
+  if (!is_inside_fresh_row(change.path)) {
+    switch (change.type) {
+      case ModelChange::Type::SET_FIELD: {
+        // The first change of a field in the step has its oldest value.
+        if (!m_step.set_field_paths.insert(change.path).second) break;
+
+        Delta delta{ModelChange::Type::SET_FIELD, change.path};
+        delta.value = change.old_value;
+        add_delta(std::move(delta));
+        break;
+      }
+      case ModelChange::Type::INSERT_ROW: {
+        Delta delta{ModelChange::Type::REMOVE_ROW, change.path};
+        delta.row = change.row;
+        add_delta(std::move(delta));
+
+        // The row that was there moved to the end.
+        const FieldPath row_path{change.path.at(change.row)};
+        drop_fresh_rows(row_path);
+        m_step_fresh_rows.insert(row_path);
+        break;
+      }
+      case ModelChange::Type::REMOVE_ROW: {
+        Delta delta{ModelChange::Type::INSERT_ROW, change.path};
+        delta.row = change.row;
+        delta.value = change.old_value;
+        delta.message = change.old_message;
+        add_delta(std::move(delta));
+        drop_fresh_rows(change.path);
+        break;
+      }
+      case ModelChange::Type::SET_ONEOF: {
+        Delta delta{ModelChange::Type::SET_ONEOF, change.path};
+        delta.field_number = change.old_field_number;
+        delta.current_field_number = change.new_field_number;
+        delta.value = change.old_value;
+        delta.message = change.old_message;
+        add_delta(std::move(delta));
+        drop_fresh_rows(change.path);
+        break;
+      }
+      default:
+        WARN_PRINT("Unsupported change type: " + std::to_string(static_cast<int>(change.type)));
+        break;
+    }
+  }
+
+  if (!m_model->is_in_batch()) close_step();
+}
+
+void ModelUndoStack::close_step() {
+  // The steps applied by undo() and redo() are closed there.
+  SILENT_CHECK_CONDITION_TRUE(m_applying || m_step_depth > 0);
+  SILENT_CHECK_CONDITION_TRUE(m_step.deltas.empty());
+
+  Step step{take_step()};
+
+  // The previous step already has the older values, e.g. typing in a field.
+  if (m_can_merge && !m_undo_steps.empty() && step.only_set_field && m_undo_steps.back().only_set_field &&
+      step.set_field_paths == m_undo_steps.back().set_field_paths) {
+    return;
+  }
+
+  m_byte_size += step.byte_size;
+  m_undo_steps.emplace_back(std::move(step));
+  m_can_merge = true;
+
+  enforce_byte_budget();
+}
+
+bool ModelUndoStack::apply_step(std::deque<Step>& from, std::deque<Step>& to) {
+  CHECK_CONDITION_TRUE_NON_VOID(m_model->is_in_batch(), false, "Cannot undo or redo while a batch is open.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(from.empty(), false);
+
+  Step step{std::move(from.back())};
+  from.pop_back();
+  m_byte_size -= step.byte_size;
+
+  // The changes made meanwhile are recorded as the opposite step.
+  bool result{true};
+  m_applying = true;
+  {
+    ProtoModel::BatchGuard guard{m_model};
+    for (auto it{step.deltas.rbegin()}; result && it != step.deltas.rend(); ++it) result = apply(*it);
+  }
+  m_applying = false;
+
+  Step opposite_step{take_step()};
+
+  if (!result) {
+    ERROR_PRINT("Failed to apply a step, the undo history is dropped.");
+    clear();
+    return false;
+  }
+
+  m_byte_size += opposite_step.byte_size;
+  to.emplace_back(std::move(opposite_step));
+  seal();
+
+  enforce_byte_budget();
+
+  return true;
+}
+
+bool ModelUndoStack::apply(const Delta& delta) const {
+  ModelChange change;
+  change.type = delta.type;
+  change.path = delta.path;
+  change.row = delta.row;
+  change.old_field_number = delta.current_field_number;
+  change.new_field_number = delta.field_number;
+  change.new_value = delta.value;
+  change.new_message = delta.message;
+  return m_model->apply_change(change);
+}
+
+void ModelUndoStack::add_delta(Delta delta) {
+  if (delta.type != ModelChange::Type::SET_FIELD) {
+    // The rows and oneofs under the paths may have moved.
+    m_step.only_set_field = false;
+    m_step.set_field_paths.clear();
+  }
+
+  m_step.byte_size += delta.get_byte_size();
+  m_step.deltas.emplace_back(std::move(delta));
+}
+
+bool ModelUndoStack::is_inside_fresh_row(const FieldPath& path) const {
+  auto it{m_step_fresh_rows.upper_bound(path)};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(it == m_step_fresh_rows.begin(), false);
+
+  // No fresh row is inside another one, see record(), so a row holding the
+  // path is the last one not after it.
+  return path.starts_with(*std::prev(it));
+}
+
+void ModelUndoStack::drop_fresh_rows(const FieldPath& prefix) {
+  auto it{m_step_fresh_rows.lower_bound(prefix)};
+  while (it != m_step_fresh_rows.end() && it->starts_with(prefix)) it = m_step_fresh_rows.erase(it);
+}
+
+ModelUndoStack::Step ModelUndoStack::take_step() {
+  Step step{std::move(m_step)};
+  step.byte_size += step.set_field_paths.size() * sizeof(FieldPath);
+
+  m_step = Step();
+  m_step_fresh_rows.clear();
+
+  return step;
+}
+
+void ModelUndoStack::enforce_byte_budget() {
+  // The latest step is always kept.
+  while (m_byte_size > m_byte_budget && m_undo_steps.size() + m_redo_steps.size() > 1) {
+    std::deque<Step>& steps{!m_undo_steps.empty() && (m_undo_steps.size() > 1 || m_redo_steps.empty()) ? m_undo_steps
+                                                                                                         : m_redo_steps};
+    m_byte_size -= steps.front().byte_size;
+    steps.pop_front();
+  }
+}
@@ -0,0 +1,172 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#ifndef MODEL_UNDO_STACK_HPP
+#define MODEL_UNDO_STACK_HPP
+
+#include <QVariant>
+#include <cstddef>
+#include <deque>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "gui/model/model_journal.hpp"
+#include "gui/model/utils/field_path.hpp"
+
+class ProtoModel;
+
+/**
+ * @brief Undo history of a model tree, see @c ProtoModel::set_undo_byte_budget.
+ * 
+ * Each step keeps the inverse of the changes it made, not a copy of the model:
+ * the old value of a set field, the content of a removed row, the old field 
+ * of a oneof. A batch is a single step, consecutive steps setting the same 
+ * fields are merged, and changes inside rows inserted by the same step are
+ * not kept since removing the row undoes them.
+ * 
+ * Undoing a step records its own inverse as the redo step the same way.
+ */
+class ModelUndoStack {
+ public:
+  ModelUndoStack(ProtoModel* model, const size_t& byte_budget);
+
+  bool can_undo() const { return !m_undo_steps.empty(); }
+  bool can_redo() const { return !m_redo_steps.empty(); }
+
+  /**
+   * @brief Reverts the latest step in a single batch.
+   * 
+   * @return false if there is nothing to undo, a batch is open or the step 
+   *         could not be applied, the history is dropped then.
+   */
+  bool undo();
+  bool redo();
+
+  /**
+   * @brief The next step is not merged into the latest one, e.g. when the
+   *        editor of a field loses focus.
+   */
+  void seal() { m_can_merge = false; }
+  void clear();
+
+  /**
+   * @brief The oldest steps are dropped to stay within the budget, the
+   *        latest one is always kept.
+   */
+  void set_byte_budget(const size_t& byte_budget);
+  size_t get_byte_budget() const { return m_byte_budget; }
+  size_t get_byte_size() const { return m_byte_size; }
+
+  int get_undo_count() const { return static_cast<int>(m_undo_steps.size()); }
+  int get_redo_count() const { return static_cast<int>(m_redo_steps.size()); }
+
+  /**
+   * @brief The changes until the matching end_step() are a single step, 
+   *        without batching their notifications. Used when setting a field
+   *        first switches the oneofs on its path.
+   */
+  void begin_step() { m_step_depth++; }
+  void end_step();
+
+  /**
+   * @brief Opens a step for its lifetime, see begin_step().
+   */
+  class StepGuard {
+   public:
+    explicit StepGuard(ModelUndoStack* undo_stack) : m_undo_stack(undo_stack) {
+      if (m_undo_stack) m_undo_stack->begin_step();
+    }
+    ~StepGuard() {
+      if (m_undo_stack) m_undo_stack->end_step();
+    }
+
+    StepGuard(const StepGuard&) = delete;
+    StepGuard& operator=(const StepGuard&) = delete;
+
+   private:
+    ModelUndoStack* m_undo_stack;
+  };
+
+  /**
+   * @brief Called by the model for every change, and once the change or the
+   *        batch holding it is done.
+   */
+  void record(const ModelChange& change);
+  void close_step();
+
+ private:
+  // The operation reverting a change.
+  struct Delta {
+    Delta(const ModelChange::Type& type, const FieldPath& path) : type(type), path(path) {}
+
+    ModelChange::Type type;
+    FieldPath path;
+    int row{-1};
+    int field_number{-1};          // SET_ONEOF: the field to set, -1 to clear the oneof.
+    int current_field_number{-1};  // SET_ONEOF: the field set now.
+    QVariant value;
+    std::string message;  // Serialized
+
+    size_t get_byte_size() const;
+  };
+
+  struct Step {
+    std::vector<Delta> deltas;
+    size_t byte_size{0};
+
+    // The fields set since the last structural change, the first change of
+    // a field has its oldest value. With only SET_FIELD deltas, these are
+    // all the fields of the step and are used for merging.
+    bool only_set_field{true};
+    std::unordered_set<FieldPath, FieldPath::Hash> set_field_paths;
+  };
+
+  ProtoModel* m_model;
+  size_t m_byte_budget;
+  size_t m_byte_size{0};
+
+  std::deque<Step> m_undo_steps;  // Oldest first
+  std::deque<Step> m_redo_steps;  // Farthest first
+
+  // The step being recorded.
+  Step m_step;
+  std::set<FieldPath> m_step_fresh_rows;  // Rows inserted by the step, sorted for prefix lookups.
+
+  int m_step_depth{0};
+  bool m_applying{false};
+  bool m_can_merge{false};
+
+  bool apply_step(std::deque<Step>& from, std::deque<Step>& to);
+  bool apply(const Delta& delta) const;
+  void add_delta(Delta delta);
+  bool is_inside_fresh_row(const FieldPath& path) const;
+  void drop_fresh_rows(const FieldPath& prefix);
+  Step take_step();
+  void enforce_byte_budget();
+};
+
+#endif  // MODEL_UNDO_STACK_HPP
@@ -37,7 +37,7 @@
 
 OneofModel::OneofModel(Message* message_buffer, const OneofDescriptor* oneof_desc, ProtoModel* parent_model,
                        const int& index_in_parent)
-    : ProtoModel(parent_model, index_in_parent),
+    : ProtoModel(Kind::ONEOF, parent_model, index_in_parent),
       m_message_buffer(message_buffer),
       m_oneof_desc(oneof_desc),
       m_current_field_desc(nullptr),
@@ -98,9 +98,12 @@ void OneofModel::parent_data_changed() const {
 
   ProtoModel* t{const_cast<ProtoModel*>(parent)};
 
-  if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    Q_EMIT message_m->dataChanged(index, index);
-    message_m->parent_data_changed();
+  const bool batched{is_in_batch()};
+
+  if (t->get_kind() == Kind::MESSAGE) {
+    MessageModel* message_m{static_cast<MessageModel*>(t)};
+    if (!batched) Q_EMIT message_m->dataChanged(index, index);
+    message_m->MessageModel::parent_data_changed();
     return;
   }
 
@@ -120,16 +123,16 @@ const ProtoModel* OneofModel::get_sub_model(const int& field_number) const {
   return m_sub_model;
 }
 
-const ProtoModel* OneofModel::get_sub_model(const FieldPath& path, const bool& for_set_data,
+const ProtoModel* OneofModel::get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data,
                                             const bool& for_get_oneof) const {
   SILENT_CHECK_PARAM_NULLPTR_NON_VOID(m_message_buffer, nullptr);
   const Descriptor* desc{m_message_buffer->GetDescriptor()};
-  CHECK_CONDITION_TRUE_NON_VOID(!path.is_valid(), nullptr, "Invalid path for " + desc->full_name());
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.is_valid(), nullptr, "Invalid path for " + desc->full_name());
   SILENT_CHECK_CONDITION_TRUE_NON_VOID(for_get_oneof, this);
 
   int fn{-1};
 
-  CHECK_CONDITION_TRUE_NON_VOID(!path.get_upcoming_field_num(fn), nullptr, "Next component is not a field number.");
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.get_upcoming_field_num(fn), nullptr, "Next component is not a field number.");
 
   const FieldDescriptor* field_desc{desc->FindFieldByNumber(fn)};
   CHECK_PARAM_NULLPTR_NON_VOID(field_desc, nullptr, "Field descriptor is null.");
@@ -144,9 +147,10 @@ const ProtoModel* OneofModel::get_sub_model(const FieldPath& path, const bool& f
   CHECK_CONDITION_TRUE_NON_VOID(m_current_field_desc->number() != field_desc->number(), nullptr,
                                 "Field number mismatch.");
 
-  CHECK_CONDITION_TRUE_NON_VOID(!path.skip_component(), nullptr, "Failed to skip field number.");
+  FieldPath::Cursor next{cursor};
+  CHECK_CONDITION_TRUE_NON_VOID(!next.skip_component(), nullptr, "Failed to skip field number.");
 
-  return m_sub_model->get_sub_model(path, for_set_data, for_get_oneof);
+  return m_sub_model->get_sub_model(next, for_set_data, for_get_oneof);
 }
 
 int OneofModel::get_oneof_value_field_number() const {
@@ -181,8 +185,9 @@ QModelIndex OneofModel::parent([[maybe_unused]] const QModelIndex& child) const
         children except for repeated primitive models which are only allowed to have children 
         of type PrimitiveModel.
     */
-  if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    return message_m->index(0, m_index_in_parent, message_m->parent(QModelIndex()));
+  if (t->get_kind() == Kind::MESSAGE) {
+    MessageModel* message_m{static_cast<MessageModel*>(t)};
+    return message_m->index(0, m_index_in_parent, message_m->MessageModel::parent(QModelIndex()));
   }
 
   FAIL_AND_RETURN_NON_VOID(QModelIndex(), "Parent model is not a message model.");
@@ -242,7 +247,7 @@ QVariant OneofModel::headerData(int section, [[maybe_unused]] Qt::Orientation or
   return QString::fromStdString(field_desc->full_name());
 }
 
-bool OneofModel::set_oneof(const int& field_number) {
+bool OneofModel::set_oneof(const int& field_number, const QVariant& value, const std::string& message) {
   const Descriptor* desc{m_message_buffer->GetDescriptor()};
 
   const FieldDescriptor* field_desc{desc->FindFieldByNumber(field_number)};
@@ -255,12 +260,38 @@ bool OneofModel::set_oneof(const int& field_number) {
 
   SILENT_CHECK_CONDITION_TRUE_NON_VOID(oneof_desc->name() != m_oneof_desc->name(), false);
 
-  bool result{set_oneof(field_desc)};
+  bool result{set_oneof(field_desc, value, message)};
   CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set oneof field.");
 
-  QModelIndex index{this->index(0, field_desc->index())};
+  QModelIndex index{this->index(0, field_desc->index_in_oneof())};
 
-  Q_EMIT dataChanged(index, index);
+  if (!is_in_batch() || !record_batch_change(get_path())) Q_EMIT dataChanged(index, index);
+  parent_data_changed();
+
+  return true;
+}
+
+bool OneofModel::clear_oneof() {
+  const Reflection* refl{m_message_buffer->GetReflection()};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!refl->HasOneof(*m_message_buffer, m_oneof_desc), true);
+
+  const FieldDescriptor* old_field_desc{refl->GetOneofFieldDescriptor(*m_message_buffer, m_oneof_desc)};
+  const bool recording{is_recording_changes()};
+  QVariant old_value;
+  std::string old_message;
+  if (recording) get_field_value(old_field_desc, old_value, old_message);
+
+  clear_sub_model();
+
+  const FieldPath path{get_path()};
+  if (recording) {
+    record_change(ModelChange::set_oneof(path, old_field_desc->number(), old_value, old_message, -1, QVariant(),
+                                         std::string()));
+  }
+
+  QModelIndex index{this->index(0, old_field_desc->index_in_oneof())};
+
+  if (!record_batch_change(path)) Q_EMIT dataChanged(index, index);
   parent_data_changed();
 
   return true;
@@ -286,25 +317,59 @@ void OneofModel::clear_sub_model() const {
   refl->ClearOneof(m_message_buffer, m_oneof_desc);
 }
 
+void OneofModel::set_message_buffer(Message* message_buffer) {
+  m_message_buffer = message_buffer;
+
+  // A message field has a message of its own.
+  if (m_sub_model && m_sub_model->get_kind() == Kind::PRIMITIVE) m_sub_model->set_message_buffer(message_buffer);
+}
+
 bool OneofModel::is_set() const { return m_current_field_desc != nullptr && m_sub_model != nullptr; }
 
-bool OneofModel::set_oneof(const FieldDescriptor* field_desc) const {
+void OneofModel::get_field_value(const FieldDescriptor* field_desc, QVariant& value, std::string& message) const {
+  SILENT_CHECK_PARAM_NULLPTR(field_desc);
+  const Reflection* refl{m_message_buffer->GetReflection()};
+
+  if (field_desc->cpp_type() == FieldDescriptor::CppType::CPPTYPE_MESSAGE) {
+    message = refl->GetMessage(*m_message_buffer, field_desc).SerializeAsString();
+  } else if (is_set() && m_current_field_desc == field_desc) {
+    value = m_sub_model->data();
+  }
+}
+
+bool OneofModel::set_oneof(const FieldDescriptor* field_desc, const QVariant& value, const std::string& message) const {
   const Reflection* refl{m_message_buffer->GetReflection()};
 
   SILENT_CHECK_CONDITION_TRUE_NON_VOID(is_set() && refl->HasOneof(*m_message_buffer, m_oneof_desc) &&
                                            m_current_field_desc->number() == field_desc->number(),
                                        true);
 
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!make_present(), false);
+
+  // The value of the old field is gone once the sub-model is cleared.
+  const FieldDescriptor* old_field_desc{refl->GetOneofFieldDescriptor(*m_message_buffer, m_oneof_desc)};
+  const bool recording{is_recording_changes()};
+  QVariant old_value;
+  std::string old_message;
+  if (recording) get_field_value(old_field_desc, old_value, old_message);
+
   if (is_set() && refl->HasOneof(*m_message_buffer, m_oneof_desc) &&
       m_current_field_desc->number() != field_desc->number())
     clear_sub_model();
 
   m_current_field_desc = field_desc;  // Set the current field descriptor
 
+  // Setting the value below is part of the switch.
+  suspend_change_recording();
+
   switch (field_desc->cpp_type()) {
     case FieldDescriptor::CppType::CPPTYPE_MESSAGE: {
-      ProtoModel* sub_model{
-          new MessageModel(refl->MutableMessage(m_message_buffer, field_desc), const_cast<OneofModel*>(this), 0)};
+      Message* field_message{refl->MutableMessage(m_message_buffer, field_desc)};
+      if (!message.empty() && !field_message->ParseFromString(message)) {
+        ERROR_PRINT("Failed to parse the value of " + field_desc->full_name());
+      }
+
+      ProtoModel* sub_model{new MessageModel(field_message, const_cast<OneofModel*>(this), 0)};
       sub_model->build_sub_models();
       m_sub_model = sub_model;
       break;
@@ -321,6 +386,11 @@ bool OneofModel::set_oneof(const FieldDescriptor* field_desc) const {
       ProtoModel* sub_model{new PrimitiveModel(m_message_buffer, field_desc, const_cast<OneofModel*>(this), 0)};
       m_sub_model = sub_model;
 
+      if (value.isValid()) {
+        sub_model->set_data(value);
+        break;
+      }
+
       // Set the oneof field
       // We don't need to do this for messages because refl->MutableMessage() already sets the oneof field
       switch (field_desc->cpp_type()) {
@@ -362,5 +432,17 @@ bool OneofModel::set_oneof(const FieldDescriptor* field_desc) const {
       break;
   }
 
+  resume_change_recording();
+
+  if (recording && old_field_desc != field_desc) {
+    record_change(ModelChange::set_oneof(get_path(), old_field_desc ? old_field_desc->number() : -1, old_value,
+                                         old_message, field_desc->number(), value, message));
+  }
+
   return true;
 }
+
+void OneofModel::add_child_path_component([[maybe_unused]] const int& child_index, FieldPath& path) const {
+  SILENT_CHECK_PARAM_NULLPTR(m_current_field_desc);
+  add_path_component(path, FieldPath::FieldNumber(m_current_field_desc->number()));
+}
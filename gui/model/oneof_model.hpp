@@ -30,6 +30,7 @@
 
 #include <google/protobuf/message.h>
 #include <memory>
+#include <string>
 #include <vector>
 #include "gui/model/proto_model.hpp"
 
@@ -39,7 +40,7 @@ using Reflection = google::protobuf::Reflection;
 using FieldDescriptor = google::protobuf::FieldDescriptor;
 using OneofDescriptor = google::protobuf::OneofDescriptor;
 
-class OneofModel : public ProtoModel {
+class OneofModel final : public ProtoModel {
   Q_OBJECT
 
  public:
@@ -55,7 +56,7 @@ class OneofModel : public ProtoModel {
   bool set_data(const QVariant& value) override;
 
   const ProtoModel* get_sub_model(const int& field_number) const;
-  const ProtoModel* get_sub_model(const FieldPath& path, const bool& for_set_data = false,
+  const ProtoModel* get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data = false,
                                   const bool& for_get_oneof = false) const override;
 
   int get_oneof_value_field_number() const override;
@@ -70,9 +71,20 @@ class OneofModel : public ProtoModel {
   QVariant headerData([[maybe_unused]] int section, [[maybe_unused]] Qt::Orientation orientation,
                       [[maybe_unused]] int role = Qt::DisplayRole) const override;
 
-  bool set_oneof(const int& field_number);
+  /**
+     * @brief Sets the field @p field_number of the oneof. Its value is 
+     *        @p value for primitive fields and the serialized @p message for
+     *        message fields, the default value if they are empty.
+     */
+  bool set_oneof(const int& field_number, const QVariant& value = QVariant(),
+                 const std::string& message = std::string());
+  bool clear_oneof();
   int get_oneof_field_number() const;
 
+  void set_message_buffer(Message* message_buffer) override;
+
+  static constexpr bool has_kind(const Kind& kind) { return kind == Kind::ONEOF; }
+
  private:
   Message* m_message_buffer;
   const OneofDescriptor* m_oneof_desc;
@@ -83,7 +95,10 @@ class OneofModel : public ProtoModel {
   void clear_sub_models() override {}
   void clear_sub_model() const;
   bool is_set() const;
-  bool set_oneof(const FieldDescriptor* field_desc) const;
+  bool set_oneof(const FieldDescriptor* field_desc, const QVariant& value = QVariant(),
+                 const std::string& message = std::string()) const;
+  void get_field_value(const FieldDescriptor* field_desc, QVariant& value, std::string& message) const;
+  void add_child_path_component(const int& child_index, FieldPath& path) const override;
 };
 
 #endif  // ONEOF_MODEL_HPP
@@ -29,6 +29,7 @@
 
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/reflection.h>
+#include <type_traits>
 #include "gui/model/message_model.hpp"
 #include "gui/model/oneof_model.hpp"
 #include "gui/model/repeated_primitive_model.hpp"
@@ -40,7 +41,11 @@ using namespace google::protobuf;
 
 PrimitiveModel::PrimitiveModel(Message* message_buffer, const FieldDescriptor* field_desc, ProtoModel* parent_model,
                                const int& index_in_parent)
-    : ProtoModel(parent_model, index_in_parent), m_message_buffer(message_buffer), m_field_desc(field_desc) {}
+    : PrimitiveModel(Kind::PRIMITIVE, message_buffer, field_desc, parent_model, index_in_parent) {}
+
+PrimitiveModel::PrimitiveModel(const Kind& kind, Message* message_buffer, const FieldDescriptor* field_desc,
+                               ProtoModel* parent_model, const int& index_in_parent)
+    : ProtoModel(kind, parent_model, index_in_parent), m_message_buffer(message_buffer), m_field_desc(field_desc) {}
 
 void PrimitiveModel::build_sub_models() { FAIL_AND_RETURN("Primitive model does not have sub-models."); }
 
@@ -53,18 +58,29 @@ void PrimitiveModel::parent_data_changed() const {
 
   ProtoModel* t{const_cast<ProtoModel*>(parent)};
 
-  if (RepeatedPrimitiveModel * repeated_m{dynamic_cast<RepeatedPrimitiveModel*>(t)}) {
-    Q_EMIT repeated_m->dataChanged(index, index);
-    repeated_m->parent_data_changed();
-    return;
-  } else if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    Q_EMIT message_m->dataChanged(index, index);
-    message_m->parent_data_changed();
-    return;
-  } else if (OneofModel * oneof_m{dynamic_cast<OneofModel*>(t)}) {
-    Q_EMIT oneof_m->dataChanged(index, index);
-    oneof_m->parent_data_changed();
-    return;
+  const bool batched{is_in_batch()};
+
+  switch (t->get_kind()) {
+    case Kind::REPEATED_PRIMITIVE: {
+      RepeatedPrimitiveModel* repeated_m{static_cast<RepeatedPrimitiveModel*>(t)};
+      if (!batched) Q_EMIT repeated_m->dataChanged(index, index);
+      repeated_m->RepeatedPrimitiveModel::parent_data_changed();
+      return;
+    }
+    case Kind::MESSAGE: {
+      MessageModel* message_m{static_cast<MessageModel*>(t)};
+      if (!batched) Q_EMIT message_m->dataChanged(index, index);
+      message_m->MessageModel::parent_data_changed();
+      return;
+    }
+    case Kind::ONEOF: {
+      OneofModel* oneof_m{static_cast<OneofModel*>(t)};
+      if (!batched) Q_EMIT oneof_m->dataChanged(index, index);
+      oneof_m->OneofModel::parent_data_changed();
+      return;
+    }
+    default:
+      break;
   }
 
   ERROR_PRINT("Parent model is not a repeated primitive model, message model, or oneof model.");
@@ -76,11 +92,11 @@ bool PrimitiveModel::set_data(const QVariant& value) {
   return setData(this->index(0, 0, this->parent(QModelIndex())), value);
 }
 
-const ProtoModel* PrimitiveModel::get_sub_model([[maybe_unused]] const FieldPath& path, const bool& for_set_data,
-                                                const bool& for_get_oneof) const {
+const ProtoModel* PrimitiveModel::get_sub_model([[maybe_unused]] const FieldPath::Cursor& cursor,
+                                                const bool& for_set_data, const bool& for_get_oneof) const {
   const Descriptor* desc{m_message_buffer->GetDescriptor()};
-  CHECK_CONDITION_TRUE_NON_VOID(!path.is_valid(), nullptr, "Invalid path for " + desc->full_name());
-  CHECK_CONDITION_TRUE_NON_VOID(!path.is_empty(), nullptr, "Trying to get sub-model of a primitive model.");
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.is_valid(), nullptr, "Invalid path for " + desc->full_name());
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.is_empty(), nullptr, "Trying to get sub-model of a primitive model.");
   return this;
 }
 
@@ -109,12 +125,21 @@ QModelIndex PrimitiveModel::parent([[maybe_unused]] const QModelIndex& child) co
         as primitive models cannot have children except for repeated primitive models which are
         only allowed to have children of type PrimitiveModel.
     */
-  if (RepeatedPrimitiveModel * repeated_m{dynamic_cast<RepeatedPrimitiveModel*>(t)}) {
-    return repeated_m->index(m_index_in_parent, 0, repeated_m->parent(QModelIndex()));
-  } else if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    return message_m->index(0, m_index_in_parent, message_m->parent(QModelIndex()));
-  } else if (OneofModel * oneof_m{dynamic_cast<OneofModel*>(t)}) {
-    return oneof_m->index(0, m_index_in_parent, oneof_m->parent(QModelIndex()));
+  switch (t->get_kind()) {
+    case Kind::REPEATED_PRIMITIVE: {
+      RepeatedPrimitiveModel* repeated_m{static_cast<RepeatedPrimitiveModel*>(t)};
+      return repeated_m->index(m_index_in_parent, 0, repeated_m->RepeatedPrimitiveModel::parent(QModelIndex()));
+    }
+    case Kind::MESSAGE: {
+      MessageModel* message_m{static_cast<MessageModel*>(t)};
+      return message_m->index(0, m_index_in_parent, message_m->MessageModel::parent(QModelIndex()));
+    }
+    case Kind::ONEOF: {
+      OneofModel* oneof_m{static_cast<OneofModel*>(t)};
+      return oneof_m->index(0, m_index_in_parent, oneof_m->OneofModel::parent(QModelIndex()));
+    }
+    default:
+      break;
   }
 
   FAIL_AND_RETURN_NON_VOID(QModelIndex(),
@@ -167,35 +192,46 @@ QVariant PrimitiveModel::data([[maybe_unused]] const QModelIndex& index, [[maybe
         WARN_PRINT("Unsupported field type: " + std::to_string(m_field_desc->cpp_type()));
         break;
     }
-  } else {
-    SILENT_CHECK_CONDITION_TRUE_NON_VOID(!refl->HasField(*m_message_buffer, m_field_desc), QVariant());
 
-    switch (m_field_desc->cpp_type()) {
-      case FieldDescriptor::CppType::CPPTYPE_MESSAGE:
-        FAIL_AND_RETURN_NON_VOID(QVariant(), "Trying to get a message field.");
-        break;
-      case FieldDescriptor::CppType::CPPTYPE_INT32:
-        return refl->GetInt32(*m_message_buffer, m_field_desc);
-      case FieldDescriptor::CppType::CPPTYPE_INT64:
-        return QVariant::fromValue(refl->GetInt64(*m_message_buffer, m_field_desc));
-      case FieldDescriptor::CppType::CPPTYPE_UINT32:
-        return refl->GetUInt32(*m_message_buffer, m_field_desc);
-      case FieldDescriptor::CppType::CPPTYPE_UINT64:
-        return QVariant::fromValue(refl->GetUInt64(*m_message_buffer, m_field_desc));
-      case FieldDescriptor::CppType::CPPTYPE_DOUBLE:
-        return refl->GetDouble(*m_message_buffer, m_field_desc);
-      case FieldDescriptor::CppType::CPPTYPE_FLOAT:
-        return refl->GetFloat(*m_message_buffer, m_field_desc);
-      case FieldDescriptor::CppType::CPPTYPE_BOOL:
-        return refl->GetBool(*m_message_buffer, m_field_desc);
-      case FieldDescriptor::CppType::CPPTYPE_STRING:
-        return QString::fromStdString(refl->GetString(*m_message_buffer, m_field_desc));
-      case FieldDescriptor::CppType::CPPTYPE_ENUM:
-        return refl->GetEnumValue(*m_message_buffer, m_field_desc);
-      default:
-        WARN_PRINT("Unsupported field type: " + std::to_string(m_field_desc->cpp_type()));
-        break;
-    }
+    return QVariant();
+  }
+
+  return get_field_value(*m_message_buffer, m_field_desc);
+}
+
+QVariant PrimitiveModel::get_field_value(const Message& message, const FieldDescriptor* field_desc) {
+  CHECK_PARAM_NULLPTR_NON_VOID(field_desc, QVariant(), "Field descriptor is null.");
+  CHECK_CONDITION_TRUE_NON_VOID(field_desc->is_repeated(), QVariant(), "Trying to get a repeated field.");
+
+  const Reflection* refl{message.GetReflection()};
+
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!refl->HasField(message, field_desc), QVariant());
+
+  switch (field_desc->cpp_type()) {
+    case FieldDescriptor::CppType::CPPTYPE_MESSAGE:
+      FAIL_AND_RETURN_NON_VOID(QVariant(), "Trying to get a message field.");
+      break;
+    case FieldDescriptor::CppType::CPPTYPE_INT32:
+      return refl->GetInt32(message, field_desc);
+    case FieldDescriptor::CppType::CPPTYPE_INT64:
+      return QVariant::fromValue(refl->GetInt64(message, field_desc));
+    case FieldDescriptor::CppType::CPPTYPE_UINT32:
+      return refl->GetUInt32(message, field_desc);
+    case FieldDescriptor::CppType::CPPTYPE_UINT64:
+      return QVariant::fromValue(refl->GetUInt64(message, field_desc));
+    case FieldDescriptor::CppType::CPPTYPE_DOUBLE:
+      return refl->GetDouble(message, field_desc);
+    case FieldDescriptor::CppType::CPPTYPE_FLOAT:
+      return refl->GetFloat(message, field_desc);
+    case FieldDescriptor::CppType::CPPTYPE_BOOL:
+      return refl->GetBool(message, field_desc);
+    case FieldDescriptor::CppType::CPPTYPE_STRING:
+      return QString::fromStdString(refl->GetString(message, field_desc));
+    case FieldDescriptor::CppType::CPPTYPE_ENUM:
+      return refl->GetEnumValue(message, field_desc);
+    default:
+      WARN_PRINT("Unsupported field type: " + std::to_string(field_desc->cpp_type()));
+      break;
   }
 
   return QVariant();
@@ -210,6 +246,9 @@ bool PrimitiveModel::setData([[maybe_unused]] const QModelIndex& index, [[maybe_
   CHECK_CONDITION_TRUE_NON_VOID(value.isNull(), false, "Value is null.");
   CHECK_CONDITION_TRUE_NON_VOID(index.row() > 0, false, "A primitive model should have only one row.");
   CHECK_CONDITION_TRUE_NON_VOID(index.column() > 0, false, "A primitive model should have only one column.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!make_present(), false);
+
+  const QVariant old_value{is_recording_changes() ? data(index) : QVariant()};
 
   const Reflection* refl{m_message_buffer->GetReflection()};
 
@@ -321,8 +360,44 @@ bool PrimitiveModel::setData([[maybe_unused]] const QModelIndex& index, [[maybe_
     }
   }
 
-  Q_EMIT dataChanged(index, index);
+  value_changed(index, old_value);
+
+  return true;
+}
+
+void PrimitiveModel::value_changed(const QModelIndex& index, const QVariant& old_value) {
+  if (is_recording_changes()) {
+    // Setting the same value again is not a change.
+    const QVariant new_value{data(index)};
+    if (new_value != old_value) record_change(ModelChange::set_field(get_path(), old_value, new_value));
+  }
+
+  notify_value_changed(index);
+}
+
+void PrimitiveModel::notify_value_changed(const QModelIndex& index) {
+  if (!is_in_batch() || !record_batch_change(get_path())) Q_EMIT dataChanged(index, index);
   parent_data_changed();
+}
+
+bool PrimitiveModel::clear_value() {
+  CHECK_PARAM_NULLPTR_NON_VOID(m_message_buffer, false, "Message buffer is null.");
+  CHECK_PARAM_NULLPTR_NON_VOID(m_field_desc, false, "Field descriptor is null.");
+  CHECK_CONDITION_TRUE_NON_VOID(m_field_desc->is_repeated(), false,
+                                "Field " + m_field_desc->full_name() + " is not a single value.");
+
+  // Clearing it would leave its oneof model pointing at an unset field.
+  CHECK_CONDITION_TRUE_NON_VOID(shadergen_utils::is_inside_real_oneof(m_field_desc), false,
+                                "Field " + m_field_desc->full_name() + " is inside a oneof.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!make_present(), false);
+
+  const QModelIndex index{this->index(0, 0, this->parent(QModelIndex()))};
+  const QVariant old_value{is_recording_changes() ? data(index) : QVariant()};
+
+  const Reflection* refl{m_message_buffer->GetReflection()};
+  refl->ClearField(m_message_buffer, m_field_desc);
+
+  value_changed(index, old_value);
 
   return true;
 }
@@ -339,3 +414,209 @@ QVariant PrimitiveModel::headerData(int section, [[maybe_unused]] Qt::Orientatio
 
   return QString::fromStdString(field_desc->full_name());
 }
+
+template <typename T>
+bool PrimitiveModel::is_value_type() const {
+  static_assert(std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t> || std::is_same_v<T, uint32_t> ||
+                    std::is_same_v<T, uint64_t> || std::is_same_v<T, float> || std::is_same_v<T, double> ||
+                    std::is_same_v<T, bool> || std::is_same_v<T, std::string>,
+                "Not a protobuf value type.");
+
+  switch (m_field_desc->cpp_type()) {
+    case FieldDescriptor::CppType::CPPTYPE_INT32:
+    case FieldDescriptor::CppType::CPPTYPE_ENUM:
+      return std::is_same_v<T, int32_t>;
+    case FieldDescriptor::CppType::CPPTYPE_INT64:
+      return std::is_same_v<T, int64_t>;
+    case FieldDescriptor::CppType::CPPTYPE_UINT32:
+      return std::is_same_v<T, uint32_t>;
+    case FieldDescriptor::CppType::CPPTYPE_UINT64:
+      return std::is_same_v<T, uint64_t>;
+    case FieldDescriptor::CppType::CPPTYPE_DOUBLE:
+      return std::is_same_v<T, double>;
+    case FieldDescriptor::CppType::CPPTYPE_FLOAT:
+      return std::is_same_v<T, float>;
+    case FieldDescriptor::CppType::CPPTYPE_BOOL:
+      return std::is_same_v<T, bool>;
+    case FieldDescriptor::CppType::CPPTYPE_STRING:
+      return std::is_same_v<T, std::string>;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Boxes @p value the way data() does.
+ */
+template <typename T>
+static QVariant to_variant(const T& value) {
+  if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>) {
+    return QVariant::fromValue(value);
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    return QString::fromStdString(value);
+  } else {
+    return QVariant(value);
+  }
+}
+
+template <typename T>
+bool PrimitiveModel::get_value(T& value_buffer) const {
+  CHECK_PARAM_NULLPTR_NON_VOID(m_message_buffer, false, "Message buffer is null.");
+  CHECK_PARAM_NULLPTR_NON_VOID(m_field_desc, false, "Field descriptor is null.");
+  CHECK_CONDITION_TRUE_NON_VOID(get_kind() != Kind::PRIMITIVE, false,
+                                "Field " + m_field_desc->full_name() + " is not a single value.");
+  CHECK_CONDITION_TRUE_NON_VOID(!is_value_type<T>(), false, "Type mismatch for field " + m_field_desc->full_name());
+
+  const Reflection* refl{m_message_buffer->GetReflection()};
+  const Message& m{*m_message_buffer};
+  const FieldDescriptor* f{m_field_desc};
+
+  // The row of a repeated field is the index in the parent.
+  if (f->is_repeated()) {
+    const int row{m_index_in_parent};
+    VALIDATE_INDEX_NON_VOID(row, refl->FieldSize(m, f), false, "Parent row index is out of range.");
+
+    if constexpr (std::is_same_v<T, int32_t>) {
+      value_buffer = f->cpp_type() == FieldDescriptor::CppType::CPPTYPE_ENUM ? refl->GetRepeatedEnumValue(m, f, row)
+                                                                              : refl->GetRepeatedInt32(m, f, row);
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+      value_buffer = refl->GetRepeatedInt64(m, f, row);
+    } else if constexpr (std::is_same_v<T, uint32_t>) {
+      value_buffer = refl->GetRepeatedUInt32(m, f, row);
+    } else if constexpr (std::is_same_v<T, uint64_t>) {
+      value_buffer = refl->GetRepeatedUInt64(m, f, row);
+    } else if constexpr (std::is_same_v<T, float>) {
+      value_buffer = refl->GetRepeatedFloat(m, f, row);
+    } else if constexpr (std::is_same_v<T, double>) {
+      value_buffer = refl->GetRepeatedDouble(m, f, row);
+    } else if constexpr (std::is_same_v<T, bool>) {
+      value_buffer = refl->GetRepeatedBool(m, f, row);
+    } else {
+      value_buffer = refl->GetRepeatedStringReference(m, f, row, &value_buffer);
+    }
+    return true;
+  }
+
+  // Unset fields read as their default value.
+  if constexpr (std::is_same_v<T, int32_t>) {
+    value_buffer =
+        f->cpp_type() == FieldDescriptor::CppType::CPPTYPE_ENUM ? refl->GetEnumValue(m, f) : refl->GetInt32(m, f);
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    value_buffer = refl->GetInt64(m, f);
+  } else if constexpr (std::is_same_v<T, uint32_t>) {
+    value_buffer = refl->GetUInt32(m, f);
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    value_buffer = refl->GetUInt64(m, f);
+  } else if constexpr (std::is_same_v<T, float>) {
+    value_buffer = refl->GetFloat(m, f);
+  } else if constexpr (std::is_same_v<T, double>) {
+    value_buffer = refl->GetDouble(m, f);
+  } else if constexpr (std::is_same_v<T, bool>) {
+    value_buffer = refl->GetBool(m, f);
+  } else {
+    value_buffer = refl->GetStringReference(m, f, &value_buffer);
+  }
+  return true;
+}
+
+template <typename T>
+bool PrimitiveModel::set_value(const T& value) {
+  CHECK_PARAM_NULLPTR_NON_VOID(m_message_buffer, false, "Message buffer is null.");
+  CHECK_PARAM_NULLPTR_NON_VOID(m_field_desc, false, "Field descriptor is null.");
+  CHECK_CONDITION_TRUE_NON_VOID(get_kind() != Kind::PRIMITIVE, false,
+                                "Field " + m_field_desc->full_name() + " is not a single value.");
+  CHECK_CONDITION_TRUE_NON_VOID(!is_value_type<T>(), false, "Type mismatch for field " + m_field_desc->full_name());
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!make_present(), false);
+
+  const Reflection* refl{m_message_buffer->GetReflection()};
+  Message* m{m_message_buffer};
+  const FieldDescriptor* f{m_field_desc};
+
+  if constexpr (std::is_same_v<T, int32_t>) {
+    CHECK_CONDITION_TRUE_NON_VOID(f->cpp_type() == FieldDescriptor::CppType::CPPTYPE_ENUM &&
+                                      !shadergen_utils::is_valid_enum_value(f->enum_type(), value),
+                                  false, "Enum value is not valid.");
+  }
+
+  // Compared typed, the values are only boxed for the record when they differ.
+  const bool recording{is_recording_changes()};
+  const auto is_set{[&]() { return f->is_repeated() || refl->HasField(*m, f); }};
+  T old_value{};
+  bool was_set{false};
+  if (recording) {
+    SILENT_CHECK_CONDITION_TRUE_NON_VOID(!get_value(old_value), false);
+    was_set = is_set();
+  }
+
+  if (f->is_repeated()) {
+    const int row{m_index_in_parent};
+    VALIDATE_INDEX_NON_VOID(row, refl->FieldSize(*m, f), false, "Parent row index is out of range.");
+
+    if constexpr (std::is_same_v<T, int32_t>) {
+      if (f->cpp_type() == FieldDescriptor::CppType::CPPTYPE_ENUM)
+        refl->SetRepeatedEnumValue(m, f, row, value);
+      else
+        refl->SetRepeatedInt32(m, f, row, value);
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+      refl->SetRepeatedInt64(m, f, row, value);
+    } else if constexpr (std::is_same_v<T, uint32_t>) {
+      refl->SetRepeatedUInt32(m, f, row, value);
+    } else if constexpr (std::is_same_v<T, uint64_t>) {
+      refl->SetRepeatedUInt64(m, f, row, value);
+    } else if constexpr (std::is_same_v<T, float>) {
+      refl->SetRepeatedFloat(m, f, row, value);
+    } else if constexpr (std::is_same_v<T, double>) {
+      refl->SetRepeatedDouble(m, f, row, value);
+    } else if constexpr (std::is_same_v<T, bool>) {
+      refl->SetRepeatedBool(m, f, row, value);
+    } else {
+      refl->SetRepeatedString(m, f, row, value);
+    }
+  } else {
+    if constexpr (std::is_same_v<T, int32_t>) {
+      if (f->cpp_type() == FieldDescriptor::CppType::CPPTYPE_ENUM)
+        refl->SetEnumValue(m, f, value);
+      else
+        refl->SetInt32(m, f, value);
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+      refl->SetInt64(m, f, value);
+    } else if constexpr (std::is_same_v<T, uint32_t>) {
+      refl->SetUInt32(m, f, value);
+    } else if constexpr (std::is_same_v<T, uint64_t>) {
+      refl->SetUInt64(m, f, value);
+    } else if constexpr (std::is_same_v<T, float>) {
+      refl->SetFloat(m, f, value);
+    } else if constexpr (std::is_same_v<T, double>) {
+      refl->SetDouble(m, f, value);
+    } else if constexpr (std::is_same_v<T, bool>) {
+      refl->SetBool(m, f, value);
+    } else {
+      refl->SetString(m, f, value);
+    }
+  }
+
+  if (recording) {
+    const bool set{is_set()};
+    if (set != was_set || !(old_value == value)) {
+      record_change(ModelChange::set_field(get_path(), was_set ? to_variant(old_value) : QVariant(),
+                                           set ? to_variant(value) : QVariant()));
+    }
+  }
+
+  notify_value_changed(this->index(0, 0, this->parent(QModelIndex())));
+
+  return true;
+}
+
+#define INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(T)            \
+  template bool PrimitiveModel::get_value<T>(T&) const; \
+  template bool PrimitiveModel::set_value<T>(const T&);
+
+INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(int32_t)
+INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(int64_t)
+INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(uint32_t)
+INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(uint64_t)
+INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(float)
+INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(double)
+INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(bool)
+INSTANTIATE_PRIMITIVE_MODEL_VALUE_ACCESS(std::string)
@@ -53,7 +53,7 @@ class PrimitiveModel : public ProtoModel {
   QVariant data() const override;
   bool set_data(const QVariant& value) override;
 
-  const ProtoModel* get_sub_model(const FieldPath& path, const bool& for_set_data = false,
+  const ProtoModel* get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data = false,
                                   const bool& for_get_oneof = false) const override;
 
   const FieldDescriptor* get_column_descriptor(const int& column) const override;
@@ -68,11 +68,56 @@ class PrimitiveModel : public ProtoModel {
 
   const FieldDescriptor* get_field_descriptor() const { return m_field_desc; }
 
+  /**
+     * @brief Reads the singular field @p field_desc of @p message the way
+     *        data() does, invalid if the field is unset.
+     */
+  static QVariant get_field_value(const Message& message, const FieldDescriptor* field_desc);
+
+  /**
+     * @brief Reads and writes the value without going through QVariant. @p T
+     *        must be the C++ type of the field, enums are read and written
+     *        as int32_t.
+     * 
+     * @note Instantiated for int32_t, int64_t, uint32_t, uint64_t, float, 
+     *       double, bool and std::string. Not available on the rows container
+     *       of a repeated primitive field.
+     * 
+     * @note While the changes are recorded, see @c ModelChange, set_value()
+     *       compares the typed old and new values and only converts them to
+     *       QVariant for the record when they differ.
+     */
+  template <typename T>
+  bool get_value(T& value_buffer) const;
+  template <typename T>
+  bool set_value(const T& value);
+
+  /**
+     * @brief Unsets the field, it reads as invalid then. Not available on
+     *        repeated fields and fields inside a oneof.
+     */
+  bool clear_value();
+
+  void set_message_buffer(Message* message_buffer) override { m_message_buffer = message_buffer; }
+
+  static constexpr bool has_kind(const Kind& kind) {
+    return kind == Kind::PRIMITIVE || kind == Kind::REPEATED_PRIMITIVE;
+  }
+
+ protected:
+  PrimitiveModel(const Kind& kind, Message* message_buffer, const FieldDescriptor* field_desc,
+                 ProtoModel* parent_model, const int& index_in_parent);
+
  private:
   Message* m_message_buffer;
   const FieldDescriptor* m_field_desc;
 
   virtual void clear_sub_models() override {}
+
+  template <typename T>
+  bool is_value_type() const;
+  void value_changed(const QModelIndex& index, const QVariant& old_value);
+  void notify_value_changed(const QModelIndex& index);
 };
 
 #endif  // PRIMITIVE_MODEL_HPP
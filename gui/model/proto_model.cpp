@@ -31,21 +31,28 @@
 #include <google/protobuf/util/json_util.h>
 #include <QDebug>
 #include <QFile>
+#include <QSaveFile>
+#include <climits>
 
+#include "byte_utils.hpp"
 #include "error_macros.hpp"
+#include "gui/model/message_model.hpp"
+#include "gui/model/model_autosaver.hpp"
+#include "gui/model/model_journal_file.hpp"
+#include "gui/model/oneof_model.hpp"
+#include "gui/model/primitive_model.hpp"
+#include "gui/model/repeated_message_model.hpp"
+#include "gui/model/repeated_primitive_model.hpp"
+#include "gui/model/utils/mapped_file.hpp"
 
 using namespace google::protobuf::util;
 using Message = google::protobuf::Message;
 
-ProtoModel::ProtoModel(ProtoModel* parent_model, const int& index_in_parent)
-    : QAbstractItemModel(parent_model), m_parent_model(parent_model), m_index_in_parent(index_in_parent) {
-  if (m_parent_model == nullptr) {
-    QObject::connect(this, &QAbstractItemModel::dataChanged,
-                     [this](const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles) {
-                       this->saveToJson("model.json");
-                     });
-  }
-}
+ProtoModel::ProtoModel(const Kind& kind, ProtoModel* parent_model, const int& index_in_parent)
+    : QAbstractItemModel(parent_model),
+      m_parent_model(parent_model),
+      m_index_in_parent(index_in_parent),
+      m_kind(kind) {}
 
 QByteArray ProtoModel::serializeToJson() const {
   const ProtoModel* root_model = get_root_model();
@@ -62,14 +69,16 @@ QByteArray ProtoModel::serializeToJson() const {
   return QByteArray::fromStdString(json_string);
 }
 
-bool ProtoModel::deserializeFromJson(const QByteArray& jsonData) {
+bool ProtoModel::deserializeFromJson(const char* data, const size_t& size) {
   const ProtoModel* root_model = get_root_model();
   CHECK_PARAM_NULLPTR_NON_VOID(root_model, false, "Failed to get root model");
   Message* message_buffer = root_model->get_message_buffer();
   CHECK_PARAM_NULLPTR_NON_VOID(message_buffer, false, "Failed to get message buffer");
 
   JsonParseOptions options;
-  absl::Status status = JsonStringToMessage(jsonData.toStdString(), message_buffer, options);
+  root_model->begin_reload();
+  absl::Status status = JsonStringToMessage(absl::string_view(data, size), message_buffer, options);
+  root_model->end_reload();
 
   CHECK_CONDITION_TRUE_NON_VOID(!status.ok(), false, "Failed to deserialize JSON:" + status.ToString());
 
@@ -77,13 +86,9 @@ bool ProtoModel::deserializeFromJson(const QByteArray& jsonData) {
 }
 
 bool ProtoModel::loadFromJson(const QString& filePath) {
-  QFile file(filePath);
-  CHECK_CONDITION_TRUE_NON_VOID(!file.open(QIODevice::ReadOnly), false,
-                                "Failed to open file for reading: " + filePath.toStdString());
-
-  QByteArray jsonData = file.readAll();
-  file.close();
-  return deserializeFromJson(jsonData);
+  MappedFile file(filePath);
+  CHECK_CONDITION_TRUE_NON_VOID(!file.open(), false, "Failed to open file for reading: " + filePath.toStdString());
+  return deserializeFromJson(file.get_data(), file.get_size());
 }
 
 bool ProtoModel::saveToJson(const QString& filePath) const {
@@ -97,6 +102,122 @@ bool ProtoModel::saveToJson(const QString& filePath) const {
   return true;
 }
 
+bool ProtoModel::serialize_to_binary(const Message& message, std::string& data) {
+  const size_t message_size{message.ByteSizeLong()};
+
+  data.clear();
+  data.reserve(PROTO_MODEL_BINARY_HEADER_SIZE + message_size);
+
+  shadergen_utils::append_u32(data, PROTO_MODEL_BINARY_MAGIC);
+  shadergen_utils::append_u32(data, PROTO_MODEL_BINARY_VERSION);
+  shadergen_utils::append_u64(data, message_size);
+  CHECK_CONDITION_TRUE_NON_VOID(!message.AppendToString(&data), false, "Failed to serialize " + message.GetTypeName());
+  return true;
+}
+
+bool ProtoModel::is_binary(const char* data, const size_t& size) {
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(size < PROTO_MODEL_BINARY_HEADER_SIZE, false);
+  return shadergen_utils::read_u32(data) == PROTO_MODEL_BINARY_MAGIC;
+}
+
+bool ProtoModel::parse_from_binary(const char* data, const size_t& size, Message& message) {
+  CHECK_CONDITION_TRUE_NON_VOID(!is_binary(data, size), false, "Not a binary project file.");
+
+  const uint32_t version{shadergen_utils::read_u32(data + 4)};
+  CHECK_CONDITION_TRUE_NON_VOID(version != PROTO_MODEL_BINARY_VERSION, false,
+                                "Unsupported binary format version: " + std::to_string(version));
+
+  // The size tells a truncated file apart from a smaller message.
+  const uint64_t message_size{shadergen_utils::read_u64(data + 8)};
+  CHECK_CONDITION_TRUE_NON_VOID(message_size != size - PROTO_MODEL_BINARY_HEADER_SIZE, false,
+                                "Expected " + std::to_string(message_size) + " bytes of message, found " +
+                                    std::to_string(size - PROTO_MODEL_BINARY_HEADER_SIZE));
+  CHECK_CONDITION_TRUE_NON_VOID(message_size > INT_MAX, false, "Message is too large.");
+
+  // Parsed in place, only the strings are copied, to the arena of the
+  // message if it has one.
+  CHECK_CONDITION_TRUE_NON_VOID(!message.ParseFromArray(data + PROTO_MODEL_BINARY_HEADER_SIZE, (int)message_size),
+                                false, "Failed to parse " + message.GetTypeName());
+  return true;
+}
+
+bool ProtoModel::deserializeFromBinary(const char* data, const size_t& size) {
+  const ProtoModel* root_model = get_root_model();
+  CHECK_PARAM_NULLPTR_NON_VOID(root_model, false, "Failed to get root model");
+  Message* message_buffer = root_model->get_message_buffer();
+  CHECK_PARAM_NULLPTR_NON_VOID(message_buffer, false, "Failed to get message buffer");
+
+  root_model->begin_reload();
+  const bool result{parse_from_binary(data, size, *message_buffer)};
+  root_model->end_reload();
+
+  return result;
+}
+
+void ProtoModel::begin_reload() const {
+  ProtoModel* root_model{const_cast<ProtoModel*>(get_root_model())};
+  root_model->beginResetModel();
+
+  // The sub-models, with the row indices of the repeated ones, point into
+  // the document being replaced.
+  root_model->clear_sub_models();
+}
+
+void ProtoModel::end_reload() const {
+  ProtoModel* root_model{const_cast<ProtoModel*>(get_root_model())};
+  if (root_model->m_snapshot_tracker) root_model->m_snapshot_tracker->invalidate();
+  root_model->endResetModel();
+}
+
+bool ProtoModel::loadFromBinary(const QString& filePath) {
+  MappedFile file(filePath);
+  CHECK_CONDITION_TRUE_NON_VOID(!file.open(), false, "Failed to open file for reading: " + filePath.toStdString());
+  return deserializeFromBinary(file.get_data(), file.get_size());
+}
+
+bool ProtoModel::saveToBinary(const QString& filePath) const {
+  const ProtoModel* root_model = get_root_model();
+  CHECK_PARAM_NULLPTR_NON_VOID(root_model, false, "Failed to get root model");
+  Message* message_buffer = root_model->get_message_buffer();
+  CHECK_PARAM_NULLPTR_NON_VOID(message_buffer, false, "Failed to get message buffer");
+
+  std::string data;
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!serialize_to_binary(*message_buffer, data), false);
+
+  // Replaces the file only once it is completely written.
+  QSaveFile file(filePath);
+  CHECK_CONDITION_TRUE_NON_VOID(!file.open(QIODevice::WriteOnly), false,
+                                "Failed to open file for writing: " + filePath.toStdString());
+  file.write(data.data(), data.size());
+  CHECK_CONDITION_TRUE_NON_VOID(!file.commit(), false,
+                                "Failed to write " + filePath.toStdString() + ": " + file.errorString().toStdString());
+  return true;
+}
+
+bool ProtoModel::load(const QString& filePath) {
+  MappedFile file(filePath);
+  CHECK_CONDITION_TRUE_NON_VOID(!file.open(), false, "Failed to open file for reading: " + filePath.toStdString());
+  return loadFromData(file.get_data(), file.get_size());
+}
+
+bool ProtoModel::loadFromData(const char* data, const size_t& size) {
+  if (is_binary(data, size)) return deserializeFromBinary(data, size);
+  return deserializeFromJson(data, size);
+}
+
+bool ProtoModel::save(const QString& filePath, const FileFormat& format) const {
+  switch (format) {
+    case FileFormat::JSON:
+      return saveToJson(filePath);
+    case FileFormat::BINARY:
+      return saveToBinary(filePath);
+    default:
+      break;
+  }
+
+  FAIL_AND_RETURN_NON_VOID(false, "Unknown file format.");
+}
+
 QVariant ProtoModel::data(const FieldPath& path) const {
   const ProtoModel* model = get_sub_model(path);
   CHECK_PARAM_NULLPTR_NON_VOID(model, QVariant(), "Failed to get sub model " + path.to_string());
@@ -104,11 +225,43 @@ QVariant ProtoModel::data(const FieldPath& path) const {
 }
 
 bool ProtoModel::set_data(const FieldPath& path, const QVariant& value) {
+  // Switching the oneofs on the path is part of the change.
+  ModelUndoStack::StepGuard step{get_undo_stack()};
+
   ProtoModel* model = const_cast<ProtoModel*>(get_sub_model(path, true));
   CHECK_PARAM_NULLPTR_NON_VOID(model, false, "Failed to get sub model " + path.to_string());
   return model->set_data(value);
 }
 
+template <typename T>
+bool ProtoModel::get(const FieldPath& path, T& value_buffer) const {
+  const PrimitiveModel* model = model_cast<PrimitiveModel>(get_sub_model(path));
+  CHECK_PARAM_NULLPTR_NON_VOID(model, false, "Failed to get primitive sub model " + path.to_string());
+  return model->get_value(value_buffer);
+}
+
+template <typename T>
+bool ProtoModel::set(const FieldPath& path, const T& value) {
+  ModelUndoStack::StepGuard step{get_undo_stack()};
+
+  PrimitiveModel* model = model_cast<PrimitiveModel>(const_cast<ProtoModel*>(get_sub_model(path, true)));
+  CHECK_PARAM_NULLPTR_NON_VOID(model, false, "Failed to get primitive sub model " + path.to_string());
+  return model->set_value(value);
+}
+
+#define INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(T)                                  \
+  template bool ProtoModel::get<T>(const FieldPath& path, T& value_buffer) const; \
+  template bool ProtoModel::set<T>(const FieldPath& path, const T& value);
+
+INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(int32_t)
+INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(int64_t)
+INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(uint32_t)
+INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(uint64_t)
+INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(float)
+INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(double)
+INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(bool)
+INSTANTIATE_PROTO_MODEL_VALUE_ACCESS(std::string)
+
 QModelIndex ProtoModel::index(int row, int column, [[maybe_unused]] const QModelIndex& parent) const {
   CHECK_CONDITION_TRUE_NON_VOID(!hasIndex(row, column, parent), QModelIndex(), "Invalid index.");
   SILENT_CHECK_CONDITION_TRUE_NON_VOID(!parent.isValid(), createIndex(row, column));
@@ -120,3 +273,223 @@ const ProtoModel* ProtoModel::get_root_model() const {
   while (m->get_parent_model()) m = m->get_parent_model();
   return m;
 }
+
+void ProtoModel::add_path_components(FieldPath& path) const {
+  SILENT_CHECK_PARAM_NULLPTR(m_parent_model);
+  m_parent_model->add_path_components(path);
+  m_parent_model->add_child_path_component(m_index_in_parent, path);
+}
+
+FieldPath ProtoModel::get_path() const {
+  const ProtoModel* root_model = get_root_model();
+  Message* message_buffer = root_model->get_message_buffer();
+  CHECK_PARAM_NULLPTR_NON_VOID(message_buffer, FieldPath(), "Failed to get message buffer");
+
+  FieldPath path;
+  path.m_root_buffer_descriptor = message_buffer->GetDescriptor();
+  add_path_components(path);
+
+  // An empty path is the root model itself.
+  CHECK_CONDITION_TRUE_NON_VOID(!path.is_empty() && !path.resolve_path(), FieldPath(),
+                                "Invalid path: " + path.to_string());
+  path.m_is_valid = true;
+  return path;
+}
+
+bool ProtoModel::make_present() const {
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(m_parent_model, true);
+  return m_parent_model->make_present();
+}
+
+void ProtoModel::begin_batch() const {
+  const ProtoModel* root_model = get_root_model();
+  if (!root_model->m_batch) root_model->m_batch = std::make_unique<BatchState>();
+
+  BatchState& batch{*root_model->m_batch};
+  if (batch.depth == 0) {
+    batch.changed_paths.clear();
+    batch.changed_path_set.clear();
+    batch.first_column = -1;
+    batch.last_column = -1;
+  }
+  batch.depth++;
+}
+
+void ProtoModel::end_batch() const {
+  ProtoModel* root_model = const_cast<ProtoModel*>(get_root_model());
+  CHECK_CONDITION_TRUE(!root_model->is_in_batch(), "No batch to end.");
+
+  BatchState& batch{*root_model->m_batch};
+  SILENT_CHECK_CONDITION_TRUE(--batch.depth > 0);
+
+  // A batch is a single undo step.
+  if (root_model->m_undo_stack) root_model->m_undo_stack->close_step();
+  if (root_model->m_journal_file) root_model->m_journal_file->flush();
+
+  SILENT_CHECK_CONDITION_TRUE(batch.changed_paths.empty());
+
+  Q_EMIT root_model->dataChanged(root_model->index(0, batch.first_column),
+                                 root_model->index(0, batch.last_column));
+}
+
+bool ProtoModel::is_in_batch() const {
+  const ProtoModel* root_model = get_root_model();
+  return root_model->m_batch && root_model->m_batch->depth > 0;
+}
+
+std::vector<FieldPath> ProtoModel::get_batch_changed_paths() const {
+  const ProtoModel* root_model = get_root_model();
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!root_model->m_batch, {});
+  return root_model->m_batch->changed_paths;
+}
+
+bool ProtoModel::record_batch_change(const FieldPath& path) const {
+  const ProtoModel* root_model = get_root_model();
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!root_model->is_in_batch(), false);
+
+  BatchState& batch{*root_model->m_batch};
+
+  // The column of the root model this change is under.
+  const ProtoModel* top{this};
+  while (top->m_parent_model && top->m_parent_model != root_model) top = top->m_parent_model;
+
+  if (top == root_model) {
+    batch.first_column = 0;
+    batch.last_column = root_model->columnCount() - 1;
+  } else {
+    const int column{top->m_index_in_parent};
+    if (batch.first_column == -1 || column < batch.first_column) batch.first_column = column;
+    if (column > batch.last_column) batch.last_column = column;
+  }
+
+  if (batch.changed_path_set.insert(path).second) batch.changed_paths.push_back(path);
+
+  return true;
+}
+
+void ProtoModel::set_journal_capacity(const int& capacity) const {
+  const ProtoModel* root_model = get_root_model();
+  CHECK_CONDITION_TRUE(capacity < 0, "Invalid journal capacity: " + std::to_string(capacity) + ".");
+
+  if (capacity == 0) {
+    root_model->m_journal.reset();
+    return;
+  }
+
+  if (root_model->m_journal) {
+    root_model->m_journal->set_capacity(capacity);
+    return;
+  }
+
+  root_model->m_journal = std::make_unique<ModelJournal>(capacity);
+}
+
+uint64_t ProtoModel::get_journal_sequence() const {
+  const ProtoModel* root_model = get_root_model();
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!root_model->m_journal, 0);
+  return root_model->m_journal->get_last_sequence();
+}
+
+bool ProtoModel::read_journal(const uint64_t& last_seen_sequence, std::vector<ModelChange>& changes) const {
+  const ProtoModel* root_model = get_root_model();
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!root_model->m_journal, false);
+  return root_model->m_journal->read(last_seen_sequence, changes);
+}
+
+void ProtoModel::set_undo_byte_budget(const size_t& byte_budget) const {
+  const ProtoModel* root_model = get_root_model();
+
+  if (byte_budget == 0) {
+    root_model->m_undo_stack.reset();
+    return;
+  }
+
+  if (root_model->m_undo_stack) {
+    root_model->m_undo_stack->set_byte_budget(byte_budget);
+    return;
+  }
+
+  root_model->m_undo_stack = std::make_unique<ModelUndoStack>(const_cast<ProtoModel*>(root_model), byte_budget);
+}
+
+ModelUndoStack* ProtoModel::get_undo_stack() const { return get_root_model()->m_undo_stack.get(); }
+
+std::shared_ptr<const ModelSnapshot> ProtoModel::take_snapshot() const {
+  const ProtoModel* root_model = get_root_model();
+  if (!root_model->m_snapshot_tracker) root_model->m_snapshot_tracker = std::make_unique<ModelSnapshotTracker>(root_model);
+  return root_model->m_snapshot_tracker->take_snapshot();
+}
+
+bool ProtoModel::apply_change(const ModelChange& change) {
+  FieldPath path{change.path};  // Consumed by the lookup
+
+  switch (change.type) {
+    case ModelChange::Type::SET_FIELD: {
+      PrimitiveModel* model{model_cast<PrimitiveModel>(const_cast<ProtoModel*>(get_sub_model(path, true)))};
+      CHECK_PARAM_NULLPTR_NON_VOID(model, false, "Field not found: " + change.path.to_string());
+      return change.new_value.isValid() ? model->set_data(change.new_value) : model->clear_value();
+    }
+    case ModelChange::Type::INSERT_ROW: {
+      ProtoModel* model{const_cast<ProtoModel*>(get_sub_model(path))};
+      if (RepeatedMessageModel * repeated_m{model_cast<RepeatedMessageModel>(model)}) {
+        return repeated_m->insert_row(change.row, change.new_message);
+      } else if (RepeatedPrimitiveModel * repeated_m{model_cast<RepeatedPrimitiveModel>(model)}) {
+        return repeated_m->insert_row(change.row, change.new_value);
+      }
+      FAIL_AND_RETURN_NON_VOID(false, "Repeated field not found: " + change.path.to_string());
+    }
+    case ModelChange::Type::REMOVE_ROW: {
+      ProtoModel* model{const_cast<ProtoModel*>(get_sub_model(path))};
+      CHECK_PARAM_NULLPTR_NON_VOID(model, false, "Repeated field not found: " + change.path.to_string());
+      return model->remove_row(change.row);
+    }
+    case ModelChange::Type::SET_ONEOF: {
+      const MessageModel* message_m{model_cast<MessageModel>(get_sub_model(path))};
+      CHECK_PARAM_NULLPTR_NON_VOID(message_m, false, "Message not found: " + change.path.to_string());
+
+      // Any field of the oneof gives its model.
+      const int fn{change.new_field_number != -1 ? change.new_field_number : change.old_field_number};
+      OneofModel* oneof_m{model_cast<OneofModel>(const_cast<ProtoModel*>(message_m->get_sub_model(fn)))};
+      CHECK_PARAM_NULLPTR_NON_VOID(oneof_m, false, "Oneof of field " + std::to_string(fn) + " not found.");
+
+      if (change.new_field_number == -1) return oneof_m->clear_oneof();
+      return oneof_m->set_oneof(change.new_field_number, change.new_value, change.new_message);
+    }
+    default:
+      break;
+  }
+
+  FAIL_AND_RETURN_NON_VOID(false, "Unsupported change type: " + std::to_string(static_cast<int>(change.type)));
+}
+
+void ProtoModel::set_autosaver(ModelAutosaver* autosaver) const { get_root_model()->m_autosaver = autosaver; }
+
+void ProtoModel::set_journal_file(ModelJournalFile* journal_file) const {
+  get_root_model()->m_journal_file = journal_file;
+}
+
+bool ProtoModel::is_recording_changes() const {
+  const ProtoModel* root_model = get_root_model();
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(root_model->m_change_recording_suspension > 0, false);
+  return root_model->m_journal || root_model->m_undo_stack || root_model->m_snapshot_tracker ||
+         root_model->m_autosaver || root_model->m_journal_file;
+}
+
+void ProtoModel::record_change(const ModelChange& change) const {
+  const ProtoModel* root_model = get_root_model();
+  SILENT_CHECK_CONDITION_TRUE(root_model->m_change_recording_suspension > 0);
+
+  if (root_model->m_undo_stack) root_model->m_undo_stack->record(change);
+  if (root_model->m_journal) root_model->m_journal->record(change);
+  if (root_model->m_snapshot_tracker) root_model->m_snapshot_tracker->record(change);
+  if (root_model->m_autosaver) root_model->m_autosaver->schedule();
+  if (root_model->m_journal_file) root_model->m_journal_file->record(change);
+}
+
+void ProtoModel::suspend_change_recording() const { get_root_model()->m_change_recording_suspension++; }
+
+void ProtoModel::resume_change_recording() const {
+  const ProtoModel* root_model = get_root_model();
+  CHECK_CONDITION_TRUE(root_model->m_change_recording_suspension == 0, "Change recording is not suspended.");
+  root_model->m_change_recording_suspension--;
+}
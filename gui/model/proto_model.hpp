@@ -30,7 +30,14 @@
 
 #include <google/protobuf/message.h>
 #include <QAbstractItemModel>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
 #include "error_macros.hpp"
+#include "gui/model/model_journal.hpp"
+#include "gui/model/model_snapshot.hpp"
+#include "gui/model/model_undo_stack.hpp"
 #include "gui/model/utils/field_path.hpp"
 
 using Message = google::protobuf::Message;
@@ -38,21 +45,70 @@ using Descriptor = google::protobuf::Descriptor;
 using Reflection = google::protobuf::Reflection;
 using FieldDescriptor = google::protobuf::FieldDescriptor;
 
+class ModelAutosaver;
+class ModelJournalFile;
+
+/**
+ * Binary project files start with a header of @c PROTO_MODEL_BINARY_MAGIC,
+ * the format version and the size of the serialized root message, followed
+ * by the message in the protobuf wire format. All values are little-endian.
+ * 
+ *   uint32 magic | uint32 version | uint64 message size | message
+ */
+#define PROTO_MODEL_BINARY_MAGIC 0x4D504753  // "SGPM"
+#define PROTO_MODEL_BINARY_VERSION 1
+#define PROTO_MODEL_BINARY_HEADER_SIZE 16
+
 // Check https://protobuf.dev/programming-guides/best-practices/ before adding any new features
 // https://doc.qt.io/qt-5/model-view-programming.html#creating-new-models
 class ProtoModel : public QAbstractItemModel {
   Q_OBJECT
 
  public:
-  explicit ProtoModel(ProtoModel* parent_model = nullptr, const int& index_in_parent = -1);
+  /**
+     * @brief The concrete class of a model, see @c model_cast. Switching on
+     *        it replaces dynamic_cast on the paths walked by every change.
+     */
+  enum class Kind { MESSAGE, REPEATED_MESSAGE, PRIMITIVE, REPEATED_PRIMITIVE, ONEOF };
+
+  explicit ProtoModel(const Kind& kind, ProtoModel* parent_model = nullptr, const int& index_in_parent = -1);
   virtual ~ProtoModel() override = default;
 
+  Kind get_kind() const { return m_kind; }
+
   virtual void build_sub_models() = 0;
 
+  enum class FileFormat { JSON, BINARY };
+
   // JSON Serialization
   bool loadFromJson(const QString& filePath);
   bool saveToJson(const QString& filePath) const;
 
+  // Binary Serialization, see PROTO_MODEL_BINARY_MAGIC
+  bool loadFromBinary(const QString& filePath);
+  bool saveToBinary(const QString& filePath) const;
+
+  /**
+     * @brief Loads a binary or a JSON file, told apart by the header of 
+     *        binary files.
+     * 
+     * @note Files are parsed straight from their mapping in memory, see 
+     *       @c MappedFile, into the arena of the root message if it has one.
+     * 
+     * @note Loading resets the whole tree, the sub-models got before are 
+     *       deleted.
+     */
+  bool load(const QString& filePath);
+  bool loadFromData(const char* data, const size_t& size);
+  bool save(const QString& filePath, const FileFormat& format) const;
+
+  /**
+     * @brief The contents of a binary file holding @p message. 
+     */
+  static bool serialize_to_binary(const Message& message, std::string& data);
+  static bool parse_from_binary(const char* data, const size_t& size, Message& message);
+  static bool is_binary(const char* data, const size_t& size);
+
   virtual void parent_data_changed() const = 0;
 
   // Set and Get data using FieldPath
@@ -62,10 +118,22 @@ class ProtoModel : public QAbstractItemModel {
   virtual QVariant data() const = 0;
   virtual bool set_data(const QVariant& value) = 0;
 
+  /**
+     * @brief Typed versions of data() and set_data(), see 
+     *        @c PrimitiveModel::get_value for the supported types.
+     *        Nothing is converted through QVariant, the change 
+     *        notifications are the same as set_data().
+     */
+  template <typename T>
+  bool get(const FieldPath& path, T& value_buffer) const;
+  template <typename T>
+  bool set(const FieldPath& path, const T& value);
+
   /**
      * @brief Get the sub model object
      * 
-     * @param path 
+     * @param cursor Where the traversal is in the path, a @c FieldPath
+     *               converts to a cursor at its first component.
      * @param for_set_data This is used for setting data in the model only
      *                     in the oneof model. For exmaple, if we want to set 
      *                     a specific field, to get to this field we need to 
@@ -88,7 +156,7 @@ class ProtoModel : public QAbstractItemModel {
      * @return const ProtoModel* 
      */
   virtual const ProtoModel* get_sub_model(
-      const FieldPath& path, const bool& for_set_data = false,
+      const FieldPath::Cursor& cursor, const bool& for_set_data = false,
       const bool& for_get_oneof = false) const = 0;  // A read-only version of ProtoModel
 
   virtual int get_oneof_value_field_number() const { return -1; }
@@ -149,15 +217,189 @@ class ProtoModel : public QAbstractItemModel {
      * @param index 
      */
   void set_index_in_parent(const int& index) { m_index_in_parent = index; }
+
+  /**
+     * @brief Points the model at @p message_buffer, the message holding its
+     *        field, once that message is made present.
+     * 
+     * @note Only used by @c MessageModel::make_present() for its sub-models.
+     */
+  virtual void set_message_buffer([[maybe_unused]] Message* message_buffer) {}
   int get_index_in_parent() const { return m_index_in_parent; }
 
+  /**
+     * @brief The path from the root model to this model.
+     * 
+     * @note Oneof models are not part of paths, same as in paths built 
+     *       with @c FieldPath::Of.
+     */
+  FieldPath get_path() const;
+
+  /**
+     * @brief Batches the changes made anywhere in the tree until the matching
+     *        end_batch(). Meanwhile no model emits dataChanged, then the root
+     *        model emits a single one covering the changed columns and the
+     *        changed paths are kept in get_batch_changed_paths(). A batch
+     *        is a single step of the undo history.
+     * 
+     * @note Batches nest, only the outermost one notifies. Can be called on
+     *       any model of the tree. Prefer @c BatchGuard over pairing the calls.
+     */
+  void begin_batch() const;
+  void end_batch() const;
+  bool is_in_batch() const;
+
+  /**
+     * @brief The paths changed by the last batch, each once, in the order 
+     *        they were first changed. Meant to be read by a dataChanged slot
+     *        of the root model.
+     * 
+     * @note The rows are the ones at the time of the change, removing a row
+     *       later in the same batch can move them.
+     */
+  std::vector<FieldPath> get_batch_changed_paths() const;
+
+  /**
+     * @brief Opens a batch for its lifetime, see begin_batch().
+     */
+  class BatchGuard {
+   public:
+    explicit BatchGuard(const ProtoModel* model) : m_model(model) {
+      if (m_model) m_model->begin_batch();
+    }
+    ~BatchGuard() {
+      if (m_model) m_model->end_batch();
+    }
+
+    BatchGuard(const BatchGuard&) = delete;
+    BatchGuard& operator=(const BatchGuard&) = delete;
+
+   private:
+    const ProtoModel* m_model;
+  };
+
+  /**
+     * @brief Keeps the latest @p capacity changes made anywhere in the tree,
+     *        0 stops recording and drops them. Off by default.
+     * 
+     * @note Can be called on any model of the tree, the journal lives in the 
+     *       root model.
+     */
+  void set_journal_capacity(const int& capacity) const;
+
+  /**
+     * @brief The sequence number of the latest recorded change, 0 if there
+     *        is none. Consumers start reading from here.
+     */
+  uint64_t get_journal_sequence() const;
+
+  /**
+     * @brief Appends the changes recorded after @p last_seen_sequence to 
+     *        @p changes, oldest first.
+     * 
+     * @return false if the journal is off or some of the changes were 
+     *         overwritten, read the whole model again then.
+     */
+  bool read_journal(const uint64_t& last_seen_sequence, std::vector<ModelChange>& changes) const;
+
+  /**
+     * @brief Keeps undo history of the changes made anywhere in the tree, 
+     *        up to @p byte_budget bytes. 0 stops recording and drops the
+     *        history. Off by default.
+     */
+  void set_undo_byte_budget(const size_t& byte_budget) const;
+
+  /**
+     * @brief The undo history of the tree, nullptr if it is off.
+     */
+  ModelUndoStack* get_undo_stack() const;
+
+  /**
+     * @brief An immutable copy of the document for work off the GUI thread,
+     *        see @c ModelSnapshot. The first call copies the whole document,
+     *        the next ones only what changed since the previous snapshot.
+     * 
+     * @note Call it on the thread of the models.
+     */
+  std::shared_ptr<const ModelSnapshot> take_snapshot() const;
+
+  /**
+     * @brief Makes @p change again, as if it was made through the models.
+     *        Only the new state of @p change is used, and the old field 
+     *        number of a SET_ONEOF to find the oneof.
+     * 
+     * @note Call it on the root model, the path of @p change starts there.
+     */
+  bool apply_change(const ModelChange& change);
+
+  /**
+     * @brief Notifies @p autosaver of every change made anywhere in the tree,
+     *        nullptr stops. Called by @c ModelAutosaver itself.
+     */
+  void set_autosaver(ModelAutosaver* autosaver) const;
+
+  /**
+     * @brief Appends every change made anywhere in the tree to 
+     *        @p journal_file, nullptr stops. Called by @c ModelJournalFile
+     *        itself.
+     */
+  void set_journal_file(ModelJournalFile* journal_file) const;
+
  protected:
   const ProtoModel* m_parent_model;
   int m_index_in_parent;
 
+  /**
+     * @brief Records a change of this model in the open batch, if any.
+     * 
+     * @param path The path of this model, the one given to record_change().
+     * 
+     * @return true if the change was recorded, the caller must not emit
+     *         dataChanged then.
+     */
+  bool record_batch_change(const FieldPath& path) const;
+
+  /**
+     * @brief Makes the message holding the field of this model present in
+     *        the document, call it before changing the field. Reading leaves
+     *        an unset message unset, see @c MessageModel.
+     * 
+     * @return false if it could not be made present, nothing is changed.
+     */
+  virtual bool make_present() const;
+
+  /**
+     * @brief Whether the changes are recorded, in the journal, the undo
+     *        history, for the snapshots, the autosaver or the journal file.
+     *        Check it before gathering what record_change() needs.
+     */
+  bool is_recording_changes() const;
+  void record_change(const ModelChange& change) const;
+
+  /**
+     * @brief Nothing is recorded until the matching resume, used when a
+     *        change is already described by the one being recorded.
+     */
+  void suspend_change_recording() const;
+  void resume_change_recording() const;
+
+  /**
+     * @brief Adds the component addressing the sub-model at @p child_index
+     *        to @p path, used by get_path().
+     */
+  virtual void add_child_path_component([[maybe_unused]] const int& child_index,
+                                        [[maybe_unused]] FieldPath& path) const {}
+
+  template <typename Component>
+  static void add_path_component(FieldPath& path, const Component& component) {
+    CHECK_CONDITION_TRUE(path.m_size == FIELD_PATH_MAX_COMPONENT_COUNT, "Path is too deep: " + path.to_string());
+    path.add_component(component);
+  }
+
   // Serialization helper
   QByteArray serializeToJson() const;
-  bool deserializeFromJson(const QByteArray& jsonData);
+  bool deserializeFromJson(const char* data, const size_t& size);
+  bool deserializeFromBinary(const char* data, const size_t& size);
 
   virtual bool insertRows(int row, [[maybe_unused]] int count, const QModelIndex& parent = QModelIndex()) override {
     return false;
@@ -166,6 +408,53 @@ class ProtoModel : public QAbstractItemModel {
     return false;
   }
   virtual void clear_sub_models() = 0;
+
+ private:
+  const Kind m_kind;
+
+  // Only allocated on the root model, by the first batch.
+  struct BatchState {
+    int depth{0};
+    std::vector<FieldPath> changed_paths;
+    std::unordered_set<FieldPath, FieldPath::Hash> changed_path_set;
+    int first_column{-1};
+    int last_column{-1};
+  };
+
+  mutable std::unique_ptr<BatchState> m_batch;
+  // Only on the root model
+  mutable std::unique_ptr<ModelJournal> m_journal;
+  mutable std::unique_ptr<ModelUndoStack> m_undo_stack;
+  mutable std::unique_ptr<ModelSnapshotTracker> m_snapshot_tracker;  // Created by the first snapshot
+  mutable ModelAutosaver* m_autosaver{nullptr};                       // Not owned
+  mutable ModelJournalFile* m_journal_file{nullptr};                  // Not owned
+  mutable int m_change_recording_suspension{0};
+
+  void add_path_components(FieldPath& path) const;
+
+  /**
+     * @brief Surround replacing the whole document, the sub-models are
+     *        deleted and created again on first access.
+     */
+  void begin_reload() const;
+  void end_reload() const;
 };
 
+/**
+ * @brief Casts @p model to @p T if its kind is one of @p T, nullptr 
+ *        otherwise. A replacement for dynamic_cast between models, @p T
+ *        must define has_kind().
+ */
+template <typename T>
+T* model_cast(ProtoModel* model) {
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(model, nullptr);
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!T::has_kind(model->get_kind()), nullptr);
+  return static_cast<T*>(model);
+}
+
+template <typename T>
+const T* model_cast(const ProtoModel* model) {
+  return model_cast<T>(const_cast<ProtoModel*>(model));
+}
+
 #endif  // PROTO_MODEL_HPP
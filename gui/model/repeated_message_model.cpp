@@ -27,6 +27,9 @@
 
 #include "gui/model/repeated_message_model.hpp"
 
+#include <algorithm>
+#include <memory>
+
 #include "error_macros.hpp"
 #include "gui/model/utils/utils.hpp"
 
@@ -35,7 +38,7 @@ using OneofDescriptor = google::protobuf::OneofDescriptor;
 
 RepeatedMessageModel::RepeatedMessageModel(Message* message_buffer, const FieldDescriptor* field_desc,
                                            ProtoModel* parent_model, const int& index_in_parent)
-    : MessageModel(field_desc->message_type(), parent_model, index_in_parent),
+    : MessageModel(Kind::REPEATED_MESSAGE, nullptr, field_desc->message_type(), parent_model, index_in_parent),
       m_message_buffer(message_buffer),
       m_field_desc(field_desc) {}
 
@@ -43,11 +46,8 @@ void RepeatedMessageModel::build_sub_models() {
   CHECK_CONDITION_TRUE(!m_field_desc->is_repeated(), "Field " + m_field_desc->full_name() + " is not repeated.");
   CHECK_PARAM_NULLPTR(m_field_desc->message_type(), "Field does not have a message type.");
 
-  int size{rowCount()};
-  for (int i{0}; i < size; i++) {
-    SILENT_CONTINUE_IF_TRUE(i < (int)m_sub_models.size());
-    append_row(i);
-  }
+  // The model of a row is created on first access, see get_sub_model(const int&).
+  m_sub_models.resize(rowCount(), nullptr);
 }
 
 void RepeatedMessageModel::parent_data_changed() const {
@@ -59,9 +59,12 @@ void RepeatedMessageModel::parent_data_changed() const {
 
   ProtoModel* t{const_cast<ProtoModel*>(parent)};
 
-  if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    Q_EMIT message_m->dataChanged(index, index);
-    message_m->parent_data_changed();
+  const bool batched{is_in_batch()};
+
+  if (t->get_kind() == Kind::MESSAGE) {
+    MessageModel* message_m{static_cast<MessageModel*>(t)};
+    if (!batched) Q_EMIT message_m->dataChanged(index, index);
+    message_m->MessageModel::parent_data_changed();
     return;
   }
 
@@ -81,26 +84,32 @@ MessageModel* RepeatedMessageModel::get_sub_model(const int& index) const {
       index, rowCount(), nullptr,
       "Accessing out-of-range proto row " + std::to_string(index) + " of " + std::to_string(rowCount()));
 
-  MessageModel* m = dynamic_cast<MessageModel*>(m_sub_models.at(index));
-  CHECK_PARAM_NULLPTR_NON_VOID(m, nullptr, "Failed to cast sub model to MessageModel.");
+  MessageModel*& m{m_sub_models.at(index)};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(m != nullptr, m);
+
+  const Reflection* refl{m_message_buffer->GetReflection()};
+  m = new MessageModel(refl->MutableRepeatedMessage(m_message_buffer, m_field_desc, index),
+                       const_cast<RepeatedMessageModel*>(this), index);
+  m->build_sub_models();
 
   return m;
 }
 
-const ProtoModel* RepeatedMessageModel::get_sub_model(const FieldPath& path, const bool& for_set_data,
+const ProtoModel* RepeatedMessageModel::get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data,
                                                       const bool& for_get_oneof) const {
-  CHECK_CONDITION_TRUE_NON_VOID(!path.is_valid(), nullptr, "Invalid path for " + m_field_desc->full_name());
-  SILENT_CHECK_CONDITION_TRUE_NON_VOID(path.is_empty(), this);
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.is_valid(), nullptr, "Invalid path for " + m_field_desc->full_name());
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(cursor.is_empty(), this);
 
   int index{-1};
 
-  CHECK_CONDITION_TRUE_NON_VOID(!path.get_upcoming_repeated_index(index), nullptr,
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.get_upcoming_repeated_index(index), nullptr,
                                 "Next component is not a repeated index.");
   VALIDATE_INDEX_NON_VOID(index, rowCount(), nullptr, "Index out of range.");
 
-  CHECK_CONDITION_TRUE_NON_VOID(!path.skip_component(), nullptr, "Failed to skip repeated index.");
+  FieldPath::Cursor next{cursor};
+  CHECK_CONDITION_TRUE_NON_VOID(!next.skip_component(), nullptr, "Failed to skip repeated index.");
 
-  return m_sub_models.at(index)->get_sub_model(path, for_set_data, for_get_oneof);
+  return get_sub_model(index)->get_sub_model(next, for_set_data, for_get_oneof);
 }
 
 QModelIndex RepeatedMessageModel::parent([[maybe_unused]] const QModelIndex& child) const {
@@ -120,8 +129,9 @@ QModelIndex RepeatedMessageModel::parent([[maybe_unused]] const QModelIndex& chi
         children except for repeated primitive models which are only allowed to have children 
         of type PrimitiveModel.
     */
-  if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    return message_m->index(0, m_index_in_parent, message_m->parent(QModelIndex()));
+  if (t->get_kind() == Kind::MESSAGE) {
+    MessageModel* message_m{static_cast<MessageModel*>(t)};
+    return message_m->index(0, m_index_in_parent, message_m->MessageModel::parent(QModelIndex()));
   }
 
   FAIL_AND_RETURN_NON_VOID(QModelIndex(), "Parent model is not a message model.");
@@ -180,14 +190,73 @@ int RepeatedMessageModel::append_row() {
 
   endInsertRows();
 
+  const FieldPath path{get_path()};
+  if (is_recording_changes()) record_change(ModelChange::insert_row(path, row, QVariant(), std::string()));
+
+  record_batch_change(path);
+
   return row;
 }
 
+bool RepeatedMessageModel::insert_row(const int& row, const std::string& message) {
+  VALIDATE_INDEX_NON_VOID(row, rowCount() + 1, false, "Index out of range.");
+
+  const Reflection* refl{m_message_buffer->GetReflection()};
+
+  // Parsed before adding the row, so a bad message adds nothing.
+  std::unique_ptr<Message> row_message;
+  if (!message.empty()) {
+    row_message.reset(refl->GetMessageFactory()->GetPrototype(m_field_desc->message_type())->New());
+    CHECK_CONDITION_TRUE_NON_VOID(!row_message->ParseFromString(message), false,
+                                  "Failed to parse a row of " + m_field_desc->full_name());
+  }
+
+  const int last_row{rowCount()};
+  QModelIndex parent_index{this->parent(QModelIndex())};
+
+  beginInsertRows(parent_index, last_row, last_row);
+
+  bool result{insertRows(last_row, 1, parent_index)};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!result, false);
+
+  endInsertRows();
+
+  if (row_message) {
+    Message* row_buffer{refl->MutableRepeatedMessage(m_message_buffer, m_field_desc, last_row)};
+    row_buffer->GetReflection()->Swap(row_buffer, row_message.get());
+  }
+
+  // The reverse of removeRows: the row in the way moves to the end.
+  if (row < last_row) {
+    refl->SwapElements(m_message_buffer, m_field_desc, row, last_row);
+    std::swap(m_sub_models.at(row), m_sub_models.at(last_row));
+    if (m_sub_models.at(row)) m_sub_models.at(row)->set_index_in_parent(row);
+    if (m_sub_models.at(last_row)) m_sub_models.at(last_row)->set_index_in_parent(last_row);
+    row_data_changed(last_row);
+  }
+  row_data_changed(row);
+
+  const FieldPath path{get_path()};
+  if (is_recording_changes()) record_change(ModelChange::insert_row(path, row, QVariant(), message));
+
+  record_batch_change(path);
+
+  return true;
+}
+
 bool RepeatedMessageModel::remove_row(const int& row) {
   VALIDATE_INDEX_NON_VOID(row, rowCount(), false, "Index out of range.");
 
   QModelIndex parent_index{this->parent(QModelIndex())};
 
+  // The removed row, for the recorded change.
+  const bool recording{is_recording_changes()};
+  std::string old_message;
+  if (recording) {
+    const Reflection* refl{m_message_buffer->GetReflection()};
+    old_message = refl->GetRepeatedMessage(*m_message_buffer, m_field_desc, row).SerializeAsString();
+  }
+
   beginRemoveRows(parent_index, row, row);
 
   bool result{removeRows(row, 1, parent_index)};
@@ -195,6 +264,11 @@ bool RepeatedMessageModel::remove_row(const int& row) {
 
   endRemoveRows();
 
+  const FieldPath path{get_path()};
+  if (recording) record_change(ModelChange::remove_row(path, row, QVariant(), old_message));
+
+  record_batch_change(path);
+
   return true;
 }
 
@@ -208,6 +282,142 @@ int RepeatedMessageModel::field_to_column(const int& fn) const {
   return field_desc->index();
 }
 
+int RepeatedMessageModel::find_row(const int& fn, const int64_t& value) const {
+  const RowIndex* index{get_row_index(fn)};
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(index, -1);
+
+  // Values are unique in practice. A new row briefly shares the default value
+  // with another one until it is set, the first row wins like a linear scan.
+  int row{-1};
+  auto range{index->rows_by_value.equal_range(value)};
+  for (auto r{range.first}; r != range.second; ++r) {
+    if (row == -1 || r->second < row) row = r->second;
+  }
+
+  return row;
+}
+
+int64_t RepeatedMessageModel::reserve_keys(const int& fn, const int& count, const int64_t& min_value) const {
+  CHECK_CONDITION_TRUE_NON_VOID(count <= 0, -1, "Invalid number of keys: " + std::to_string(count) + ".");
+
+  RowIndex* index{get_row_index(fn)};
+  SILENT_CHECK_PARAM_NULLPTR_NON_VOID(index, -1);
+
+  const int64_t first{std::max(index->next_key, min_value)};
+  index->next_key = first + count;
+
+  return first;
+}
+
+RepeatedMessageModel::RowIndex* RepeatedMessageModel::get_row_index(const int& fn) const {
+  auto it{m_row_indices.find(fn)};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(it != m_row_indices.end(), &it->second);
+
+  const FieldDescriptor* key_desc{m_field_desc->message_type()->FindFieldByNumber(fn)};
+  CHECK_PARAM_NULLPTR_NON_VOID(key_desc, nullptr, "Field not found.");
+  CHECK_CONDITION_TRUE_NON_VOID(key_desc->is_repeated() || (key_desc->cpp_type() != FieldDescriptor::CPPTYPE_INT32 &&
+                                                            key_desc->cpp_type() != FieldDescriptor::CPPTYPE_INT64 &&
+                                                            key_desc->cpp_type() != FieldDescriptor::CPPTYPE_UINT32 &&
+                                                            key_desc->cpp_type() != FieldDescriptor::CPPTYPE_UINT64 &&
+                                                            key_desc->cpp_type() != FieldDescriptor::CPPTYPE_ENUM),
+                                nullptr, "Field " + key_desc->full_name() + " is not a singular integer field.");
+
+  RowIndex index;
+  index.key_desc = key_desc;
+
+  const int size{rowCount()};
+  index.values.resize(size);
+  index.rows_by_value.reserve(size);
+  for (int i{0}; i < size; i++) {
+    const int64_t value{get_row_key(i, key_desc)};
+    index.values.at(i) = value;
+    index.rows_by_value.emplace(value, i);
+    index.next_key = std::max(index.next_key, value + 1);
+  }
+
+  return &m_row_indices.emplace(fn, std::move(index)).first->second;
+}
+
+void RepeatedMessageModel::row_data_changed(const int& row) const {
+  for (auto& [fn, index] : m_row_indices) {
+    VALIDATE_INDEX(row, (int)index.values.size(), "Row " + std::to_string(row) + " is not indexed.");
+
+    const int64_t value{get_row_key(row, index.key_desc)};
+    SILENT_CONTINUE_IF_TRUE(value == index.values.at(row));
+
+    auto range{index.rows_by_value.equal_range(index.values.at(row))};
+    for (auto r{range.first}; r != range.second; ++r) {
+      if (r->second == row) {
+        index.rows_by_value.erase(r);
+        break;
+      }
+    }
+
+    index.values.at(row) = value;
+    index.rows_by_value.emplace(value, row);
+    index.next_key = std::max(index.next_key, value + 1);
+  }
+}
+
+int64_t RepeatedMessageModel::get_row_key(const int& row, const FieldDescriptor* key_desc) const {
+  const Reflection* refl{m_message_buffer->GetReflection()};
+  const Message& message{refl->GetRepeatedMessage(*m_message_buffer, m_field_desc, row)};
+  const Reflection* row_refl{message.GetReflection()};
+
+  switch (key_desc->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return row_refl->GetInt32(message, key_desc);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return row_refl->GetInt64(message, key_desc);
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return row_refl->GetUInt32(message, key_desc);
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return (int64_t)row_refl->GetUInt64(message, key_desc);
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return row_refl->GetEnumValue(message, key_desc);
+    default:
+      break;
+  }
+
+  FAIL_AND_RETURN_NON_VOID(0, "Field " + key_desc->full_name() + " is not an integer field.");
+}
+
+void RepeatedMessageModel::add_row_to_indices(const int& row) const {
+  for (auto& [fn, index] : m_row_indices) {
+    CHECK_CONDITION_TRUE(row != (int)index.values.size(), "Only the last row can be added to the indices.");
+
+    index.values.push_back(get_row_key(row, index.key_desc));
+    index.rows_by_value.emplace(index.values.back(), row);
+    index.next_key = std::max(index.next_key, index.values.back() + 1);
+  }
+}
+
+static void erase_indexed_row(std::unordered_multimap<int64_t, int>& rows_by_value, const int64_t& value,
+                              const int& row) {
+  auto range{rows_by_value.equal_range(value)};
+  for (auto r{range.first}; r != range.second; ++r) {
+    if (r->second == row) {
+      rows_by_value.erase(r);
+      return;
+    }
+  }
+}
+
+void RepeatedMessageModel::remove_row_from_indices(const int& row, const int& last_row) const {
+  for (auto& [fn, index] : m_row_indices) {
+    CHECK_CONDITION_TRUE(last_row != (int)index.values.size() - 1, "Indices are out of sync with the rows.");
+
+    // Mirrors removeRows: the last row takes the place of the removed one.
+    erase_indexed_row(index.rows_by_value, index.values.at(row), row);
+    if (row < last_row) {
+      erase_indexed_row(index.rows_by_value, index.values.at(last_row), last_row);
+      index.values.at(row) = index.values.at(last_row);
+      index.rows_by_value.emplace(index.values.at(row), row);
+    }
+    index.values.pop_back();
+  }
+}
+
 bool RepeatedMessageModel::insertRows(int row, int count, const QModelIndex& parent) {
   CHECK_CONDITION_TRUE_NON_VOID(!parent.isValid(), false, "Parent is not valid.");
   CHECK_CONDITION_TRUE_NON_VOID(row >= (rowCount() + 1), false, "You can only insert a row at the end of the model.");
@@ -215,13 +425,16 @@ bool RepeatedMessageModel::insertRows(int row, int count, const QModelIndex& par
       count != 1, false,
       "Invalid number of rows: " + std::to_string(count) + ". Adding multiple rows at once is not supported yet.");
 
+  CHECK_CONDITION_TRUE_NON_VOID(row != rowCount() || row != (int)m_sub_models.size(), false,
+                                "You can only insert a row at the end of the model.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!make_present(), false);
+
   const Reflection* refl{m_message_buffer->GetReflection()};
-  MessageModel* new_model{nullptr};
-  // Create a new model for an existing message or a new message
-  if (row < rowCount()) new_model = new MessageModel(refl->MutableRepeatedMessage(m_message_buffer, m_field_desc, row), this, row);
-  else new_model = new MessageModel(refl->AddMessage(m_message_buffer, m_field_desc), this, row);
-  m_sub_models.emplace_back(new_model);
-  new_model->build_sub_models();
+  refl->AddMessage(m_message_buffer, m_field_desc);
+  add_row_to_indices(row);
+
+  // The model of the new row is created on first access.
+  m_sub_models.emplace_back(nullptr);
 
   return true;
 }
@@ -232,9 +445,12 @@ bool RepeatedMessageModel::removeRows(int row, int count, const QModelIndex& par
   CHECK_CONDITION_TRUE_NON_VOID(
       count != 1, false,
       "Invalid number of rows: " + std::to_string(count) + ". Adding multiple rows at once is not supported yet.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!make_present(), false);
 
   int last_row{rowCount() - 1};
 
+  remove_row_from_indices(row, last_row);
+
   if (row < last_row) std::swap(m_sub_models.at(row), m_sub_models.at(last_row));
 
   delete m_sub_models.at(last_row);
@@ -246,8 +462,8 @@ bool RepeatedMessageModel::removeRows(int row, int count, const QModelIndex& par
   if (row < last_row) refl->SwapElements(m_message_buffer, m_field_desc, row, last_row);
   refl->RemoveLast(m_message_buffer, m_field_desc);
 
-  // Must be done after removing the row
-  for (int i{row}; i < rowCount(); i++) m_sub_models.at(i)->set_index_in_parent(i);  // Update the index in parent
+  // Only the moved row changed its index, the others keep theirs.
+  if (row < last_row && m_sub_models.at(row)) m_sub_models.at(row)->set_index_in_parent(row);
 
   return true;
 }
@@ -255,22 +471,12 @@ bool RepeatedMessageModel::removeRows(int row, int count, const QModelIndex& par
 void RepeatedMessageModel::clear_sub_models() {
   for (auto& sub_model : m_sub_models) delete sub_model;
   m_sub_models.clear();
+  m_row_indices.clear();
 
   const Reflection* refl{m_message_buffer->GetReflection()};
   refl->ClearField(m_message_buffer, m_field_desc);
 }
 
-void RepeatedMessageModel::append_row(const int& row) {
-  CHECK_CONDITION_TRUE(m_field_desc->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE, "Field is not a message.");
-  VALIDATE_INDEX(row, rowCount(),
-                 "You are allowed to append only a row between 0 and " + std::to_string(rowCount()) + "exclusive.");
-
-  QModelIndex parent_index{this->parent(QModelIndex())};
-  
-  beginInsertRows(parent_index, row, row);
-  
-  bool result{insertRows(row, 1, parent_index)};
-  CHECK_CONDITION_TRUE(!result, "Failed to insert row.");
-
-  endInsertRows();
+void RepeatedMessageModel::add_child_path_component(const int& child_index, FieldPath& path) const {
+  add_path_component(path, FieldPath::RepeatedAt(child_index));
 }
@@ -28,6 +28,10 @@
 #ifndef REPEATED_MESSAGE_MODEL_HPP
 #define REPEATED_MESSAGE_MODEL_HPP
 
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
 #include "gui/model/message_model.hpp"
 
 /**
@@ -45,7 +49,7 @@
     @brief The repeated message represents multiple rows in the model. It can have multiple fields.
            Each field represents a column in the model.
 */
-class RepeatedMessageModel : public MessageModel {
+class RepeatedMessageModel final : public MessageModel {
   Q_OBJECT
 
  public:
@@ -61,7 +65,7 @@ class RepeatedMessageModel : public MessageModel {
   bool set_data(const QVariant& value) override;
 
   MessageModel* get_sub_model(const int& index) const;
-  const ProtoModel* get_sub_model(const FieldPath& path, const bool& for_set_data = false,
+  const ProtoModel* get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data = false,
                                   const bool& for_get_oneof = false) const override;
 
   QModelIndex parent(const QModelIndex& child) const override;
@@ -72,19 +76,74 @@ class RepeatedMessageModel : public MessageModel {
   int append_row() override;
   bool remove_row(const int& row) override;
 
+  /**
+   * @brief Inserts a row holding the serialized @p message at @p row, the
+   *        default value if it is empty. The row there moves to the end, so
+   *        this reverts remove_row(row).
+   */
+  bool insert_row(const int& row, const std::string& message);
+
   int field_to_column(const int& fn) const;
 
+  /**
+   * @brief Returns the first row whose integer field @p fn holds @p value, or
+   *        -1 if there is none.
+   *
+   * The first lookup of a field indexes all rows by it. The index is then kept
+   * up to date as rows are added, removed or changed through the model, so
+   * later lookups do not scan the rows.
+   */
+  int find_row(const int& fn, const int64_t& value) const;
+
+  /**
+   * @brief Reserves @p count consecutive values of the integer field @p fn
+   *        and returns the first one, at least @p min_value.
+   *
+   * Values are handed out in increasing order, above every value a row held
+   * since the field was indexed, and are never handed out twice. A range is
+   * meant for bulk inserts such as paste or import.
+   */
+  int64_t reserve_keys(const int& fn, const int& count = 1, const int64_t& min_value = 0) const;
+
+  /**
+   * @brief Updates the indexed fields of a row after its data changed.
+   *
+   * @note Called by the sub-models of the rows.
+   */
+  void row_data_changed(const int& row) const;
+
   Message* get_message_buffer() const { return m_message_buffer; }
+  void set_message_buffer(Message* message_buffer) override { m_message_buffer = message_buffer; }
+
+  // The field is in the message of the parent, not a message of its own.
+  bool make_present() const override { return ProtoModel::make_present(); }
+
+  static constexpr bool has_kind(const Kind& kind) { return kind == Kind::REPEATED_MESSAGE; }
 
  private:
   Message* m_message_buffer;
   const FieldDescriptor* m_field_desc;
-  std::vector<MessageModel*> m_sub_models;
+  mutable std::vector<MessageModel*> m_sub_models;  // nullptr until the row is accessed
+
+  struct RowIndex {
+    const FieldDescriptor* key_desc{nullptr};
+    std::unordered_multimap<int64_t, int> rows_by_value;
+    std::vector<int64_t> values;  // The indexed value of each row.
+    int64_t next_key{std::numeric_limits<int64_t>::min()};  // Above every value seen so far.
+  };
+
+  // Field number -> index of the rows by that field, built on the first lookup.
+  mutable std::unordered_map<int, RowIndex> m_row_indices;
+
+  RowIndex* get_row_index(const int& fn) const;
+  int64_t get_row_key(const int& row, const FieldDescriptor* key_desc) const;
+  void add_row_to_indices(const int& row) const;
+  void remove_row_from_indices(const int& row, const int& last_row) const;
 
   bool insertRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
   bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
   void clear_sub_models() override;
-  void append_row(const int& row);
+  void add_child_path_component(const int& child_index, FieldPath& path) const override;
 };
 
 #endif  // REPEATED_MESSAGE_MODEL_HPP
@@ -32,10 +32,16 @@
 
 RepeatedPrimitiveModel::RepeatedPrimitiveModel(Message* message_buffer, const FieldDescriptor* field_desc,
                                                ProtoModel* parent_model, const int& index_in_parent)
-    : PrimitiveModel(message_buffer, field_desc, parent_model, index_in_parent),
+    : PrimitiveModel(Kind::REPEATED_PRIMITIVE, message_buffer, field_desc, parent_model, index_in_parent),
       m_message_buffer(message_buffer),
       m_field_desc(field_desc) {}
 
+void RepeatedPrimitiveModel::set_message_buffer(Message* message_buffer) {
+  PrimitiveModel::set_message_buffer(message_buffer);
+  m_message_buffer = message_buffer;
+  for (PrimitiveModel* sub_model : m_sub_models) sub_model->set_message_buffer(message_buffer);
+}
+
 void RepeatedPrimitiveModel::build_sub_models() {
   CHECK_CONDITION_TRUE(!m_field_desc->is_repeated(), "Field " + m_field_desc->full_name() + " is not repeated.");
   CHECK_CONDITION_TRUE(m_field_desc->message_type() != nullptr,
@@ -57,9 +63,12 @@ void RepeatedPrimitiveModel::parent_data_changed() const {
 
   ProtoModel* t{const_cast<ProtoModel*>(parent)};
 
-  if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    Q_EMIT message_m->dataChanged(index, index);
-    message_m->parent_data_changed();
+  const bool batched{is_in_batch()};
+
+  if (t->get_kind() == Kind::MESSAGE) {
+    MessageModel* message_m{static_cast<MessageModel*>(t)};
+    if (!batched) Q_EMIT message_m->dataChanged(index, index);
+    message_m->MessageModel::parent_data_changed();
     return;
   }
 
@@ -79,26 +88,24 @@ PrimitiveModel* RepeatedPrimitiveModel::get_sub_model(const int& index) const {
       index, rowCount(), nullptr,
       "Accessing out-of-range proto row " + std::to_string(index) + " of " + std::to_string(rowCount()));
 
-  PrimitiveModel* m = dynamic_cast<PrimitiveModel*>(m_sub_models.at(index));
-  CHECK_PARAM_NULLPTR_NON_VOID(m, nullptr, "Failed to cast sub model to PrimitiveModel.");
-
-  return m;
+  return m_sub_models.at(index);
 }
 
-const ProtoModel* RepeatedPrimitiveModel::get_sub_model(const FieldPath& path, const bool& for_set_data,
+const ProtoModel* RepeatedPrimitiveModel::get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data,
                                                         const bool& for_get_oneof) const {
-  CHECK_CONDITION_TRUE_NON_VOID(!path.is_valid(), nullptr, "Invalid path for " + m_field_desc->full_name());
-  SILENT_CHECK_CONDITION_TRUE_NON_VOID(path.is_empty(), this);
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.is_valid(), nullptr, "Invalid path for " + m_field_desc->full_name());
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(cursor.is_empty(), this);
 
   int index{-1};
 
-  CHECK_CONDITION_TRUE_NON_VOID(!path.get_upcoming_repeated_index(index), nullptr,
+  CHECK_CONDITION_TRUE_NON_VOID(!cursor.get_upcoming_repeated_index(index), nullptr,
                                 "Next component is not a repeated index.");
   VALIDATE_INDEX_NON_VOID(index, rowCount(), nullptr, "Index out of range.");
 
-  CHECK_CONDITION_TRUE_NON_VOID(!path.skip_component(), nullptr, "Failed to skip repeated index.");
+  FieldPath::Cursor next{cursor};
+  CHECK_CONDITION_TRUE_NON_VOID(!next.skip_component(), nullptr, "Failed to skip repeated index.");
 
-  return m_sub_models.at(index)->get_sub_model(path, for_set_data, for_get_oneof);
+  return m_sub_models.at(index)->get_sub_model(next, for_set_data, for_get_oneof);
 }
 
 QModelIndex RepeatedPrimitiveModel::parent([[maybe_unused]] const QModelIndex& child) const {
@@ -118,8 +125,9 @@ QModelIndex RepeatedPrimitiveModel::parent([[maybe_unused]] const QModelIndex& c
         children except for repeated primitive models which are only allowed to have children 
         of type PrimitiveModel.
     */
-  if (MessageModel * message_m{dynamic_cast<MessageModel*>(t)}) {
-    return message_m->index(0, m_index_in_parent, message_m->parent(QModelIndex()));
+  if (t->get_kind() == Kind::MESSAGE) {
+    MessageModel* message_m{static_cast<MessageModel*>(t)};
+    return message_m->index(0, m_index_in_parent, message_m->MessageModel::parent(QModelIndex()));
   }
 
   FAIL_AND_RETURN_NON_VOID(QModelIndex(), "Parent model is not a message model.");
@@ -138,7 +146,9 @@ QVariant RepeatedPrimitiveModel::data(const QModelIndex& index, int role) const
       "Accessing out-of-range proto row " + std::to_string(index.row()) + " of " + std::to_string(rowCount()));
   CHECK_CONDITION_TRUE_NON_VOID(index.column() > 0, QVariant(), "A primitive model should have only one column.");
 
-  return get_sub_model(index.row())->data(this->index(0, 0, index), role);
+  // The parent of an index of this model is this model, not the row, so the row builds its own.
+  const PrimitiveModel* sub_model{get_sub_model(index.row())};
+  return sub_model->data(sub_model->index(0, 0, sub_model->parent(QModelIndex())), role);
 }
 
 bool RepeatedPrimitiveModel::setData([[maybe_unused]] const QModelIndex& index, [[maybe_unused]] const QVariant& value,
@@ -152,7 +162,8 @@ bool RepeatedPrimitiveModel::setData([[maybe_unused]] const QModelIndex& index,
       "Accessing out-of-range proto row " + std::to_string(index.row()) + " of " + std::to_string(rowCount()));
   CHECK_CONDITION_TRUE_NON_VOID(index.column() > 0, false, "A primitive model should have only one column.");
 
-  return get_sub_model(index.row())->setData(this->index(0, 0, index), value, role);
+  PrimitiveModel* sub_model{get_sub_model(index.row())};
+  return sub_model->setData(sub_model->index(0, 0, sub_model->parent(QModelIndex())), value, role);
 }
 
 int RepeatedPrimitiveModel::append_row() {
@@ -171,14 +182,61 @@ int RepeatedPrimitiveModel::append_row() {
 
   endInsertRows();
 
+  const FieldPath path{get_path()};
+  if (is_recording_changes()) record_change(ModelChange::insert_row(path, row, QVariant(), std::string()));
+
+  record_batch_change(path);
+
   return row;
 }
 
+bool RepeatedPrimitiveModel::insert_row(const int& row, const QVariant& value) {
+  VALIDATE_INDEX_NON_VOID(row, rowCount() + 1, false, "Index out of range.");
+
+  const int last_row{rowCount()};
+  QModelIndex parent_index{this->parent(QModelIndex())};
+
+  beginInsertRows(parent_index, last_row, last_row);
+
+  bool result{insertRows(last_row, 1, parent_index)};
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!result, false);
+
+  endInsertRows();
+
+  // Setting the value is part of the insertion.
+  if (value.isValid()) {
+    suspend_change_recording();
+    result = m_sub_models.at(last_row)->set_data(value);
+    resume_change_recording();
+    CHECK_CONDITION_TRUE_NON_VOID(!result, false, "Failed to set the value of the row.");
+  }
+
+  // The reverse of removeRows: the row in the way moves to the end.
+  if (row < last_row) {
+    const Reflection* refl{m_message_buffer->GetReflection()};
+    refl->SwapElements(m_message_buffer, m_field_desc, row, last_row);
+    std::swap(m_sub_models.at(row), m_sub_models.at(last_row));
+    m_sub_models.at(row)->set_index_in_parent(row);
+    m_sub_models.at(last_row)->set_index_in_parent(last_row);
+  }
+
+  const FieldPath path{get_path()};
+  if (is_recording_changes()) record_change(ModelChange::insert_row(path, row, value, std::string()));
+
+  record_batch_change(path);
+
+  return true;
+}
+
 bool RepeatedPrimitiveModel::remove_row(const int& row) {
   VALIDATE_INDEX_NON_VOID(row, rowCount(), false, "Index out of range.");
 
   QModelIndex parent_index{this->parent(QModelIndex())};
 
+  // The removed row, for the recorded change.
+  const bool recording{is_recording_changes()};
+  const QVariant old_value{recording ? get_sub_model(row)->data() : QVariant()};
+
   beginRemoveRows(parent_index, row, row);
 
   bool result{removeRows(row, 1, parent_index)};
@@ -186,6 +244,11 @@ bool RepeatedPrimitiveModel::remove_row(const int& row) {
 
   endRemoveRows();
 
+  const FieldPath path{get_path()};
+  if (recording) record_change(ModelChange::remove_row(path, row, old_value, std::string()));
+
+  record_batch_change(path);
+
   return true;
 }
 
@@ -205,6 +268,7 @@ bool RepeatedPrimitiveModel::insertRows(int row, int count, const QModelIndex& p
   CHECK_CONDITION_TRUE_NON_VOID(
       count != 1, false,
       "Invalid number of rows: " + std::to_string(count) + ". Adding multiple rows at once is not supported yet.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!make_present(), false);
 
   const Reflection* refl{m_message_buffer->GetReflection()};
 
@@ -258,6 +322,7 @@ bool RepeatedPrimitiveModel::removeRows(int row, int count, const QModelIndex& p
   CHECK_CONDITION_TRUE_NON_VOID(
       count != 1, false,
       "Invalid number of rows: " + std::to_string(count) + ". Adding multiple rows at once is not supported yet.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!make_present(), false);
 
   int last_row{rowCount() - 1};
 
@@ -272,8 +337,8 @@ bool RepeatedPrimitiveModel::removeRows(int row, int count, const QModelIndex& p
   if (row < last_row) refl->SwapElements(m_message_buffer, m_field_desc, row, last_row);
   refl->RemoveLast(m_message_buffer, m_field_desc);
 
-  // Must be done after removing the row
-  for (int i{row}; i < rowCount(); i++) m_sub_models.at(i)->set_index_in_parent(i);  // Update the index in parent
+  // Only the moved row changed its index, the others keep theirs.
+  if (row < last_row) m_sub_models.at(row)->set_index_in_parent(row);
 
   return true;
 }
@@ -299,3 +364,7 @@ void RepeatedPrimitiveModel::append_row(const int& row) {
 
   endInsertRows();
 }
+
+void RepeatedPrimitiveModel::add_child_path_component(const int& child_index, FieldPath& path) const {
+  add_path_component(path, FieldPath::RepeatedAt(child_index));
+}
@@ -44,7 +44,7 @@
 
     @brief The repeated message represents multiple rows in the model.
 */
-class RepeatedPrimitiveModel : public PrimitiveModel {
+class RepeatedPrimitiveModel final : public PrimitiveModel {
   Q_OBJECT
 
  public:
@@ -60,7 +60,7 @@ class RepeatedPrimitiveModel : public PrimitiveModel {
   bool set_data(const QVariant& value) override;
 
   PrimitiveModel* get_sub_model(const int& index) const;
-  const ProtoModel* get_sub_model(const FieldPath& path, const bool& for_set_data = false,
+  const ProtoModel* get_sub_model(const FieldPath::Cursor& cursor, const bool& for_set_data = false,
                                   const bool& for_get_oneof = false) const override;
 
   QModelIndex parent(const QModelIndex& child) const override;
@@ -71,9 +71,18 @@ class RepeatedPrimitiveModel : public PrimitiveModel {
   int append_row();
   bool remove_row(const int& row);
 
+  /**
+   * @brief Inserts a value at @c row, the row there moves to the end. This
+   *        is the inverse of @c remove_row.
+   */
+  bool insert_row(const int& row, const QVariant& value);
+
   int field_to_column(const int& fn) const;
 
   Message* get_message_buffer() const { return m_message_buffer; }
+  void set_message_buffer(Message* message_buffer) override;
+
+  static constexpr bool has_kind(const Kind& kind) { return kind == Kind::REPEATED_PRIMITIVE; }
 
  private:
   Message* m_message_buffer;
@@ -84,6 +93,7 @@ class RepeatedPrimitiveModel : public PrimitiveModel {
   bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
   void clear_sub_models() override;
   void append_row(const int& row);
+  void add_child_path_component(const int& child_index, FieldPath& path) const override;
 };
 
 #endif  // REPEATED_PRIMITIVE_MODEL_HPP
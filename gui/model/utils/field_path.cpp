@@ -27,12 +27,11 @@
 
 #include "gui/model/utils/field_path.hpp"
 
-#include "gui/model/utils/utils.hpp"
+#include <algorithm>
 
-#define PATH_COMPONENT_VARIANT_FIELD_NUMBER_INDEX 0
-#define PATH_COMPONENT_VARIANT_REPEATED_AT_INDEX 1
+#include "gui/model/utils/utils.hpp"
 
-bool FieldPath::is_valid_path() const {
+bool FieldPath::resolve_path() {
   SILENT_CHECK_CONDITION_TRUE_NON_VOID(is_empty(), false);
   SILENT_CHECK_PARAM_NULLPTR_NON_VOID(m_root_buffer_descriptor, false);
 
@@ -40,104 +39,140 @@ bool FieldPath::is_valid_path() const {
 
   const google::protobuf::FieldDescriptor* repeated_field{nullptr};
 
-  std::queue<PathComponent> temp = m_components;
-
-  while (!temp.empty()) {
-    PathComponent component{temp.front()};
-    temp.pop();
-
-    switch (component.index()) {
-      case PATH_COMPONENT_VARIANT_FIELD_NUMBER_INDEX: {
-        SILENT_CHECK_PARAM_NULLPTR_NON_VOID(current_buffer_descriptor, false);
-        int fn{std::get<FieldPath::FieldNumber>(component).field_number};
-        const google::protobuf::FieldDescriptor* field{current_buffer_descriptor->FindFieldByNumber(fn)};
-        CHECK_PARAM_NULLPTR_NON_VOID(
-            field, false,
-            "Field " + std::to_string(fn) + " not found in descriptor " + current_buffer_descriptor->full_name());
-        current_buffer_descriptor = field->message_type();
-        if (field->is_repeated())
-          repeated_field = field;
-        else
-          repeated_field = nullptr;
-        break;
-      }
-      case PATH_COMPONENT_VARIANT_REPEATED_AT_INDEX: {
-        CHECK_PARAM_NULLPTR_NON_VOID(repeated_field, false, "No repeated field to access.");
-        CHECK_CONDITION_TRUE_NON_VOID(!repeated_field->is_repeated(), false,
-                                      "Field " + repeated_field->full_name() + " is not repeated.");
-        current_buffer_descriptor = repeated_field->message_type();
+  for (int i{0}; i < m_size; i++) {
+    Component& component{m_components[i]};
+
+    if (!component.is_repeated_index) {
+      SILENT_CHECK_PARAM_NULLPTR_NON_VOID(current_buffer_descriptor, false);
+      int fn{component.value};
+      const google::protobuf::FieldDescriptor* field{current_buffer_descriptor->FindFieldByNumber(fn)};
+      CHECK_PARAM_NULLPTR_NON_VOID(
+          field, false,
+          "Field " + std::to_string(fn) + " not found in descriptor " + current_buffer_descriptor->full_name());
+      component.field_desc = field;
+      current_buffer_descriptor = field->message_type();
+      if (field->is_repeated())
+        repeated_field = field;
+      else
         repeated_field = nullptr;
-        break;
-      }
-      default: {
-        FAIL_AND_RETURN_NON_VOID(false, "Invalid path component type");
-      }
+    } else {
+      CHECK_PARAM_NULLPTR_NON_VOID(repeated_field, false, "No repeated field to access.");
+      CHECK_CONDITION_TRUE_NON_VOID(!repeated_field->is_repeated(), false,
+                                    "Field " + repeated_field->full_name() + " is not repeated.");
+      current_buffer_descriptor = repeated_field->message_type();
+      repeated_field = nullptr;
     }
   }
 
   return true;
 }
 
-bool FieldPath::is_upcoming_field() const {
-  SILENT_CHECK_CONDITION_TRUE_NON_VOID(is_empty(), false);
-  if (m_components.front().index() == PATH_COMPONENT_VARIANT_FIELD_NUMBER_INDEX) {
-    return true;
+std::string FieldPath::to_string() const {
+  std::string path_string;
+
+  for (int i{0}; i < m_size; i++) {
+    const Component& component{m_components[i]};
+
+    if (!component.is_repeated_index) {
+      path_string += "FN(" + std::to_string(component.value) + ")";
+    } else {
+      path_string += "AT[" + std::to_string(component.value) + "]";
+    }
+
+    if (i + 1 < m_size) {
+      path_string += " --> ";
+    }
   }
-  return false;
+
+  return path_string;
 }
 
-bool FieldPath::is_upcoming_repeated_index() const {
-  SILENT_CHECK_CONDITION_TRUE_NON_VOID(is_empty(), false);
-  if (m_components.front().index() == PATH_COMPONENT_VARIANT_REPEATED_AT_INDEX) {
-    return true;
+FieldPath FieldPath::at(const int& index) const {
+  CHECK_CONDITION_TRUE_NON_VOID(m_size == FIELD_PATH_MAX_COMPONENT_COUNT, FieldPath(),
+                                "Path is too deep: " + to_string());
+  FieldPath path{*this};
+  path.add_component(RepeatedAt(index));
+  return path;
+}
+
+bool FieldPath::starts_with(const FieldPath& prefix) const {
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(prefix.m_size > m_size, false);
+
+  for (int i{0}; i < prefix.m_size; i++) {
+    SILENT_CHECK_CONDITION_TRUE_NON_VOID(m_components[i].is_repeated_index != prefix.m_components[i].is_repeated_index ||
+                                             m_components[i].value != prefix.m_components[i].value,
+                                         false);
   }
-  return false;
+
+  return true;
 }
 
-bool FieldPath::skip_component() const {
-  SILENT_CHECK_CONDITION_TRUE_NON_VOID(is_empty(), false);
-  m_components.pop();
+bool FieldPath::operator<(const FieldPath& other) const {
+  const int size{std::min(m_size, other.m_size)};
+
+  for (int i{0}; i < size; i++) {
+    const Component& a{m_components[i]};
+    const Component& b{other.m_components[i]};
+    if (a.is_repeated_index != b.is_repeated_index) return b.is_repeated_index;
+    if (a.value != b.value) return a.value < b.value;
+  }
+
+  return m_size < other.m_size;
+}
+
+bool FieldPath::operator==(const FieldPath& other) const {
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(m_size != other.m_size, false);
+
+  for (int i{0}; i < m_size; i++) {
+    SILENT_CHECK_CONDITION_TRUE_NON_VOID(m_components[i].is_repeated_index != other.m_components[i].is_repeated_index ||
+                                             m_components[i].value != other.m_components[i].value,
+                                         false);
+  }
+
   return true;
 }
 
-std::string FieldPath::to_string() const {
-  std::string path_string;
-  std::queue<PathComponent> temp = m_components;
-
-  while (!temp.empty()) {
-    PathComponent component{temp.front()};
-    temp.pop();
-
-    switch (component.index()) {
-      case PATH_COMPONENT_VARIANT_FIELD_NUMBER_INDEX: {
-        path_string += "FN(" + std::to_string(std::get<FieldPath::FieldNumber>(component).field_number) + ")";
-        break;
-      }
-      case PATH_COMPONENT_VARIANT_REPEATED_AT_INDEX: {
-        path_string += "AT[" + std::to_string(std::get<FieldPath::RepeatedAt>(component).index) + "]";
-        break;
-      }
-      default: {
-        FAIL_AND_RETURN_NON_VOID(path_string, "Invalid path component type");
-      }
-    }
+size_t FieldPath::Hash::operator()(const FieldPath& path) const noexcept {
+  size_t hash{(size_t)path.m_size};
 
-    if (!temp.empty()) {
-      path_string += " --> ";
-    }
+  for (int i{0}; i < path.m_size; i++) {
+    const Component& component{path.m_components[i]};
+    const size_t value{((size_t)(uint32_t)component.value << 1) | (size_t)component.is_repeated_index};
+    hash ^= value + 0x9E3779B9 + (hash << 6) + (hash >> 2);
   }
 
-  return path_string;
+  return hash;
 }
 
-bool FieldPath::get_upcoming_field_num(int& num_buffer) const {
+bool FieldPath::Cursor::is_upcoming_field() const {
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(is_empty(), false);
+  return !m_path->m_components[m_position].is_repeated_index;
+}
+
+bool FieldPath::Cursor::is_upcoming_repeated_index() const {
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(is_empty(), false);
+  return m_path->m_components[m_position].is_repeated_index;
+}
+
+bool FieldPath::Cursor::get_upcoming_field_num(int& num_buffer) const {
   SILENT_CHECK_CONDITION_TRUE_NON_VOID(!is_upcoming_field(), false);
-  num_buffer = std::get<FieldPath::FieldNumber>(m_components.front()).field_number;
+  num_buffer = m_path->m_components[m_position].value;
   return true;
 }
 
-bool FieldPath::get_upcoming_repeated_index(int& index_buffer) const {
+bool FieldPath::Cursor::get_upcoming_repeated_index(int& index_buffer) const {
   SILENT_CHECK_CONDITION_TRUE_NON_VOID(!is_upcoming_repeated_index(), false);
-  index_buffer = std::get<FieldPath::RepeatedAt>(m_components.front()).index;
+  index_buffer = m_path->m_components[m_position].value;
+  return true;
+}
+
+const google::protobuf::FieldDescriptor* FieldPath::Cursor::get_upcoming_field_desc() const {
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!is_upcoming_field(), nullptr);
+  return m_path->m_components[m_position].field_desc;
+}
+
+bool FieldPath::Cursor::skip_component() {
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(is_empty(), false);
+  m_position++;
   return true;
 }
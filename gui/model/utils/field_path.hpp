@@ -29,11 +29,12 @@
 #define FIELD_PATH_HPP
 
 #include <google/protobuf/message.h>
-#include <queue>
+#include <array>
 #include <type_traits>
-#include <variant>
 #include "error_macros.hpp"
 
+#define FIELD_PATH_MAX_COMPONENT_COUNT 8
+
 /**
  * @brief A class to represent a path to a field in a protobuf message.
  * 
@@ -67,6 +68,9 @@
  *        // This will return a message model with the field number 2 in a message with 
  *        // the field number 1
  * 
+ *   The models walk a path with a @c FieldPath::Cursor and leave it unchanged,
+ *   so a @c const path can be traversed any number of times. Use
+ *   @c CompiledFieldPath for a path whose repeated indices change.
  * 
  */
 class FieldPath {
@@ -86,34 +90,49 @@ class FieldPath {
     explicit FieldNumber(const int& f) : field_number(f) {}
   };
 
+  /**
+     * @brief The index is left out in a @c CompiledFieldPath, it is given
+     *        to @c CompiledFieldPath::bind instead.
+     */
   struct RepeatedAt {
     int index;
-    explicit RepeatedAt(const int& i) : index(i) {}
+    explicit RepeatedAt(const int& i = -1) : index(i) {}
   };
 
-  // Variant to hold any path component
-  using PathComponent = std::variant<FieldNumber, RepeatedAt>;
-
  private:
+  friend class CompiledFieldPath;
+  friend class ProtoModel;
+  friend struct ModelChange;
+
+  struct Component {
+    bool is_repeated_index{false};
+    int value{-1};  // Field number or repeated index
+
+    // Resolved against the root buffer descriptor, nullptr for a repeated index
+    const google::protobuf::FieldDescriptor* field_desc{nullptr};
+  };
+
   bool m_is_valid;
   const google::protobuf::Descriptor* m_root_buffer_descriptor;
-  mutable std::queue<PathComponent> m_components;
+  std::array<Component, FIELD_PATH_MAX_COMPONENT_COUNT> m_components;
+  int m_size;
+
+  FieldPath() : m_is_valid(false), m_root_buffer_descriptor(nullptr), m_size(0) {}
 
-  FieldPath() : m_is_valid(false), m_root_buffer_descriptor(nullptr) {}
-  bool is_upcoming_field() const;
-  bool is_upcoming_repeated_index() const;
+  void add_component(const FieldNumber& component) { m_components[m_size++] = Component{false, component.field_number}; }
+  void add_component(const RepeatedAt& component) { m_components[m_size++] = Component{true, component.index}; }
 
   /**
-     * @brief Check if the path is valid
+     * @brief Check if the path is valid and resolve the field descriptors
+     *        of its components
      * 
-     * @note @c private because it should be called only on a full path. This
-     *       means if you skipped a component, the path becomes invalid because
-     *       the root buffer descriptor is no longer the correct one.
+     * @note @c private because it should be called only on a path built
+     *       against @c m_root_buffer_descriptor.
      * 
      * @return true 
      * @return false 
      */
-  bool is_valid_path() const;
+  bool resolve_path();
 
  public:
   // Construct a FieldPath using variadic templates
@@ -121,26 +140,137 @@ class FieldPath {
   static FieldPath Of(Components... components) {
     static_assert(((std::is_same_v<Components, FieldNumber> || std::is_same_v<Components, RepeatedAt>) && ...),
                   "All Components must be FieldNumber or RepeatedAt.");
+    static_assert(sizeof...(Components) <= FIELD_PATH_MAX_COMPONENT_COUNT, "Too many components.");
     FieldPath path;
     path.m_root_buffer_descriptor = T::GetDescriptor();
-    (path.m_components.push(components), ...);  // Add all components
-    CHECK_CONDITION_TRUE_NON_VOID(!path.is_valid_path(), FieldPath(), "Invalid path: " + path.to_string());
+    (path.add_component(components), ...);  // Add all components
+    CHECK_CONDITION_TRUE_NON_VOID(!path.resolve_path(), FieldPath(), "Invalid path: " + path.to_string());
     path.m_is_valid = true;
     return path;
   }
 
-  bool is_empty() const { return m_components.empty(); }
+  bool is_empty() const { return m_size == 0; }
   bool is_valid() const { return m_is_valid; }
 
-  bool get_upcoming_field_num(int& num_buffer) const;
-  bool get_upcoming_repeated_index(int& index_buffer) const;
+  /**
+     * @brief The path to the element @p index of the repeated field this
+     *        path leads to, invalid if the path is full.
+     */
+  FieldPath at(const int& index) const;
 
-  bool skip_component() const;
+  /**
+     * @brief Whether the first components of this path are the ones of
+     *        @p prefix, a path starts with itself.
+     */
+  bool starts_with(const FieldPath& prefix) const;
 
   std::string to_string() const;
 
-  // Access the components
-  const std::queue<PathComponent>& get_components() const { return m_components; }
+  /**
+     * @brief Compares the components by field number and repeated index.
+     */
+  bool operator==(const FieldPath& other) const;
+  bool operator!=(const FieldPath& other) const { return !(*this == other); }
+
+  /**
+     * @brief Orders the paths component by component, a path comes right 
+     *        before the paths starting with it. For sorted containers of 
+     *        paths, where the paths under a prefix are contiguous.
+     */
+  bool operator<(const FieldPath& other) const;
+
+  /**
+     * @brief Hashes the components, for unordered containers of paths.
+     */
+  struct Hash {
+    size_t operator()(const FieldPath& path) const noexcept;
+  };
+
+  /**
+     * @brief The position of a traversal in a path. Skipping a component
+     *        moves the cursor only, the path is left as it is, so the same
+     *        path can be walked by any number of cursors at once.
+     * 
+     * @note The path must outlive the cursor.
+     */
+  class Cursor {
+   public:
+    Cursor(const FieldPath& path) : m_path(&path), m_position(0) {}
+
+    bool is_empty() const { return m_position == m_path->m_size; }
+    bool is_valid() const { return m_path->is_valid(); }
+
+    bool get_upcoming_field_num(int& num_buffer) const;
+    bool get_upcoming_repeated_index(int& index_buffer) const;
+
+    /**
+       * @brief The descriptor of the upcoming field, in the message type it
+       *        was resolved against.
+       */
+    const google::protobuf::FieldDescriptor* get_upcoming_field_desc() const;
+
+    bool skip_component();
+
+   private:
+    const FieldPath* m_path;
+    int m_position;  // The upcoming component, the ones before it are skipped
+
+    bool is_upcoming_field() const;
+    bool is_upcoming_repeated_index() const;
+  };
+};
+
+/**
+ * @brief A @c FieldPath validated once and reused for any number of accesses,
+ *        for example as a @c static in a hot path. The @c RepeatedAt indices
+ *        are given on each access.
+ * 
+ * @example
+ * 
+ *   static const CompiledFieldPath node_id_path{CompiledFieldPath::Of<VisualShader>(
+ *       FieldPath::FieldNumber(VisualShader::kNodesFieldNumber), FieldPath::RepeatedAt(),
+ *       FieldPath::FieldNumber(VisualShader::VisualShaderNode::kIdFieldNumber))};
+ * 
+ *   model->data(node_id_path.bind(row));
+ * 
+ */
+class CompiledFieldPath {
+ public:
+  CompiledFieldPath() : m_repeated_count(0) {}
+
+  template <typename T, typename... Components>
+  static CompiledFieldPath Of(Components... components) {
+    CompiledFieldPath compiled;
+    compiled.m_path = FieldPath::Of<T>(components...);
+    for (int i{0}; i < compiled.m_path.m_size; i++) {
+      if (compiled.m_path.m_components[i].is_repeated_index) compiled.m_repeated_positions[compiled.m_repeated_count++] = i;
+    }
+    return compiled;
+  }
+
+  bool is_valid() const { return m_path.is_valid(); }
+
+  /**
+     * @brief Returns a ready to traverse copy of the path, with the @c RepeatedAt
+     *        components set to @p indices in order. Nothing is validated again,
+     *        the indices are checked by the models while traversing.
+     */
+  template <typename... Indices>
+  FieldPath bind(const Indices&... indices) const {
+    static_assert((std::is_convertible_v<Indices, int> && ...), "All indices must be integers.");
+    CHECK_CONDITION_TRUE_NON_VOID((int)sizeof...(Indices) != m_repeated_count, FieldPath(),
+                                  "Expected " + std::to_string(m_repeated_count) + " indices for " +
+                                      m_path.to_string());
+    FieldPath path{m_path};
+    int i{0};
+    ((path.m_components[m_repeated_positions[i++]].value = (int)indices), ...);
+    return path;
+  }
+
+ private:
+  FieldPath m_path;
+  std::array<int, FIELD_PATH_MAX_COMPONENT_COUNT> m_repeated_positions;
+  int m_repeated_count;
 };
 
 #endif  // FIELD_PATH_HPP
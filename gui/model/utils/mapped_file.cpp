@@ -0,0 +1,65 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#include "gui/model/utils/mapped_file.hpp"
+
+#include "error_macros.hpp"
+
+MappedFile::MappedFile(const QString& file_path) : m_file(file_path) {}
+
+bool MappedFile::open() {
+  CHECK_CONDITION_TRUE_NON_VOID(m_is_open, false, "File is already open.");
+  SILENT_CHECK_CONDITION_TRUE_NON_VOID(!m_file.open(QIODevice::ReadOnly), false);
+
+  const qint64 size{m_file.size()};
+  if (size > 0) m_mapped_data = m_file.map(0, size);
+
+  if (m_mapped_data) {
+    m_mapped_size = (size_t)size;
+  } else {
+    m_buffer = m_file.readAll();
+  }
+
+  m_is_open = true;
+  return true;
+}
+
+void MappedFile::close() {
+  SILENT_CHECK_CONDITION_TRUE(!m_is_open);
+
+  if (m_mapped_data) m_file.unmap(m_mapped_data);
+  m_mapped_data = nullptr;
+  m_mapped_size = 0;
+  m_buffer.clear();
+  m_file.close();
+  m_is_open = false;
+}
+
+const char* MappedFile::get_data() const {
+  return m_mapped_data ? reinterpret_cast<const char*>(m_mapped_data) : m_buffer.constData();
+}
+
+size_t MappedFile::get_size() const { return m_mapped_data ? m_mapped_size : (size_t)m_buffer.size(); }
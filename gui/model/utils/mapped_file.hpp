@@ -0,0 +1,66 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+/**
+ * @brief The read-only contents of a file, mapped into memory. Parsing 
+ *        from get_data() reads the pages of the file once, instead of 
+ *        copying the whole file into a buffer first. Files that cannot 
+ *        be mapped, empty ones for example, are read instead.
+ * 
+ * @note The data is valid until the file is closed.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const QString& file_path);
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open();
+  void close();
+  bool is_open() const { return m_is_open; }
+  bool is_mapped() const { return m_mapped_data != nullptr; }
+
+  const char* get_data() const;
+  size_t get_size() const;
+
+ private:
+  QFile m_file;
+  uchar* m_mapped_data{nullptr};
+  size_t m_mapped_size{0};
+  QByteArray m_buffer;  // Only if the file is not mapped
+  bool m_is_open{false};
+};
+
+#endif  // MAPPED_FILE_HPP
@@ -30,15 +30,29 @@
 #include <QApplication>
 #include <QCommandLineOption>
 #include <QCommandLineParser>
+#include <QFile>
+#include <QMessageBox>
 #include <filesystem>
+#include <google/protobuf/arena.h>
 
 #include "gui/model/schema/visual_shader.pb.h"
 
 #include "gui/controller/visual_shader_editor.hpp"
 #include "gui/model/message_model.hpp"
+#include "gui/model/model_autosaver.hpp"
+#include "gui/model/model_journal_file.hpp"
 
 using VisualShader = gui::model::schema::VisualShader;
 
+// The document is allocated in blocks growing from the start size up to the
+// max size, a loaded graph usually fits in the first few.
+#define DOCUMENT_ARENA_START_BLOCK_SIZE (64 * 1024)
+#define DOCUMENT_ARENA_MAX_BLOCK_SIZE (1024 * 1024)
+
+#define PROJECT_FILE_PATH "model.bin"
+#define LEGACY_PROJECT_FILE_PATH "model.json"  // Saved as JSON by older versions
+#define EXPORT_FILE_PATH "model.json"          // Readable copy of the project, kept by the autosaver
+
 int main(int argc, char** argv) {
   // Verify that the version of the library that we linked against is
   // compatible with the version of the headers we compiled against.
@@ -56,15 +70,45 @@ int main(int argc, char** argv) {
   parser.addVersionOption();
   parser.process(shader_gen_app);
 
-  VisualShader visual_shader;
+  // The nodes and connections are allocated from the arena and freed all
+  // at once with it, after the models.
+  google::protobuf::ArenaOptions arena_options;
+  arena_options.start_block_size = DOCUMENT_ARENA_START_BLOCK_SIZE;
+  arena_options.max_block_size = DOCUMENT_ARENA_MAX_BLOCK_SIZE;
+  google::protobuf::Arena arena{arena_options};
+
+  VisualShader* visual_shader{google::protobuf::Arena::CreateMessage<VisualShader>(&arena)};
+
+  MessageModel* root_model = new MessageModel(visual_shader);
 
-  MessageModel* root_model = new MessageModel(&visual_shader);
-  bool load_result = dynamic_cast<ProtoModel*>(root_model)->loadFromJson("model.json");
-  if (!load_result) {
-  	ERROR_PRINT("Failed to load model from JSON");
+  // Older versions only saved the JSON file, it becomes the project file.
+  // Nothing is opened on a project file that was not written, the edits
+  // would be journaled after an empty document.
+  if (!QFile::exists(PROJECT_FILE_PATH) && QFile::exists(LEGACY_PROJECT_FILE_PATH)) {
+    if (!root_model->load(LEGACY_PROJECT_FILE_PATH) || !root_model->saveToBinary(PROJECT_FILE_PATH)) {
+      QFile::remove(PROJECT_FILE_PATH);
+      QMessageBox::critical(nullptr, QCoreApplication::applicationName(),
+                            "Failed to convert " LEGACY_PROJECT_FILE_PATH " to " PROJECT_FILE_PATH ".");
+      delete root_model;
+      return 1;
+    }
+  }
+
+  // Every change is appended to the journal of the project file. Without
+  // it the edits would be lost, so the editor does not start.
+  ModelJournalFile* journal_file = new ModelJournalFile(root_model, PROJECT_FILE_PATH);
+  if (!journal_file->open()) {
+    QMessageBox::critical(nullptr, QCoreApplication::applicationName(),
+                          "Failed to open the project " PROJECT_FILE_PATH ".");
+    delete journal_file;
+    delete root_model;
+    return 1;
   }
   root_model->build_sub_models();
 
+  // The JSON copy is written in the background once the edits settle.
+  ModelAutosaver* autosaver = new ModelAutosaver(root_model, EXPORT_FILE_PATH, ProtoModel::FileFormat::JSON);
+
   VisualShaderEditor* w = new VisualShaderEditor(root_model);
 
   w->resize(1440, 720);
@@ -73,6 +117,8 @@ int main(int argc, char** argv) {
   int result{shader_gen_app.exec()};
 
   delete w;
+  delete autosaver;     // Writes the pending changes
+  delete journal_file;  // Writes the queued changes
   delete root_model;
 
   return result;
@@ -0,0 +1,165 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "evaluator/simd/batch_kernels.hpp"
+#include "evaluator/utils/utils.hpp"
+#include "evaluator/visual_shader_node_evaluators.hpp"
+#include "evaluator/vs_node_noise_evaluators.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+// 19 lanes so that every SIMD width leaves a tail.
+static std::vector<float> make_lanes(const float& start, const float& step) {
+  std::vector<float> lanes(19);
+  for (size_t i{0}; i < lanes.size(); i++) lanes[i] = start + step * float(i);
+  return lanes;
+}
+
+static std::vector<const BatchKernels*> get_supported_batch_kernels() {
+  std::vector<const BatchKernels*> kernels{get_scalar_batch_kernels()};
+  if (get_supported_simd_level() >= SimdLevel::SSE4) kernels.push_back(get_sse4_batch_kernels());
+  if (get_supported_simd_level() >= SimdLevel::AVX2) kernels.push_back(get_avx2_batch_kernels());
+  return kernels;
+}
+
+static void expect_same(const float& expected, const float& actual) {
+  if (std::isnan(expected)) {
+    EXPECT_TRUE(std::isnan(actual));
+  } else {
+    EXPECT_FLOAT_EQ(expected, actual);
+  }
+}
+
+TEST(BatchKernelsTest, TestFloatOpMatchesReference) {
+  const std::vector<float> a{make_lanes(-2.3f, 0.37f)}, b{make_lanes(1.7f, -0.21f)};
+  std::vector<float> r(a.size());
+
+  for (const BatchKernels* kernels : get_supported_batch_kernels()) {
+    for (int op{VisualShaderNodeFloatOp::OP_ADD}; op <= VisualShaderNodeFloatOp::OP_STEP; op++) {
+      const VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType t{
+          static_cast<VisualShaderNodeFloatOp::VisualShaderNodeFloatOpType>(op)};
+      kernels->float_op(t, a.data(), b.data(), r.data(), (int)r.size());
+      for (size_t i{0}; i < r.size(); i++) expect_same(apply_float_op(t, a[i], b[i]), r[i]);
+    }
+  }
+}
+
+TEST(BatchKernelsTest, TestFloatFuncMatchesReference) {
+  const std::vector<float> x{make_lanes(-1.45f, 0.15f)};
+  std::vector<float> r(x.size());
+
+  for (const BatchKernels* kernels : get_supported_batch_kernels()) {
+    for (int func{VisualShaderNodeFloatFunc::FUNC_SIN}; func <= VisualShaderNodeFloatFunc::FUNC_ONEMINUS; func++) {
+      const VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType t{
+          static_cast<VisualShaderNodeFloatFunc::VisualShaderNodeFloatFuncType>(func)};
+      kernels->float_func(t, x.data(), r.data(), (int)r.size());
+      for (size_t i{0}; i < r.size(); i++) expect_same(apply_float_func(t, x[i]), r[i]);
+    }
+  }
+}
+
+TEST(BatchKernelsTest, TestSinCosMatchStandardLibrary) {
+  // Wide enough for the noise hashes, which take sin of large arguments.
+  const std::vector<float> x{make_lanes(-8000.0f, 841.3f)};
+  std::vector<float> r(x.size());
+
+  for (const BatchKernels* kernels : get_supported_batch_kernels()) {
+    kernels->float_func(VisualShaderNodeFloatFunc::FUNC_SIN, x.data(), r.data(), (int)r.size());
+    for (size_t i{0}; i < r.size(); i++) {
+      EXPECT_EQ(evaluator_utils::sin(x[i]), r[i]);
+      EXPECT_NEAR(std::sin((double)x[i]), r[i], 1e-6);
+    }
+
+    kernels->float_func(VisualShaderNodeFloatFunc::FUNC_COS, x.data(), r.data(), (int)r.size());
+    for (size_t i{0}; i < r.size(); i++) {
+      EXPECT_EQ(evaluator_utils::cos(x[i]), r[i]);
+      EXPECT_NEAR(std::cos((double)x[i]), r[i], 1e-6);
+    }
+  }
+}
+
+TEST(BatchKernelsTest, TestNoiseMatchesReference) {
+  const std::vector<float> u{make_lanes(0.013f, 0.05f)}, v{make_lanes(0.97f, -0.045f)};
+  std::vector<float> r(u.size());
+
+  for (const BatchKernels* kernels : get_supported_batch_kernels()) {
+    kernels->value_noise(u.data(), v.data(), 100.0f, r.data(), (int)r.size());
+    for (size_t i{0}; i < r.size(); i++) EXPECT_FLOAT_EQ(generate_value_noise_float(u[i], v[i], 100.0f), r[i]);
+
+    kernels->perlin_noise(u.data(), v.data(), 10.0f, r.data(), (int)r.size());
+    for (size_t i{0}; i < r.size(); i++) EXPECT_FLOAT_EQ(generate_perlin_noise_float(u[i], v[i], 10.0f), r[i]);
+
+    kernels->voronoi_noise(u.data(), v.data(), 10.0f, 5.0f, r.data(), (int)r.size());
+    for (size_t i{0}; i < r.size(); i++) {
+      EXPECT_FLOAT_EQ(generate_voronoi_noise_float(u[i], v[i], 10.0f, 5.0f), r[i]);
+    }
+  }
+}
+
+TEST(BatchKernelsTest, TestImageLossesMatchReference) {
+  // 9 pixels so that every SIMD width leaves a tail, moments reads them as 3 rows of 3.
+  std::vector<float> a(36), b(36);
+  for (size_t i{0}; i < a.size(); i++) {
+    a[i] = 0.03f * float(i);
+    b[i] = 1.0f - 0.02f * float(i);
+  }
+
+  float squared[4]{}, absolute[4]{}, moments[20]{};
+  for (size_t i{0}; i < a.size(); i++) {
+    const int c{int(i % 4)};
+    squared[c] += (a[i] - b[i]) * (a[i] - b[i]);
+    absolute[c] += std::fabs(a[i] - b[i]);
+    moments[c] += a[i];
+    moments[4 + c] += b[i];
+    moments[8 + c] += a[i] * a[i];
+    moments[12 + c] += b[i] * b[i];
+    moments[16 + c] += a[i] * b[i];
+  }
+
+  for (const BatchKernels* kernels : get_supported_batch_kernels()) {
+    // The kernels accumulate, start from 1 to check it.
+    float r[20];
+    std::fill(r, r + 20, 1.0f);
+
+    kernels->squared_error(a.data(), b.data(), r, (int)a.size());
+    for (int c{0}; c < 4; c++) EXPECT_NEAR(squared[c] + 1.0f, r[c], 1e-5f);
+
+    std::fill(r, r + 20, 1.0f);
+    kernels->absolute_error(a.data(), b.data(), r, (int)a.size());
+    for (int c{0}; c < 4; c++) EXPECT_NEAR(absolute[c] + 1.0f, r[c], 1e-5f);
+
+    std::fill(r, r + 20, 1.0f);
+    kernels->moments(a.data(), b.data(), 12, 3, r, 12);
+    for (int i{0}; i < 20; i++) EXPECT_NEAR(moments[i] + 1.0f, r[i], 1e-5f);
+  }
+}
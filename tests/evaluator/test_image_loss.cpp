@@ -0,0 +1,114 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "evaluator/image_loss.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+static Image make_gradient(const int& width, const int& height) {
+  Image image{width, height};
+  for (int y{0}; y < height; y++) {
+    for (int x{0}; x < width; x++) {
+      float* pixel{image.at(x, y)};
+      pixel[0] = (float(x) + 0.5f) / float(width);
+      pixel[1] = (float(y) + 0.5f) / float(height);
+      pixel[2] = 0.5f;
+      pixel[3] = 1.0f;
+    }
+  }
+  return image;
+}
+
+TEST(ImageLossTest, TestMseAndL1) {
+  Image a{5, 3}, b{5, 3};
+  for (int y{0}; y < 3; y++) {
+    for (int x{0}; x < 5; x++) {
+      b.at(x, y)[0] = 0.5f;
+      b.at(x, y)[1] = -0.25f;
+      b.at(x, y)[3] = 1.0f;
+    }
+  }
+
+  EXPECT_FLOAT_EQ(compute_mse(a, b), (0.25f + 0.0625f) / 3.0f);
+  EXPECT_FLOAT_EQ(compute_image_loss(a, b, ImageLossType::MSE), (0.25f + 0.0625f) / 3.0f);
+
+  float l1[4];
+  EXPECT_TRUE(compute_l1(a, b, l1));
+  EXPECT_FLOAT_EQ(l1[0], 0.5f);
+  EXPECT_FLOAT_EQ(l1[1], 0.25f);
+  EXPECT_FLOAT_EQ(l1[2], 0.0f);
+  EXPECT_FLOAT_EQ(l1[3], 1.0f);
+  EXPECT_FLOAT_EQ(compute_image_loss(a, b, ImageLossType::L1), 0.25f);
+
+  EXPECT_TRUE(std::isinf(compute_image_loss(a, Image{3, 5}, ImageLossType::MSE)));
+}
+
+TEST(ImageLossTest, TestSsim) {
+  const Image a{make_gradient(20, 13)};
+  EXPECT_NEAR(compute_ssim(a, a), 1.0f, 1e-5f);
+  EXPECT_NEAR(compute_image_loss(a, a, ImageLossType::SSIM), 0.0f, 1e-5f);
+
+  // Same mean, flipped structure.
+  Image b{a};
+  for (int y{0}; y < a.height; y++) {
+    for (int x{0}; x < a.width; x++) b.at(x, y)[0] = a.at(a.width - 1 - x, y)[0];
+  }
+  EXPECT_LT(compute_ssim(a, b), 0.9f);
+
+  // Smaller than a window.
+  const Image c{make_gradient(3, 2)};
+  EXPECT_NEAR(compute_ssim(c, c), 1.0f, 1e-5f);
+}
+
+TEST(ImageLossTest, TestImagePyramid) {
+  const Image image{make_gradient(100, 80)};
+
+  ImagePyramid pyramid;
+  build_image_pyramid(image, 64, 64, 16, pyramid);
+  ASSERT_EQ(pyramid.levels.size(), 3u);
+  EXPECT_EQ(pyramid.levels.at(0).width, 16);
+  EXPECT_EQ(pyramid.levels.at(1).width, 32);
+  EXPECT_EQ(pyramid.levels.at(2).width, 64);
+  EXPECT_EQ(pyramid.levels.at(2).height, 64);
+
+  // Box filtering keeps the mean.
+  for (const Image& level : pyramid.levels) {
+    double sum{0.0};
+    for (int y{0}; y < level.height; y++) {
+      for (int x{0}; x < level.width; x++) sum += level.at(x, y)[2];
+    }
+    EXPECT_NEAR(sum / double(level.width * level.height), 0.5, 1e-5);
+  }
+
+  build_image_pyramid(image, 12, 12, 16, pyramid);
+  ASSERT_EQ(pyramid.levels.size(), 1u);
+  EXPECT_EQ(pyramid.levels.at(0).width, 12);
+}
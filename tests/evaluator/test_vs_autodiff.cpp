@@ -0,0 +1,214 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "evaluator/image_loss.hpp"
+#include "evaluator/visual_shader_autodiff.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+static VisualShader::VisualShaderNode* add_node(VisualShader& visual_shader, const int& id) {
+  VisualShader::VisualShaderNode* node{visual_shader.add_nodes()};
+  node->set_id(id);
+  return node;
+}
+
+static void add_connection(VisualShader& visual_shader, const int& from_node_id, const int& from_port_index,
+                           const int& to_node_id, const int& to_port_index) {
+  VisualShader::VisualShaderConnection* c{visual_shader.add_connections()};
+  c->set_id(visual_shader.connections_size() - 1);
+  c->set_from_node_id(from_node_id);
+  c->set_from_port_index(from_port_index);
+  c->set_to_node_id(to_node_id);
+  c->set_to_port_index(to_port_index);
+}
+
+static void set_color(VisualShader::VisualShaderNode* node, const float& r, const float& g, const float& b) {
+  VisualShaderNodeColorConstant* color{node->mutable_color_constant()};
+  color->set_r(r);
+  color->set_g(g);
+  color->set_b(b);
+  color->set_a(1.0f);
+}
+
+static Image make_gradient(const int& width, const int& height) {
+  Image image{width, height};
+  for (int y{0}; y < height; y++) {
+    for (int x{0}; x < width; x++) {
+      float* pixel{image.at(x, y)};
+      pixel[0] = (float(x) + 0.5f) / float(width);
+      pixel[1] = (float(y) + 0.5f) / float(height);
+      pixel[2] = 0.5f;
+      pixel[3] = 1.0f;
+    }
+  }
+  return image;
+}
+
+static float render_loss(const VisualShader& visual_shader, const Image& target) {
+  Image image;
+  EXPECT_TRUE(render_shader(visual_shader, target.width, target.height, 0.0f, image));
+  return compute_mse(image, target);
+}
+
+TEST(VisualShaderAutodiffTest, TestGradientMatchesFiniteDifferences) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  add_node(visual_shader, 2)->mutable_perlin_noise()->set_scale(4.0f);
+  set_color(add_node(visual_shader, 3), 0.2f, 0.4f, 0.6f);
+
+  VisualShaderNodeVec3Constant* vec3{add_node(visual_shader, 4)->mutable_vec3_constant()};
+  vec3->set_x(0.5f);
+  vec3->set_y(0.25f);
+  vec3->set_z(1.0f);
+
+  VisualShaderNodeVectorOp* vector_op{add_node(visual_shader, 5)->mutable_vector_op()};
+  vector_op->set_type(VisualShaderNodeVectorType::TYPE_VECTOR_3D);
+  vector_op->set_op(VisualShaderNodeVectorOp::OP_MUL);
+
+  add_node(visual_shader, 6)->mutable_mix()->set_type(VisualShaderNodePortType::PORT_TYPE_VECTOR_4D);
+  add_node(visual_shader, 7)->mutable_float_constant()->set_value(0.3f);
+  add_node(visual_shader, 8)->mutable_float_func()->set_func(VisualShaderNodeFloatFunc::FUNC_SIN);
+
+  // mix(color, noise * vec3, sin(0.3)) with vec4 to vec3, vec3 to vec4 and
+  // float to vec4 conversions.
+  add_connection(visual_shader, 1, 0, 2, 0);
+  add_connection(visual_shader, 2, 0, 5, 0);
+  add_connection(visual_shader, 4, 0, 5, 1);
+  add_connection(visual_shader, 7, 0, 8, 0);
+  add_connection(visual_shader, 3, 0, 6, 0);
+  add_connection(visual_shader, 5, 0, 6, 1);
+  add_connection(visual_shader, 8, 0, 6, 2);
+  add_connection(visual_shader, 6, 0, 0, 0);
+
+  std::vector<TunableParameter> parameters;
+  get_tunable_parameters(visual_shader, parameters);
+  EXPECT_EQ(parameters.size(), 9);
+
+  const Image target{make_gradient(16, 16)};
+
+  float loss{0.0f};
+  std::vector<float> gradient;
+  EXPECT_TRUE(compute_loss_gradient(visual_shader, parameters, target, loss, gradient));
+  EXPECT_NEAR(loss, render_loss(visual_shader, target), 1e-5f);
+  EXPECT_EQ(gradient.size(), parameters.size());
+
+  for (size_t k{0}; k < parameters.size(); k++) {
+    float value{0.0f};
+    EXPECT_TRUE(get_parameter_value(visual_shader, parameters.at(k), value));
+
+    const float h{1e-2f * std::max(1.0f, std::fabs(value))};
+    VisualShader shifted{visual_shader};
+    EXPECT_TRUE(set_parameter_value(shifted, parameters.at(k), value + h));
+    const float loss_plus{render_loss(shifted, target)};
+    EXPECT_TRUE(set_parameter_value(shifted, parameters.at(k), value - h));
+    const float loss_minus{render_loss(shifted, target)};
+
+    const float expected{(loss_plus - loss_minus) / (2.0f * h)};
+    EXPECT_NEAR(gradient.at(k), expected, 1e-3f + 0.05f * std::fabs(expected)) << "Parameter " << k;
+  }
+
+  // The alpha of the color (after the noise scale) does not reach the RGB loss.
+  EXPECT_FLOAT_EQ(gradient.at(4), 0.0f);
+}
+
+TEST(VisualShaderAutodiffTest, TestUnreachedNodesHaveNoTangents) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  add_node(visual_shader, 2)->mutable_float_constant()->set_value(2.0f);
+  add_node(visual_shader, 3)->mutable_vector_func()->set_func(VisualShaderNodeVectorFunc::FUNC_SIN);
+  add_node(visual_shader, 4)->mutable_float_op()->set_op(VisualShaderNodeFloatOp::OP_MUL);
+
+  add_connection(visual_shader, 1, 0, 3, 0);
+  add_connection(visual_shader, 3, 0, 4, 0);
+  add_connection(visual_shader, 2, 0, 4, 1);
+  add_connection(visual_shader, 4, 0, 0, 0);
+
+  EvaluationGraph graph;
+  EXPECT_TRUE(to_evaluation_graph(visual_shader, 0, graph));
+
+  DualEvaluationState state;
+  EXPECT_TRUE(make_dual_evaluation_state(graph, {{2, 0}}, state));
+
+  // Nodes 1 and 3 only depend on the UV.
+  int active_count{0};
+  for (const int& offset : state.tangent_offsets) active_count += offset >= 0 ? 1 : 0;
+  EXPECT_EQ(active_count, 3);
+
+  EvaluationContext context;
+  context.uv[0] = 0.25f;
+  EXPECT_TRUE(evaluate_graph_dual(graph, context, state));
+
+  // d(sin(u) * c) / dc = sin(u), splatted to the vec4 color with an alpha of 1.0.
+  float tangents[4];
+  const Value value{get_input_dual_value(graph, state, (int)graph.nodes.size() - 1, 0, tangents)};
+  EXPECT_FLOAT_EQ(value.f[0], std::sin(0.25f) * 2.0f);
+  for (int c{0}; c < 4; c++) EXPECT_FLOAT_EQ(tangents[c], std::sin(0.25f));
+}
+
+TEST(VisualShaderAutodiffTest, TestTuneParametersReducesLoss) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  set_color(add_node(visual_shader, 2), 1.0f, 0.0f, 0.5f);
+  set_color(add_node(visual_shader, 3), 0.0f, 1.0f, 0.25f);
+  add_node(visual_shader, 4)->mutable_mix()->set_type(VisualShaderNodePortType::PORT_TYPE_VECTOR_4D);
+
+  add_connection(visual_shader, 2, 0, 4, 0);
+  add_connection(visual_shader, 3, 0, 4, 1);
+  add_connection(visual_shader, 1, 0, 4, 2);
+  add_connection(visual_shader, 4, 0, 0, 0);
+
+  Image target;
+  EXPECT_TRUE(render_shader(visual_shader, 32, 32, 0.0f, target));
+
+  set_color(visual_shader.mutable_nodes(2), 0.5f, 0.5f, 0.5f);
+  set_color(visual_shader.mutable_nodes(3), 0.5f, 0.5f, 0.5f);
+  const float initial_loss{render_loss(visual_shader, target)};
+
+  std::vector<TunableParameter> parameters;
+  get_tunable_parameters(visual_shader, parameters);
+
+  ParameterTuningOptions options;
+  options.iteration_count = 200;
+  options.learning_rate = 0.02f;
+  options.image_size = 32;
+
+  float loss{0.0f};
+  EXPECT_TRUE(tune_parameters(visual_shader, parameters, target, options, loss));
+  EXPECT_LT(loss, initial_loss * 0.01f);
+  EXPECT_NEAR(loss, render_loss(visual_shader, target), 1e-6f);
+
+  EXPECT_NEAR(visual_shader.nodes(2).color_constant().r(), 1.0f, 0.05f);
+  EXPECT_NEAR(visual_shader.nodes(3).color_constant().g(), 1.0f, 0.05f);
+}
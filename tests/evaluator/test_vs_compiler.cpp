@@ -0,0 +1,201 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "evaluator/visual_shader_compiler.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+static VisualShader::VisualShaderNode* add_node(VisualShader& visual_shader, const int& id) {
+  VisualShader::VisualShaderNode* node{visual_shader.add_nodes()};
+  node->set_id(id);
+  return node;
+}
+
+static void add_connection(VisualShader& visual_shader, const int& from_node_id, const int& from_port_index,
+                           const int& to_node_id, const int& to_port_index) {
+  VisualShader::VisualShaderConnection* c{visual_shader.add_connections()};
+  c->set_id(visual_shader.connections_size() - 1);
+  c->set_from_node_id(from_node_id);
+  c->set_from_port_index(from_port_index);
+  c->set_to_node_id(to_node_id);
+  c->set_to_port_index(to_port_index);
+}
+
+TEST(VisualShaderCompilerTest, TestConstantFolding) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_float_constant()->set_value(3.0f);
+  add_node(visual_shader, 2)->mutable_float_constant()->set_value(4.0f);
+  add_node(visual_shader, 3)->mutable_float_op()->set_op(VisualShaderNodeFloatOp::OP_MUL);
+
+  add_connection(visual_shader, 1, 0, 3, 0);
+  add_connection(visual_shader, 2, 0, 3, 1);
+  add_connection(visual_shader, 3, 0, 0, 0);
+
+  Program program;
+  EXPECT_TRUE(compile_program(visual_shader, 0, program));
+  EXPECT_TRUE(program.instructions.empty());
+
+  // The float -> vec4 conversion of the output is folded as well.
+  const BatchValue& color{program.registers.at(program.root_input_registers.at(0))};
+  EXPECT_EQ(color.type, VisualShaderNodePortType::PORT_TYPE_VECTOR_4D);
+  for (int c{0}; c < 4; c++) EXPECT_FLOAT_EQ(color.f[c][5], 12.0f);
+}
+
+TEST(VisualShaderCompilerTest, TestRegisterReuse) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_TIME);
+
+  // A chain of sin(sin(...(time))) only needs two live scalars at a time.
+  const int chain_length{32};
+  for (int i{0}; i < chain_length; i++) {
+    add_node(visual_shader, 2 + i)->mutable_float_func()->set_func(VisualShaderNodeFloatFunc::FUNC_SIN);
+    add_connection(visual_shader, 1 + i, 0, 2 + i, 0);
+  }
+  add_connection(visual_shader, 1 + chain_length, 0, 0, 0);
+
+  Program program;
+  EXPECT_TRUE(compile_program(visual_shader, 0, program));
+  EXPECT_EQ((int)program.instructions.size(), chain_length + 2);  // Input, chain and the vec4 conversion.
+  EXPECT_LT((int)program.registers.size(), 8);
+
+  ProgramState state;
+  make_program_state(program, state);
+
+  BatchEvaluationContext context;
+  context.time = 0.5f;
+  EXPECT_TRUE(execute_program(program, context, state));
+
+  float expected{0.5f};
+  for (int i{0}; i < chain_length; i++) expected = std::sin(expected);
+
+  const BatchValue& color{state.registers.at(program.root_input_registers.at(0))};
+  EXPECT_FLOAT_EQ(color.f[0][0], expected);
+  EXPECT_FLOAT_EQ(color.f[3][15], expected);
+}
+
+TEST(VisualShaderCompilerTest, TestLoweredNodesMatchReference) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  add_node(visual_shader, 2)->mutable_voronoi_noise()->set_cell_density(5.0f);
+  VisualShader::VisualShaderNode* vector_op{add_node(visual_shader, 3)};
+  vector_op->mutable_vector_op()->set_type(VisualShaderNodeVectorType::TYPE_VECTOR_3D);
+  vector_op->mutable_vector_op()->set_op(VisualShaderNodeVectorOp::OP_MUL);
+  add_node(visual_shader, 4)->mutable_vector_3d_decompose();
+  add_node(visual_shader, 5)->mutable_float_op()->set_op(VisualShaderNodeFloatOp::OP_POW);
+  add_node(visual_shader, 6)->mutable_smooth_step();
+  add_node(visual_shader, 7)->mutable_vector_4d_compose();
+  VisualShader::VisualShaderNode* vector_func{add_node(visual_shader, 8)};
+  vector_func->mutable_vector_func()->set_type(VisualShaderNodeVectorType::TYPE_VECTOR_4D);
+  vector_func->mutable_vector_func()->set_func(VisualShaderNodeVectorFunc::FUNC_SIN);
+  add_node(visual_shader, 9)->mutable_mix()->set_type(VisualShaderNodePortType::PORT_TYPE_VECTOR_4D);
+
+  // vec2 -> vec3 and vec4 -> vec3 conversions into the vector operator, a
+  // splat of a float into the mix and unconnected inputs.
+  add_connection(visual_shader, 1, 0, 2, 0);
+  add_connection(visual_shader, 1, 0, 3, 0);
+  add_connection(visual_shader, 2, 0, 3, 1);
+  add_connection(visual_shader, 3, 0, 4, 0);
+  add_connection(visual_shader, 4, 0, 5, 0);
+  add_connection(visual_shader, 4, 1, 5, 1);
+  add_connection(visual_shader, 4, 2, 6, 1);
+  add_connection(visual_shader, 5, 0, 6, 2);
+  add_connection(visual_shader, 6, 0, 7, 0);
+  add_connection(visual_shader, 4, 2, 7, 1);
+  add_connection(visual_shader, 7, 0, 8, 0);
+  add_connection(visual_shader, 8, 0, 9, 0);
+  add_connection(visual_shader, 1, 0, 9, 1);
+  add_connection(visual_shader, 5, 0, 9, 2);
+  add_connection(visual_shader, 9, 0, 0, 0);
+
+  Program program;
+  EXPECT_TRUE(compile_program(visual_shader, 0, program));
+  for (const Instruction& instruction : program.instructions) {
+    EXPECT_NE(instruction.opcode, OpCode::EVALUATE_NODE);
+    EXPECT_NE(instruction.opcode, OpCode::CONVERT);
+  }
+
+  ProgramState state;
+  make_program_state(program, state);
+
+  BatchEvaluationContext context;
+  for (int l{0}; l < SHADER_GEN_EVALUATOR_BATCH_SIZE; l++) {
+    context.uv[0][l] = 0.05f * float(l);
+    context.uv[1][l] = 0.9f - 0.03f * float(l);
+  }
+  EXPECT_TRUE(execute_program(program, context, state));
+
+  EvaluationGraph graph;
+  EXPECT_TRUE(to_evaluation_graph(visual_shader, 0, graph));
+
+  EvaluationState reference_state;
+  make_evaluation_state(graph, reference_state);
+
+  const BatchValue& color{state.registers.at(program.root_input_registers.at(0))};
+  for (int l{0}; l < SHADER_GEN_EVALUATOR_BATCH_SIZE; l++) {
+    EvaluationContext lane_context;
+    lane_context.uv[0] = context.uv[0][l];
+    lane_context.uv[1] = context.uv[1][l];
+    EXPECT_TRUE(evaluate_graph(graph, lane_context, reference_state));
+
+    const Value expected{get_input_value(graph, reference_state, (int)graph.nodes.size() - 1, 0)};
+    for (int c{0}; c < 4; c++) EXPECT_FLOAT_EQ(color.f[c][l], expected.f[c]);
+  }
+}
+
+TEST(VisualShaderCompilerTest, TestProgramCache) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  add_node(visual_shader, 2)->mutable_value_noise()->set_scale(10.0f);
+
+  add_connection(visual_shader, 1, 0, 2, 0);
+  add_connection(visual_shader, 2, 0, 0, 0);
+
+  ProgramCache cache;
+  std::shared_ptr<const Program> program{cache.get_program(visual_shader, 0)};
+  EXPECT_NE(program, nullptr);
+
+  // Moving a node does not change the program.
+  visual_shader.mutable_nodes(2)->set_x_coordinate(100.0f);
+  EXPECT_EQ(cache.get_program(visual_shader, 0), program);
+  EXPECT_EQ(cache.get_size(), 1);
+
+  // Changing a property does.
+  visual_shader.mutable_nodes(2)->mutable_value_noise()->set_scale(20.0f);
+  EXPECT_NE(cache.get_program(visual_shader, 0), program);
+  EXPECT_EQ(cache.get_size(), 2);
+
+  cache.clear();
+  EXPECT_EQ(cache.get_size(), 0);
+}
@@ -0,0 +1,164 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <random>
+
+#include "evaluator/visual_shader_dataset.hpp"
+#include "evaluator/visual_shader_evaluator.hpp"
+#include "evaluator/visual_shader_graph_search.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+static std::string make_temp_directory(const std::string& name) {
+  const std::filesystem::path path{std::filesystem::temp_directory_path() / ("shader_gen_" + name)};
+  std::filesystem::remove_all(path);
+  return path.string();
+}
+
+static VisualShader make_graph(const float& value) {
+  VisualShader visual_shader;
+  VisualShader::VisualShaderNode* output{visual_shader.add_nodes()};
+  output->set_id(0);
+  output->mutable_output();
+
+  VisualShader::VisualShaderNode* constant{visual_shader.add_nodes()};
+  constant->set_id(1);
+  constant->mutable_float_constant()->set_value(value);
+
+  VisualShader::VisualShaderConnection* c{visual_shader.add_connections()};
+  c->set_from_node_id(1);
+  c->set_to_node_id(0);
+  return visual_shader;
+}
+
+TEST(VisualShaderDatasetTest, TestGenerateRandomGraph) {
+  std::mt19937 rng{7};
+  for (int i{0}; i < 20; i++) {
+    VisualShader visual_shader;
+    generate_random_graph(8, rng, visual_shader);
+    EXPECT_GE(visual_shader.nodes_size(), 2);
+    EXPECT_LE(visual_shader.nodes_size(), 9);
+
+    Image image;
+    EXPECT_TRUE(render_shader(visual_shader, 4, 4, 0.0f, image));
+  }
+}
+
+TEST(VisualShaderDatasetTest, TestWriteAndReadShards) {
+  const std::string directory{make_temp_directory("dataset_shards")};
+
+  std::vector<std::string> records(5);
+  for (int i{0}; i < 5; i++) {
+    Image image;
+    EXPECT_TRUE(render_shader(make_graph(0.2f * i), 8, 4, 0.0f, image));
+    const DatasetImageEncoding encoding{i % 2 == 0 ? DatasetImageEncoding::RGBA32F : DatasetImageEncoding::RGBA8};
+    EXPECT_TRUE(encode_dataset_record(make_graph(0.2f * i), image, encoding, records.at(i)));
+  }
+
+  // Room for two records per shard.
+  {
+    DatasetWriter writer{directory, 8 + records.at(0).size() * 2};
+    EXPECT_TRUE(writer.open());
+    for (const std::string& record : records) EXPECT_TRUE(writer.add_record(record));
+    EXPECT_TRUE(writer.close());
+    EXPECT_EQ(writer.get_record_count(), 5);
+    EXPECT_EQ(writer.get_shard_count(), 3);
+  }
+
+  DatasetReader reader;
+  EXPECT_TRUE(reader.open(directory));
+  EXPECT_EQ(reader.get_record_count(), 5);
+
+  // Out of order, across shards.
+  for (const int& i : {4, 0, 3, 1, 2}) {
+    VisualShader visual_shader;
+    Image image;
+    EXPECT_TRUE(reader.read_record(i, visual_shader, image));
+    EXPECT_EQ(image.width, 8);
+    EXPECT_EQ(image.height, 4);
+    EXPECT_FLOAT_EQ(visual_shader.nodes(1).float_constant().value(), 0.2f * i);
+    EXPECT_NEAR(image.pixels.at(0), 0.2f * i, i % 2 == 0 ? 0.0f : 0.5f / 255.0f) << "Record " << i;
+  }
+
+  VisualShader visual_shader;
+  Image image;
+  EXPECT_FALSE(reader.read_record(5, visual_shader, image));
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(VisualShaderDatasetTest, TestGenerateDataset) {
+  const std::string directory{make_temp_directory("dataset_generate")};
+
+  DatasetOptions options;
+  options.record_count = 37;
+  options.image_size = 8;
+  options.max_node_count = 6;
+  options.max_shard_size = 4096;
+  options.chunk_size = 3;
+  options.seed = 11;
+
+  uint64_t last_count{0};
+  const std::atomic<bool> cancelled{false};
+  EXPECT_TRUE(generate_dataset(directory, options, cancelled, [&](const uint64_t& count) {
+    EXPECT_GT(count, last_count);
+    last_count = count;
+  }));
+  EXPECT_EQ(last_count, 37);
+
+  DatasetReader reader;
+  EXPECT_TRUE(reader.open(directory));
+  EXPECT_EQ(reader.get_record_count(), 37);
+  EXPECT_TRUE(std::filesystem::exists(get_dataset_shard_path(directory, 1)));
+
+  // A record only depends on the seed and its index, re-rendering its graph
+  // gives the same image.
+  VisualShader visual_shader;
+  Image image, expected;
+  EXPECT_TRUE(reader.read_record(20, visual_shader, image));
+  EXPECT_TRUE(render_shader(visual_shader, 8, 8, 0.0f, expected));
+  for (size_t i{0}; i < image.pixels.size(); i++) {
+    const float c{std::fmin(std::fmax(expected.pixels.at(i), 0.0f), 1.0f)};
+    EXPECT_NEAR(image.pixels.at(i), c, 0.5f / 255.0f + 1e-6f);
+  }
+
+  options.chunk_size = 1;
+  const std::string other_directory{make_temp_directory("dataset_generate_other")};
+  EXPECT_TRUE(generate_dataset(other_directory, options, cancelled, nullptr));
+
+  DatasetReader other_reader;
+  VisualShader other_visual_shader;
+  EXPECT_TRUE(other_reader.open(other_directory));
+  EXPECT_TRUE(other_reader.read_record(20, other_visual_shader, image));
+  EXPECT_EQ(other_visual_shader.SerializeAsString(), visual_shader.SerializeAsString());
+
+  std::filesystem::remove_all(directory);
+  std::filesystem::remove_all(other_directory);
+}
@@ -0,0 +1,209 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "evaluator/visual_shader_evaluator.hpp"
+#include "evaluator/vs_node_noise_evaluators.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+static VisualShader::VisualShaderNode* add_node(VisualShader& visual_shader, const int& id) {
+  VisualShader::VisualShaderNode* node{visual_shader.add_nodes()};
+  node->set_id(id);
+  return node;
+}
+
+static void add_connection(VisualShader& visual_shader, const int& from_node_id, const int& from_port_index,
+                           const int& to_node_id, const int& to_port_index) {
+  VisualShader::VisualShaderConnection* c{visual_shader.add_connections()};
+  c->set_id(visual_shader.connections_size() - 1);
+  c->set_from_node_id(from_node_id);
+  c->set_from_port_index(from_port_index);
+  c->set_to_node_id(to_node_id);
+  c->set_to_port_index(to_port_index);
+}
+
+TEST(VisualShaderEvaluatorTest, TestRenderShaderColorConstant) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+
+  VisualShaderNodeColorConstant* color{add_node(visual_shader, 1)->mutable_color_constant()};
+  color->set_r(0.25f);
+  color->set_g(0.5f);
+  color->set_b(0.75f);
+  color->set_a(1.0f);
+
+  add_connection(visual_shader, 1, 0, 0, 0);
+
+  Image image;
+  EXPECT_TRUE(render_shader(visual_shader, 4, 4, 0.0f, image));
+  EXPECT_EQ(image.width, 4);
+  EXPECT_EQ(image.height, 4);
+
+  const float* pixel{image.at(3, 2)};
+  EXPECT_FLOAT_EQ(pixel[0], 0.25f);
+  EXPECT_FLOAT_EQ(pixel[1], 0.5f);
+  EXPECT_FLOAT_EQ(pixel[2], 0.75f);
+  EXPECT_FLOAT_EQ(pixel[3], 1.0f);
+}
+
+TEST(VisualShaderEvaluatorTest, TestRenderShaderUnconnectedOutput) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+
+  Image image;
+  EXPECT_TRUE(render_shader(visual_shader, 2, 2, 0.0f, image));
+  for (const float& c : image.pixels) EXPECT_FLOAT_EQ(c, 0.0f);
+}
+
+TEST(VisualShaderEvaluatorTest, TestRenderShaderFloatOpAndConversion) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+
+  VisualShaderNodeFloatConstant* constant{add_node(visual_shader, 2)->mutable_float_constant()};
+  constant->set_value(2.0f);
+
+  add_node(visual_shader, 3)->mutable_float_op()->set_op(VisualShaderNodeFloatOp::OP_MUL);
+
+  // vec2 -> float takes the x component, float -> vec4 splats the value.
+  add_connection(visual_shader, 1, 0, 3, 0);
+  add_connection(visual_shader, 2, 0, 3, 1);
+  add_connection(visual_shader, 3, 0, 0, 0);
+
+  Image image;
+  EXPECT_TRUE(render_shader(visual_shader, 4, 4, 0.0f, image));
+
+  for (int x{0}; x < 4; x++) {
+    const float expected{(float(x) + 0.5f) / 4.0f * 2.0f};
+    const float* pixel{image.at(x, 1)};
+    for (int c{0}; c < 4; c++) EXPECT_FLOAT_EQ(pixel[c], expected);
+  }
+}
+
+TEST(VisualShaderEvaluatorTest, TestRenderShaderValueNoise) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  add_node(visual_shader, 2)->mutable_value_noise()->set_scale(100.0f);
+
+  add_connection(visual_shader, 1, 0, 2, 0);
+  add_connection(visual_shader, 2, 0, 0, 0);
+
+  Image image;
+  EXPECT_TRUE(render_shader(visual_shader, 8, 8, 0.0f, image));
+
+  // Row 0 is the top of the image, FragCoord.y is close to 1.0 there.
+  const float u{(2.0f + 0.5f) / 8.0f}, v{1.0f - (0.0f + 0.5f) / 8.0f};
+  const float expected{generate_value_noise_float(u, v, 100.0f)};
+  const float* pixel{image.at(2, 0)};
+  EXPECT_FLOAT_EQ(pixel[0], expected);
+  EXPECT_FLOAT_EQ(pixel[1], expected);
+  EXPECT_FLOAT_EQ(pixel[2], expected);
+  EXPECT_FLOAT_EQ(pixel[3], 1.0f);
+}
+
+TEST(VisualShaderEvaluatorTest, TestRenderShaderMatchesReference) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  add_node(visual_shader, 2)->mutable_perlin_noise()->set_scale(10.0f);
+  add_node(visual_shader, 3)->mutable_float_func()->set_func(VisualShaderNodeFloatFunc::FUNC_SIN);
+  add_node(visual_shader, 4)->mutable_mix()->set_type(VisualShaderNodePortType::PORT_TYPE_VECTOR_4D);
+  add_node(visual_shader, 5)->mutable_int_func()->set_func(VisualShaderNodeIntFunc::FUNC_NEGATE);
+
+  // Mixes into vec4 with conversions, a SIMD function and a per-lane fallback.
+  add_connection(visual_shader, 1, 0, 2, 0);
+  add_connection(visual_shader, 2, 0, 3, 0);
+  add_connection(visual_shader, 1, 0, 4, 0);
+  add_connection(visual_shader, 3, 0, 5, 0);
+  add_connection(visual_shader, 5, 0, 4, 1);
+  add_connection(visual_shader, 2, 0, 4, 2);
+  add_connection(visual_shader, 4, 0, 0, 0);
+
+  // Spans several tiles, with partial tiles and batches on the borders.
+  const int width{150}, height{37};
+
+  Image image;
+  EXPECT_TRUE(render_shader(visual_shader, width, height, 0.0f, image));
+
+  EvaluationGraph graph;
+  EXPECT_TRUE(to_evaluation_graph(visual_shader, 0, graph));
+
+  EvaluationState state;
+  make_evaluation_state(graph, state);
+
+  EvaluationContext context;
+  for (int y{0}; y < height; y++) {
+    for (int x{0}; x < width; x++) {
+      context.uv[0] = (float(x) + 0.5f) / float(width);
+      context.uv[1] = 1.0f - (float(y) + 0.5f) / float(height);
+      EXPECT_TRUE(evaluate_graph(graph, context, state));
+
+      const Value expected{get_input_value(graph, state, (int)graph.nodes.size() - 1, 0)};
+      for (int c{0}; c < 4; c++) EXPECT_FLOAT_EQ(image.at(x, y)[c], expected.f[c]);
+    }
+  }
+}
+
+TEST(VisualShaderEvaluatorTest, TestRenderPreviewShaderCompare) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  add_node(visual_shader, 2)->mutable_float_constant()->set_value(0.5f);
+
+  VisualShaderNodeCompare* compare{add_node(visual_shader, 3)->mutable_compare()};
+  compare->set_type(VisualShaderNodeCompare::CMP_TYPE_SCALAR);
+  compare->set_func(VisualShaderNodeCompare::FUNC_GREATER_THAN);
+
+  add_connection(visual_shader, 1, 0, 3, 0);
+  add_connection(visual_shader, 2, 0, 3, 1);
+
+  Image image;
+  EXPECT_TRUE(render_preview_shader(visual_shader, 3, 0, 4, 1, 0.0f, image));
+
+  EXPECT_FLOAT_EQ(image.at(0, 0)[0], 0.0f);
+  EXPECT_FLOAT_EQ(image.at(1, 0)[0], 0.0f);
+  EXPECT_FLOAT_EQ(image.at(2, 0)[0], 1.0f);
+  EXPECT_FLOAT_EQ(image.at(3, 0)[0], 1.0f);
+  EXPECT_FLOAT_EQ(image.at(3, 0)[3], 1.0f);
+}
+
+TEST(VisualShaderEvaluatorTest, TestRenderShaderCycle) {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_float_op()->set_op(VisualShaderNodeFloatOp::OP_ADD);
+  add_node(visual_shader, 2)->mutable_float_op()->set_op(VisualShaderNodeFloatOp::OP_ADD);
+
+  add_connection(visual_shader, 1, 0, 2, 0);
+  add_connection(visual_shader, 2, 0, 1, 0);
+  add_connection(visual_shader, 2, 0, 0, 0);
+
+  Image image;
+  EXPECT_FALSE(render_shader(visual_shader, 2, 2, 0.0f, image));
+}
@@ -0,0 +1,146 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "evaluator/visual_shader_evaluator.hpp"
+#include "evaluator/visual_shader_graph_search.hpp"
+#include "generator/utils/utils.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+static VisualShader make_output_only_graph() {
+  VisualShader visual_shader;
+  VisualShader::VisualShaderNode* output{visual_shader.add_nodes()};
+  output->set_id(0);
+  output->mutable_output();
+  return visual_shader;
+}
+
+TEST(VisualShaderGraphSearchTest, TestMutationsKeepGraphValid) {
+  VisualShader visual_shader{make_output_only_graph()};
+  std::mt19937 rng{42};
+
+  for (int i{0}; i < 300; i++) {
+    mutate_graph(visual_shader, 16, rng);
+    EXPECT_LE(visual_shader.nodes_size(), 16);
+
+    // Acyclic and every node feeds the output.
+    EvaluationGraph graph;
+    ASSERT_TRUE(to_evaluation_graph(visual_shader, 0, graph));
+    EXPECT_EQ((int)graph.nodes.size(), visual_shader.nodes_size());
+
+    for (const VisualShader::VisualShaderConnection& c : visual_shader.connections()) {
+      const EvaluationNode* from{nullptr};
+      const EvaluationNode* to{nullptr};
+      for (const EvaluationNode& e_node : graph.nodes) {
+        if (e_node.id == c.from_node_id()) from = &e_node;
+        if (e_node.id == c.to_node_id()) to = &e_node;
+      }
+      ASSERT_NE(from, nullptr);
+      ASSERT_NE(to, nullptr);
+      EXPECT_TRUE(generator_utils::is_valid_connection(from->output_port_types.at(c.from_port_index()),
+                                                       to->input_port_types.at(c.to_port_index())));
+    }
+  }
+}
+
+TEST(VisualShaderGraphSearchTest, TestSearchImprovesLoss) {
+  Image target{16, 16};
+  for (int y{0}; y < 16; y++) {
+    for (int x{0}; x < 16; x++) {
+      float* pixel{target.at(x, y)};
+      pixel[0] = 0.2f;
+      pixel[1] = (float(x) + 0.5f) / 16.0f;
+      pixel[2] = 0.8f;
+      pixel[3] = 1.0f;
+    }
+  }
+
+  GraphSearchOptions options;
+  options.population_size = 24;
+  options.generation_count = 15;
+  options.image_size = 16;
+  options.min_image_size = 8;  // Children are scored at 8x8 first.
+  options.tuning_iteration_count = 20;
+  options.seed = 7;
+
+  const VisualShader initial_graph{make_output_only_graph()};
+
+  Image scaled_target, image;
+  resize_image(target, 16, 16, scaled_target);
+  EXPECT_TRUE(render_shader(initial_graph, 16, 16, 0.0f, image));
+  const float initial_loss{compute_image_loss(image, scaled_target, ImageLossType::MSE)};
+
+  std::atomic<bool> cancelled{false};
+  int progress_count{0};
+  float last_loss{initial_loss};
+
+  VisualShader best_graph;
+  float best_loss;
+  EXPECT_TRUE(search_graph(
+      initial_graph, target, options, cancelled,
+      [&](const GraphSearchProgress& progress) {
+        EXPECT_EQ(progress.generation, progress_count++);
+        EXPECT_LE(progress.best_loss, last_loss);  // Elitism never loses the best candidate.
+        last_loss = progress.best_loss;
+      },
+      best_graph, best_loss));
+
+  EXPECT_EQ(progress_count, options.generation_count + 1);
+  EXPECT_LT(best_loss, initial_loss * 0.5f);
+  EXPECT_LE(best_loss, last_loss);  // Tuning only keeps better constants.
+
+  // The best loss is always measured at full resolution.
+  EXPECT_TRUE(render_shader(best_graph, 16, 16, 0.0f, image));
+  EXPECT_FLOAT_EQ(compute_image_loss(image, scaled_target, ImageLossType::MSE), best_loss);
+}
+
+TEST(VisualShaderGraphSearchTest, TestCancel) {
+  Image target{4, 4};
+
+  GraphSearchOptions options;
+  options.population_size = 8;
+  options.generation_count = 1000;
+  options.image_size = 4;
+
+  std::atomic<bool> cancelled{false};
+  int last_generation{-1};
+
+  VisualShader best_graph;
+  float best_loss;
+  EXPECT_TRUE(search_graph(
+      make_output_only_graph(), target, options, cancelled,
+      [&](const GraphSearchProgress& progress) {
+        last_generation = progress.generation;
+        if (progress.generation == 3) cancelled = true;
+      },
+      best_graph, best_loss));
+
+  EXPECT_EQ(last_generation, 3);
+  EXPECT_GE(best_graph.nodes_size(), 1);
+}
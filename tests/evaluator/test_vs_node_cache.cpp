@@ -0,0 +1,188 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "evaluator/visual_shader_node_cache.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+static VisualShader::VisualShaderNode* add_node(VisualShader& visual_shader, const int& id) {
+  VisualShader::VisualShaderNode* node{visual_shader.add_nodes()};
+  node->set_id(id);
+  return node;
+}
+
+static void add_connection(VisualShader& visual_shader, const int& from_node_id, const int& from_port_index,
+                           const int& to_node_id, const int& to_port_index) {
+  VisualShader::VisualShaderConnection* c{visual_shader.add_connections()};
+  c->set_id(visual_shader.connections_size() - 1);
+  c->set_from_node_id(from_node_id);
+  c->set_from_port_index(from_port_index);
+  c->set_to_node_id(to_node_id);
+  c->set_to_port_index(to_port_index);
+}
+
+// uv -> perlin -> sin -> mix(uv, ., perlin) -> output
+static VisualShader make_graph() {
+  VisualShader visual_shader;
+  add_node(visual_shader, 0)->mutable_output();
+  add_node(visual_shader, 1)->mutable_input()->set_type(VisualShaderNodeInputType::INPUT_TYPE_UV);
+  add_node(visual_shader, 2)->mutable_perlin_noise()->set_scale(10.0f);
+  add_node(visual_shader, 3)->mutable_float_func()->set_func(VisualShaderNodeFloatFunc::FUNC_SIN);
+  add_node(visual_shader, 4)->mutable_mix()->set_type(VisualShaderNodePortType::PORT_TYPE_VECTOR_4D);
+
+  add_connection(visual_shader, 1, 0, 2, 0);
+  add_connection(visual_shader, 2, 0, 3, 0);
+  add_connection(visual_shader, 1, 0, 4, 0);
+  add_connection(visual_shader, 3, 0, 4, 1);
+  add_connection(visual_shader, 2, 0, 4, 2);
+  add_connection(visual_shader, 4, 0, 0, 0);
+  return visual_shader;
+}
+
+TEST(VisualShaderNodeCacheTest, TestSubgraphKeys) {
+  VisualShader a{make_graph()}, b{make_graph()};
+
+  // Ids and positions do not matter.
+  for (int i{0}; i < b.nodes_size(); i++) b.mutable_nodes(i)->set_x_coordinate(10.0f * i);
+
+  EvaluationGraph graph_a, graph_b;
+  EXPECT_TRUE(to_evaluation_graph(a, 0, graph_a));
+  EXPECT_TRUE(to_evaluation_graph(b, 0, graph_b));
+
+  std::vector<std::string> keys_a, keys_b;
+  std::vector<uint64_t> hashes_a, hashes_b;
+  get_subgraph_keys(graph_a, 0.0f, keys_a, hashes_a);
+  get_subgraph_keys(graph_b, 0.0f, keys_b, hashes_b);
+  EXPECT_EQ(hashes_a, hashes_b);
+
+  // Changing the noise changes its hash and the hashes downstream, not the UV.
+  b.mutable_nodes(2)->mutable_perlin_noise()->set_scale(20.0f);
+  get_subgraph_keys(graph_b, 0.0f, keys_b, hashes_b);
+  for (size_t i{0}; i < graph_b.nodes.size(); i++) {
+    const bool is_uv{graph_b.nodes.at(i).id == 1};
+    EXPECT_EQ(hashes_a.at(i) == hashes_b.at(i), is_uv) << "Node " << graph_b.nodes.at(i).id;
+  }
+
+  // The time is only part of the keys that depend on it.
+  get_subgraph_keys(graph_a, 1.0f, keys_b, hashes_b);
+  EXPECT_EQ(hashes_a, hashes_b);
+}
+
+TEST(VisualShaderNodeCacheTest, TestRenderShaderCachedMatchesRenderShader) {
+  const VisualShader visual_shader{make_graph()};
+
+  // Partial batches at the end of each row.
+  const int width{37}, height{9};
+
+  Image expected, image;
+  EXPECT_TRUE(render_shader(visual_shader, width, height, 0.0f, expected));
+
+  NodeImageCache cache;
+  EXPECT_TRUE(render_shader_cached(visual_shader, width, height, 0.0f, cache, image));
+  EXPECT_EQ(image.pixels, expected.pixels);
+  EXPECT_EQ(cache.get_size(), 4);
+
+  // A second render is served from the cache.
+  std::fill(image.pixels.begin(), image.pixels.end(), 0.0f);
+  EXPECT_TRUE(render_shader_cached(visual_shader, width, height, 0.0f, cache, image));
+  EXPECT_EQ(image.pixels, expected.pixels);
+  EXPECT_EQ(cache.get_hit_count(), 1);  // Only the node feeding the output was looked up.
+}
+
+TEST(VisualShaderNodeCacheTest, TestMutationOnlyEvaluatesConsumers) {
+  VisualShader visual_shader{make_graph()};
+
+  NodeImageCache cache;
+  Image image;
+  EXPECT_TRUE(render_shader_cached(visual_shader, 16, 16, 0.0f, cache, image));
+  EXPECT_EQ(cache.get_size(), 4);
+
+  // Only the function and the mix consuming it are evaluated again.
+  visual_shader.mutable_nodes(3)->mutable_float_func()->set_func(VisualShaderNodeFloatFunc::FUNC_COS);
+  EXPECT_TRUE(render_shader_cached(visual_shader, 16, 16, 0.0f, cache, image));
+  EXPECT_EQ(cache.get_size(), 6);
+
+  Image expected;
+  EXPECT_TRUE(render_shader(visual_shader, 16, 16, 0.0f, expected));
+  EXPECT_EQ(image.pixels, expected.pixels);
+
+  // Another resolution is another entry.
+  EXPECT_TRUE(render_shader_cached(visual_shader, 8, 8, 0.0f, cache, image));
+  EXPECT_EQ(cache.get_size(), 10);
+}
+
+TEST(VisualShaderNodeCacheTest, TestConstantNodesAreEvaluatedOnce) {
+  VisualShader visual_shader{make_graph()};
+
+  // sin(0.5) instead of sin(perlin).
+  add_node(visual_shader, 5)->mutable_float_constant()->set_value(0.5f);
+  visual_shader.mutable_connections(1)->set_from_node_id(5);
+
+  NodeImageCache cache;
+  Image image, expected;
+  EXPECT_TRUE(render_shader_cached(visual_shader, 37, 9, 0.0f, cache, image));
+  EXPECT_TRUE(render_shader(visual_shader, 37, 9, 0.0f, expected));
+  EXPECT_EQ(image.pixels, expected.pixels);
+
+  EvaluationGraph graph;
+  EXPECT_TRUE(to_evaluation_graph(visual_shader, 0, graph));
+  std::vector<std::string> keys;
+  std::vector<uint64_t> hashes;
+  get_subgraph_keys(graph, 0.0f, keys, hashes);
+
+  for (size_t i{0}; i + 1 < graph.nodes.size(); i++) {
+    const std::shared_ptr<const NodeImages> images{cache.get_images(keys.at(i), hashes.at(i), 37, 9)};
+    ASSERT_TRUE(images) << "Node " << graph.nodes.at(i).id;
+
+    const int id{graph.nodes.at(i).id};
+    const bool is_constant{id == 3 || id == 5};
+    EXPECT_EQ(images->is_constant, is_constant) << "Node " << id;
+    EXPECT_EQ(images->ports.at(0).size(), is_constant ? 1 : 9 * 3) << "Node " << id;
+  }
+}
+
+TEST(VisualShaderNodeCacheTest, TestCapacity) {
+  const VisualShader visual_shader{make_graph()};
+
+  NodeImageCache unbounded;
+  Image image;
+  EXPECT_TRUE(render_shader_cached(visual_shader, 16, 16, 0.0f, unbounded, image));
+
+  // Room for a bit more than 2 of the 4 images, the least recently used go first.
+  NodeImageCache cache{unbounded.get_byte_size() / 2 + 1};
+  EXPECT_TRUE(render_shader_cached(visual_shader, 16, 16, 0.0f, cache, image));
+  EXPECT_EQ(cache.get_size(), 2);
+  EXPECT_LE(cache.get_byte_size(), unbounded.get_byte_size() / 2 + 1);
+
+  cache.clear();
+  EXPECT_EQ(cache.get_size(), 0);
+  EXPECT_EQ(cache.get_byte_size(), 0);
+}
@@ -0,0 +1,99 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "evaluator/utils/thread_pool.hpp"
+
+using namespace evaluator_utils;
+
+TEST(ThreadPoolTest, TestRunsEveryTaskOnce) {
+  ThreadPool pool{4};
+  EXPECT_EQ(pool.get_thread_count(), 4);
+
+  const int task_count{1000};
+  std::vector<std::atomic<int>> runs(task_count);
+  std::atomic<bool> valid_thread_indices{true};
+
+  // Run twice to make sure the workers pick up the next job.
+  for (int i{0}; i < 2; i++) {
+    pool.run(task_count, [&](const int& task_index, const int& thread_index) {
+      if (thread_index < 0 || thread_index >= pool.get_thread_count()) valid_thread_indices = false;
+      runs.at(task_index)++;
+    });
+  }
+
+  EXPECT_TRUE(valid_thread_indices);
+  for (const std::atomic<int>& r : runs) EXPECT_EQ(r.load(), 2);
+}
+
+TEST(ThreadPoolTest, TestUnevenTasks) {
+  ThreadPool pool{3};
+
+  // All the expensive tasks start in the first thread's range, the others
+  // have to steal them.
+  const int task_count{64};
+  std::atomic<int> sum{0};
+  pool.run(task_count, [&](const int& task_index, const int&) {
+    if (task_index < task_count / 3) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    sum += task_index;
+  });
+
+  EXPECT_EQ(sum.load(), task_count * (task_count - 1) / 2);
+}
+
+TEST(ThreadPoolTest, TestSingleThread) {
+  ThreadPool pool{0};
+  EXPECT_EQ(pool.get_thread_count(), 1);
+
+  int count{0};
+  pool.run(10, [&](const int&, const int& thread_index) {
+    EXPECT_EQ(thread_index, 0);
+    count++;
+  });
+  EXPECT_EQ(count, 10);
+
+  pool.run(0, [&](const int&, const int&) { count++; });
+  EXPECT_EQ(count, 10);
+}
+
+TEST(ThreadPoolTest, TestNestedRun) {
+  ThreadPool pool{4};
+
+  std::atomic<int> count{0};
+  pool.run(8, [&](const int&, const int&) {
+    pool.run(8, [&](const int&, const int& thread_index) {
+      EXPECT_EQ(thread_index, 0);
+      count++;
+    });
+  });
+  EXPECT_EQ(count.load(), 64);
+}
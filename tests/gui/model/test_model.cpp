@@ -27,10 +27,18 @@
 
 #include <gtest/gtest.h>
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/util/json_util.h>
 #include <QSignalSpy>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 #include "error_macros.hpp"
 #include "gui/model/message_model.hpp"
+#include "gui/model/model_autosaver.hpp"
+#include "gui/model/model_journal_file.hpp"
+#include "gui/model/oneof_model.hpp"
 #include "gui/model/primitive_model.hpp"
 #include "gui/model/repeated_message_model.hpp"
 #include "gui/model/repeated_primitive_model.hpp"
@@ -446,6 +454,170 @@ TEST(MessageModelTest, TestAddRemoveRow) {
   delete model;  // For the AddressSanitizer to not complain about memory leaks
 }
 
+TEST(MessageModelTest, TestFindRow) {
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  RepeatedMessageModel* employees = dynamic_cast<RepeatedMessageModel*>(const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber)))));
+  ASSERT_TRUE(employees);
+
+  auto set_id = [&](const int& row, const int& id) {
+    ASSERT_TRUE(model->set_data(
+        FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber),
+                                              FieldPath::RepeatedAt(row), FieldPath::FieldNumber(Person::kIdFieldNumber)),
+        id));
+  };
+
+  // Index the rows before they change.
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 10), -1);
+
+  for (int i{0}; i < 4; i++) {
+    ASSERT_EQ(employees->append_row(), i);
+    set_id(i, 10 * (i + 1));
+  }
+  for (int i{0}; i < 4; i++) ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 10 * (i + 1)), i);
+
+  // The last row takes the place of the removed one.
+  ASSERT_TRUE(employees->remove_row(1));
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 20), -1);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 40), 1);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 30), 2);
+
+  ASSERT_TRUE(employees->remove_row(2));
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 30), -1);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 40), 1);
+
+  set_id(0, 50);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 10), -1);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 50), 0);
+
+  // A new row has the default id until it is set.
+  ASSERT_EQ(employees->append_row(), 2);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 0), 2);
+  set_id(2, 60);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 0), -1);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 60), 2);
+
+  // Only integer fields can be looked up.
+  ASSERT_EQ(employees->find_row(Person::kNameFieldNumber, 0), -1);
+
+  // A compiled path is reused for every row.
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+  for (int i{0}; i < employees->rowCount(); i++) {
+    ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, model->data(id_path.bind(i)).toInt()), i);
+  }
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestReserveKeys) {
+  OrganizationTestSchema org;
+  for (const int& id : {3, 7, 5}) org.add_employees()->set_id(id);
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  RepeatedMessageModel* employees = dynamic_cast<RepeatedMessageModel*>(const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber)))));
+  ASSERT_TRUE(employees);
+
+  // Above the ids already there.
+  ASSERT_EQ(employees->reserve_keys(Person::kIdFieldNumber), 8);
+  ASSERT_EQ(employees->reserve_keys(Person::kIdFieldNumber, 4), 9);
+  ASSERT_EQ(employees->reserve_keys(Person::kIdFieldNumber), 13);
+
+  // Removed ids are not handed out again.
+  ASSERT_TRUE(employees->remove_row(1));
+  ASSERT_EQ(employees->reserve_keys(Person::kIdFieldNumber), 14);
+
+  // An id set by hand moves the next one past it.
+  ASSERT_EQ(employees->append_row(), 2);
+  ASSERT_TRUE(model->set_data(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber),
+                                            FieldPath::RepeatedAt(2), FieldPath::FieldNumber(Person::kIdFieldNumber)),
+      100));
+  ASSERT_EQ(employees->reserve_keys(Person::kIdFieldNumber), 101);
+  ASSERT_EQ(employees->reserve_keys(Person::kIdFieldNumber, 1, 200), 200);
+  ASSERT_EQ(employees->reserve_keys(Person::kIdFieldNumber), 201);
+
+  ASSERT_EQ(employees->reserve_keys(Person::kIdFieldNumber, 0), -1);
+  ASSERT_EQ(employees->reserve_keys(Person::kNameFieldNumber), -1);
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestLazySubModels) {
+  OrganizationTestSchema org;
+  for (int i{0}; i < 100; i++) org.add_employees()->set_id(i);
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  RepeatedMessageModel* employees = dynamic_cast<RepeatedMessageModel*>(const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber)))));
+  ASSERT_TRUE(employees);
+  ASSERT_EQ(employees->rowCount(), 100);
+
+  // A row is created once, on first access.
+  const MessageModel* row{employees->get_sub_model(42)};
+  ASSERT_TRUE(row);
+  ASSERT_EQ(employees->get_sub_model(42), row);
+  ASSERT_EQ(row->get_sub_model(Person::kIdFieldNumber), row->get_sub_model(Person::kIdFieldNumber));
+
+  // Rows that were never accessed can be removed, the accessed one keeps its data.
+  ASSERT_TRUE(employees->remove_row(0));
+  ASSERT_TRUE(employees->remove_row(1));
+  ASSERT_EQ(employees->get_sub_model(42), row);
+  ASSERT_EQ(row->get_index_in_parent(), 42);
+  ASSERT_EQ(model->data(FieldPath::Of<OrganizationTestSchema>(
+                            FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(0),
+                            FieldPath::FieldNumber(Person::kIdFieldNumber)))
+                .toInt(),
+            99);
+  ASSERT_EQ(model->data(FieldPath::Of<OrganizationTestSchema>(
+                            FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(1),
+                            FieldPath::FieldNumber(Person::kIdFieldNumber)))
+                .toInt(),
+            98);
+
+  // Reading a field of an unset message leaves it unset, setting the field
+  // sets the message.
+  const CompiledFieldPath city_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kHomeAddressFieldNumber), FieldPath::FieldNumber(Address::kCityFieldNumber))};
+  ASSERT_EQ(model->data(city_path.bind(5)).toString(), "");
+  ASSERT_FALSE(org.employees(5).has_home_address());
+  ASSERT_TRUE(model->set_data(city_path.bind(5), "Alexandria"));
+  ASSERT_TRUE(org.employees(5).has_home_address());
+  ASSERT_EQ(org.employees(5).home_address().city(), "Alexandria");
+  ASSERT_EQ(model->data(city_path.bind(5)).toString(), "Alexandria");
+  ASSERT_FALSE(org.employees(6).has_home_address());
+
+  // Loading again replaces the sub-models, with the row indices.
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 50), 50);
+  OrganizationTestSchema other;
+  for (int i{0}; i < 3; i++) other.add_employees()->set_id(1000 + i);
+  std::string data;
+  ASSERT_TRUE(ProtoModel::serialize_to_binary(other, data));
+  ASSERT_TRUE(model->loadFromData(data.data(), data.size()));
+
+  employees = dynamic_cast<RepeatedMessageModel*>(const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber)))));
+  ASSERT_TRUE(employees);
+  ASSERT_EQ(employees->rowCount(), 3);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 50), -1);
+  ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 1001), 1);
+  ASSERT_EQ(model->data(city_path.bind(1)).toString(), "");
+  ASSERT_FALSE(org.employees(1).has_home_address());
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
 TEST(MessageModelTest, TestOneofModel) {
   OrganizationTestSchema org;
 
@@ -604,3 +776,953 @@ TEST(MessageModelTest, TestDataChangedSignalPrimitiveModel) {
 
   delete model;  // For the AddressSanitizer to not complain about memory leaks
 }
+
+TEST(MessageModelTest, TestBatchedChanges) {
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  RepeatedMessageModel* employees = dynamic_cast<RepeatedMessageModel*>(const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber)))));
+  ASSERT_TRUE(employees);
+
+  QSignalSpy model_spy(model, &ProtoModel::dataChanged);
+  QSignalSpy employees_spy(employees, &ProtoModel::dataChanged);
+
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+  const CompiledFieldPath number_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kPreferredPhoneFieldNumber), FieldPath::FieldNumber(PhoneNumber::kNumberFieldNumber))};
+
+  {
+    ProtoModel::BatchGuard batch{model};
+    for (int i{0}; i < 10; i++) {
+      const int row{employees->append_row()};
+      ASSERT_TRUE(model->set_data(id_path.bind(row), 100 + i));
+
+      // Nested batches only notify once the outermost one ends.
+      ProtoModel::BatchGuard nested_batch{employees};
+      ASSERT_TRUE(model->set_data(number_path.bind(row), "555"));
+      ASSERT_TRUE(model->set_data(number_path.bind(row), "555-1234"));
+    }
+
+    ASSERT_TRUE(employees->is_in_batch());
+    ASSERT_EQ(model_spy.count(), 0);
+    ASSERT_EQ(employees_spy.count(), 0);
+
+    // The row indices are kept up to date within the batch.
+    ASSERT_EQ(employees->find_row(Person::kIdFieldNumber, 107), 7);
+  }
+
+  ASSERT_FALSE(model->is_in_batch());
+  ASSERT_EQ(employees_spy.count(), 0);
+  ASSERT_EQ(model_spy.count(), 1);
+  QList<QVariant> arguments = model_spy.takeFirst();
+  ASSERT_EQ(arguments.at(0).value<QModelIndex>(), model->index(0, 1));  // Column of employees
+  ASSERT_EQ(arguments.at(1).value<QModelIndex>(), model->index(0, 1));
+
+  // The rows, then the id and the phone number of each row, once.
+  const std::vector<FieldPath> paths{model->get_batch_changed_paths()};
+  ASSERT_EQ(paths.size(), 21);
+  ASSERT_EQ(paths.at(0).to_string(), employees->get_path().to_string());
+  ASSERT_EQ(paths.at(1).to_string(), id_path.bind(0).to_string());
+  ASSERT_EQ(paths.at(2).to_string(), number_path.bind(0).to_string());
+  ASSERT_EQ(paths.at(20).to_string(), number_path.bind(9).to_string());
+  ASSERT_EQ(model->data(paths.at(20)).toString(), "555-1234");
+
+  // Outside of a batch every change notifies again.
+  ASSERT_TRUE(model->set_data(id_path.bind(0), 1));
+  ASSERT_EQ(model_spy.count(), 1);
+  ASSERT_EQ(employees_spy.count(), 1);
+
+  // A batch without changes doesn't notify.
+  model->begin_batch();
+  model->end_batch();
+  ASSERT_EQ(model_spy.count(), 1);
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestTypedAccess) {
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  ProtoModel* employees = const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber))));
+  const int row{employees->append_row()};
+
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+  const CompiledFieldPath salary_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmploymentDetailsFieldNumber),
+      FieldPath::FieldNumber(EmploymentDetails::kAnnualSalaryFieldNumber))};
+  const CompiledFieldPath type_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kPreferredPhoneFieldNumber), FieldPath::FieldNumber(PhoneNumber::kTypeFieldNumber))};
+  const CompiledFieldPath name_path{
+      CompiledFieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kNameFieldNumber))};
+
+  QSignalSpy model_spy(model, &ProtoModel::dataChanged);
+  ASSERT_TRUE(model_spy.isValid());
+
+  // Unset fields read as their default value.
+  int32_t id{-1};
+  ASSERT_TRUE(model->get(id_path.bind(row), id));
+  ASSERT_EQ(id, 0);
+
+  ASSERT_TRUE(model->set(id_path.bind(row), int32_t{7}));
+  ASSERT_TRUE(model->get(id_path.bind(row), id));
+  ASSERT_EQ(id, 7);
+  ASSERT_EQ(org.employees(row).id(), 7);
+  ASSERT_EQ(model->data(id_path.bind(row)).toInt(), 7);
+
+  // Oneofs on the way are set.
+  ASSERT_TRUE(model->set(salary_path.bind(row), 1234.5));
+  double salary{0.0};
+  ASSERT_TRUE(model->get(salary_path.bind(row), salary));
+  ASSERT_DOUBLE_EQ(salary, 1234.5);
+  ASSERT_DOUBLE_EQ(org.employees(row).employment_details().annual_salary(), 1234.5);
+
+  // Enums are int32_t and must hold a valid value.
+  ASSERT_TRUE(model->set(type_path.bind(row), int32_t{PhoneNumber::WORK}));
+  ASSERT_EQ(org.employees(row).preferred_phone().type(), PhoneNumber::WORK);
+  ASSERT_FALSE(model->set(type_path.bind(row), int32_t{42}));
+
+  ASSERT_TRUE(model->set(name_path.bind(), std::string{"Org"}));
+  std::string name;
+  ASSERT_TRUE(model->get(name_path.bind(), name));
+  ASSERT_EQ(name, "Org");
+
+  // The type must match the field.
+  ASSERT_FALSE(model->set(id_path.bind(row), 7.0));
+  ASSERT_FALSE(model->get(salary_path.bind(row), id));
+  ASSERT_EQ(org.employees(row).id(), 7);
+
+  // Same notifications as set_data().
+  const int count{model_spy.count()};
+  ASSERT_TRUE(model->set_data(salary_path.bind(row), 1.0));
+  const int set_data_count{model_spy.count() - count};
+  ASSERT_GT(set_data_count, 0);
+  ASSERT_TRUE(model->set(salary_path.bind(row), 2.0));
+  ASSERT_EQ(model_spy.count() - count, 2 * set_data_count);
+
+  // Recorded like set_data(), setting the same value again is not a change.
+  model->set_journal_capacity(8);
+  const uint64_t sequence{model->get_journal_sequence()};
+  ASSERT_TRUE(model->set(id_path.bind(row), int32_t{7}));
+  ASSERT_EQ(model->get_journal_sequence(), sequence);
+
+  ASSERT_TRUE(model->set(name_path.bind(), std::string{"Other"}));
+  std::vector<ModelChange> changes;
+  ASSERT_TRUE(model->read_journal(sequence, changes));
+  ASSERT_EQ(changes.size(), 1);
+  ASSERT_EQ(changes.at(0).old_value, QVariant(QString("Org")));
+  ASSERT_EQ(changes.at(0).new_value, model->data(name_path.bind()));
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestModelJournal) {
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  ProtoModel* employees = const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber))));
+
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+  const CompiledFieldPath company_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kCompanyFieldNumber))};
+  const CompiledFieldPath salary_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmploymentDetailsFieldNumber),
+      FieldPath::FieldNumber(EmploymentDetails::kAnnualSalaryFieldNumber))};
+  const CompiledFieldPath employee_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt())};
+  const CompiledFieldPath emails_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmailsFieldNumber))};
+
+  // Off by default.
+  std::vector<ModelChange> changes;
+  ASSERT_EQ(model->get_journal_sequence(), 0);
+  ASSERT_FALSE(model->read_journal(0, changes));
+
+  employees->set_journal_capacity(64);  // Any model of the tree
+  const uint64_t start{model->get_journal_sequence()};
+  ASSERT_EQ(start, 0);
+
+  const int row{employees->append_row()};
+  ASSERT_TRUE(model->set(id_path.bind(row), int32_t{7}));
+  ASSERT_TRUE(model->set_data(id_path.bind(row), 8));
+  ASSERT_TRUE(model->set_data(company_path.bind(row), "Company"));
+  ASSERT_TRUE(model->set_data(salary_path.bind(row), 1234.5));
+
+  ASSERT_TRUE(model->read_journal(start, changes));
+  ASSERT_EQ(changes.size(), 8);
+  for (size_t i{0}; i < changes.size(); i++) ASSERT_EQ(changes.at(i).sequence, start + i + 1);
+
+  ASSERT_EQ(changes.at(0).type, ModelChange::Type::INSERT_ROW);
+  ASSERT_EQ(changes.at(0).path.to_string(), employees->get_path().to_string());
+  ASSERT_EQ(changes.at(0).row, row);
+
+  // Unset fields have no old value.
+  ASSERT_EQ(changes.at(1).type, ModelChange::Type::SET_FIELD);
+  ASSERT_EQ(changes.at(1).path.to_string(), id_path.bind(row).to_string());
+  ASSERT_FALSE(changes.at(1).old_value.isValid());
+  ASSERT_EQ(changes.at(1).new_value.toInt(), 7);
+  ASSERT_EQ(changes.at(2).old_value.toInt(), 7);
+  ASSERT_EQ(changes.at(2).new_value.toInt(), 8);
+
+  // Switching a oneof, then setting the field.
+  ASSERT_EQ(changes.at(3).type, ModelChange::Type::SET_ONEOF);
+  ASSERT_EQ(changes.at(3).path.to_string(), employee_path.bind(row).to_string());
+  ASSERT_EQ(changes.at(3).old_field_number, -1);
+  ASSERT_EQ(changes.at(3).new_field_number, Person::kCompanyFieldNumber);
+  ASSERT_EQ(changes.at(4).type, ModelChange::Type::SET_FIELD);
+  ASSERT_EQ(changes.at(4).new_value.toString(), "Company");
+
+  // The old field of a switched oneof is kept.
+  ASSERT_EQ(changes.at(5).type, ModelChange::Type::SET_ONEOF);
+  ASSERT_EQ(changes.at(5).old_field_number, Person::kCompanyFieldNumber);
+  ASSERT_EQ(changes.at(5).new_field_number, Person::kEmploymentDetailsFieldNumber);
+  ASSERT_EQ(changes.at(5).old_value.toString(), "Company");
+  ASSERT_EQ(changes.at(6).type, ModelChange::Type::SET_ONEOF);
+  ASSERT_EQ(changes.at(6).new_field_number, EmploymentDetails::kAnnualSalaryFieldNumber);
+  ASSERT_EQ(changes.at(7).type, ModelChange::Type::SET_FIELD);
+  ASSERT_EQ(changes.at(7).path.to_string(), salary_path.bind(row).to_string());
+
+  // Removed rows are kept.
+  ProtoModel* emails = const_cast<ProtoModel*>(model->get_sub_model(emails_path.bind(row)));
+  const int email_row{emails->append_row()};
+  ASSERT_TRUE(emails->setData(emails->index(email_row, 0), "a@b.c"));
+  ASSERT_TRUE(emails->remove_row(email_row));
+  ASSERT_TRUE(employees->remove_row(row));
+
+  const uint64_t last_seen{changes.back().sequence};
+  changes.clear();
+  ASSERT_TRUE(model->read_journal(last_seen, changes));
+  ASSERT_EQ(changes.size(), 4);
+  ASSERT_EQ(changes.at(2).type, ModelChange::Type::REMOVE_ROW);
+  ASSERT_EQ(changes.at(2).old_value.toString(), "a@b.c");
+  ASSERT_EQ(changes.at(3).type, ModelChange::Type::REMOVE_ROW);
+  ASSERT_EQ(changes.at(3).row, row);
+
+  Person removed;
+  ASSERT_TRUE(removed.ParseFromString(changes.at(3).old_message));
+  ASSERT_EQ(removed.id(), 8);
+  ASSERT_DOUBLE_EQ(removed.employment_details().annual_salary(), 1234.5);
+
+  // Nothing new.
+  changes.clear();
+  ASSERT_TRUE(model->read_journal(model->get_journal_sequence(), changes));
+  ASSERT_TRUE(changes.empty());
+
+  // Overwritten changes can't be read anymore.
+  model->set_journal_capacity(2);
+  ASSERT_FALSE(model->read_journal(start, changes));
+  ASSERT_TRUE(model->read_journal(model->get_journal_sequence() - 2, changes));
+  ASSERT_EQ(changes.size(), 2);
+  ASSERT_EQ(changes.at(1).sequence, model->get_journal_sequence());
+
+  ASSERT_TRUE(model->set_data(FieldPath::Of<OrganizationTestSchema>(
+                                  FieldPath::FieldNumber(OrganizationTestSchema::kNameFieldNumber)),
+                              "Org"));
+  changes.clear();
+  ASSERT_TRUE(model->read_journal(model->get_journal_sequence() - 2, changes));
+  ASSERT_EQ(changes.size(), 2);
+  ASSERT_EQ(changes.at(1).new_value.toString(), "Org");
+
+  model->set_journal_capacity(0);
+  ASSERT_FALSE(model->read_journal(0, changes));
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestUndoRedo) {
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  ProtoModel* employees = const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber))));
+
+  const CompiledFieldPath name_path{
+      CompiledFieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kNameFieldNumber))};
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+  const CompiledFieldPath company_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kCompanyFieldNumber))};
+  const CompiledFieldPath job_title_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kJobTitleFieldNumber))};
+  const CompiledFieldPath emails_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmailsFieldNumber))};
+
+  // Off by default.
+  ASSERT_EQ(model->get_undo_stack(), nullptr);
+
+  employees->set_undo_byte_budget(1 << 20);  // Any model of the tree
+  ModelUndoStack* undo_stack{model->get_undo_stack()};
+  ASSERT_NE(undo_stack, nullptr);
+  ASSERT_FALSE(undo_stack->can_undo());
+  ASSERT_FALSE(undo_stack->undo());
+
+  // Consecutive sets of the same field are a single step until sealed.
+  ASSERT_TRUE(model->set_data(name_path.bind(), "A"));
+  ASSERT_TRUE(model->set_data(name_path.bind(), "B"));
+  ASSERT_EQ(undo_stack->get_undo_count(), 1);
+  undo_stack->seal();
+  ASSERT_TRUE(model->set_data(name_path.bind(), "C"));
+  ASSERT_EQ(undo_stack->get_undo_count(), 2);
+
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_EQ(org.name(), "B");
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_TRUE(org.name().empty());
+  ASSERT_FALSE(undo_stack->can_undo());
+  ASSERT_EQ(undo_stack->get_redo_count(), 2);
+
+  ASSERT_TRUE(undo_stack->redo());
+  ASSERT_EQ(org.name(), "B");
+  ASSERT_TRUE(undo_stack->redo());
+  ASSERT_EQ(org.name(), "C");
+  ASSERT_FALSE(undo_stack->can_redo());
+
+  // A new change drops the undone steps.
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_TRUE(model->set_data(name_path.bind(), "D"));
+  ASSERT_FALSE(undo_stack->can_redo());
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_EQ(org.name(), "B");
+
+  // A batch is a single step, the changes inside the new rows come back with them.
+  const int undo_count{undo_stack->get_undo_count()};
+  {
+    ProtoModel::BatchGuard batch{model};
+    for (int i{0}; i < 3; i++) {
+      const int row{employees->append_row()};
+      ASSERT_TRUE(model->set_data(id_path.bind(row), i + 1));
+      ASSERT_TRUE(model->set_data(company_path.bind(row), QString::fromStdString("Company " + std::to_string(i + 1))));
+    }
+    ASSERT_FALSE(undo_stack->undo());  // Not while a batch is open
+  }
+  ASSERT_EQ(undo_stack->get_undo_count(), undo_count + 1);
+
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_EQ(org.employees_size(), 0);
+  ASSERT_TRUE(undo_stack->redo());
+  ASSERT_EQ(org.employees_size(), 3);
+  ASSERT_EQ(org.employees(2).id(), 3);
+  ASSERT_EQ(org.employees(2).company(), "Company 3");
+  ASSERT_EQ(model->data(company_path.bind(2)).toString(), "Company 3");
+
+  // Removed rows come back at their position.
+  ASSERT_TRUE(employees->remove_row(0));
+  ASSERT_EQ(org.employees(0).id(), 3);
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_EQ(org.employees_size(), 3);
+  for (int i{0}; i < 3; i++) ASSERT_EQ(model->data(id_path.bind(i)).toInt(), i + 1);
+  ASSERT_TRUE(undo_stack->redo());
+  ASSERT_EQ(org.employees_size(), 2);
+  ASSERT_EQ(model->data(id_path.bind(0)).toInt(), 3);
+  ASSERT_TRUE(undo_stack->undo());
+
+  // The old field of a oneof comes back with its value.
+  ASSERT_TRUE(model->set_data(job_title_path.bind(1), "Engineer"));
+  ASSERT_EQ(org.employees(1).employment_case(), Person::kJobTitle);
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_EQ(org.employees(1).employment_case(), Person::kCompany);
+  ASSERT_EQ(model->data(company_path.bind(1)).toString(), "Company 2");
+  ASSERT_TRUE(undo_stack->redo());
+  ASSERT_EQ(model->data(job_title_path.bind(1)).toString(), "Engineer");
+
+  // Only the rows are kept for a bulk append, not every value set in them.
+  ProtoModel* emails = const_cast<ProtoModel*>(model->get_sub_model(emails_path.bind(0)));
+  const size_t byte_size{undo_stack->get_byte_size()};
+  {
+    ProtoModel::BatchGuard batch{model};
+    for (int i{0}; i < 1000; i++) {
+      const int row{emails->append_row()};
+      ASSERT_TRUE(emails->setData(emails->index(row, 0), QString::fromStdString(std::to_string(i) + "@b.c")));
+    }
+  }
+  const size_t bulk_byte_size{undo_stack->get_byte_size() - byte_size};
+  ASSERT_EQ(org.employees(0).emails_size(), 1000);
+
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_EQ(org.employees(0).emails_size(), 0);
+  ASSERT_TRUE(undo_stack->redo());
+  ASSERT_EQ(org.employees(0).emails_size(), 1000);
+  ASSERT_EQ(org.employees(0).emails(999), "999@b.c");
+
+  // The redo step keeps the values, the undo step only the rows.
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_GT(undo_stack->get_byte_size() - byte_size, bulk_byte_size);
+  ASSERT_TRUE(undo_stack->redo());
+
+  // The oldest steps are dropped to fit the budget, the latest is kept.
+  const int count{undo_stack->get_undo_count()};
+  ASSERT_GT(count, 1);
+  model->set_undo_byte_budget(1);
+  ASSERT_EQ(undo_stack->get_undo_count(), 1);
+  ASSERT_TRUE(undo_stack->undo());
+  ASSERT_EQ(org.employees(0).emails_size(), 0);
+  ASSERT_FALSE(undo_stack->can_undo());
+
+  model->set_undo_byte_budget(0);
+  ASSERT_EQ(model->get_undo_stack(), nullptr);
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestSnapshots) {
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  ProtoModel* employees = const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber))));
+
+  const CompiledFieldPath name_path{
+      CompiledFieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kNameFieldNumber))};
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+  const CompiledFieldPath company_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kCompanyFieldNumber))};
+
+  // More rows than a chunk.
+  const int row_count{MODEL_SNAPSHOT_CHUNK_SIZE * 2 + 10};
+  for (int i{0}; i < row_count; i++) {
+    const int row{employees->append_row()};
+    ASSERT_TRUE(model->set_data(id_path.bind(row), i));
+  }
+  ASSERT_TRUE(model->set_data(name_path.bind(), "Org"));
+
+  const auto is_same_document = [&org](const std::shared_ptr<const ModelSnapshot>& snapshot) {
+    OrganizationTestSchema copy;
+    return snapshot->copy_to(copy) && copy.SerializeAsString() == org.SerializeAsString();
+  };
+
+  const std::shared_ptr<const ModelSnapshot> first{model->take_snapshot()};
+  ASSERT_TRUE(is_same_document(first));
+  ASSERT_EQ(first->get_row_count(OrganizationTestSchema::kEmployeesFieldNumber), row_count);
+  ASSERT_EQ(first->get_row_count(OrganizationTestSchema::kNameFieldNumber), -1);
+
+  // Nothing changed.
+  ASSERT_EQ(model->take_snapshot(), first);
+
+  // Only the changed row is copied, the snapshots already taken don't change.
+  ASSERT_TRUE(model->set_data(company_path.bind(70), "Company"));
+  const std::shared_ptr<const ModelSnapshot> second{model->take_snapshot()};
+  ASSERT_TRUE(is_same_document(second));
+  ASSERT_EQ(&second->get_fields(), &first->get_fields());
+  for (int i{0}; i < row_count; i++) {
+    const bool is_shared{second->get_row(OrganizationTestSchema::kEmployeesFieldNumber, i) ==
+                         first->get_row(OrganizationTestSchema::kEmployeesFieldNumber, i)};
+    ASSERT_EQ(is_shared, i != 70) << "Row " << i;
+  }
+  ASSERT_TRUE(static_cast<const Person*>(first->get_row(OrganizationTestSchema::kEmployeesFieldNumber, 70))
+                  ->company()
+                  .empty());
+
+  ASSERT_TRUE(model->set_data(name_path.bind(), "Other"));
+  const std::shared_ptr<const ModelSnapshot> third{model->take_snapshot()};
+  ASSERT_NE(&third->get_fields(), &second->get_fields());
+  ASSERT_EQ(static_cast<const OrganizationTestSchema&>(second->get_fields()).name(), "Org");
+  ASSERT_EQ(third->get_row(OrganizationTestSchema::kEmployeesFieldNumber, 0),
+            second->get_row(OrganizationTestSchema::kEmployeesFieldNumber, 0));
+
+  // The last row moves into a removed one, it is still shared.
+  const Message* last_row{third->get_row(OrganizationTestSchema::kEmployeesFieldNumber, row_count - 1)};
+  ASSERT_TRUE(employees->remove_row(5));
+  const std::shared_ptr<const ModelSnapshot> fourth{model->take_snapshot()};
+  ASSERT_TRUE(is_same_document(fourth));
+  ASSERT_EQ(fourth->get_row_count(OrganizationTestSchema::kEmployeesFieldNumber), row_count - 1);
+  ASSERT_EQ(fourth->get_row(OrganizationTestSchema::kEmployeesFieldNumber, 5), last_row);
+  ASSERT_EQ(third->get_row_count(OrganizationTestSchema::kEmployeesFieldNumber), row_count);
+
+  // Changes to a row, then moving it around before the next snapshot.
+  {
+    ProtoModel::BatchGuard batch{model};
+    ASSERT_TRUE(model->set_data(id_path.bind(row_count - 2), 1000));
+    ASSERT_TRUE(employees->remove_row(0));
+    const int row{employees->append_row()};
+    ASSERT_TRUE(model->set_data(id_path.bind(row), 2000));
+    ASSERT_TRUE(employees->remove_row(MODEL_SNAPSHOT_CHUNK_SIZE));
+  }
+  ASSERT_TRUE(is_same_document(model->take_snapshot()));
+
+  // Read by another thread while the model changes.
+  const std::shared_ptr<const ModelSnapshot> snapshot{model->take_snapshot()};
+  const std::string expected{org.SerializeAsString()};
+  std::thread worker{[&snapshot, &expected]() {
+    for (int i{0}; i < 20; i++) {
+      OrganizationTestSchema copy;
+      EXPECT_TRUE(snapshot->copy_to(copy));
+      EXPECT_EQ(copy.SerializeAsString(), expected);
+    }
+  }};
+  for (int i{0}; i < 50; i++) {
+    ASSERT_TRUE(model->set_data(id_path.bind(i), -i));
+    model->take_snapshot();
+  }
+  worker.join();
+  ASSERT_TRUE(is_same_document(model->take_snapshot()));
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestModelKinds) {
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  const ProtoModel* employees = model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber)));
+  ASSERT_EQ(model->get_kind(), ProtoModel::Kind::MESSAGE);
+  ASSERT_EQ(employees->get_kind(), ProtoModel::Kind::REPEATED_MESSAGE);
+
+  // A repeated message model is a message model too.
+  ASSERT_NE(model_cast<MessageModel>(employees), nullptr);
+  ASSERT_NE(model_cast<RepeatedMessageModel>(employees), nullptr);
+  ASSERT_EQ(model_cast<RepeatedMessageModel>(model), nullptr);
+  ASSERT_EQ(model_cast<PrimitiveModel>(model), nullptr);
+  ASSERT_EQ(model_cast<MessageModel>(static_cast<const ProtoModel*>(nullptr)), nullptr);
+
+  const int row{const_cast<ProtoModel*>(employees)->append_row()};
+  const ProtoModel* emails = model->get_sub_model(FieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(row),
+      FieldPath::FieldNumber(Person::kEmailsFieldNumber)));
+  ASSERT_EQ(emails->get_kind(), ProtoModel::Kind::REPEATED_PRIMITIVE);
+  ASSERT_NE(model_cast<PrimitiveModel>(emails), nullptr);
+
+  const ProtoModel* employment = model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber),
+                                            FieldPath::RepeatedAt(row), FieldPath::FieldNumber(Person::kCompanyFieldNumber)),
+      false, true);
+  ASSERT_EQ(employment->get_kind(), ProtoModel::Kind::ONEOF);
+  ASSERT_NE(model_cast<OneofModel>(employment), nullptr);
+  ASSERT_EQ(model_cast<MessageModel>(employment), nullptr);
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestSetDataThroughput) {
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  ProtoModel* employees = const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber))));
+
+  // Message, repeated message, oneof and primitive models on the way down
+  // and back up with the change notification.
+  const CompiledFieldPath years_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmploymentDetailsFieldNumber),
+      FieldPath::FieldNumber(EmploymentDetails::kYearsOfExperienceFieldNumber))};
+
+  const int row_count{64};
+  for (int i{0}; i < row_count; i++) employees->append_row();
+
+  const int iteration_count{row_count * 1000};
+
+  auto start_time{std::chrono::high_resolution_clock::now()};
+
+  for (int i{0}; i < iteration_count; i++) {
+    ASSERT_TRUE(model->set_data(years_path.bind(i % row_count), i));
+  }
+
+  auto end_time{std::chrono::high_resolution_clock::now()};
+
+  auto duration{std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()};
+  RecordProperty("set_data_ns", std::to_string(duration / iteration_count));
+
+  for (int i{0}; i < row_count; i++) {
+    ASSERT_EQ(org.employees(i).employment_details().years_of_experience(),
+              iteration_count - row_count + i);
+  }
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestArenaDocument) {
+  google::protobuf::ArenaOptions arena_options;
+  arena_options.start_block_size = 1024;
+  arena_options.max_block_size = 8 * 1024;
+  google::protobuf::Arena arena{arena_options};
+
+  OrganizationTestSchema* org{google::protobuf::Arena::CreateMessage<OrganizationTestSchema>(&arena)};
+
+  ProtoModel* model = new MessageModel(org);
+  model->build_sub_models();
+  model->set_undo_byte_budget(1024 * 1024);
+
+  ProtoModel* employees = const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber))));
+
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+  const CompiledFieldPath years_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmploymentDetailsFieldNumber),
+      FieldPath::FieldNumber(EmploymentDetails::kYearsOfExperienceFieldNumber))};
+
+  for (int i{0}; i < 100; i++) {
+    const int row{employees->append_row()};
+    ASSERT_TRUE(model->set_data(id_path.bind(row), i));
+    ASSERT_TRUE(model->set_data(years_path.bind(row), i * 2));
+  }
+  ASSERT_GE(arena.SpaceUsed(), 100 * sizeof(Person));
+  ASSERT_EQ(org->employees(0).GetArena(), &arena);
+
+  // The removed row comes back from the undo history, which is off the arena.
+  const std::string removed{org->employees(10).SerializeAsString()};
+  ASSERT_TRUE(employees->remove_row(10));
+  ASSERT_EQ(org->employees(10).id(), 99);
+  ASSERT_TRUE(model->get_undo_stack()->undo());
+  ASSERT_EQ(org->employees(10).SerializeAsString(), removed);
+  ASSERT_EQ(org->employees(10).GetArena(), &arena);
+
+  OrganizationTestSchema copy;
+  ASSERT_TRUE(model->take_snapshot()->copy_to(copy));
+  ASSERT_EQ(copy.SerializeAsString(), org->SerializeAsString());
+
+  delete model;  // The models go first, the arena frees the document.
+}
+
+TEST(MessageModelTest, TestAutosave) {
+  const std::filesystem::path file_path{std::filesystem::temp_directory_path() / "shader_gen_autosave.json"};
+  std::filesystem::remove(file_path);
+
+  const auto read_file = [&file_path](OrganizationTestSchema& org) {
+    std::ifstream file{file_path};
+    const std::string json{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    return util::JsonStringToMessage(json, &org).ok();
+  };
+
+  OrganizationTestSchema org;
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  ModelAutosaver* autosaver = new ModelAutosaver(model, QString::fromStdString(file_path.string()),
+                                                 ProtoModel::FileFormat::JSON, 60 * 1000);
+
+  ProtoModel* employees = const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber))));
+  const CompiledFieldPath name_path{
+      CompiledFieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kNameFieldNumber))};
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+
+  // Nothing is written until the changes stop for the interval.
+  for (int i{0}; i < 10; i++) {
+    const int row{employees->append_row()};
+    ASSERT_TRUE(model->set_data(id_path.bind(row), i));
+  }
+  ASSERT_TRUE(model->set_data(name_path.bind(), "Org"));
+  ASSERT_FALSE(std::filesystem::exists(file_path));
+
+  ASSERT_TRUE(autosaver->flush());
+  OrganizationTestSchema saved;
+  ASSERT_TRUE(read_file(saved));
+  ASSERT_EQ(saved.SerializeAsString(), org.SerializeAsString());
+
+  // Deleting the autosaver saves the pending changes.
+  ASSERT_TRUE(employees->remove_row(3));
+  delete autosaver;
+  saved.Clear();
+  ASSERT_TRUE(read_file(saved));
+  ASSERT_EQ(saved.employees_size(), 9);
+  ASSERT_EQ(saved.SerializeAsString(), org.SerializeAsString());
+
+  // A failed write is reported.
+  {
+    ModelAutosaver unwritable{model, QString::fromStdString((file_path / "missing" / "file.json").string())};
+    ASSERT_TRUE(model->set_data(name_path.bind(), "Other"));
+    ASSERT_FALSE(unwritable.flush());
+  }
+  ASSERT_TRUE(read_file(saved));
+  ASSERT_EQ(saved.name(), "Org");
+
+  std::filesystem::remove(file_path);
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestBinaryFormat) {
+  const std::filesystem::path directory{std::filesystem::temp_directory_path()};
+  const QString binary_path{QString::fromStdString((directory / "shader_gen_project.bin").string())};
+  const QString json_path{QString::fromStdString((directory / "shader_gen_project.json").string())};
+
+  OrganizationTestSchema org;
+  org.set_name("Org");
+  for (int i{0}; i < 10; i++) {
+    Person* person{org.add_employees()};
+    person->set_id(i);
+    person->add_emails("person" + std::to_string(i) + "@org.com");
+    person->mutable_employment_details()->set_annual_salary(1000.0 * i);
+  }
+
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  ASSERT_TRUE(model->saveToBinary(binary_path));
+  ASSERT_TRUE(model->save(json_path, ProtoModel::FileFormat::JSON));
+  ASSERT_LT(std::filesystem::file_size(binary_path.toStdString()), std::filesystem::file_size(json_path.toStdString()));
+
+  // Both formats are told apart on load.
+  for (const QString& path : {binary_path, json_path}) {
+    OrganizationTestSchema loaded;
+    ProtoModel* loaded_model = new MessageModel(&loaded);
+    ASSERT_TRUE(loaded_model->load(path));
+    loaded_model->build_sub_models();
+    ASSERT_EQ(loaded.SerializeAsString(), org.SerializeAsString());
+    delete loaded_model;
+  }
+
+  OrganizationTestSchema loaded;
+  ProtoModel* loaded_model = new MessageModel(&loaded);
+  ASSERT_TRUE(loaded_model->loadFromBinary(binary_path));
+  ASSERT_FALSE(loaded_model->loadFromBinary(json_path));
+
+  std::string data;
+  ASSERT_TRUE(ProtoModel::serialize_to_binary(org, data));
+  ASSERT_EQ(data.size(), PROTO_MODEL_BINARY_HEADER_SIZE + org.ByteSizeLong());
+
+  // Truncated files and unknown versions are rejected.
+  ASSERT_FALSE(ProtoModel::parse_from_binary(data.data(), data.size() - 1, loaded));
+  ASSERT_FALSE(ProtoModel::parse_from_binary(data.data(), PROTO_MODEL_BINARY_HEADER_SIZE - 1, loaded));
+  std::string other_version{data};
+  other_version[4] = (char)(PROTO_MODEL_BINARY_VERSION + 1);
+  ASSERT_FALSE(ProtoModel::parse_from_binary(other_version.data(), other_version.size(), loaded));
+
+  std::filesystem::remove(binary_path.toStdString());
+  std::filesystem::remove(json_path.toStdString());
+
+  delete loaded_model;
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
+
+TEST(MessageModelTest, TestJournalFile) {
+  const std::filesystem::path project_path{std::filesystem::temp_directory_path() / "shader_gen_journal.bin"};
+  const QString project_file_path{QString::fromStdString(project_path.string())};
+  const std::filesystem::path journal_path{ModelJournalFile::get_journal_path(project_file_path).toStdString()};
+  const std::filesystem::path next_journal_path{journal_path.string() + ".next"};
+  std::filesystem::remove(project_path);
+  std::filesystem::remove(journal_path);
+  std::filesystem::remove(next_journal_path);
+
+  const auto read_file = [](const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  };
+
+  // Loads the project file and replays its journal into a new document.
+  const auto load = [&project_file_path](std::string& serialized) {
+    OrganizationTestSchema org;
+    ProtoModel* model = new MessageModel(&org);
+    model->build_sub_models();
+    bool result;
+    {
+      ModelJournalFile journal_file{model, project_file_path};
+      result = journal_file.open();
+    }
+    serialized = org.SerializeAsString();
+    delete model;
+    return result;
+  };
+
+  const CompiledFieldPath name_path{
+      CompiledFieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kNameFieldNumber))};
+  const CompiledFieldPath id_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kIdFieldNumber))};
+  const CompiledFieldPath company_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kCompanyFieldNumber))};
+  const CompiledFieldPath job_title_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kJobTitleFieldNumber))};
+  const CompiledFieldPath salary_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmploymentDetailsFieldNumber),
+      FieldPath::FieldNumber(Person::EmploymentDetails::kAnnualSalaryFieldNumber))};
+  const CompiledFieldPath emails_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmailsFieldNumber))};
+  const CompiledFieldPath email_path{CompiledFieldPath::Of<OrganizationTestSchema>(
+      FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber), FieldPath::RepeatedAt(),
+      FieldPath::FieldNumber(Person::kEmailsFieldNumber), FieldPath::RepeatedAt())};
+
+  OrganizationTestSchema org;
+  ProtoModel* model = new MessageModel(&org);
+  model->build_sub_models();
+
+  // No project file yet, an empty document.
+  ModelJournalFile* journal_file = new ModelJournalFile(model, project_file_path);
+  ASSERT_TRUE(journal_file->open());
+  ASSERT_EQ(journal_file->get_size(), MODEL_JOURNAL_FILE_HEADER_SIZE);
+
+  ProtoModel* employees = const_cast<ProtoModel*>(model->get_sub_model(
+      FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(OrganizationTestSchema::kEmployeesFieldNumber))));
+
+  ASSERT_TRUE(model->set_data(name_path.bind(), "Org"));
+  for (int i{0}; i < 5; i++) {
+    const int row{employees->append_row()};
+    ASSERT_TRUE(model->set_data(id_path.bind(row), i - 2));
+    ASSERT_TRUE(model->set_data(company_path.bind(row), QString::fromStdString("Company " + std::to_string(i))));
+  }
+  ASSERT_TRUE(model->set_data(job_title_path.bind(2), "Engineer"));  // Switches the oneof
+  ASSERT_TRUE(model->set_data(salary_path.bind(3), 1234.5));
+  ProtoModel* emails{const_cast<ProtoModel*>(model->get_sub_model(emails_path.bind(4)))};
+  for (int i{0}; i < 3; i++) ASSERT_EQ(emails->append_row(), i);
+  ASSERT_TRUE(model->set_data(email_path.bind(4, 1), "person@org.com"));
+  ASSERT_TRUE(emails->remove_row(0));
+  ASSERT_TRUE(employees->remove_row(1));
+
+  // A batch is appended when it ends, a field set more than once with its
+  // last value only.
+  const size_t batch_start_size{journal_file->get_size()};
+  {
+    ProtoModel::BatchGuard batch{model};
+    for (int i{0}; i < 10; i++) ASSERT_TRUE(model->set_data(salary_path.bind(3), 100.0 * i));
+    ASSERT_EQ(journal_file->get_size(), batch_start_size);
+  }
+  const size_t batch_size{journal_file->get_size() - batch_start_size};
+  ASSERT_TRUE(model->set_data(salary_path.bind(3), 1234.5));
+  ASSERT_EQ(journal_file->get_size(), batch_start_size + 2 * batch_size);
+
+  // Setting the same value again is not a change.
+  ASSERT_TRUE(model->set_data(salary_path.bind(3), 1234.5));
+  ASSERT_EQ(journal_file->get_size(), batch_start_size + 2 * batch_size);
+
+  // Only the journal is written, record by record.
+  ASSERT_TRUE(journal_file->wait());
+  ASSERT_FALSE(std::filesystem::exists(project_path));
+  const size_t size{journal_file->get_size()};
+  ASSERT_EQ(std::filesystem::file_size(journal_path), size);
+  delete journal_file;
+
+  std::string loaded;
+  ASSERT_TRUE(load(loaded));
+  ASSERT_EQ(loaded, org.SerializeAsString());
+
+  // A crash while appending loses the last change only.
+  {
+    OrganizationTestSchema other;
+    ProtoModel* other_model = new MessageModel(&other);
+    other_model->build_sub_models();
+    ModelJournalFile* other_journal_file = new ModelJournalFile(other_model, project_file_path);
+    ASSERT_TRUE(other_journal_file->open());
+    ASSERT_TRUE(other_model->set_data(name_path.bind(), "Other"));
+    delete other_journal_file;
+    delete other_model;
+  }
+  std::filesystem::resize_file(journal_path, std::filesystem::file_size(journal_path) - 1);
+  ASSERT_TRUE(load(loaded));
+  ASSERT_EQ(loaded, org.SerializeAsString());
+  ASSERT_EQ(std::filesystem::file_size(journal_path), size);
+
+  // Past the threshold, the journal is compacted into the project file while
+  // the changes go on.
+  delete model;
+  org.Clear();
+  model = new MessageModel(&org);
+  model->build_sub_models();
+  journal_file = new ModelJournalFile(model, project_file_path, 256);
+  ASSERT_TRUE(journal_file->open());
+  const std::string stale_journal{read_file(journal_path)};
+
+  for (int i{0}; i < 200; i++) ASSERT_TRUE(model->set_data(id_path.bind(i % 4), i));
+  ASSERT_TRUE(journal_file->wait());
+  ASSERT_TRUE(std::filesystem::exists(project_path));
+  ASSERT_FALSE(std::filesystem::exists(next_journal_path));
+
+  // The changes made meanwhile are in the journal until the next one.
+  journal_file->compact();
+  ASSERT_TRUE(journal_file->wait());
+  ASSERT_EQ(journal_file->get_size(), MODEL_JOURNAL_FILE_HEADER_SIZE);
+
+  // The next journal cannot replace the current one, as on Windows while it
+  // is open elsewhere, so the changes go on in it.
+  std::filesystem::remove(journal_path);
+  std::filesystem::create_directories(journal_path / "blocker");
+  journal_file->compact();
+  ASSERT_FALSE(journal_file->wait());
+  ASSERT_EQ(journal_file->get_size(), MODEL_JOURNAL_FILE_HEADER_SIZE);
+  ASSERT_TRUE(model->set_data(name_path.bind(), "Next"));
+  ASSERT_FALSE(journal_file->wait());
+  ASSERT_EQ(std::filesystem::file_size(next_journal_path), journal_file->get_size());
+  delete journal_file;
+
+  // Loading also appends to the next journal until it can be renamed.
+  ASSERT_TRUE(load(loaded));
+  ASSERT_EQ(loaded, org.SerializeAsString());
+  ASSERT_TRUE(std::filesystem::exists(next_journal_path));
+
+  delete model;
+  org.Clear();
+  model = new MessageModel(&org);
+  model->build_sub_models();
+  journal_file = new ModelJournalFile(model, project_file_path);
+  ASSERT_TRUE(journal_file->open());
+  ASSERT_EQ(org.SerializeAsString(), loaded);
+
+  // Renamed by the next compaction.
+  std::filesystem::remove_all(journal_path);
+  journal_file->compact();
+  ASSERT_TRUE(journal_file->wait());
+  ASSERT_FALSE(std::filesystem::exists(next_journal_path));
+  ASSERT_TRUE(model->set_data(name_path.bind(), "Compacted"));
+  delete journal_file;
+
+  ASSERT_TRUE(load(loaded));
+  ASSERT_EQ(loaded, org.SerializeAsString());
+
+  // A crash before the next journal replaced the current one.
+  std::filesystem::rename(journal_path, next_journal_path);
+  std::ofstream{journal_path, std::ios::binary} << stale_journal;
+  ASSERT_TRUE(load(loaded));
+  ASSERT_EQ(loaded, org.SerializeAsString());
+  ASSERT_FALSE(std::filesystem::exists(next_journal_path));
+
+  // A journal following another project file is dropped.
+  OrganizationTestSchema replaced;
+  replaced.set_name("Replaced");
+  std::string data;
+  ASSERT_TRUE(ProtoModel::serialize_to_binary(replaced, data));
+  std::ofstream{project_path, std::ios::binary | std::ios::trunc} << data;
+  ASSERT_TRUE(load(loaded));
+  ASSERT_EQ(loaded, replaced.SerializeAsString());
+  ASSERT_EQ(std::filesystem::file_size(journal_path), MODEL_JOURNAL_FILE_HEADER_SIZE);
+
+  std::filesystem::remove(project_path);
+  std::filesystem::remove(journal_path);
+
+  delete model;  // For the AddressSanitizer to not complain about memory leaks
+}
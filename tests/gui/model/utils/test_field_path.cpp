@@ -102,3 +102,79 @@ TEST(FieldPathTest, EdgeCaseValidation) {
   auto path1 = FieldPath::Of<Person>();
   ASSERT_FALSE(path1.is_valid());
 }
+
+// Compiled paths are validated once and bound to indices on each access
+TEST(FieldPathTest, CompiledPathBinding) {
+  auto compiled = CompiledFieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(2),  // employees
+                                                                FieldPath::RepeatedAt(),    // employees[?]
+                                                                FieldPath::FieldNumber(5),  // emails
+                                                                FieldPath::RepeatedAt()     // emails[?]
+  );
+  ASSERT_TRUE(compiled.is_valid());
+
+  auto path1 = compiled.bind(3, 1);
+  ASSERT_TRUE(path1.is_valid());
+  ASSERT_EQ(path1.to_string(), "FN(2) --> AT[3] --> FN(5) --> AT[1]");
+
+  // Traversing a bound path changes neither the path nor the compiled one
+  FieldPath::Cursor cursor{path1};
+  ASSERT_TRUE(cursor.skip_component());
+  int index{-1};
+  ASSERT_TRUE(cursor.get_upcoming_repeated_index(index));
+  ASSERT_EQ(index, 3);
+  ASSERT_EQ(path1.to_string(), "FN(2) --> AT[3] --> FN(5) --> AT[1]");
+  auto path2 = compiled.bind(4, 0);
+  ASSERT_EQ(path2.to_string(), "FN(2) --> AT[4] --> FN(5) --> AT[0]");
+
+  // Wrong number of indices
+  ASSERT_FALSE(compiled.bind(1).is_valid());
+
+  auto invalid = CompiledFieldPath::Of<Person>(FieldPath::FieldNumber(99));
+  ASSERT_FALSE(invalid.is_valid());
+}
+
+// Paths are compared and hashed by their components
+TEST(FieldPathTest, PathEquality) {
+  auto compiled = CompiledFieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(2),  // employees
+                                                                FieldPath::RepeatedAt(),    // employees[?]
+                                                                FieldPath::FieldNumber(5)   // emails
+  );
+
+  auto path1 = compiled.bind(3);
+  auto path2 = compiled.bind(3);
+  ASSERT_TRUE(path1 == path2);
+  ASSERT_EQ(FieldPath::Hash{}(path1), FieldPath::Hash{}(path2));
+  ASSERT_TRUE(path1 != compiled.bind(4));
+
+  // A repeated index is not a field number
+  auto path3 = FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(2), FieldPath::RepeatedAt(3));
+  auto path4 = FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(2), FieldPath::RepeatedAt(2));
+  ASSERT_TRUE(path3 != path4);
+
+  // A cursor leaves the path as it is.
+  FieldPath::Cursor cursor{path2};
+  ASSERT_TRUE(cursor.skip_component());
+  ASSERT_TRUE(path1 == path2);
+}
+
+// Prefixes are matched and ordered component by component
+TEST(FieldPathTest, PathPrefixes) {
+  auto employees = FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(2));
+  auto employee = employees.at(1);
+  ASSERT_EQ(employee, FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(2), FieldPath::RepeatedAt(1)));
+
+  auto emails = FieldPath::Of<OrganizationTestSchema>(FieldPath::FieldNumber(2), FieldPath::RepeatedAt(1),
+                                                      FieldPath::FieldNumber(5));
+  ASSERT_TRUE(emails.starts_with(employee));
+  ASSERT_TRUE(emails.starts_with(emails));
+  ASSERT_FALSE(employee.starts_with(emails));
+
+  // AT[1] is not a prefix of AT[12].
+  ASSERT_FALSE(employees.at(12).starts_with(employee));
+
+  // The paths under a prefix follow it.
+  ASSERT_TRUE(employee < emails);
+  ASSERT_TRUE(emails < employees.at(2));
+  ASSERT_FALSE(emails < employee);
+  ASSERT_FALSE(employee < employee);
+}
@@ -0,0 +1,75 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "gui/model/utils/mapped_file.hpp"
+
+static QString write_temp_file(const std::string& name, const std::string& contents) {
+  const std::filesystem::path path{std::filesystem::temp_directory_path() / ("shader_gen_" + name)};
+  std::ofstream{path, std::ios::binary | std::ios::trunc} << contents;
+  return QString::fromStdString(path.string());
+}
+
+TEST(MappedFileTest, TestMapsTheFile) {
+  std::string contents(1 << 20, '\0');
+  for (size_t i{0}; i < contents.size(); i++) contents[i] = (char)(i * 31);
+  const QString path{write_temp_file("mapped_file", contents)};
+
+  MappedFile file{path};
+  ASSERT_FALSE(file.is_open());
+  ASSERT_TRUE(file.open());
+  ASSERT_TRUE(file.is_mapped());
+  ASSERT_EQ(file.get_size(), contents.size());
+  ASSERT_EQ(std::string(file.get_data(), file.get_size()), contents);
+  ASSERT_FALSE(file.open());  // Already open
+
+  file.close();
+  ASSERT_FALSE(file.is_open());
+  ASSERT_EQ(file.get_size(), 0);
+
+  std::filesystem::remove(path.toStdString());
+}
+
+TEST(MappedFileTest, TestEmptyAndMissingFiles) {
+  const QString path{write_temp_file("mapped_file_empty", "")};
+
+  // An empty file cannot be mapped, it is read instead.
+  MappedFile file{path};
+  ASSERT_TRUE(file.open());
+  ASSERT_FALSE(file.is_mapped());
+  ASSERT_EQ(file.get_size(), 0);
+  ASSERT_NE(file.get_data(), nullptr);
+
+  std::filesystem::remove(path.toStdString());
+
+  MappedFile missing{path};
+  ASSERT_FALSE(missing.open());
+}
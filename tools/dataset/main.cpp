@@ -0,0 +1,153 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+
+#include "error_macros.hpp"
+#include "evaluator/visual_shader_dataset.hpp"
+#include "main.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+static std::atomic<bool> cancelled{false};
+
+// The chunk being rendered is still written, so the dataset stays valid.
+static void handle_interrupt(int) { cancelled = true; }
+
+int main(int argc, char** argv) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  QCoreApplication shader_gen_dataset_app(argc, argv);
+  QCoreApplication::setOrganizationName(ENIGMA_ORG_NAME);
+  QCoreApplication::setApplicationName(SHADER_GEN_PROJECT_NAME " Dataset");
+  QCoreApplication::setApplicationVersion(SHADER_GEN_PROJECT_VERSION);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Generates random graphs and their renders into sharded binary files.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("output", "Directory of the shards and the index.");
+
+  QCommandLineOption count_option({"n", "count"}, "Number of records.", "count", "1000");
+  QCommandLineOption size_option({"s", "size"}, "Width and height of the images.", "pixels", "64");
+  QCommandLineOption time_option({"t", "time"}, "Value of uTime.", "seconds", "0");
+  QCommandLineOption min_nodes_option("min-nodes", "Minimum number of nodes per graph.", "count", "2");
+  QCommandLineOption max_nodes_option("max-nodes", "Maximum number of nodes per graph.", "count", "16");
+  QCommandLineOption encoding_option({"e", "encoding"}, "Pixel format of the images: rgba8 or rgba32f.", "encoding",
+                                     "rgba8");
+  QCommandLineOption shard_size_option("shard-size", "Maximum size of a shard.", "MiB", "256");
+  QCommandLineOption seed_option("seed", "Seed of the random graphs.", "seed", "0");
+  parser.addOption(count_option);
+  parser.addOption(size_option);
+  parser.addOption(time_option);
+  parser.addOption(min_nodes_option);
+  parser.addOption(max_nodes_option);
+  parser.addOption(encoding_option);
+  parser.addOption(shard_size_option);
+  parser.addOption(seed_option);
+
+  parser.process(shader_gen_dataset_app);
+
+  const QStringList arguments{parser.positionalArguments()};
+  if (arguments.size() != 1) parser.showHelp(1);
+
+  DatasetOptions options;
+  bool ok;
+
+  options.record_count = parser.value(count_option).toULongLong(&ok);
+  if (!ok) {
+    ERROR_PRINT("Invalid count: " + parser.value(count_option).toStdString());
+    return 1;
+  }
+
+  options.image_size = parser.value(size_option).toInt(&ok);
+  if (!ok || options.image_size <= 0) {
+    ERROR_PRINT("Invalid size: " + parser.value(size_option).toStdString());
+    return 1;
+  }
+
+  options.time = parser.value(time_option).toFloat(&ok);
+  if (!ok) {
+    ERROR_PRINT("Invalid time: " + parser.value(time_option).toStdString());
+    return 1;
+  }
+
+  options.min_node_count = parser.value(min_nodes_option).toInt(&ok);
+  bool max_ok;
+  options.max_node_count = parser.value(max_nodes_option).toInt(&max_ok);
+  if (!ok || !max_ok || options.min_node_count < 0 || options.max_node_count < options.min_node_count) {
+    ERROR_PRINT("Invalid node counts.");
+    return 1;
+  }
+
+  const QString encoding{parser.value(encoding_option)};
+  if (encoding == "rgba8") {
+    options.encoding = DatasetImageEncoding::RGBA8;
+  } else if (encoding == "rgba32f") {
+    options.encoding = DatasetImageEncoding::RGBA32F;
+  } else {
+    ERROR_PRINT("Invalid encoding: " + encoding.toStdString());
+    return 1;
+  }
+
+  const uint64_t shard_size{parser.value(shard_size_option).toULongLong(&ok)};
+  if (!ok || shard_size == 0) {
+    ERROR_PRINT("Invalid shard size: " + parser.value(shard_size_option).toStdString());
+    return 1;
+  }
+  options.max_shard_size = shard_size * 1024 * 1024;
+
+  options.seed = parser.value(seed_option).toULongLong(&ok);
+  if (!ok) {
+    ERROR_PRINT("Invalid seed: " + parser.value(seed_option).toStdString());
+    return 1;
+  }
+
+  std::signal(SIGINT, handle_interrupt);
+
+  const bool generated{generate_dataset(arguments.at(0).toStdString(), options, cancelled,
+                                        [&](const uint64_t& count) {
+                                          std::printf("\r[%llu/%llu]", (unsigned long long)count,
+                                                      (unsigned long long)options.record_count);
+                                          std::fflush(stdout);
+                                        })};
+  std::printf("\n");
+
+  if (!generated) {
+    ERROR_PRINT("Failed to generate the dataset.");
+    return 1;
+  }
+
+  if (cancelled) std::printf("Interrupted, the records generated so far were written.\n");
+
+  return 0;
+}
@@ -0,0 +1,251 @@
+/*********************************************************************************/
+/*                                                                               */
+/*  Copyright (C) 2024 Seif Kandil (k0T0z)                                       */
+/*                                                                               */
+/*  This file is a part of the ENIGMA Development Environment.                   */
+/*                                                                               */
+/*                                                                               */
+/*  ENIGMA is free software: you can redistribute it and/or modify it under the  */
+/*  terms of the GNU General Public License as published by the Free Software    */
+/*  Foundation, version 3 of the license or any later version.                   */
+/*                                                                               */
+/*  This application and its source code is distributed AS-IS, WITHOUT ANY       */
+/*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS    */
+/*  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more        */
+/*  details.                                                                     */
+/*                                                                               */
+/*  You should have recieved a copy of the GNU General Public License along      */
+/*  with this code. If not, see <http://www.gnu.org/licenses/>                   */
+/*                                                                               */
+/*  ENIGMA is an environment designed to create games and other programs with a  */
+/*  high-level, fully compilable language. Developers of ENIGMA or anything      */
+/*  associated with ENIGMA are in no way responsible for its users or            */
+/*  applications created by its users, or damages caused by the environment      */
+/*  or programs made in the environment.                                         */
+/*                                                                               */
+/*********************************************************************************/
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+#include <google/protobuf/util/json_util.h>
+
+#include "error_macros.hpp"
+#include "evaluator/utils/thread_pool.hpp"
+#include "evaluator/visual_shader_evaluator.hpp"
+#include "main.hpp"
+
+using namespace shadergen_visual_shader_evaluator;
+
+#define MANIFEST_FILE_NAME "thumbs_manifest.json"
+#define MANIFEST_VERSION 1
+
+/**
+ * @brief The manifest maps each graph file name to the hash of its content.
+ *        A thumbnail is rendered again when the hash changes, when the
+ *        thumbnail is missing or when the render settings change.
+ */
+struct Manifest {
+  int size{0};
+  double time{0.0};
+  QJsonObject hashes;
+};
+
+static bool load_manifest(const QString& path, Manifest& manifest) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) return false;  // No manifest yet.
+
+  const QJsonObject root{QJsonDocument::fromJson(file.readAll()).object()};
+  CHECK_CONDITION_TRUE_NON_VOID(root.value("version").toInt() != MANIFEST_VERSION, false,
+                                "Ignoring manifest with an unknown version: " + path.toStdString());
+
+  manifest.size = root.value("size").toInt();
+  manifest.time = root.value("time").toDouble();
+  manifest.hashes = root.value("files").toObject();
+  return true;
+}
+
+static bool save_manifest(const QString& path, const Manifest& manifest) {
+  QJsonObject root;
+  root.insert("version", MANIFEST_VERSION);
+  root.insert("size", manifest.size);
+  root.insert("time", manifest.time);
+  root.insert("files", manifest.hashes);
+
+  // Written to a temporary file first so an interrupted run keeps the old manifest.
+  QSaveFile file(path);
+  CHECK_CONDITION_TRUE_NON_VOID(!file.open(QIODevice::WriteOnly), false,
+                                "Failed to open file for writing: " + path.toStdString());
+  file.write(QJsonDocument(root).toJson());
+  return file.commit();
+}
+
+enum class ThumbnailStatus { FAILED, SKIPPED, RENDERED };
+
+struct Thumbnail {
+  QString graph_path;
+  QString image_path;
+  QString hash;
+  ThumbnailStatus status{ThumbnailStatus::FAILED};
+};
+
+static bool render_thumbnail(const QByteArray& json_data, const int& size, const float& time,
+                             const QString& image_path) {
+  VisualShader visual_shader;
+  google::protobuf::util::JsonParseOptions options;
+  absl::Status status = google::protobuf::util::JsonStringToMessage(json_data.toStdString(), &visual_shader, options);
+  CHECK_CONDITION_TRUE_NON_VOID(!status.ok(), false, "Failed to deserialize JSON:" + status.ToString());
+
+  Image image;
+  CHECK_CONDITION_TRUE_NON_VOID(!render_shader(visual_shader, size, size, time, image), false,
+                                "Failed to render the shader.");
+
+  std::vector<uint8_t> data;
+  image.to_rgba8(data);
+
+  const QImage q_image(data.data(), image.width, image.height, image.width * 4, QImage::Format_RGBA8888);
+  CHECK_CONDITION_TRUE_NON_VOID(!q_image.save(image_path, "PNG"), false,
+                                "Failed to write image: " + image_path.toStdString());
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  QCoreApplication shader_gen_thumbs_app(argc, argv);
+  QCoreApplication::setOrganizationName(ENIGMA_ORG_NAME);
+  QCoreApplication::setApplicationName(SHADER_GEN_PROJECT_NAME " Thumbnails");
+  QCoreApplication::setApplicationVersion(SHADER_GEN_PROJECT_VERSION);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Renders a PNG thumbnail for each graph JSON file of a directory.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("input", "Directory containing the graph JSON files.");
+
+  QCommandLineOption output_option({"o", "output"}, "Directory of the thumbnails (defaults to the input).", "directory");
+  QCommandLineOption size_option({"s", "size"}, "Width and height of the thumbnails.", "pixels", "128");
+  QCommandLineOption time_option({"t", "time"}, "Value of uTime.", "seconds", "0");
+  QCommandLineOption force_option({"f", "force"}, "Render all thumbnails, even unchanged ones.");
+  parser.addOption(output_option);
+  parser.addOption(size_option);
+  parser.addOption(time_option);
+  parser.addOption(force_option);
+
+  parser.process(shader_gen_thumbs_app);
+
+  const QStringList arguments{parser.positionalArguments()};
+  if (arguments.size() != 1) parser.showHelp(1);
+
+  const QDir input_dir(arguments.at(0));
+  if (!input_dir.exists()) {
+    ERROR_PRINT("Input directory does not exist: " + input_dir.path().toStdString());
+    return 1;
+  }
+
+  const QDir output_dir(parser.isSet(output_option) ? parser.value(output_option) : input_dir.path());
+  if (!output_dir.mkpath(".")) {
+    ERROR_PRINT("Failed to create output directory: " + output_dir.path().toStdString());
+    return 1;
+  }
+
+  bool ok;
+  const int size{parser.value(size_option).toInt(&ok)};
+  if (!ok || size <= 0) {
+    ERROR_PRINT("Invalid size: " + parser.value(size_option).toStdString());
+    return 1;
+  }
+
+  const float time{parser.value(time_option).toFloat(&ok)};
+  if (!ok) {
+    ERROR_PRINT("Invalid time: " + parser.value(time_option).toStdString());
+    return 1;
+  }
+
+  const QString manifest_path{output_dir.filePath(MANIFEST_FILE_NAME)};
+
+  Manifest old_manifest;
+  const bool reuse{!parser.isSet(force_option) && load_manifest(manifest_path, old_manifest) &&
+                   old_manifest.size == size && old_manifest.time == (double)time};
+
+  std::vector<Thumbnail> thumbnails;
+  for (const QFileInfo& info : input_dir.entryInfoList({"*.json"}, QDir::Files, QDir::Name)) {
+    if (info.fileName() == MANIFEST_FILE_NAME) continue;
+
+    Thumbnail thumbnail;
+    thumbnail.graph_path = info.filePath();
+    thumbnail.image_path = output_dir.filePath(info.completeBaseName() + ".png");
+    thumbnails.push_back(thumbnail);
+  }
+
+  // One file per task, each thumbnail is rendered on the thread running it.
+  std::atomic<int> done_count{0};
+  evaluator_utils::get_thread_pool().run((int)thumbnails.size(), [&](const int& i, const int&) {
+    Thumbnail& thumbnail{thumbnails.at(i)};
+
+    QFile file(thumbnail.graph_path);
+    const QString name{QFileInfo(thumbnail.graph_path).fileName()};
+
+    if (!file.open(QIODevice::ReadOnly)) {
+      ERROR_PRINT("Failed to open file for reading: " + thumbnail.graph_path.toStdString());
+    } else {
+      const QByteArray json_data{file.readAll()};
+      thumbnail.hash = QString::fromLatin1(QCryptographicHash::hash(json_data, QCryptographicHash::Sha256).toHex());
+
+      if (reuse && old_manifest.hashes.value(name).toString() == thumbnail.hash &&
+          QFileInfo::exists(thumbnail.image_path)) {
+        thumbnail.status = ThumbnailStatus::SKIPPED;
+      } else if (render_thumbnail(json_data, size, time, thumbnail.image_path)) {
+        thumbnail.status = ThumbnailStatus::RENDERED;
+      } else {
+        ERROR_PRINT("Failed to render thumbnail of " + thumbnail.graph_path.toStdString());
+      }
+    }
+
+    std::printf("\r[%d/%d]", ++done_count, (int)thumbnails.size());
+    std::fflush(stdout);
+  });
+
+  // Failed files are left out so they are retried on the next run.
+  Manifest manifest;
+  manifest.size = size;
+  manifest.time = (double)time;
+
+  int rendered_count{0}, skipped_count{0}, failed_count{0};
+  for (const Thumbnail& thumbnail : thumbnails) {
+    switch (thumbnail.status) {
+      case ThumbnailStatus::RENDERED:
+        rendered_count++;
+        break;
+      case ThumbnailStatus::SKIPPED:
+        skipped_count++;
+        break;
+      default:
+        failed_count++;
+        continue;
+    }
+    manifest.hashes.insert(QFileInfo(thumbnail.graph_path).fileName(), thumbnail.hash);
+  }
+
+  if (!save_manifest(manifest_path, manifest)) {
+    ERROR_PRINT("Failed to write manifest: " + manifest_path.toStdString());
+    return 1;
+  }
+
+  std::printf("\nRendered %d, skipped %d, failed %d.\n", rendered_count, skipped_count, failed_count);
+
+  return failed_count == 0 ? 0 : 1;
+}